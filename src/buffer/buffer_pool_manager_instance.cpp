@@ -12,16 +12,17 @@
 
 #include "buffer/buffer_pool_manager_instance.h"
 
+#include "common/exception.h"
 #include "common/macros.h"
 
 namespace bustub {
 
-BufferPoolManagerInstance::BufferPoolManagerInstance(size_t pool_size, DiskManager *disk_manager,
+BufferPoolManagerInstance::BufferPoolManagerInstance(size_t pool_size, DiskInterface *disk_manager,
                                                      LogManager *log_manager)
     : BufferPoolManagerInstance(pool_size, 1, 0, disk_manager, log_manager) {}
 
 BufferPoolManagerInstance::BufferPoolManagerInstance(size_t pool_size, uint32_t num_instances, uint32_t instance_index,
-                                                     DiskManager *disk_manager, LogManager *log_manager)
+                                                     DiskInterface *disk_manager, LogManager *log_manager)
     : pool_size_(pool_size),
       num_instances_(num_instances),
       instance_index_(instance_index),
@@ -62,7 +63,12 @@ bool BufferPoolManagerInstance::FlushPgImp(page_id_t page_id) {
   }
 
   auto page = &pages_[it->second];
-  disk_manager_->WritePage(page_id, page->GetData());
+  try {
+    disk_manager_->WritePage(page_id, page->GetData());
+  } catch (Exception &e) {
+    latch_.unlock();
+    throw;
+  }
 
   latch_.unlock();
   return true;
@@ -71,9 +77,14 @@ bool BufferPoolManagerInstance::FlushPgImp(page_id_t page_id) {
 void BufferPoolManagerInstance::FlushAllPgsImp() {
   // You can do it!
   latch_.lock();
-  for (auto &&it : page_table_) {
-    auto page = &pages_[it.second];
-    disk_manager_->WritePage(page->GetPageId(), page->GetData());
+  try {
+    for (auto &&it : page_table_) {
+      auto page = &pages_[it.second];
+      disk_manager_->WritePage(page->GetPageId(), page->GetData());
+    }
+  } catch (Exception &e) {
+    latch_.unlock();
+    throw;
   }
   latch_.unlock();
 }
@@ -87,6 +98,12 @@ Page *BufferPoolManagerInstance::NewPgImp(page_id_t *page_id) {
 
   latch_.lock();
 
+  // a read-only disk manager has nowhere to put the new page
+  if (disk_manager_->IsReadOnly()) {
+    latch_.unlock();
+    return nullptr;
+  }
+
   // 1.   If all the pages in the buffer pool are pinned, return nullptr.
   bool allpined = true;
   for (size_t i = 0; i < pool_size_; i++) {
@@ -103,27 +120,14 @@ Page *BufferPoolManagerInstance::NewPgImp(page_id_t *page_id) {
 
   // 2.   Pick a victim page P from either the free list or the replacer. Always pick from the free list first.
   frame_id_t frame_id = -1;
-  if (!free_list_.empty()) {
-    frame_id = free_list_.front();
-    free_list_.pop_front();
-  } else if (replacer_->Victim(&frame_id)) {
-    page_id_t replacepage = -1;
-    for (auto &&p : page_table_) {
-      if (p.second == frame_id) {
-        replacepage = p.first;
-        break;
-      }
-    }
-
-    if (replacepage != -1) {
-      auto page = &pages_[frame_id];
-      if (page->IsDirty()) {
-        disk_manager_->WritePage(replacepage, page->GetData());
-        page->pin_count_ = 0;
-        page->is_dirty_ = false;
-      }
-    }
-  } else {
+  bool found;
+  try {
+    found = FindFrame(&frame_id);
+  } catch (Exception &e) {
+    latch_.unlock();
+    throw;
+  }
+  if (!found) {
     latch_.unlock();
     return nullptr;
   }
@@ -134,14 +138,22 @@ Page *BufferPoolManagerInstance::NewPgImp(page_id_t *page_id) {
 
   auto page = &pages_[frame_id];
   page_table_.erase(page->page_id_);
+  page->page_id_ = INVALID_PAGE_ID;
+  page->is_dirty_ = false;
+  page->ResetMemory();
+  try {
+    disk_manager_->WritePage(pageid, page->GetData());
+  } catch (Exception &e) {
+    // the frame holds no page now, give it back instead of leaving it half-mapped
+    free_list_.push_back(frame_id);
+    latch_.unlock();
+    throw;
+  }
   page->pin_count_++;
   page->page_id_ = pageid;
-  page->is_dirty_ = false;
   replacer_->Pin(frame_id);
   page_table_[pageid] = frame_id;
 
-  disk_manager_->WritePage(pageid, page->GetData());
-
   *page_id = pageid;
 
   latch_.unlock();
@@ -171,27 +183,14 @@ Page *BufferPoolManagerInstance::FetchPgImp(page_id_t page_id) {
   }
 
   frame_id_t frame_id = -1;
-  if (!free_list_.empty()) {
-    frame_id = free_list_.front();
-    free_list_.pop_front();
-  } else if (replacer_->Victim(&frame_id)) {
-    page_id_t replacepage = -1;
-    for (auto &&p : page_table_) {
-      if (p.second == frame_id) {
-        replacepage = p.first;
-        break;
-      }
-    }
-
-    if (replacepage != -1) {
-      auto page = &pages_[frame_id];
-      if (page->IsDirty()) {
-        disk_manager_->WritePage(replacepage, page->GetData());
-        page->pin_count_ = 0;
-        page->is_dirty_ = false;
-      }
-    }
-  } else {
+  bool found;
+  try {
+    found = FindFrame(&frame_id);
+  } catch (Exception &e) {
+    latch_.unlock();
+    throw;
+  }
+  if (!found) {
     latch_.unlock();
     return nullptr;
   }
@@ -201,7 +200,17 @@ Page *BufferPoolManagerInstance::FetchPgImp(page_id_t page_id) {
   page->pin_count_++;
   page->page_id_ = page_id;
   page->is_dirty_ = false;
-  disk_manager_->ReadPage(page_id, page->data_);
+  try {
+    disk_manager_->ReadPage(page_id, page->data_);
+  } catch (Exception &e) {
+    // e.g. a checksum mismatch: the frame holds no page now, give it back instead of leaving it half-mapped
+    page->ResetMemory();
+    page->pin_count_ = 0;
+    page->page_id_ = INVALID_PAGE_ID;
+    free_list_.push_back(frame_id);
+    latch_.unlock();
+    throw;
+  }
   replacer_->Pin(frame_id);
   page_table_[page_id] = frame_id;
 
@@ -233,7 +242,12 @@ bool BufferPoolManagerInstance::DeletePgImp(page_id_t page_id) {
   }
 
   if (page->IsDirty()) {
-    disk_manager_->WritePage(page_id, page->GetData());
+    try {
+      disk_manager_->WritePage(page_id, page->GetData());
+    } catch (Exception &e) {
+      latch_.unlock();
+      throw;
+    }
   }
 
   DeallocatePage(page_id);
@@ -280,6 +294,32 @@ bool BufferPoolManagerInstance::UnpinPgImp(page_id_t page_id, bool is_dirty) {
   return true;
 }
 
+/*
+ * Called with latch_ held. A dirty victim is written back first; if that fails, e.g. on a read-only disk manager, the
+ * victim stays in its frame and in the replacer, and the exception is passed on.
+ */
+bool BufferPoolManagerInstance::FindFrame(frame_id_t *frame_id) {
+  if (!free_list_.empty()) {
+    *frame_id = free_list_.front();
+    free_list_.pop_front();
+    return true;
+  }
+  if (!replacer_->Victim(frame_id)) {
+    return false;
+  }
+  auto page = &pages_[*frame_id];
+  if (page->IsDirty()) {
+    try {
+      disk_manager_->WritePage(page->GetPageId(), page->GetData());
+    } catch (Exception &e) {
+      replacer_->Unpin(*frame_id);
+      throw;
+    }
+    page->is_dirty_ = false;
+  }
+  return true;
+}
+
 page_id_t BufferPoolManagerInstance::AllocatePage() {
   const page_id_t next_page_id = next_page_id_;
   next_page_id_ += num_instances_;
@@ -15,8 +15,8 @@
 
 namespace bustub {
 
-ParallelBufferPoolManager::ParallelBufferPoolManager(size_t num_instances, size_t pool_size, DiskManager *disk_manager,
-                                                     LogManager *log_manager)
+ParallelBufferPoolManager::ParallelBufferPoolManager(size_t num_instances, size_t pool_size,
+                                                     DiskInterface *disk_manager, LogManager *log_manager)
     : num_instances_(num_instances), instances_index_(0) {
   // Allocate and create individual BufferPoolManagerInstances
   for (size_t i = 0; i < num_instances_; i++) {
@@ -0,0 +1,326 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// crc32c_util.cpp
+//
+// Identification: src/common/util/crc32c_util.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <array>
+#include <cstring>
+
+#include "common/util/crc32c_util.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define BUSTUB_CRC32C_HARDWARE
+#define BUSTUB_CRC32C_FOLD
+#define BUSTUB_CRC32C_TARGET __attribute__((target("sse4.2")))
+#define BUSTUB_CRC32C_FOLD_TARGET __attribute__((target("sse4.2,pclmul,avx2,vpclmulqdq")))
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#define BUSTUB_CRC32C_HARDWARE
+#define BUSTUB_CRC32C_TARGET
+#endif
+
+namespace bustub {
+
+namespace {
+
+/** CRC32C polynomial, bit-reflected. */
+constexpr uint32_t CRC32C_POLY = 0x82F63B78;
+
+using Crc32cTables = std::array<std::array<uint32_t, 256>, 8>;
+
+/** tables[k][b] is the register update for byte b followed by k zero bytes. */
+constexpr Crc32cTables MakeTables() {
+  Crc32cTables tables{};
+  for (uint32_t i = 0; i < 256; i++) {
+    uint32_t crc = i;
+    for (int bit = 0; bit < 8; bit++) {
+      crc = (crc & 1) != 0 ? (crc >> 1) ^ CRC32C_POLY : crc >> 1;
+    }
+    tables[0][i] = crc;
+  }
+  for (size_t k = 1; k < 8; k++) {
+    for (uint32_t i = 0; i < 256; i++) {
+      tables[k][i] = (tables[k - 1][i] >> 8) ^ tables[0][tables[k - 1][i] & 0xFF];
+    }
+  }
+  return tables;
+}
+
+constexpr Crc32cTables CRC32C_TABLES = MakeTables();
+
+/** Advance the (non-inverted) CRC register over the given bytes, eight bytes per step. */
+uint32_t ExtendPortable(uint32_t crc, const char *data, size_t size) {
+  const auto *p = reinterpret_cast<const uint8_t *>(data);
+  const auto &t = CRC32C_TABLES;
+  while (size >= 8) {
+    uint32_t lo = crc ^ (static_cast<uint32_t>(p[0]) | static_cast<uint32_t>(p[1]) << 8 |
+                         static_cast<uint32_t>(p[2]) << 16 | static_cast<uint32_t>(p[3]) << 24);
+    crc = t[7][lo & 0xFF] ^ t[6][(lo >> 8) & 0xFF] ^ t[5][(lo >> 16) & 0xFF] ^ t[4][lo >> 24] ^ t[3][p[4]] ^
+          t[2][p[5]] ^ t[1][p[6]] ^ t[0][p[7]];
+    p += 8;
+    size -= 8;
+  }
+  while (size > 0) {
+    crc = (crc >> 8) ^ t[0][(crc ^ *p) & 0xFF];
+    p++;
+    size--;
+  }
+  return crc;
+}
+
+#ifdef BUSTUB_CRC32C_HARDWARE
+
+/** Bytes per stream in the interleaved loop; three streams cover a 4 KiB page in one iteration. */
+constexpr size_t STREAM_SIZE = 1360;
+
+/** @return a * b mod P in the reflected representation; a must be non-zero */
+constexpr uint32_t MultiplyModP(uint32_t a, uint32_t b) {
+  uint32_t m = 1U << 31;
+  uint32_t product = 0;
+  while (true) {
+    if ((a & m) != 0) {
+      product ^= b;
+      if ((a & (m - 1)) == 0) {
+        break;
+      }
+    }
+    m >>= 1;
+    b = (b & 1) != 0 ? (b >> 1) ^ CRC32C_POLY : b >> 1;
+  }
+  return product;
+}
+
+/** @return x^(8 * bytes) mod P, i.e. the multiplier that advances a CRC register over that many zero bytes */
+constexpr uint32_t ZeroBytesMultiplier(size_t bytes) {
+  uint32_t crc = 0x80000000;  // x^0 in the reflected representation
+  for (size_t i = 0; i < 8 * bytes; i++) {
+    crc = (crc & 1) != 0 ? (crc >> 1) ^ CRC32C_POLY : crc >> 1;
+  }
+  return crc;
+}
+
+using ShiftTables = std::array<std::array<uint32_t, 256>, 4>;
+
+/**
+ * Multiplying by a constant is linear, so advancing a register over STREAM_SIZE zero bytes is the xor of one table
+ * lookup per register byte.
+ */
+constexpr ShiftTables MakeShiftTables() {
+  uint32_t multiplier = ZeroBytesMultiplier(STREAM_SIZE);
+  ShiftTables tables{};
+  for (size_t k = 0; k < 4; k++) {
+    for (uint32_t i = 0; i < 256; i++) {
+      tables[k][i] = MultiplyModP(multiplier, i << (8 * k));
+    }
+  }
+  return tables;
+}
+
+constexpr ShiftTables STREAM_SHIFT_TABLES = MakeShiftTables();
+
+/** @return the register advanced over STREAM_SIZE zero bytes */
+inline uint32_t ShiftStream(uint32_t crc) {
+  const auto &t = STREAM_SHIFT_TABLES;
+  return t[0][crc & 0xFF] ^ t[1][(crc >> 8) & 0xFF] ^ t[2][(crc >> 16) & 0xFF] ^ t[3][crc >> 24];
+}
+
+inline uint64_t Load64(const char *p) {
+  uint64_t value;
+  memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+#if defined(__x86_64__)
+BUSTUB_CRC32C_TARGET inline uint64_t HardwareCrc64(uint64_t crc, uint64_t value) { return _mm_crc32_u64(crc, value); }
+BUSTUB_CRC32C_TARGET inline uint32_t HardwareCrc8(uint32_t crc, uint8_t value) { return _mm_crc32_u8(crc, value); }
+bool DetectHardware() {
+  // may run before the constructor that initializes the cpu model
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("sse4.2");
+}
+#else
+BUSTUB_CRC32C_TARGET inline uint64_t HardwareCrc64(uint64_t crc, uint64_t value) {
+  return __crc32cd(static_cast<uint32_t>(crc), value);
+}
+BUSTUB_CRC32C_TARGET inline uint32_t HardwareCrc8(uint32_t crc, uint8_t value) { return __crc32cb(crc, value); }
+bool DetectHardware() { return true; }
+#endif
+
+/** Advance the (non-inverted) CRC register over the given bytes with CRC instructions. */
+BUSTUB_CRC32C_TARGET uint32_t ExtendHardware(uint32_t crc, const char *data, size_t size) {
+  while (size >= 3 * STREAM_SIZE) {
+    // three independent dependency chains keep the crc unit busy
+    uint64_t crc0 = crc;
+    uint64_t crc1 = 0;
+    uint64_t crc2 = 0;
+    for (size_t i = 0; i < STREAM_SIZE; i += 8) {
+      crc0 = HardwareCrc64(crc0, Load64(data + i));
+      crc1 = HardwareCrc64(crc1, Load64(data + STREAM_SIZE + i));
+      crc2 = HardwareCrc64(crc2, Load64(data + 2 * STREAM_SIZE + i));
+    }
+    // crc(A || B) = crc(A) shifted over |B| zero bytes ^ crc(B) started from zero
+    crc = ShiftStream(static_cast<uint32_t>(crc0)) ^ static_cast<uint32_t>(crc1);
+    crc = ShiftStream(crc) ^ static_cast<uint32_t>(crc2);
+    data += 3 * STREAM_SIZE;
+    size -= 3 * STREAM_SIZE;
+  }
+  uint64_t crc64 = crc;
+  while (size >= 8) {
+    crc64 = HardwareCrc64(crc64, Load64(data));
+    data += 8;
+    size -= 8;
+  }
+  crc = static_cast<uint32_t>(crc64);
+  while (size > 0) {
+    crc = HardwareCrc8(crc, static_cast<uint8_t>(*data));
+    data++;
+    size--;
+  }
+  return crc;
+}
+
+const bool HAS_HARDWARE_CRC32C = DetectHardware();
+
+#ifdef BUSTUB_CRC32C_FOLD
+
+/**
+ * Bytes folded per iteration of the main loop: four 256-bit registers. Staying below 512 bits keeps the fold on AVX2
+ * machines and clear of the frequency drop some CPUs take for 512-bit instructions.
+ */
+constexpr size_t FOLD_BLOCK_SIZE = 128;
+
+/**
+ * @return the carry-less multiplier that moves 64 bits of the register forward over the given number of bytes: the
+ * reflected x^(8 * bytes) mod P, shifted left by one because a reflected carry-less product comes out one bit short.
+ */
+constexpr uint64_t FoldConstant(size_t bytes) { return static_cast<uint64_t>(ZeroBytesMultiplier(bytes)) << 1; }
+
+/**
+ * @return the multipliers for a 128-bit lane that is folded forward by DISTANCE bytes. The low half of the lane is
+ * the earlier one in the reflected order, so it moves 32 bits further; its multiplier goes in the high half, because
+ * Fold128() multiplies each half of the lane by the opposite half of the multipliers.
+ */
+template <size_t DISTANCE>
+BUSTUB_CRC32C_FOLD_TARGET inline __m128i FoldConstants() {
+  constexpr uint64_t FOR_LOW = FoldConstant(DISTANCE + 4);
+  constexpr uint64_t FOR_HIGH = FoldConstant(DISTANCE - 4);
+  return _mm_set_epi64x(FOR_LOW, FOR_HIGH);
+}
+
+/** FoldConstants() in both lanes of a 256-bit register. */
+template <size_t DISTANCE>
+BUSTUB_CRC32C_FOLD_TARGET inline __m256i FoldConstants256() {
+  constexpr uint64_t FOR_LOW = FoldConstant(DISTANCE + 4);
+  constexpr uint64_t FOR_HIGH = FoldConstant(DISTANCE - 4);
+  return _mm256_set_epi64x(FOR_LOW, FOR_HIGH, FOR_LOW, FOR_HIGH);
+}
+
+BUSTUB_CRC32C_FOLD_TARGET inline __m128i Fold128(__m128i x, __m128i k) {
+  return _mm_xor_si128(_mm_clmulepi64_si128(x, k, 0x01), _mm_clmulepi64_si128(x, k, 0x10));
+}
+
+/** @return each 128-bit lane of x folded forward and added to the lane of data it lands on */
+BUSTUB_CRC32C_FOLD_TARGET inline __m256i Fold256(__m256i x, __m256i k, __m256i data) {
+  return _mm256_xor_si256(_mm256_xor_si256(_mm256_clmulepi64_epi128(x, k, 0x01), _mm256_clmulepi64_epi128(x, k, 0x10)),
+                          data);
+}
+
+BUSTUB_CRC32C_FOLD_TARGET inline __m256i Load256(const char *data) {
+  return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data));
+}
+
+/**
+ * Advance the (non-inverted) CRC register over at least FOLD_BLOCK_SIZE bytes by folding with carry-less
+ * multiplication: the register is added into the first bytes, then 8 lanes of 128 bits run down the buffer, each
+ * multiplied forward onto the data FOLD_BLOCK_SIZE bytes later. This takes the crc unit out of the loop, and
+ * vpclmulqdq works on two lanes per instruction. The lanes are folded into one at the end, whose 16 bytes have the
+ * same CRC as everything before them, so the crc32 instruction finishes the job.
+ */
+BUSTUB_CRC32C_FOLD_TARGET uint32_t ExtendFold(uint32_t crc, const char *data, size_t size) {
+  __m256i y0 = Load256(data);
+  __m256i y1 = Load256(data + 32);
+  __m256i y2 = Load256(data + 64);
+  __m256i y3 = Load256(data + 96);
+  y0 = _mm256_xor_si256(y0, _mm256_zextsi128_si256(_mm_cvtsi32_si128(static_cast<int>(crc))));
+  data += FOLD_BLOCK_SIZE;
+  size -= FOLD_BLOCK_SIZE;
+
+  const __m256i k_block = FoldConstants256<FOLD_BLOCK_SIZE>();
+  while (size >= FOLD_BLOCK_SIZE) {
+    y0 = Fold256(y0, k_block, Load256(data));
+    y1 = Fold256(y1, k_block, Load256(data + 32));
+    y2 = Fold256(y2, k_block, Load256(data + 64));
+    y3 = Fold256(y3, k_block, Load256(data + 96));
+    data += FOLD_BLOCK_SIZE;
+    size -= FOLD_BLOCK_SIZE;
+  }
+
+  // four registers into one, then its low lane into the high one
+  const __m256i k_register = FoldConstants256<32>();
+  y1 = Fold256(y0, k_register, y1);
+  y2 = Fold256(y1, k_register, y2);
+  y3 = Fold256(y2, k_register, y3);
+  __m128i x = _mm_xor_si128(_mm256_extracti128_si256(y3, 1),
+                            Fold128(_mm256_castsi256_si128(y3), FoldConstants<16>()));
+  // the compiler leaves this out when the function ends in a tail call, and dirty upper halves slow down every SSE
+  // instruction that runs after it, e.g. the next memcpy
+  _mm256_zeroupper();
+
+  const __m128i k_lane = FoldConstants<16>();
+  while (size >= 16) {
+    x = _mm_xor_si128(Fold128(x, k_lane), _mm_loadu_si128(reinterpret_cast<const __m128i *>(data)));
+    data += 16;
+    size -= 16;
+  }
+  uint64_t crc64 = _mm_crc32_u64(0, static_cast<uint64_t>(_mm_cvtsi128_si64(x)));
+  crc64 = _mm_crc32_u64(crc64, static_cast<uint64_t>(_mm_extract_epi64(x, 1)));
+  return ExtendHardware(static_cast<uint32_t>(crc64), data, size);
+}
+
+bool DetectFold() {
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("sse4.2") && __builtin_cpu_supports("pclmul") && __builtin_cpu_supports("avx2") &&
+         __builtin_cpu_supports("vpclmulqdq");
+}
+
+const bool HAS_FOLD_CRC32C = DetectFold();
+
+#endif
+
+#else
+
+const bool HAS_HARDWARE_CRC32C = false;
+
+#endif
+
+}  // namespace
+
+uint32_t Crc32cUtil::Crc32c(const char *data, size_t size, uint32_t crc) {
+#ifdef BUSTUB_CRC32C_HARDWARE
+#ifdef BUSTUB_CRC32C_FOLD
+  if (HAS_FOLD_CRC32C && size >= FOLD_BLOCK_SIZE) {
+    return ~ExtendFold(~crc, data, size);
+  }
+#endif
+  if (HAS_HARDWARE_CRC32C) {
+    return ~ExtendHardware(~crc, data, size);
+  }
+#endif
+  return ~ExtendPortable(~crc, data, size);
+}
+
+uint32_t Crc32cUtil::Crc32cPortable(const char *data, size_t size, uint32_t crc) {
+  return ~ExtendPortable(~crc, data, size);
+}
+
+bool Crc32cUtil::IsHardwareAccelerated() { return HAS_HARDWARE_CRC32C; }
+
+}  // namespace bustub
@@ -10,8 +10,11 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
+#include <atomic>
 #include <iostream>
 #include <string>
+#include <thread>  // NOLINT
 #include <utility>
 #include <vector>
 
@@ -24,21 +27,14 @@ namespace bustub {
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 HASH_TABLE_TYPE::ExtendibleHashTable(const std::string &name, BufferPoolManager *buffer_pool_manager,
-                                     const KeyComparator &comparator, HashFunction<KeyType> hash_fn)
+                                     const KeyComparator &comparator, HashFunction<KeyType> hash_fn,
+                                     uint32_t root_depth)
     : buffer_pool_manager_(buffer_pool_manager), comparator_(comparator), hash_fn_(std::move(hash_fn)) {
-  //  implement me!
-  auto *dirpage = buffer_pool_manager_->NewPage(&directory_page_id_);
-  page_id_t bucket_page = 0;
-  buffer_pool_manager_->NewPage(&bucket_page);
-  HashTableDirectoryPage *dir_page = reinterpret_cast<HashTableDirectoryPage *>(dirpage->GetData());
-  dir_page->SetPageId(directory_page_id_);
-  dir_page->SetLSN(0);
-  dir_page->SetBucketPageId(0, bucket_page);
-
-  dir_page->VerifyIntegrity();
-
-  buffer_pool_manager_->UnpinPage(directory_page_id_, false);
-  buffer_pool_manager_->UnpinPage(bucket_page, false);
+  // directory pages are allocated lazily by the first insert into them
+  auto *page = buffer_pool_manager_->NewPage(&root_page_id_);
+  auto *root_page = reinterpret_cast<HashTableRootPage *>(page->GetData());
+  root_page->Init(root_page_id_, root_depth);
+  buffer_pool_manager_->UnpinPage(root_page_id_, true);
 }
 
 /*****************************************************************************
@@ -56,6 +52,12 @@ uint32_t HASH_TABLE_TYPE::Hash(KeyType key) {
   return static_cast<uint32_t>(hash_fn_.GetHash(key));
 }
 
+template <typename KeyType, typename ValueType, typename KeyComparator>
+inline uint8_t HASH_TABLE_TYPE::HashToFingerprint(uint32_t hash) {
+  // a directory uses at most the low 9 bits, the root at most the high 9
+  return static_cast<uint8_t>(hash >> 9);
+}
+
 template <typename KeyType, typename ValueType, typename KeyComparator>
 inline uint32_t HASH_TABLE_TYPE::KeyToDirectoryIndex(KeyType key, HashTableDirectoryPage *dir_page) {
   return Hash(key) & dir_page->GetGlobalDepthMask();
@@ -67,8 +69,21 @@ inline uint32_t HASH_TABLE_TYPE::KeyToPageId(KeyType key, HashTableDirectoryPage
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
-HashTableDirectoryPage *HASH_TABLE_TYPE::FetchDirectoryPage() {
-  return reinterpret_cast<HashTableDirectoryPage *>(buffer_pool_manager_->FetchPage(directory_page_id_)->GetData());
+page_id_t HASH_TABLE_TYPE::KeyToDirectoryPageId(KeyType key) {
+  auto *root_page = FetchRootPage();
+  page_id_t directory_page_id = root_page->GetDirectoryPageId(root_page->HashToDirectoryIndex(Hash(key)));
+  buffer_pool_manager_->UnpinPage(root_page_id_, false);
+  return directory_page_id;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+HashTableRootPage *HASH_TABLE_TYPE::FetchRootPage() {
+  return reinterpret_cast<HashTableRootPage *>(buffer_pool_manager_->FetchPage(root_page_id_)->GetData());
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+HashTableDirectoryPage *HASH_TABLE_TYPE::FetchDirectoryPage(page_id_t directory_page_id) {
+  return reinterpret_cast<HashTableDirectoryPage *>(buffer_pool_manager_->FetchPage(directory_page_id)->GetData());
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
@@ -76,137 +91,543 @@ HASH_TABLE_BUCKET_TYPE *HASH_TABLE_TYPE::FetchBucketPage(page_id_t bucket_page_i
   return reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(buffer_pool_manager_->FetchPage(bucket_page_id)->GetData());
 }
 
+template <typename KeyType, typename ValueType, typename KeyComparator>
+page_id_t HASH_TABLE_TYPE::CreateDirectoryPage(KeyType key) {
+  page_id_t directory_page_id = INVALID_PAGE_ID;
+  page_id_t bucket_page_id = INVALID_PAGE_ID;
+  Page *page = buffer_pool_manager_->NewPage(&directory_page_id);
+  if (page == nullptr) {
+    return INVALID_PAGE_ID;
+  }
+  if (buffer_pool_manager_->NewPage(&bucket_page_id) == nullptr) {
+    buffer_pool_manager_->UnpinPage(directory_page_id, false);
+    buffer_pool_manager_->DeletePage(directory_page_id);
+    return INVALID_PAGE_ID;
+  }
+
+  auto *dir_page = reinterpret_cast<HashTableDirectoryPage *>(page->GetData());
+  dir_page->SetPageId(directory_page_id);
+  dir_page->SetLSN(0);
+  dir_page->SetBucketPageId(0, bucket_page_id);
+  buffer_pool_manager_->UnpinPage(bucket_page_id, true);
+  buffer_pool_manager_->UnpinPage(directory_page_id, true);
+
+  auto *root_page = FetchRootPage();
+  root_page->SetDirectoryPageId(root_page->HashToDirectoryIndex(Hash(key)), directory_page_id);
+  buffer_pool_manager_->UnpinPage(root_page_id_, true);
+  return directory_page_id;
+}
+
 /*****************************************************************************
  * SEARCH
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
 bool HASH_TABLE_TYPE::GetValue(Transaction *transaction, const KeyType &key, std::vector<ValueType> *result) {
   table_latch_.RLock();
+  auto directory_page_id = KeyToDirectoryPageId(key);
+  if (directory_page_id == INVALID_PAGE_ID) {
+    table_latch_.RUnlock();
+    return false;
+  }
 
-  auto page_id = KeyToPageId(key, FetchDirectoryPage());
-  auto *bucket_page = FetchBucketPage(page_id);
-  bool result_bool = bucket_page->GetValue(key, comparator_, result);
+  auto page_id = KeyToPageId(key, FetchDirectoryPage(directory_page_id));
+  Page *page = buffer_pool_manager_->FetchPage(page_id);
+  auto *bucket_page = reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(page->GetData());
+  page->RLatch();
+  bool result_bool = bucket_page->GetValue(key, HashToFingerprint(Hash(key)), comparator_, result);
+  page->RUnlatch();
 
-  buffer_pool_manager_->UnpinPage(directory_page_id_, false);
+  buffer_pool_manager_->UnpinPage(directory_page_id, false);
   buffer_pool_manager_->UnpinPage(page_id, false);
   table_latch_.RUnlock();
   return result_bool;
 }
 
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void HASH_TABLE_TYPE::GetValues(Transaction *transaction, const std::vector<KeyType> &keys,
+                                std::vector<std::vector<ValueType>> *results) {
+  struct Probe {
+    page_id_t page_id_;
+    uint32_t hash_;
+    size_t key_idx_;
+  };
+  auto by_page_id = [](const Probe &a, const Probe &b) { return a.page_id_ < b.page_id_; };
+
+  results->assign(keys.size(), {});
+  std::vector<Probe> probes;
+  probes.reserve(keys.size());
+
+  table_latch_.RLock();
+
+  // hash every key once and find its directory page
+  auto *root_page = FetchRootPage();
+  for (size_t i = 0; i < keys.size(); i++) {
+    uint32_t hash = Hash(keys[i]);
+    page_id_t directory_page_id = root_page->GetDirectoryPageId(root_page->HashToDirectoryIndex(hash));
+    if (directory_page_id != INVALID_PAGE_ID) {
+      probes.push_back({directory_page_id, hash, i});
+    }
+  }
+  buffer_pool_manager_->UnpinPage(root_page_id_, false);
+
+  // replace the directory page by the bucket page, fetching each directory once. The directories cannot change
+  // while we hold the table latch, so the bucket page ids stay valid after they are unpinned.
+  std::sort(probes.begin(), probes.end(), by_page_id);
+  for (size_t begin = 0, end = 0; begin < probes.size(); begin = end) {
+    page_id_t directory_page_id = probes[begin].page_id_;
+    auto *dir_page = FetchDirectoryPage(directory_page_id);
+    for (end = begin; end < probes.size() && probes[end].page_id_ == directory_page_id; end++) {
+      probes[end].page_id_ = dir_page->GetBucketPageId(probes[end].hash_ & dir_page->GetGlobalDepthMask());
+    }
+    buffer_pool_manager_->UnpinPage(directory_page_id, false);
+  }
+  std::sort(probes.begin(), probes.end(), by_page_id);
+
+  Page *page = probes.empty() ? nullptr : buffer_pool_manager_->FetchPage(probes[0].page_id_);
+  for (size_t begin = 0, end = 0; begin < probes.size(); begin = end) {
+    end = begin;
+    while (end < probes.size() && probes[end].page_id_ == probes[begin].page_id_) {
+      end++;
+    }
+
+    // pin the next bucket and start pulling its metadata into the cache before probing this one
+    Page *next_page = end < probes.size() ? buffer_pool_manager_->FetchPage(probes[end].page_id_) : nullptr;
+    if (next_page != nullptr) {
+      reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(next_page->GetData())->Prefetch();
+    }
+
+    auto *bucket_page = reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(page->GetData());
+    page->RLatch();
+    for (size_t i = begin; i < end; i++) {
+      const Probe &probe = probes[i];
+      bucket_page->GetValue(keys[probe.key_idx_], HashToFingerprint(probe.hash_), comparator_,
+                            &(*results)[probe.key_idx_]);
+    }
+    page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(probes[begin].page_id_, false);
+    page = next_page;
+  }
+
+  table_latch_.RUnlock();
+}
+
 /*****************************************************************************
  * INSERTION
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
 bool HASH_TABLE_TYPE::Insert(Transaction *transaction, const KeyType &key, const ValueType &value) {
-  table_latch_.WLock();
-  auto bucket_page_id = KeyToPageId(key, FetchDirectoryPage());
-  auto *bucket_page = FetchBucketPage(bucket_page_id);
-  bool result;
-
-  if (bucket_page->IsFull()) {
-    table_latch_.WUnlock();
-    result = SplitInsert(transaction, key, value);
-    table_latch_.WLock();
-  } else {
-    result = bucket_page->Insert(key, value, comparator_);
+  // the directory cannot change while we hold the table latch in read mode, so only the bucket needs latching
+  table_latch_.RLock();
+  auto directory_page_id = KeyToDirectoryPageId(key);
+  if (directory_page_id == INVALID_PAGE_ID) {
+    // the first key of this directory, allocating it changes the root
+    table_latch_.RUnlock();
+    return SplitInsert(transaction, key, value);
   }
 
-  buffer_pool_manager_->UnpinPage(directory_page_id_, false);
-  buffer_pool_manager_->UnpinPage(bucket_page_id, true);
-  table_latch_.WUnlock();
+  auto bucket_page_id = KeyToPageId(key, FetchDirectoryPage(directory_page_id));
+  Page *page = buffer_pool_manager_->FetchPage(bucket_page_id);
+  auto *bucket_page = reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(page->GetData());
+
+  page->WLatch();
+  bool is_full = bucket_page->IsFull();
+  bool result = !is_full && bucket_page->Insert(key, value, HashToFingerprint(Hash(key)), comparator_);
+  page->WUnlatch();
+
+  buffer_pool_manager_->UnpinPage(directory_page_id, false);
+  buffer_pool_manager_->UnpinPage(bucket_page_id, result);
+  table_latch_.RUnlock();
+
+  if (is_full) {
+    return SplitInsert(transaction, key, value);
+  }
   return result;
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 bool HASH_TABLE_TYPE::SplitInsert(Transaction *transaction, const KeyType &key, const ValueType &value) {
+  // splits change the directory, which needs the table latch in write mode. Holding it also excludes every other
+  // operation, so bucket pages need no latches from here on.
   table_latch_.WLock();
 
-  bool result_bool = false;
-
-  auto *dir_pag = FetchDirectoryPage();
-  auto bucket_page_id = KeyToPageId(key, dir_pag);
-  auto *bucket_page = FetchBucketPage(bucket_page_id);
+  auto directory_page_id = KeyToDirectoryPageId(key);
+  if (directory_page_id == INVALID_PAGE_ID) {
+    directory_page_id = CreateDirectoryPage(key);
+    if (directory_page_id == INVALID_PAGE_ID) {
+      table_latch_.WUnlock();
+      return false;
+    }
+  }
 
-  if (bucket_page->IsFull()) {
-    auto index = KeyToDirectoryIndex(key, dir_pag);
+  auto *dir_page = FetchDirectoryPage(directory_page_id);
+  bool dir_dirty = false;
+  bool result = false;
+
+  // another thread may have split the bucket while we were waiting for the latch, and all entries of a split bucket
+  // may end up on the key's side, so retry until the key's bucket has room
+  while (true) {
+    auto bucket_idx = KeyToDirectoryIndex(key, dir_page);
+    auto bucket_page_id = dir_page->GetBucketPageId(bucket_idx);
+    auto *bucket_page = FetchBucketPage(bucket_page_id);
+
+    if (!bucket_page->IsFull()) {
+      result = bucket_page->Insert(key, value, HashToFingerprint(Hash(key)), comparator_);
+      buffer_pool_manager_->UnpinPage(bucket_page_id, result);
+      break;
+    }
 
-    dir_pag->IncrLocalDepth(index);
-    auto newindex = dir_pag->GetSplitImageIndex(index);
+    // a duplicate pair is rejected no matter how often the bucket is split
+    std::vector<ValueType> values;
+    bucket_page->GetValue(key, HashToFingerprint(Hash(key)), comparator_, &values);
+    if (std::find(values.begin(), values.end(), value) != values.end()) {
+      buffer_pool_manager_->UnpinPage(bucket_page_id, false);
+      break;
+    }
 
-    if (dir_pag->GetLocalDepth(index) > dir_pag->GetGlobalDepth()) {
-      dir_pag->IncrGlobalDepth();
-    } else {
-      dir_pag->IncrLocalDepth(newindex);
+    // the directory is as large as it gets, so split it across the root instead and retry in the key's half
+    uint32_t local_depth = dir_page->GetLocalDepth(bucket_idx);
+    if (local_depth == dir_page->GetGlobalDepth() && 2 * dir_page->Size() > DIRECTORY_ARRAY_SIZE) {
+      bool split = CanSplitDirectory(key, bucket_page);
+      buffer_pool_manager_->UnpinPage(bucket_page_id, false);
+      buffer_pool_manager_->UnpinPage(directory_page_id, dir_dirty);
+      dir_dirty = false;
+      if (!split || !SplitDirectory(key)) {
+        table_latch_.WUnlock();
+        return false;
+      }
+      directory_page_id = KeyToDirectoryPageId(key);
+      dir_page = FetchDirectoryPage(directory_page_id);
+      continue;
     }
 
-    page_id_t bucket_pageid = 0;
-    buffer_pool_manager_->NewPage(&bucket_pageid);
-    dir_pag->SetBucketPageId(newindex, bucket_pageid);
+    page_id_t image_page_id = INVALID_PAGE_ID;
+    Page *image_page = buffer_pool_manager_->NewPage(&image_page_id);
+    if (image_page == nullptr) {
+      buffer_pool_manager_->UnpinPage(bucket_page_id, false);
+      break;
+    }
+    auto *image_bucket_page = reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(image_page->GetData());
 
-    std::vector<MappingType> bucket_values;
-    bucket_page->GetAllValue(&bucket_values);
-    bucket_page->Clear();
-    for (auto &&v : bucket_values) {
-      table_latch_.WUnlock();
-      Insert(transaction, v.first, v.second);
-      table_latch_.WLock();
+    if (local_depth == dir_page->GetGlobalDepth()) {
+      dir_page->IncrGlobalDepth();
     }
 
-    table_latch_.WUnlock();
-    result_bool = Insert(transaction, key, value);
-    table_latch_.WLock();
+    dir_page->SplitBucket(bucket_idx, image_page_id);
+    dir_dirty = true;
+
+    // partition in place: entries with the new hash bit set move to the front of the empty image, the rest stay put
+    uint32_t high_bit = 1U << local_depth;
+    uint32_t image_idx = 0;
+    for (uint32_t i = 0; i < BUCKET_ARRAY_SIZE && bucket_page->IsOccupied(i); i++) {
+      if (bucket_page->IsReadable(i) && (Hash(bucket_page->KeyAt(i)) & high_bit) != 0) {
+        image_bucket_page->InsertAt(image_idx++, bucket_page->KeyAt(i), bucket_page->ValueAt(i),
+                                    bucket_page->FingerprintAt(i));
+        bucket_page->RemoveAt(i);
+      }
+    }
 
-    buffer_pool_manager_->UnpinPage(directory_page_id_, true);
-    buffer_pool_manager_->UnpinPage(bucket_pageid, true);
-  } else {
-    result_bool = bucket_page->Insert(key, value, comparator_);
-    buffer_pool_manager_->UnpinPage(directory_page_id_, false);
+    buffer_pool_manager_->UnpinPage(bucket_page_id, true);
+    buffer_pool_manager_->UnpinPage(image_page_id, true);
   }
-  buffer_pool_manager_->UnpinPage(bucket_page_id, true);
+
+  buffer_pool_manager_->UnpinPage(directory_page_id, dir_dirty);
   table_latch_.WUnlock();
-  return result_bool;
+  return result;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool HASH_TABLE_TYPE::CanSplitDirectory(KeyType key, HASH_TABLE_BUCKET_TYPE *bucket_page) {
+  // the root can tell apart at most the top ROOT_MAX_DEPTH bits, e.g. the values of a single key share all of them
+  uint32_t prefix = Hash(key) >> (32 - ROOT_MAX_DEPTH);
+  for (uint32_t i = 0; i < BUCKET_ARRAY_SIZE && bucket_page->IsOccupied(i); i++) {
+    if (bucket_page->IsReadable(i) && Hash(bucket_page->KeyAt(i)) >> (32 - ROOT_MAX_DEPTH) != prefix) {
+      return true;
+    }
+  }
+  return false;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool HASH_TABLE_TYPE::SplitDirectory(KeyType key) {
+  auto *root_page = FetchRootPage();
+  uint32_t root_idx = root_page->HashToDirectoryIndex(Hash(key));
+  page_id_t directory_page_id = root_page->GetDirectoryPageId(root_idx);
+  if (root_page->GetRunLength(root_idx) == 1) {
+    if (root_page->GetDepth() == ROOT_MAX_DEPTH) {
+      buffer_pool_manager_->UnpinPage(root_page_id_, false);
+      return false;
+    }
+    root_page->IncrDepth();
+    root_idx = root_page->HashToDirectoryIndex(Hash(key));
+  }
+  // the upper half of the run moves to the new directory
+  uint32_t image_start = root_page->GetRunStart(root_idx) + root_page->GetRunLength(root_idx) / 2;
+  auto *dir_page = FetchDirectoryPage(directory_page_id);
+
+  // allocate every page before moving anything, so that running out of frames leaves the table as it was
+  page_id_t image_directory_page_id = INVALID_PAGE_ID;
+  std::vector<page_id_t> image_page_ids(dir_page->Size(), INVALID_PAGE_ID);
+  auto give_up = [&]() {
+    for (auto page_id : image_page_ids) {
+      if (page_id != INVALID_PAGE_ID) {
+        buffer_pool_manager_->DeletePage(page_id);
+      }
+    }
+    if (image_directory_page_id != INVALID_PAGE_ID) {
+      buffer_pool_manager_->UnpinPage(image_directory_page_id, false);
+      buffer_pool_manager_->DeletePage(image_directory_page_id);
+    }
+    buffer_pool_manager_->UnpinPage(directory_page_id, false);
+    // doubling the root on its own changes no lookup, so it can stay
+    buffer_pool_manager_->UnpinPage(root_page_id_, true);
+    return false;
+  };
+  Page *page = buffer_pool_manager_->NewPage(&image_directory_page_id);
+  if (page == nullptr) {
+    image_directory_page_id = INVALID_PAGE_ID;
+    return give_up();
+  }
+  // a bucket is listed at every index that agrees with it on the low local depth bits, the first of them stands
+  // for it
+  for (uint32_t i = 0; i < dir_page->Size(); i++) {
+    if (i < (1U << dir_page->GetLocalDepth(i))) {
+      if (buffer_pool_manager_->NewPage(&image_page_ids[i]) == nullptr) {
+        image_page_ids[i] = INVALID_PAGE_ID;
+        return give_up();
+      }
+      buffer_pool_manager_->UnpinPage(image_page_ids[i], true);
+    }
+  }
+
+  // the new directory has the same shape, each bucket taking the entries of its twin that hash to the upper half
+  auto *image_dir_page = reinterpret_cast<HashTableDirectoryPage *>(page->GetData());
+  image_dir_page->SetPageId(image_directory_page_id);
+  image_dir_page->SetLSN(0);
+  for (uint32_t depth = 0; depth < dir_page->GetGlobalDepth(); depth++) {
+    image_dir_page->IncrGlobalDepth();
+  }
+  for (uint32_t i = 0; i < dir_page->Size(); i++) {
+    uint32_t local_depth = dir_page->GetLocalDepth(i);
+    image_dir_page->SetLocalDepth(i, local_depth);
+    image_dir_page->SetBucketPageId(i, image_page_ids[i & ((1U << local_depth) - 1)]);
+    if (i >= (1U << local_depth)) {
+      continue;
+    }
+
+    page_id_t bucket_page_id = dir_page->GetBucketPageId(i);
+    auto *bucket_page = FetchBucketPage(bucket_page_id);
+    auto *image_bucket_page = FetchBucketPage(image_page_ids[i]);
+    uint32_t image_idx = 0;
+    for (uint32_t j = 0; j < BUCKET_ARRAY_SIZE && bucket_page->IsOccupied(j); j++) {
+      if (bucket_page->IsReadable(j) && root_page->HashToDirectoryIndex(Hash(bucket_page->KeyAt(j))) >= image_start) {
+        image_bucket_page->InsertAt(image_idx++, bucket_page->KeyAt(j), bucket_page->ValueAt(j),
+                                    bucket_page->FingerprintAt(j));
+        bucket_page->RemoveAt(j);
+      }
+    }
+    buffer_pool_manager_->UnpinPage(bucket_page_id, image_idx > 0);
+    buffer_pool_manager_->UnpinPage(image_page_ids[i], image_idx > 0);
+  }
+
+  uint32_t image_end = root_page->GetRunStart(root_idx) + root_page->GetRunLength(root_idx);
+  for (uint32_t idx = image_start; idx < image_end; idx++) {
+    root_page->SetDirectoryPageId(idx, image_directory_page_id);
+  }
+  buffer_pool_manager_->UnpinPage(image_directory_page_id, true);
+  buffer_pool_manager_->UnpinPage(directory_page_id, false);
+  buffer_pool_manager_->UnpinPage(root_page_id_, true);
+  return true;
 }
 
 /*****************************************************************************
- * REMOVE
+ * BULK LOAD
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
-bool HASH_TABLE_TYPE::Remove(Transaction *transaction, const KeyType &key, const ValueType &value) {
+bool HASH_TABLE_TYPE::BulkLoad(Transaction *transaction, const std::vector<std::pair<KeyType, ValueType>> &entries,
+                               size_t num_threads) {
   table_latch_.WLock();
+  auto *root_page = FetchRootPage();
+  bool empty = true;
+  for (uint32_t i = 0; i < root_page->MaxSize() && empty; i++) {
+    empty = root_page->GetDirectoryPageId(i) == INVALID_PAGE_ID;
+  }
+  if (!empty) {
+    buffer_pool_manager_->UnpinPage(root_page_id_, false);
+    table_latch_.WUnlock();
+    bool loaded = true;
+    for (const auto &entry : entries) {
+      loaded = Insert(transaction, entry.first, entry.second) && loaded;
+    }
+    return loaded;
+  }
 
-  auto bucket_page_id = KeyToPageId(key, FetchDirectoryPage());
-  auto *bucket_page = FetchBucketPage(bucket_page_id);
+  // deepen the root until directories are at most half deep after the load, so they can keep splitting
+  const size_t bucket_fill = BUCKET_ARRAY_SIZE * BULK_FILL_FACTOR / 100;
+  const auto max_global_depth = static_cast<uint32_t>(__builtin_ctz(DIRECTORY_ARRAY_SIZE));
+  const size_t directory_fill = DIRECTORY_ARRAY_SIZE / 2 * bucket_fill;
+  uint32_t root_depth = root_page->GetDepth();
+  while (root_depth < ROOT_MAX_DEPTH && entries.size() > (size_t{1} << root_depth) * directory_fill) {
+    root_depth++;
+  }
+  root_page->Init(root_page_id_, root_depth);
 
-  if (!bucket_page->Remove(key, value, comparator_)) {
-    buffer_pool_manager_->UnpinPage(bucket_page_id, false);
-    buffer_pool_manager_->UnpinPage(directory_page_id_, false);
-    table_latch_.WUnlock();
+  std::vector<uint32_t> hashes(entries.size());
+  std::vector<size_t> directory_counts(root_page->MaxSize());
+  for (size_t i = 0; i < entries.size(); i++) {
+    hashes[i] = Hash(entries[i].first);
+    directory_counts[root_page->HashToDirectoryIndex(hashes[i])]++;
+  }
 
-    return false;
+  // every directory gets the smallest global depth that keeps its buckets at the fill factor, and one partition per
+  // bucket, numbered across directories
+  std::vector<uint32_t> global_depths(root_page->MaxSize());
+  std::vector<size_t> first_partitions(root_page->MaxSize() + 1);
+  for (uint32_t d = 0; d < root_page->MaxSize(); d++) {
+    while (global_depths[d] < max_global_depth && directory_counts[d] > (size_t{1} << global_depths[d]) * bucket_fill) {
+      global_depths[d]++;
+    }
+    first_partitions[d + 1] = first_partitions[d] + (size_t{1} << global_depths[d]);
   }
-  buffer_pool_manager_->UnpinPage(bucket_page_id, true);
-  buffer_pool_manager_->UnpinPage(directory_page_id_, false);
+  auto partition_of = [&](size_t i) {
+    uint32_t d = root_page->HashToDirectoryIndex(hashes[i]);
+    return first_partitions[d] + (hashes[i] & ((1U << global_depths[d]) - 1));
+  };
+
+  // counting sort of the entries by partition
+  std::vector<size_t> partition_offsets(first_partitions.back() + 1);
+  for (size_t i = 0; i < entries.size(); i++) {
+    partition_offsets[partition_of(i) + 1]++;
+  }
+  for (size_t p = 1; p < partition_offsets.size(); p++) {
+    partition_offsets[p] += partition_offsets[p - 1];
+  }
+  std::vector<size_t> next_offsets(partition_offsets.begin(), partition_offsets.end() - 1);
+  std::vector<uint32_t> order(entries.size());
+  for (size_t i = 0; i < entries.size(); i++) {
+    order[next_offsets[partition_of(i)]++] = static_cast<uint32_t>(i);
+  }
+
+  // directories share nothing but their slot in the root page, so threads can fill them independently
+  num_threads = std::clamp<size_t>(num_threads, 1, root_page->MaxSize());
+  std::vector<std::vector<uint32_t>> overflows(num_threads);
+  std::atomic<uint32_t> next_directory{0};
+  auto fill_directories = [&](size_t thread_idx) {
+    for (uint32_t d = next_directory++; d < root_page->MaxSize(); d = next_directory++) {
+      if (directory_counts[d] > 0) {
+        root_page->SetDirectoryPageId(d, BulkLoadDirectory(entries, hashes, order, partition_offsets,
+                                                           first_partitions[d], global_depths[d],
+                                                           &overflows[thread_idx]));
+      }
+    }
+  };
+  std::vector<std::thread> threads;
+  for (size_t t = 1; t < num_threads; t++) {
+    threads.emplace_back(fill_directories, t);
+  }
+  fill_directories(0);
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  buffer_pool_manager_->UnpinPage(root_page_id_, true);
   table_latch_.WUnlock();
-  if (bucket_page->IsEmpty()) {
-    Merge(transaction, key, value);
+
+  bool loaded = true;
+  for (const auto &overflow : overflows) {
+    for (auto i : overflow) {
+      loaded = Insert(transaction, entries[i].first, entries[i].second) && loaded;
+    }
   }
-  return true;
+  return loaded;
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
-void HASH_TABLE_TYPE::ChangeBucketDepth(uint32_t bucket_index, page_id_t bucket_page_id,
-                                        HashTableDirectoryPage *dir_page) {
-  uint32_t bucket_interval = 1 << (dir_page->GetGlobalDepth() - 1);
-
-  if (bucket_index + bucket_interval < dir_page->Size() &&
-      dir_page->GetBucketPageId(bucket_index) == dir_page->GetBucketPageId(bucket_index + bucket_interval)) {
-    dir_page->DecrLocalDepth(bucket_index + bucket_interval);
-    dir_page->SetBucketPageId(bucket_index + bucket_interval, bucket_page_id);
-  } else if (bucket_index - bucket_interval < dir_page->Size() &&
-             dir_page->GetBucketPageId(bucket_index) == dir_page->GetBucketPageId(bucket_index - bucket_interval)) {
-    dir_page->DecrLocalDepth(bucket_index - bucket_interval);
-    dir_page->SetBucketPageId(bucket_index - bucket_interval, bucket_page_id);
+page_id_t HASH_TABLE_TYPE::BulkLoadDirectory(const std::vector<std::pair<KeyType, ValueType>> &entries,
+                                             const std::vector<uint32_t> &hashes, const std::vector<uint32_t> &order,
+                                             const std::vector<size_t> &partition_offsets, size_t first_partition,
+                                             uint32_t global_depth, std::vector<uint32_t> *overflow) {
+  size_t num_buckets = size_t{1} << global_depth;
+  auto give_up = [&](const std::vector<page_id_t> &page_ids) {
+    // leave the whole directory to Insert()
+    for (auto page_id : page_ids) {
+      buffer_pool_manager_->DeletePage(page_id);
+    }
+    overflow->insert(overflow->end(), order.begin() + partition_offsets[first_partition],
+                     order.begin() + partition_offsets[first_partition + num_buckets]);
+    return INVALID_PAGE_ID;
+  };
+
+  page_id_t directory_page_id = INVALID_PAGE_ID;
+  Page *page = buffer_pool_manager_->NewPage(&directory_page_id);
+  if (page == nullptr) {
+    return give_up({});
   }
+  auto *dir_page = reinterpret_cast<HashTableDirectoryPage *>(page->GetData());
+  dir_page->SetPageId(directory_page_id);
+  dir_page->SetLSN(0);
+  for (uint32_t depth = 0; depth < global_depth; depth++) {
+    dir_page->IncrGlobalDepth();
+  }
+
+  std::vector<page_id_t> bucket_page_ids;
+  for (size_t b = 0; b < num_buckets; b++) {
+    page_id_t bucket_page_id = INVALID_PAGE_ID;
+    Page *bucket = buffer_pool_manager_->NewPage(&bucket_page_id);
+    if (bucket == nullptr) {
+      buffer_pool_manager_->UnpinPage(directory_page_id, false);
+      bucket_page_ids.push_back(directory_page_id);
+      return give_up(bucket_page_ids);
+    }
+    bucket_page_ids.push_back(bucket_page_id);
+
+    auto *bucket_page = reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(bucket->GetData());
+    size_t begin = partition_offsets[first_partition + b];
+    size_t end = partition_offsets[first_partition + b + 1];
+    size_t filled = std::min<size_t>(end - begin, BUCKET_ARRAY_SIZE);
+    for (size_t k = 0; k < filled; k++) {
+      uint32_t i = order[begin + k];
+      bucket_page->InsertAt(k, entries[i].first, entries[i].second, HashToFingerprint(hashes[i]));
+    }
+    overflow->insert(overflow->end(), order.begin() + begin + filled, order.begin() + end);
+    buffer_pool_manager_->UnpinPage(bucket_page_id, true);
+
+    dir_page->SetBucketPageId(b, bucket_page_id);
+    dir_page->SetLocalDepth(b, global_depth);
+  }
+
+  buffer_pool_manager_->UnpinPage(directory_page_id, true);
+  return directory_page_id;
+}
+
+/*****************************************************************************
+ * REMOVE
+ *****************************************************************************/
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool HASH_TABLE_TYPE::Remove(Transaction *transaction, const KeyType &key, const ValueType &value) {
+  table_latch_.RLock();
+  auto directory_page_id = KeyToDirectoryPageId(key);
+  if (directory_page_id == INVALID_PAGE_ID) {
+    table_latch_.RUnlock();
+    return false;
+  }
+
+  auto bucket_page_id = KeyToPageId(key, FetchDirectoryPage(directory_page_id));
+  Page *page = buffer_pool_manager_->FetchPage(bucket_page_id);
+  auto *bucket_page = reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(page->GetData());
+
+  page->WLatch();
+  bool result = bucket_page->Remove(key, value, HashToFingerprint(Hash(key)), comparator_);
+  bool is_empty = result && bucket_page->IsEmpty();
+  page->WUnlatch();
+
+  buffer_pool_manager_->UnpinPage(directory_page_id, false);
+  buffer_pool_manager_->UnpinPage(bucket_page_id, result);
+  table_latch_.RUnlock();
+
+  if (is_empty) {
+    Merge(transaction, key, value);
+  }
+  return result;
 }
 
 /*****************************************************************************
@@ -216,57 +637,133 @@ template <typename KeyType, typename ValueType, typename KeyComparator>
 void HASH_TABLE_TYPE::Merge(Transaction *transaction, const KeyType &key, const ValueType &value) {
   table_latch_.WLock();
 
-  auto *dir_pag = FetchDirectoryPage();
-  auto bucket_page_id = KeyToPageId(key, dir_pag);
+  // directory pages are never freed, so the key's directory still exists
+  auto directory_page_id = KeyToDirectoryPageId(key);
+  auto *dir_page = FetchDirectoryPage(directory_page_id);
+  auto bucket_idx = KeyToDirectoryIndex(key, dir_page);
+  auto bucket_page_id = dir_page->GetBucketPageId(bucket_idx);
   auto *bucket_page = FetchBucketPage(bucket_page_id);
-  bool is_dirty = false;
-  if (bucket_page->IsEmpty()) {
-    auto index = KeyToDirectoryIndex(key, dir_pag);
-    auto newindex = dir_pag->GetSplitImageIndex(index);
-    if (dir_pag->GetLocalDepth(index) == dir_pag->GetLocalDepth(newindex)) {
-      is_dirty = true;
-      ChangeBucketDepth(index, dir_pag->GetBucketPageId(newindex), dir_pag);
-      ChangeBucketDepth(newindex, dir_pag->GetBucketPageId(newindex), dir_pag);
-
-      dir_pag->DecrLocalDepth(index);
-      dir_pag->DecrLocalDepth(newindex);
-      dir_pag->SetBucketPageId(index, dir_pag->GetBucketPageId(newindex));
-      buffer_pool_manager_->UnpinPage(bucket_page_id, is_dirty);
-      buffer_pool_manager_->DeletePage(bucket_page_id);
-      if (dir_pag->CanShrink()) {
-        dir_pag->DecrGlobalDepth();
-      }
-    }
+  uint32_t local_depth = dir_page->GetLocalDepth(bucket_idx);
+
+  // the bucket may have been refilled or merged while we were waiting for the latch
+  if (!bucket_page->IsEmpty() || local_depth == 0 ||
+      dir_page->GetLocalDepth(dir_page->GetSplitImageIndex(bucket_idx)) != local_depth) {
+    buffer_pool_manager_->UnpinPage(bucket_page_id, false);
+    buffer_pool_manager_->UnpinPage(directory_page_id, false);
+    table_latch_.WUnlock();
+    return;
   }
-  if (!is_dirty) {
-    buffer_pool_manager_->UnpinPage(bucket_page_id, is_dirty);
+
+  dir_page->MergeBucket(bucket_idx);
+  while (dir_page->CanShrink()) {
+    dir_page->DecrGlobalDepth();
   }
-  buffer_pool_manager_->UnpinPage(directory_page_id_, is_dirty);
+
+  buffer_pool_manager_->UnpinPage(bucket_page_id, false);
+  buffer_pool_manager_->DeletePage(bucket_page_id);
+  buffer_pool_manager_->UnpinPage(directory_page_id, true);
   table_latch_.WUnlock();
 }
 
 /*****************************************************************************
- * GETGLOBALDEPTH - DO NOT TOUCH
+ * GETGLOBALDEPTH
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
 uint32_t HASH_TABLE_TYPE::GetGlobalDepth() {
   table_latch_.RLock();
-  HashTableDirectoryPage *dir_page = FetchDirectoryPage();
-  uint32_t global_depth = dir_page->GetGlobalDepth();
-  assert(buffer_pool_manager_->UnpinPage(directory_page_id_, false, nullptr));
+  auto *root_page = FetchRootPage();
+  uint32_t global_depth = 0;
+  for (uint32_t i = 0; i < root_page->MaxSize(); i++) {
+    // indexes sharing a directory follow each other, visit it at the first
+    page_id_t directory_page_id = root_page->GetDirectoryPageId(i);
+    if (directory_page_id == INVALID_PAGE_ID || root_page->GetRunStart(i) != i) {
+      continue;
+    }
+    HashTableDirectoryPage *dir_page = FetchDirectoryPage(directory_page_id);
+    global_depth = std::max(global_depth, dir_page->GetGlobalDepth());
+    buffer_pool_manager_->UnpinPage(directory_page_id, false, nullptr);
+  }
+  buffer_pool_manager_->UnpinPage(root_page_id_, false, nullptr);
   table_latch_.RUnlock();
   return global_depth;
 }
 
 /*****************************************************************************
- * VERIFY INTEGRITY - DO NOT TOUCH
+ * GETSTATS
+ *****************************************************************************/
+template <typename KeyType, typename ValueType, typename KeyComparator>
+HashTableStats HASH_TABLE_TYPE::GetStats(uint32_t bucket_sample_step) {
+  static_assert(size_t{1} << (NUM_LOCAL_DEPTHS - 1) == DIRECTORY_ARRAY_SIZE, "one histogram slot per local depth");
+  HashTableStats stats;
+  stats.bucket_capacity_ = BUCKET_ARRAY_SIZE;
+  bucket_sample_step = std::max<uint32_t>(bucket_sample_step, 1);
+
+  table_latch_.RLock();
+  auto *root_page = FetchRootPage();
+  for (uint32_t d = 0; d < root_page->MaxSize(); d++) {
+    page_id_t directory_page_id = root_page->GetDirectoryPageId(d);
+    if (directory_page_id == INVALID_PAGE_ID || root_page->GetRunStart(d) != d) {
+      continue;
+    }
+    auto *dir_page = FetchDirectoryPage(directory_page_id);
+    stats.num_directories_++;
+    stats.global_depth_ = std::max(stats.global_depth_, dir_page->GetGlobalDepth());
+    for (uint32_t i = 0; i < dir_page->Size(); i++) {
+      // a bucket fills every slot that agrees with it on the low local depth bits, count it at the first of them
+      uint32_t local_depth = dir_page->GetLocalDepth(i);
+      if (i >= (1U << local_depth)) {
+        continue;
+      }
+      stats.local_depth_histogram_[local_depth]++;
+      if (stats.num_buckets_++ % bucket_sample_step != 0) {
+        continue;
+      }
+
+      page_id_t bucket_page_id = dir_page->GetBucketPageId(i);
+      Page *page = buffer_pool_manager_->FetchPage(bucket_page_id);
+      auto *bucket_page = reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(page->GetData());
+      page->RLatch();
+      uint64_t readable = bucket_page->NumReadable();
+      uint64_t tombstones = bucket_page->NumTombstones();
+      page->RUnlatch();
+      buffer_pool_manager_->UnpinPage(bucket_page_id, false);
+
+      // a lookup scans every slot group up to the last occupied slot
+      uint64_t groups = (readable + tombstones + BUCKET_GROUP_SIZE - 1) / BUCKET_GROUP_SIZE;
+      stats.num_sampled_buckets_++;
+      stats.num_entries_ += readable;
+      stats.num_tombstones_ += tombstones;
+      stats.num_full_buckets_ += readable == BUCKET_ARRAY_SIZE ? 1 : 0;
+      stats.fill_histogram_[readable * (NUM_FILL_BUCKETS - 1) / BUCKET_ARRAY_SIZE]++;
+      stats.probe_groups_ += readable * groups;
+    }
+    buffer_pool_manager_->UnpinPage(directory_page_id, false);
+  }
+  buffer_pool_manager_->UnpinPage(root_page_id_, false);
+  table_latch_.RUnlock();
+
+  stats.pages_used_ = 1 + stats.num_directories_ + stats.num_buckets_;
+  return stats;
+}
+
+/*****************************************************************************
+ * VERIFY INTEGRITY
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
 void HASH_TABLE_TYPE::VerifyIntegrity() {
   table_latch_.RLock();
-  HashTableDirectoryPage *dir_page = FetchDirectoryPage();
-  dir_page->VerifyIntegrity();
-  assert(buffer_pool_manager_->UnpinPage(directory_page_id_, false, nullptr));
+  auto *root_page = FetchRootPage();
+  for (uint32_t i = 0; i < root_page->MaxSize(); i++) {
+    // indexes sharing a directory follow each other, visit it at the first
+    page_id_t directory_page_id = root_page->GetDirectoryPageId(i);
+    if (directory_page_id == INVALID_PAGE_ID || root_page->GetRunStart(i) != i) {
+      continue;
+    }
+    HashTableDirectoryPage *dir_page = FetchDirectoryPage(directory_page_id);
+    dir_page->VerifyIntegrity();
+    buffer_pool_manager_->UnpinPage(directory_page_id, false, nullptr);
+  }
+  buffer_pool_manager_->UnpinPage(root_page_id_, false, nullptr);
   table_latch_.RUnlock();
 }
 
@@ -0,0 +1,67 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// hash_table_stats.cpp
+//
+// Identification: src/container/hash/hash_table_stats.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+
+#include "container/hash/hash_table_stats.h"
+
+namespace bustub {
+
+double HashTableStats::AverageFill() const {
+  uint64_t slots = num_sampled_buckets_ * bucket_capacity_;
+  return slots == 0 ? 0 : static_cast<double>(num_entries_) / static_cast<double>(slots);
+}
+
+double HashTableStats::TombstoneRatio() const {
+  uint64_t occupied = num_entries_ + num_tombstones_;
+  return occupied == 0 ? 0 : static_cast<double>(num_tombstones_) / static_cast<double>(occupied);
+}
+
+double HashTableStats::AverageProbeLength() const {
+  return num_entries_ == 0 ? 0 : static_cast<double>(probe_groups_) / static_cast<double>(num_entries_);
+}
+
+uint32_t HashTableStats::MaxLocalDepth() const {
+  for (size_t depth = NUM_LOCAL_DEPTHS; depth > 0; depth--) {
+    if (local_depth_histogram_[depth - 1] != 0) {
+      return depth - 1;
+    }
+  }
+  return 0;
+}
+
+std::string HashTableStats::ToString() const {
+  std::string result;
+  char line[256];
+  auto append = [&](int len) { result.append(line, std::min<size_t>(std::max(len, 0), sizeof(line) - 1)); };
+  append(snprintf(line, sizeof(line),
+                  "global depth %u, %lu directories, %lu buckets, %lu pages\n"
+                  "%lu entries, fill %.1f%%, tombstones %.1f%%, %lu full buckets, probe length %.2f groups "
+                  "(%lu of %lu buckets sampled)\n",
+                  global_depth_, num_directories_, num_buckets_, pages_used_, num_entries_, AverageFill() * 100.0,
+                  TombstoneRatio() * 100.0, num_full_buckets_, AverageProbeLength(), num_sampled_buckets_,
+                  num_buckets_));
+  result.append("local depth:");
+  for (size_t depth = 0; depth < NUM_LOCAL_DEPTHS; depth++) {
+    append(snprintf(line, sizeof(line), " %lu", local_depth_histogram_[depth]));
+  }
+  result.append("\nfill %:");
+  for (size_t i = 0; i < NUM_FILL_BUCKETS; i++) {
+    append(snprintf(line, sizeof(line), " %lu", fill_histogram_[i]));
+  }
+  result.push_back('\n');
+  return result;
+}
+
+}  // namespace bustub
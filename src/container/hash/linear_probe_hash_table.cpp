@@ -10,6 +10,7 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
 #include <iostream>
 #include <string>
 #include <utility>
@@ -26,21 +27,188 @@ template <typename KeyType, typename ValueType, typename KeyComparator>
 HASH_TABLE_TYPE::LinearProbeHashTable(const std::string &name, BufferPoolManager *buffer_pool_manager,
                                       const KeyComparator &comparator, size_t num_buckets,
                                       HashFunction<KeyType> hash_fn)
-    : buffer_pool_manager_(buffer_pool_manager), comparator_(comparator), hash_fn_(std::move(hash_fn)) {}
+    : buffer_pool_manager_(buffer_pool_manager), comparator_(comparator), hash_fn_(std::move(hash_fn)) {
+  if (!CreateTable(num_buckets, &table_)) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "LinearProbeHashTable: cannot allocate table pages");
+  }
+}
+
+/*****************************************************************************
+ * HELPERS
+ *****************************************************************************/
+template <typename KeyType, typename ValueType, typename KeyComparator>
+inline Page *HASH_TABLE_TYPE::FetchBlock(const BlockTable &table, size_t block_ind) {
+  return buffer_pool_manager_->FetchPage(table.block_page_ids_[block_ind]);
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool HASH_TABLE_TYPE::CreateTable(size_t num_slots, BlockTable *table) {
+  size_t num_blocks =
+      std::clamp<size_t>((num_slots + BLOCK_ARRAY_SIZE - 1) / BLOCK_ARRAY_SIZE, 1, HEADER_ARRAY_SIZE);
+  BlockTable created;
+  Page *page = buffer_pool_manager_->NewPage(&created.header_page_id_);
+  if (page == nullptr) {
+    return false;
+  }
+  auto *header_page = reinterpret_cast<HashTableHeaderPage *>(page->GetData());
+  header_page->SetPageId(created.header_page_id_);
+  header_page->SetLSN(0);
+  for (size_t i = 0; i < num_blocks; i++) {
+    page_id_t block_page_id;
+    if (buffer_pool_manager_->NewPage(&block_page_id) == nullptr) {
+      buffer_pool_manager_->UnpinPage(created.header_page_id_, false);
+      DeleteTable(created);
+      return false;
+    }
+    // a zeroed page is an empty block
+    buffer_pool_manager_->UnpinPage(block_page_id, true);
+    header_page->AddBlockPageId(block_page_id);
+    created.block_page_ids_.push_back(block_page_id);
+  }
+  created.size_ = num_blocks * BLOCK_ARRAY_SIZE;
+  header_page->SetSize(created.size_);
+  buffer_pool_manager_->UnpinPage(created.header_page_id_, true);
+  *table = std::move(created);
+  return true;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void HASH_TABLE_TYPE::DeleteTable(const BlockTable &table) {
+  for (auto block_page_id : table.block_page_ids_) {
+    buffer_pool_manager_->DeletePage(block_page_id);
+  }
+  buffer_pool_manager_->DeletePage(table.header_page_id_);
+}
 
 /*****************************************************************************
  * SEARCH
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
 bool HASH_TABLE_TYPE::GetValue(Transaction *transaction, const KeyType &key, std::vector<ValueType> *result) {
-  return false;
+  table_latch_.RLock();
+  uint64_t hash = hash_fn_.GetHash(key);
+  bool resizing = old_table_.header_page_id_ != INVALID_PAGE_ID;
+  bool found = false;
+  size_t first = result->size();
+  // the old table first: a pair migrated in the meantime was inserted into the current table before it left the old
+  if (resizing) {
+    found = GetValueFrom(old_table_, key, hash, result);
+  }
+  size_t migrated = result->size();
+  found = GetValueFrom(table_, key, hash, result) || found;
+  if (resizing && migrated != first) {
+    // a pair migrated in between shows up in both tables
+    auto old_begin = result->begin() + first;
+    auto old_end = result->begin() + migrated;
+    auto in_old = [&](const ValueType &value) { return std::find(old_begin, old_end, value) != old_end; };
+    result->erase(std::remove_if(old_end, result->end(), in_old), result->end());
+  }
+  table_latch_.RUnlock();
+  return found;
 }
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool HASH_TABLE_TYPE::GetValueFrom(const BlockTable &table, const KeyType &key, uint64_t hash,
+                                   std::vector<ValueType> *result) {
+  size_t num_blocks = table.block_page_ids_.size();
+  size_t slot = hash % table.size_;
+  size_t block_ind = slot / BLOCK_ARRAY_SIZE;
+  auto offset = static_cast<slot_offset_t>(slot % BLOCK_ARRAY_SIZE);
+  bool found = false;
+  bool end = false;
+  for (size_t probed = 0; !end && probed < table.size_; block_ind = (block_ind + 1) % num_blocks, offset = 0) {
+    Page *page = FetchBlock(table, block_ind);
+    page->RLatch();
+    auto *block = reinterpret_cast<HASH_TABLE_BLOCK_TYPE *>(page->GetData());
+    for (; offset < BLOCK_ARRAY_SIZE && probed < table.size_; offset++, probed++) {
+      if (!block->IsOccupied(offset)) {
+        end = true;
+        break;
+      }
+      if (block->IsReadable(offset) && comparator_(block->KeyAt(offset), key) == 0) {
+        result->push_back(block->ValueAt(offset));
+        found = true;
+      }
+    }
+    page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(table.block_page_ids_[block_ind], false);
+  }
+  return found;
+}
+
 /*****************************************************************************
  * INSERTION
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
 bool HASH_TABLE_TYPE::Insert(Transaction *transaction, const KeyType &key, const ValueType &value) {
-  return false;
+  table_latch_.RLock();
+  uint64_t hash = hash_fn_.GetHash(key);
+  bool resizing = old_table_.header_page_id_ != INVALID_PAGE_ID;
+  bool inserted = false;
+  std::vector<ValueType> old_values;
+  if (resizing) {
+    GetValueFrom(old_table_, key, hash, &old_values);
+  }
+  if (std::find(old_values.begin(), old_values.end(), value) == old_values.end()) {
+    inserted = InsertInto(key, value, hash);
+  }
+  if (inserted) {
+    num_readable_++;
+  }
+  bool maintain = resizing || num_occupied_ * 2 >= table_.size_;
+  table_latch_.RUnlock();
+
+  if (maintain) {
+    Maintain();
+  }
+  return inserted;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool HASH_TABLE_TYPE::InsertInto(const KeyType &key, const ValueType &value, uint64_t hash) {
+  size_t num_blocks = table_.block_page_ids_.size();
+  size_t slot = hash % table_.size_;
+  size_t block_ind = slot / BLOCK_ARRAY_SIZE;
+  auto offset = static_cast<slot_offset_t>(slot % BLOCK_ARRAY_SIZE);
+  Page *page = FetchBlock(table_, block_ind);
+  page->WLatch();
+  auto *block = reinterpret_cast<HASH_TABLE_BLOCK_TYPE *>(page->GetData());
+  bool inserted = false;
+  bool end = false;
+  for (size_t probed = 0; probed < table_.size_;) {
+    for (; offset < BLOCK_ARRAY_SIZE && probed < table_.size_; offset++, probed++) {
+      if (!block->IsOccupied(offset)) {
+        inserted = block->Insert(offset, key, value);
+        end = true;
+        break;
+      }
+      if (block->IsReadable(offset) && comparator_(block->KeyAt(offset), key) == 0 && block->ValueAt(offset) == value) {
+        end = true;
+        break;
+      }
+    }
+    if (end || probed == table_.size_) {
+      break;
+    }
+    offset = 0;
+    if (num_blocks == 1) {
+      continue;
+    }
+    // latch the next block before letting go of this one, so a concurrent insert of the same pair can not pass us
+    block_ind = (block_ind + 1) % num_blocks;
+    Page *next_page = FetchBlock(table_, block_ind);
+    next_page->WLatch();
+    page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+    page = next_page;
+    block = reinterpret_cast<HASH_TABLE_BLOCK_TYPE *>(page->GetData());
+  }
+  page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(page->GetPageId(), inserted);
+  if (inserted) {
+    num_occupied_++;
+  }
+  return inserted;
 }
 
 /*****************************************************************************
@@ -48,21 +216,163 @@ bool HASH_TABLE_TYPE::Insert(Transaction *transaction, const KeyType &key, const
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
 bool HASH_TABLE_TYPE::Remove(Transaction *transaction, const KeyType &key, const ValueType &value) {
-  return false;
+  table_latch_.RLock();
+  uint64_t hash = hash_fn_.GetHash(key);
+  bool resizing = old_table_.header_page_id_ != INVALID_PAGE_ID;
+  // the old table first, for the same reason as in GetValue
+  bool removed = resizing && RemoveFrom(old_table_, key, value, hash);
+  if (!removed) {
+    removed = RemoveFrom(table_, key, value, hash);
+  }
+  if (removed) {
+    num_readable_--;
+  }
+  table_latch_.RUnlock();
+
+  if (resizing) {
+    Maintain();
+  }
+  return removed;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool HASH_TABLE_TYPE::RemoveFrom(const BlockTable &table, const KeyType &key, const ValueType &value,
+                                 uint64_t hash) {
+  size_t num_blocks = table.block_page_ids_.size();
+  size_t slot = hash % table.size_;
+  size_t block_ind = slot / BLOCK_ARRAY_SIZE;
+  auto offset = static_cast<slot_offset_t>(slot % BLOCK_ARRAY_SIZE);
+  bool removed = false;
+  bool end = false;
+  for (size_t probed = 0; !end && probed < table.size_; block_ind = (block_ind + 1) % num_blocks, offset = 0) {
+    Page *page = FetchBlock(table, block_ind);
+    page->WLatch();
+    auto *block = reinterpret_cast<HASH_TABLE_BLOCK_TYPE *>(page->GetData());
+    for (; offset < BLOCK_ARRAY_SIZE && probed < table.size_; offset++, probed++) {
+      if (!block->IsOccupied(offset)) {
+        end = true;
+        break;
+      }
+      if (block->IsReadable(offset) && comparator_(block->KeyAt(offset), key) == 0 && block->ValueAt(offset) == value) {
+        block->Remove(offset);
+        removed = true;
+        end = true;
+        break;
+      }
+    }
+    page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(table.block_page_ids_[block_ind], removed);
+  }
+  return removed;
 }
 
 /*****************************************************************************
  * RESIZE
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
-void HASH_TABLE_TYPE::Resize(size_t initial_size) {}
+void HASH_TABLE_TYPE::Resize(size_t initial_size) {
+  table_latch_.WLock();
+  if (old_table_.header_page_id_ != INVALID_PAGE_ID) {
+    MigrateBlocks(old_table_.block_page_ids_.size());
+    FinishResize();
+  }
+  BeginResize(initial_size);
+  table_latch_.WUnlock();
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool HASH_TABLE_TYPE::BeginResize(size_t initial_size) {
+  BlockTable resized;
+  if (!CreateTable(2 * initial_size, &resized)) {
+    return false;
+  }
+  old_table_ = std::move(table_);
+  table_ = std::move(resized);
+  next_migrate_block_ = 0;
+  num_migrated_blocks_ = 0;
+  num_occupied_ = 0;
+  return true;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool HASH_TABLE_TYPE::MigrateBlocks(size_t num_blocks) {
+  size_t num_old_blocks = old_table_.block_page_ids_.size();
+  for (size_t i = 0; i < num_blocks; i++) {
+    size_t block_ind = next_migrate_block_++;
+    if (block_ind >= num_old_blocks) {
+      break;
+    }
+    // the block stays latched until its pairs are in the current table, so a probe that finds a pair gone from it
+    // finds the pair in the current table
+    Page *page = FetchBlock(old_table_, block_ind);
+    page->WLatch();
+    auto *block = reinterpret_cast<HASH_TABLE_BLOCK_TYPE *>(page->GetData());
+    for (slot_offset_t offset = 0; offset < BLOCK_ARRAY_SIZE; offset++) {
+      if (block->IsReadable(offset)) {
+        KeyType key = block->KeyAt(offset);
+        InsertInto(key, block->ValueAt(offset), hash_fn_.GetHash(key));
+        // keep the slot occupied, unmigrated pairs may be stored past it
+        block->Remove(offset);
+      }
+    }
+    page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(old_table_.block_page_ids_[block_ind], true);
+    num_migrated_blocks_++;
+  }
+  return num_migrated_blocks_ == num_old_blocks;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void HASH_TABLE_TYPE::FinishResize() {
+  if (old_table_.header_page_id_ != INVALID_PAGE_ID && num_migrated_blocks_ == old_table_.block_page_ids_.size()) {
+    DeleteTable(old_table_);
+    old_table_ = BlockTable();
+  }
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void HASH_TABLE_TYPE::Maintain() {
+  // migration steps run alongside other operations, only the step that drains the old table takes the write latch
+  table_latch_.RLock();
+  bool resizing = old_table_.header_page_id_ != INVALID_PAGE_ID;
+  bool drained = resizing && MigrateBlocks(MIGRATE_BLOCKS_PER_OP);
+  bool grow = !resizing && num_occupied_ * 2 >= table_.size_;
+  table_latch_.RUnlock();
+  if (!drained && !grow) {
+    return;
+  }
+
+  table_latch_.WLock();
+  if (old_table_.header_page_id_ != INVALID_PAGE_ID) {
+    FinishResize();
+  } else if (num_occupied_ * 2 >= table_.size_) {
+    if (num_readable_ * 4 < table_.size_) {
+      // mostly tombstones, rebuild at the same size
+      BeginResize(table_.size_ / 2);
+    } else if (table_.block_page_ids_.size() < HEADER_ARRAY_SIZE) {
+      BeginResize(table_.size_);
+    }
+  }
+  table_latch_.WUnlock();
+}
 
 /*****************************************************************************
  * GETSIZE
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
 size_t HASH_TABLE_TYPE::GetSize() {
-  return 0;
+  table_latch_.RLock();
+  size_t size = table_.size_;
+  table_latch_.RUnlock();
+  return size;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool HASH_TABLE_TYPE::IsResizing() {
+  table_latch_.RLock();
+  bool resizing = old_table_.header_page_id_ != INVALID_PAGE_ID;
+  table_latch_.RUnlock();
+  return resizing;
 }
 
 template class LinearProbeHashTable<int, int, IntComparator>;
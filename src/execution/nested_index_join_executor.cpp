@@ -12,14 +12,128 @@
 
 #include "execution/executors/nested_index_join_executor.h"
 
+#include "common/macros.h"
+#include "execution/expressions/column_value_expression.h"
+#include "execution/expressions/comparison_expression.h"
+
 namespace bustub {
 
 NestIndexJoinExecutor::NestIndexJoinExecutor(ExecutorContext *exec_ctx, const NestedIndexJoinPlanNode *plan,
                                              std::unique_ptr<AbstractExecutor> &&child_executor)
-    : AbstractExecutor(exec_ctx) {}
+    : AbstractExecutor(exec_ctx),
+      plan_(plan),
+      child_executor_(std::move(child_executor)),
+      inner_table_(exec_ctx->GetCatalog()->GetTable(plan_->GetInnerTableOid())),
+      index_info_(exec_ctx->GetCatalog()->GetIndex(plan_->GetIndexName(), inner_table_->name_)) {}
+
+void NestIndexJoinExecutor::Init() {
+  // the index key of each outer tuple is the outer operand of the predicate, there is nothing to probe without one
+  BUSTUB_ASSERT(plan_->Predicate() != nullptr, "nested index join needs a join predicate");
+  outer_key_expr_ = IndexProbeOperand();
+  child_executor_->Init();
+  results_.clear();
+  cursor_ = 0;
+}
+
+bool NestIndexJoinExecutor::Next(Tuple *tuple, RID *rid) {
+  while (cursor_ == results_.size()) {
+    results_.clear();
+    cursor_ = 0;
+    if (!NextBatch()) {
+      return false;
+    }
+  }
+  *tuple = results_[cursor_++];
+  return true;
+}
+
+bool NestIndexJoinExecutor::NextBatch() {
+  std::vector<Tuple> outer_tuples;
+  Tuple outer_tuple;
+  RID outer_rid;
+  while (outer_tuples.size() < BATCH_SIZE && child_executor_->Next(&outer_tuple, &outer_rid)) {
+    outer_tuples.push_back(outer_tuple);
+  }
+  if (outer_tuples.empty()) {
+    return false;
+  }
+
+  auto *txn = exec_ctx_->GetTransaction();
+  std::vector<std::vector<RID>> inner_rids;
+  if (outer_key_expr_ != nullptr) {
+    std::vector<Tuple> keys;
+    keys.reserve(outer_tuples.size());
+    for (const auto &tuple : outer_tuples) {
+      keys.push_back(OuterKey(tuple));
+    }
+    index_info_->index_->ScanKeys(keys, &inner_rids, txn);
+  } else {
+    // every inner tuple is a candidate for every outer tuple of the batch
+    inner_rids.emplace_back();
+    for (auto it = inner_table_->table_->Begin(txn); it != inner_table_->table_->End(); ++it) {
+      inner_rids[0].push_back(it->GetRid());
+    }
+  }
+
+  const Schema *outer_schema = plan_->OuterTableSchema();
+  const Schema *inner_schema = &inner_table_->schema_;
+  auto cols = GetOutputSchema()->GetColumnCount();
+  for (size_t i = 0; i < outer_tuples.size(); i++) {
+    for (const RID &inner_rid : inner_rids[outer_key_expr_ != nullptr ? i : 0]) {
+      Tuple inner_tuple;
+      if (!inner_table_->table_->GetTuple(inner_rid, &inner_tuple, txn)) {
+        continue;
+      }
+      if (!plan_->Predicate()->EvaluateJoin(&outer_tuples[i], outer_schema, &inner_tuple, inner_schema).GetAs<bool>()) {
+        continue;
+      }
+
+      std::vector<Value> values(cols);
+      for (size_t c = 0; c < cols; c++) {
+        values[c] =
+            GetOutputSchema()->GetColumn(c).GetExpr()->EvaluateJoin(&outer_tuples[i], outer_schema, &inner_tuple,
+                                                                    inner_schema);
+      }
+      results_.emplace_back(values, GetOutputSchema());
+    }
+  }
+  return true;
+}
+
+const AbstractExpression *NestIndexJoinExecutor::IndexProbeOperand() const {
+  const auto *comparison = dynamic_cast<const ComparisonExpression *>(plan_->Predicate());
+  const auto &key_attrs = index_info_->index_->GetKeyAttrs();
+  if (comparison == nullptr || comparison->GetComparisonType() != ComparisonType::Equal || key_attrs.size() != 1) {
+    return nullptr;
+  }
+  // outer_expr = inner.key_column, either side may come first
+  for (uint32_t side = 0; side < 2; side++) {
+    const auto *inner_column = dynamic_cast<const ColumnValueExpression *>(comparison->GetChildAt(side));
+    const AbstractExpression *outer_expr = comparison->GetChildAt(1 - side);
+    if (inner_column != nullptr && inner_column->GetTupleIdx() == 1 && inner_column->GetColIdx() == key_attrs[0] &&
+        ReadsOnly(outer_expr, 0)) {
+      return outer_expr;
+    }
+  }
+  return nullptr;
+}
 
-void NestIndexJoinExecutor::Init() {}
+bool NestIndexJoinExecutor::ReadsOnly(const AbstractExpression *expr, uint32_t tuple_idx) {
+  const auto *column = dynamic_cast<const ColumnValueExpression *>(expr);
+  if (column != nullptr) {
+    return column->GetTupleIdx() == tuple_idx;
+  }
+  for (const auto *child : expr->GetChildren()) {
+    if (!ReadsOnly(child, tuple_idx)) {
+      return false;
+    }
+  }
+  return true;
+}
 
-bool NestIndexJoinExecutor::Next(Tuple *tuple, RID *rid) { return false; }
+Tuple NestIndexJoinExecutor::OuterKey(const Tuple &outer_tuple) const {
+  std::vector<Value> key_values{outer_key_expr_->Evaluate(&outer_tuple, plan_->OuterTableSchema())};
+  return Tuple(key_values, &index_info_->key_schema_);
+}
 
 }  // namespace bustub
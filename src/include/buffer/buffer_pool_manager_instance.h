@@ -35,7 +35,7 @@ class BufferPoolManagerInstance : public BufferPoolManager {
    * @param disk_manager the disk manager
    * @param log_manager the log manager (for testing only: nullptr = disable logging)
    */
-  BufferPoolManagerInstance(size_t pool_size, DiskManager *disk_manager, LogManager *log_manager = nullptr);
+  BufferPoolManagerInstance(size_t pool_size, DiskInterface *disk_manager, LogManager *log_manager = nullptr);
   /**
    * Creates a new BufferPoolManagerInstance.
    * @param pool_size the size of the buffer pool
@@ -45,7 +45,7 @@ class BufferPoolManagerInstance : public BufferPoolManager {
    * @param log_manager the log manager (for testing only: nullptr = disable logging)
    */
   BufferPoolManagerInstance(size_t pool_size, uint32_t num_instances, uint32_t instance_index,
-                            DiskManager *disk_manager, LogManager *log_manager = nullptr);
+                            DiskInterface *disk_manager, LogManager *log_manager = nullptr);
 
   /**
    * Destroys an existing BufferPoolManagerInstance.
@@ -63,6 +63,7 @@ class BufferPoolManagerInstance : public BufferPoolManager {
    * Fetch the requested page from the buffer pool.
    * @param page_id id of page to be fetched
    * @return the requested page
+   * @throws Exception if the page can't be read, e.g. on a checksum mismatch; the frame goes back to the free list
    */
   Page *FetchPgImp(page_id_t page_id) override;
 
@@ -84,7 +85,8 @@ class BufferPoolManagerInstance : public BufferPoolManager {
   /**
    * Creates a new page in the buffer pool.
    * @param[out] page_id id of created page
-   * @return nullptr if no new pages could be created, otherwise pointer to new page
+   * @return nullptr if no new pages could be created, e.g. on a read-only disk manager, otherwise pointer to new page
+   * @throws Exception if the new page can't be written, or a dirty victim can't be written back
    */
   Page *NewPgImp(page_id_t *page_id) override;
 
@@ -100,6 +102,14 @@ class BufferPoolManagerInstance : public BufferPoolManager {
    */
   void FlushAllPgsImp() override;
 
+  /**
+   * Pick a frame for a page, from the free list or else the replacer, writing the victim back if it is dirty.
+   * @param[out] frame_id the frame
+   * @return false if every frame is pinned
+   * @throws Exception if the victim can't be written back; it keeps its frame
+   */
+  bool FindFrame(frame_id_t *frame_id);
+
   /**
    * Allocate a page on disk.∂
    * @return the id of the allocated page
@@ -133,7 +143,7 @@ class BufferPoolManagerInstance : public BufferPoolManager {
   /** Array of buffer pool pages. */
   Page *pages_;
   /** Pointer to the disk manager. */
-  DiskManager *disk_manager_ __attribute__((__unused__));
+  DiskInterface *disk_manager_ __attribute__((__unused__));
   /** Pointer to the log manager. */
   LogManager *log_manager_ __attribute__((__unused__));
   /** Page table for keeping track of buffer pool pages. */
@@ -29,7 +29,7 @@ class ParallelBufferPoolManager : public BufferPoolManager {
    * @param disk_manager the disk manager
    * @param log_manager the log manager (for testing only: nullptr = disable logging)
    */
-  ParallelBufferPoolManager(size_t num_instances, size_t pool_size, DiskManager *disk_manager,
+  ParallelBufferPoolManager(size_t num_instances, size_t pool_size, DiskInterface *disk_manager,
                             LogManager *log_manager = nullptr);
 
   /**
@@ -20,7 +20,9 @@
 
 #include "buffer/buffer_pool_manager.h"
 #include "catalog/schema.h"
+#include "common/logger.h"
 #include "container/hash/hash_function.h"
+#include "storage/index/b_plus_tree_index.h"
 #include "storage/index/extendible_hash_table_index.h"
 #include "storage/index/index.h"
 #include "storage/table/table_heap.h"
@@ -105,6 +107,12 @@ class Catalog {
   /** Indicates that an operation returning a `IndexInfo*` failed */
   static constexpr IndexInfo *NULL_INDEX_INFO{nullptr};
 
+  /**
+   * Number of tuples whose keys are gathered before they are handed to a new index, which bounds the memory an index
+   * build takes however large the table. A table that fits in one batch is bulk loaded in a single pass.
+   */
+  static constexpr size_t INDEX_BUILD_BATCH_SIZE = 1 << 14;
+
   /**
    * Construct a new Catalog instance.
    * @param bpm The buffer pool manager backing tables created by this catalog
@@ -192,18 +200,7 @@ class Catalog {
   IndexInfo *CreateIndex(Transaction *txn, const std::string &index_name, const std::string &table_name,
                          const Schema &schema, const Schema &key_schema, const std::vector<uint32_t> &key_attrs,
                          std::size_t keysize, HashFunction<KeyType> hash_function) {
-    // Reject the creation request for nonexistent table
-    if (table_names_.find(table_name) == table_names_.end()) {
-      return NULL_INDEX_INFO;
-    }
-
-    // If the table exists, an entry for the table should already be present in index_names_
-    BUSTUB_ASSERT((index_names_.find(table_name) != index_names_.end()), "Broken Invariant");
-
-    // Determine if the requested index already exists for this table
-    auto &table_indexes = index_names_.find(table_name)->second;
-    if (table_indexes.find(index_name) != table_indexes.end()) {
-      // The requested index already exists for this table
+    if (!CanCreateIndex(index_name, table_name)) {
       return NULL_INDEX_INFO;
     }
 
@@ -216,27 +213,38 @@ class Catalog {
     // just the key, value, and comparator types
     auto index = std::make_unique<ExtendibleHashTableIndex<KeyType, ValueType, KeyComparator>>(std::move(meta), bpm_,
                                                                                                hash_function);
+    return PopulateAndRegisterIndex(txn, std::move(index), index_name, table_name, schema, key_schema, key_attrs,
+                                    keysize);
+  }
 
-    // Populate the index with all tuples in table heap
-    auto *table_meta = GetTable(table_name);
-    auto *heap = table_meta->table_.get();
-    for (auto tuple = heap->Begin(txn); tuple != heap->End(); ++tuple) {
-      index->InsertEntry(tuple->KeyFromTuple(schema, key_schema, key_attrs), tuple->GetRid(), txn);
+  /**
+   * Create a new B+ tree index, populate existing data of the table and return its metadata.
+   * The existing tuples are sorted by key and the tree is bulk loaded bottom-up.
+   * @param txn The transaction in which the table is being created
+   * @param index_name The name of the new index
+   * @param table_name The name of the table
+   * @param schema The schema of the table
+   * @param key_schema The schema of the key
+   * @param key_attrs Key attributes
+   * @param keysize Size of the key
+   * @param is_unique Whether a key may appear at most once; a non-unique index keeps every RID of a key
+   * @param mode How writers change the tree (see BPlusTreeMode); BUFFERED suits ingest-heavy tables and needs a unique
+   * index
+   * @return A (non-owning) pointer to the metadata of the new table
+   */
+  template <class KeyType, class ValueType, class KeyComparator>
+  IndexInfo *CreateIndex(Transaction *txn, const std::string &index_name, const std::string &table_name,
+                         const Schema &schema, const Schema &key_schema, const std::vector<uint32_t> &key_attrs,
+                         std::size_t keysize, bool is_unique = true,
+                         BPlusTreeMode mode = BPlusTreeMode::LATCH_COUPLING) {
+    if (!CanCreateIndex(index_name, table_name)) {
+      return NULL_INDEX_INFO;
     }
 
-    // Get the next OID for the new index
-    const auto index_oid = next_index_oid_.fetch_add(1);
-
-    // Construct index information; IndexInfo takes ownership of the Index itself
-    auto index_info =
-        std::make_unique<IndexInfo>(key_schema, index_name, std::move(index), index_oid, table_name, keysize);
-    auto *tmp = index_info.get();
-
-    // Update internal tracking
-    indexes_.emplace(index_oid, std::move(index_info));
-    table_indexes.emplace(index_name, index_oid);
-
-    return tmp;
+    auto meta = std::make_unique<IndexMetadata>(index_name, table_name, &schema, key_attrs, is_unique);
+    auto index = std::make_unique<BPlusTreeIndex<KeyType, ValueType, KeyComparator>>(std::move(meta), bpm_, mode);
+    return PopulateAndRegisterIndex(txn, std::move(index), index_name, table_name, schema, key_schema, key_attrs,
+                                    keysize);
   }
 
   /**
@@ -323,6 +331,67 @@ class Catalog {
   }
 
  private:
+  /** @return true if the table exists and has no index of this name yet */
+  bool CanCreateIndex(const std::string &index_name, const std::string &table_name) {
+    // Reject the creation request for nonexistent table
+    if (table_names_.find(table_name) == table_names_.end()) {
+      return false;
+    }
+
+    // If the table exists, an entry for the table should already be present in index_names_
+    BUSTUB_ASSERT((index_names_.find(table_name) != index_names_.end()), "Broken Invariant");
+
+    // Determine if the requested index already exists for this table
+    auto &table_indexes = index_names_.find(table_name)->second;
+    return table_indexes.find(index_name) == table_indexes.end();
+  }
+
+  /**
+   * Populate a newly constructed index with all tuples in the table heap, then take ownership of it.
+   * @return the metadata of the index, or NULL_INDEX_INFO if the index refused some of the tuples, e.g. a duplicate
+   * key of a unique index; the index is dropped then
+   */
+  IndexInfo *PopulateAndRegisterIndex(Transaction *txn, std::unique_ptr<Index> index, const std::string &index_name,
+                                      const std::string &table_name, const Schema &schema, const Schema &key_schema,
+                                      const std::vector<uint32_t> &key_attrs, std::size_t keysize) {
+    // Populate the index with all tuples in table heap, in batches of INDEX_BUILD_BATCH_SIZE
+    auto *table_meta = GetTable(table_name);
+    auto *heap = table_meta->table_.get();
+    std::vector<Tuple> keys;
+    std::vector<RID> rids;
+    bool populated = true;
+    for (auto tuple = heap->Begin(txn); tuple != heap->End() && populated; ++tuple) {
+      keys.push_back(tuple->KeyFromTuple(schema, key_schema, key_attrs));
+      rids.push_back(tuple->GetRid());
+      if (keys.size() == INDEX_BUILD_BATCH_SIZE) {
+        populated = index->InsertEntries(keys, rids, txn);
+        keys.clear();
+        rids.clear();
+      }
+    }
+    if (populated && !keys.empty()) {
+      populated = index->InsertEntries(keys, rids, txn);
+    }
+    if (!populated) {
+      LOG_WARN("could not insert every tuple of table %s into index %s", table_name.c_str(), index_name.c_str());
+      return NULL_INDEX_INFO;
+    }
+
+    // Get the next OID for the new index
+    const auto index_oid = next_index_oid_.fetch_add(1);
+
+    // Construct index information; IndexInfo takes ownership of the Index itself
+    auto index_info =
+        std::make_unique<IndexInfo>(key_schema, index_name, std::move(index), index_oid, table_name, keysize);
+    auto *tmp = index_info.get();
+
+    // Update internal tracking
+    indexes_.emplace(index_oid, std::move(index_info));
+    index_names_.find(table_name)->second.emplace(index_name, index_oid);
+
+    return tmp;
+  }
+
   [[maybe_unused]] BufferPoolManager *bpm_;
   [[maybe_unused]] LockManager *lock_manager_;
   [[maybe_unused]] LogManager *log_manager_;
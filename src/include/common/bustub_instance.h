@@ -18,16 +18,39 @@
 #include "recovery/checkpoint_manager.h"
 #include "recovery/log_manager.h"
 #include "storage/disk/disk_manager.h"
+#include "storage/disk/memory_disk_manager.h"
+#include "storage/disk/mmap_disk_manager.h"
 
 namespace bustub {
 
+/** The storage backends a BustubInstance can run on. */
+enum class DiskManagerType {
+  /** Read-write database and log files. */
+  FILE = 0,
+  /** Read-only memory-mapped database file, for reporting replicas. */
+  MMAP_READ_ONLY,
+  /** Database and log kept in memory, the file name is ignored. For benchmarks and ephemeral data. */
+  MEMORY,
+};
+
 class BustubInstance {
  public:
-  explicit BustubInstance(const std::string &db_file_name) {
+  explicit BustubInstance(const std::string &db_file_name, DiskManagerType disk_manager_type = DiskManagerType::FILE) {
     enable_logging = false;
 
     // storage related
-    disk_manager_ = new DiskManager(db_file_name);
+    switch (disk_manager_type) {
+      case DiskManagerType::MMAP_READ_ONLY:
+        disk_manager_ = new MmapDiskManager(db_file_name);
+        break;
+      case DiskManagerType::MEMORY:
+        disk_manager_ = new MemoryDiskManager();
+        break;
+      case DiskManagerType::FILE:
+      default:
+        disk_manager_ = new DiskManager(db_file_name);
+        break;
+    }
 
     // log related
     log_manager_ = new LogManager(disk_manager_);
@@ -54,7 +77,7 @@ class BustubInstance {
     delete disk_manager_;
   }
 
-  DiskManager *disk_manager_;
+  DiskInterface *disk_manager_;
   BufferPoolManager *buffer_pool_manager_;
   LockManager *lock_manager_;
   TransactionManager *transaction_manager_;
@@ -48,6 +48,19 @@ class ReaderWriterLatch {
     }
   }
 
+  /**
+   * Acquire a write latch if it is free, without waiting.
+   * @return true if the latch was acquired
+   */
+  bool TryWLock() {
+    std::lock_guard<mutex_t> guard(mutex_);
+    if (writer_entered_ || reader_count_ > 0) {
+      return false;
+    }
+    writer_entered_ = true;
+    return true;
+  }
+
   /**
    * Release a write latch.
    */
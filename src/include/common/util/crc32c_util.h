@@ -0,0 +1,47 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// crc32c_util.h
+//
+// Identification: src/include/common/util/crc32c_util.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace bustub {
+
+/**
+ * Crc32cUtil computes CRC32C (Castagnoli) checksums, the polynomial with hardware support on both x86 and ARM.
+ *
+ * Crc32c() uses the SSE4.2 crc32 instruction when the CPU has it (detected at runtime) or the ARMv8 CRC extension
+ * when the build targets it, and falls back to a slicing-by-8 table implementation otherwise. On x86 large buffers are
+ * split into three interleaved streams, because the crc32 instruction has a latency of three cycles but a throughput
+ * of one per cycle; the three partial checksums are then combined in GF(2). CPUs with AVX2 vpclmulqdq skip the
+ * crc32 instruction for buffers of 128 bytes and more and fold them with carry-less multiplication instead, about
+ * three times as fast.
+ */
+class Crc32cUtil {
+ public:
+  /**
+   * @param data the bytes to checksum
+   * @param size number of bytes
+   * @param crc the checksum of the preceding bytes, to checksum a buffer in pieces
+   * @return the CRC32C of the bytes
+   */
+  static uint32_t Crc32c(const char *data, size_t size, uint32_t crc = 0);
+
+  /** Same as Crc32c(), but always uses the portable slicing-by-8 implementation. */
+  static uint32_t Crc32cPortable(const char *data, size_t size, uint32_t crc = 0);
+
+  /** @return true if Crc32c() uses CRC instructions of the CPU */
+  static bool IsHardwareAccelerated();
+};
+
+}  // namespace bustub
@@ -13,9 +13,12 @@
 #pragma once
 
 #include <algorithm>
+#include <cstdint>
 #include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <string>
+#include <type_traits>
 
 #include "common/macros.h"
 #include "type/value.h"
@@ -28,33 +31,130 @@ class HashUtil {
  private:
   static const hash_t PRIME_FACTOR = 10000019;
 
+  /** Odd 64-bit constants with balanced bits, from wyhash. */
+  static constexpr uint64_t SECRET[4] = {0x2d358dccaa6c78a5ULL, 0x8bb84b93962eacc9ULL, 0x4b33a62ed433d4a3ULL,
+                                         0x4d5a2da51de1aa47ULL};
+
+  /** @return the low and high halves of the 128-bit product folded together */
+  static inline uint64_t Mix(uint64_t a, uint64_t b) {
+    __uint128_t product = static_cast<__uint128_t>(a) * b;
+    return static_cast<uint64_t>(product) ^ static_cast<uint64_t>(product >> 64);
+  }
+
+  static inline uint64_t Read8(const char *p) {
+    uint64_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+  }
+
+  static inline uint64_t Read4(const char *p) {
+    uint32_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+  }
+
+  /** Folds the last two input words a and b into the hash. */
+  static inline hash_t Finish(uint64_t a, uint64_t b, uint64_t seed, size_t length) {
+    __uint128_t product = static_cast<__uint128_t>(a ^ SECRET[1]) * (b ^ seed);
+    return Mix(static_cast<uint64_t>(product) ^ SECRET[0] ^ length, static_cast<uint64_t>(product >> 64) ^ SECRET[1]);
+  }
+
+  /** Lengths without an overload of their own take the general path of HashBytes(). */
+  template <size_t Length>
+  static inline hash_t HashFixedImpl(const char *bytes, std::integral_constant<size_t, Length> /*unused*/) {
+    return HashBytes(bytes, Length);
+  }
+
+  /*
+   * The 4-, 8- and 16-byte keys of the hash indexes go straight to the two 4-byte read pairs HashBytes() would pick
+   * for them and the final multiplication.
+   */
+  static inline hash_t HashFixedImpl(const char *bytes, std::integral_constant<size_t, 4> /*unused*/) {
+    uint64_t a = (Read4(bytes) << 32) | Read4(bytes);
+    return Finish(a, a, Mix(SECRET[0], SECRET[1]), 4);
+  }
+
+  static inline hash_t HashFixedImpl(const char *bytes, std::integral_constant<size_t, 8> /*unused*/) {
+    uint64_t a = (Read4(bytes) << 32) | Read4(bytes + 4);
+    uint64_t b = (Read4(bytes + 4) << 32) | Read4(bytes);
+    return Finish(a, b, Mix(SECRET[0], SECRET[1]), 8);
+  }
+
+  static inline hash_t HashFixedImpl(const char *bytes, std::integral_constant<size_t, 16> /*unused*/) {
+    uint64_t a = (Read4(bytes) << 32) | Read4(bytes + 8);
+    uint64_t b = (Read4(bytes + 12) << 32) | Read4(bytes + 4);
+    return Finish(a, b, Mix(SECRET[0], SECRET[1]), 16);
+  }
+
  public:
+  /**
+   * Hashes a byte string with the wyhash algorithm: 8 to 48 bytes per step are folded in with 64x64->128-bit
+   * multiplications, which avalanche every input bit into the whole result in one round.
+   */
   static inline hash_t HashBytes(const char *bytes, size_t length) {
-    // https://github.com/greenplum-db/gpos/blob/b53c1acd6285de94044ff91fbee91589543feba1/libgpos/src/utils.cpp#L126
-    hash_t hash = length;
-    for (size_t i = 0; i < length; ++i) {
-      hash = ((hash << 5) ^ (hash >> 27)) ^ bytes[i];
+    const char *p = bytes;
+    uint64_t seed = Mix(SECRET[0], SECRET[1]);
+    uint64_t a;
+    uint64_t b;
+    if (length <= 16) {
+      if (length >= 4) {
+        // two possibly overlapping 4-byte reads from each end cover 4 to 16 bytes
+        size_t quarter = (length >> 3) << 2;
+        a = (Read4(p) << 32) | Read4(p + quarter);
+        b = (Read4(p + length - 4) << 32) | Read4(p + length - 4 - quarter);
+      } else if (length > 0) {
+        a = (static_cast<uint64_t>(static_cast<uint8_t>(p[0])) << 16) |
+            (static_cast<uint64_t>(static_cast<uint8_t>(p[length >> 1])) << 8) | static_cast<uint8_t>(p[length - 1]);
+        b = 0;
+      } else {
+        a = 0;
+        b = 0;
+      }
+    } else {
+      size_t remaining = length;
+      if (remaining > 48) {
+        // three independent lanes keep the multipliers busy
+        uint64_t seed1 = seed;
+        uint64_t seed2 = seed;
+        do {
+          seed = Mix(Read8(p) ^ SECRET[1], Read8(p + 8) ^ seed);
+          seed1 = Mix(Read8(p + 16) ^ SECRET[2], Read8(p + 24) ^ seed1);
+          seed2 = Mix(Read8(p + 32) ^ SECRET[3], Read8(p + 40) ^ seed2);
+          p += 48;
+          remaining -= 48;
+        } while (remaining > 48);
+        seed ^= seed1 ^ seed2;
+      }
+      while (remaining > 16) {
+        seed = Mix(Read8(p) ^ SECRET[1], Read8(p + 8) ^ seed);
+        p += 16;
+        remaining -= 16;
+      }
+      a = Read8(p + remaining - 16);
+      b = Read8(p + remaining - 8);
     }
-    return hash;
+    return Finish(a, b, seed, length);
   }
 
-  static inline hash_t CombineHashes(hash_t l, hash_t r) {
-    hash_t both[2] = {};
-    both[0] = l;
-    both[1] = r;
-    return HashBytes(reinterpret_cast<char *>(both), sizeof(hash_t) * 2);
+  /** Same as HashBytes() for a length known at compile time. */
+  template <size_t Length>
+  static inline hash_t HashFixed(const char *bytes) {
+    return HashFixedImpl(bytes, std::integral_constant<size_t, Length>{});
   }
 
+  /** @return a hash of the ordered pair of hashes */
+  static inline hash_t CombineHashes(hash_t l, hash_t r) { return Mix(l ^ SECRET[0], r ^ SECRET[1]); }
+
   static inline hash_t SumHashes(hash_t l, hash_t r) { return (l % PRIME_FACTOR + r % PRIME_FACTOR) % PRIME_FACTOR; }
 
   template <typename T>
   static inline hash_t Hash(const T *ptr) {
-    return HashBytes(reinterpret_cast<const char *>(ptr), sizeof(T));
+    return HashFixed<sizeof(T)>(reinterpret_cast<const char *>(ptr));
   }
 
   template <typename T>
   static inline hash_t HashPtr(const T *ptr) {
-    return HashBytes(reinterpret_cast<const char *>(&ptr), sizeof(void *));
+    return HashFixed<sizeof(void *)>(reinterpret_cast<const char *>(&ptr));
   }
 
   /** @return the hash of the value */
@@ -14,13 +14,16 @@
 
 #include <queue>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "buffer/buffer_pool_manager.h"
 #include "concurrency/transaction.h"
 #include "container/hash/hash_function.h"
+#include "container/hash/hash_table_stats.h"
 #include "storage/page/hash_table_bucket_page.h"
 #include "storage/page/hash_table_directory_page.h"
+#include "storage/page/hash_table_root_page.h"
 
 namespace bustub {
 
@@ -30,6 +33,17 @@ namespace bustub {
  * Implementation of extendible hash table that is backed by a buffer pool
  * manager. Non-unique keys are supported. Supports insert and delete. The
  * table grows/shrinks dynamically as buckets become full/empty.
+ *
+ * The table has three levels: a root page picks a directory page by the
+ * high bits of the hash, the directory picks a bucket page by the low bits.
+ * Directory pages are allocated the first time a key hashes to them. A
+ * directory that is full is split in two by the next high bit, doubling
+ * the root first if the directory has a root index to itself.
+ *
+ * Lookups, inserts and removes take table_latch_ in read mode and latch only
+ * the bucket page they touch, so operations on different buckets run in
+ * parallel. Only splits and merges, which change the directory, take
+ * table_latch_ in write mode.
  */
 template <typename KeyType, typename ValueType, typename KeyComparator>
 class ExtendibleHashTable {
@@ -40,9 +54,12 @@ class ExtendibleHashTable {
    * @param buffer_pool_manager buffer pool manager to be used
    * @param comparator comparator for keys
    * @param hash_fn the hash function
+   * @param root_depth number of hash bits the root starts out using to pick a directory, 0 for a single directory,
+   * at most ROOT_MAX_DEPTH. The root deepens on its own as directories fill up.
    */
   explicit ExtendibleHashTable(const std::string &name, BufferPoolManager *buffer_pool_manager,
-                               const KeyComparator &comparator, HashFunction<KeyType> hash_fn);
+                               const KeyComparator &comparator, HashFunction<KeyType> hash_fn,
+                               uint32_t root_depth = ROOT_DEFAULT_DEPTH);
 
   /**
    * Inserts a key-value pair into the hash table.
@@ -75,18 +92,53 @@ class ExtendibleHashTable {
   bool GetValue(Transaction *transaction, const KeyType &key, std::vector<ValueType> *result);
 
   /**
-   * Returns the global depth.  Do not touch.
+   * Performs a point query for each of a batch of keys. The table latch is taken and the root and directory pages
+   * are fetched once for the whole batch, and each bucket is fetched once however many keys fall into it. While the
+   * keys of one bucket are probed, the next bucket is already pinned and its metadata prefetched into the cache.
+   *
+   * @param transaction the current transaction
+   * @param keys the keys to look up
+   * @param[out] results results->at(i) receives the value(s) associated with keys[i]
+   */
+  void GetValues(Transaction *transaction, const std::vector<KeyType> &keys,
+                 std::vector<std::vector<ValueType>> *results);
+
+  /**
+   * Loads a batch of pairs into an empty table. The pairs are counted per directory to pick the root depth and every
+   * directory's global depth up front, partitioned by hash prefix with a counting sort, and each bucket page is then
+   * written once, in order, at BULK_FILL_FACTOR percent full. Directories are filled by num_threads threads. Pairs
+   * of buckets that overflow, e.g. from many duplicates of a key, and all pairs loaded into a non-empty table go
+   * through Insert().
+   *
+   * @param transaction the current transaction
+   * @param entries the pairs to load, which must be distinct
+   * @param num_threads number of threads filling directories
+   * @return true if every pair was loaded, false if Insert() refused some, e.g. for lack of buffer pool frames
+   */
+  bool BulkLoad(Transaction *transaction, const std::vector<std::pair<KeyType, ValueType>> &entries,
+                size_t num_threads = 1);
+
+  /**
+   * Returns the global depth, the largest one over all directory pages.
    */
   uint32_t GetGlobalDepth();
 
   /**
-   * Helper function to verify the integrity of the extendible hash table's directory.  Do not touch.
+   * Summarizes the shape of the table: depths, page counts, bucket fill, tombstones and probe length. Only holds the
+   * table latch in read mode and reads the counters of each bucket page, so it can be sampled while the table is in
+   * use.
+   *
+   * @param bucket_sample_step read every bucket_sample_step-th bucket page only, to bound the cost on large tables
+   * @return the statistics
+   */
+  HashTableStats GetStats(uint32_t bucket_sample_step = 1);
+
+  /**
+   * Helper function to verify the integrity of every directory page of the extendible hash table.
    */
   void VerifyIntegrity();
 
  private:
-  void ChangeBucketDepth(uint32_t bucket_index, page_id_t bucket_page_id, HashTableDirectoryPage *dir_page);
-
   /**
    * Hash - simple helper to downcast MurmurHash's 64-bit hash to 32-bit
    * for extendible hashing.
@@ -96,6 +148,15 @@ class ExtendibleHashTable {
    */
   inline uint32_t Hash(KeyType key);
 
+  /**
+   * Fingerprint - the byte the bucket pages filter slots by before comparing keys. It is taken from hash bits
+   * neither the directory nor the root page index by, so keys sharing a bucket do not share it.
+   *
+   * @param hash the hash of a key
+   * @return the key's fingerprint
+   */
+  static inline uint8_t HashToFingerprint(uint32_t hash);
+
   /**
    * KeyToDirectoryIndex - maps a key to a directory index
    *
@@ -118,17 +179,41 @@ class ExtendibleHashTable {
    * Get the bucket page_id corresponding to a key.
    *
    * @param key the key for lookup
-   * @param dir_page a pointer to the hash table's directory page
+   * @param dir_page a pointer to the key's directory page
    * @return the bucket page_id corresponding to the input key
    */
   inline uint32_t KeyToPageId(KeyType key, HashTableDirectoryPage *dir_page);
 
   /**
-   * Fetches the directory page from the buffer pool manager.
+   * Get the directory page_id corresponding to a key.
+   *
+   * @param key the key for lookup
+   * @return the directory page_id corresponding to the input key, INVALID_PAGE_ID if it was not allocated yet
+   */
+  page_id_t KeyToDirectoryPageId(KeyType key);
+
+  /**
+   * Fetches the root page from the buffer pool manager.
    *
+   * @return a pointer to the root page
+   */
+  HashTableRootPage *FetchRootPage();
+
+  /**
+   * Fetches a directory page from the buffer pool manager.
+   *
+   * @param directory_page_id the page_id to fetch
    * @return a pointer to the directory page
    */
-  HashTableDirectoryPage *FetchDirectoryPage();
+  HashTableDirectoryPage *FetchDirectoryPage(page_id_t directory_page_id);
+
+  /**
+   * Allocate the directory page of a key, with a single empty bucket. Caller holds the table latch in write mode.
+   *
+   * @param key the key whose directory page is missing
+   * @return the page_id of the new directory page, INVALID_PAGE_ID if the buffer pool is out of frames
+   */
+  page_id_t CreateDirectoryPage(KeyType key);
 
   /**
    * Fetches the a bucket page from the buffer pool manager using the bucket's page_id.
@@ -139,7 +224,8 @@ class ExtendibleHashTable {
   HASH_TABLE_BUCKET_TYPE *FetchBucketPage(page_id_t bucket_page_id);
 
   /**
-   * Performs insertion with an optional bucket splitting.
+   * Performs insertion with an optional bucket splitting. Called by Insert with no latches held when the key's
+   * bucket is full; takes the table latch in write mode.
    *
    * @param transaction a pointer to the current transaction
    * @param key the key to insert
@@ -148,6 +234,35 @@ class ExtendibleHashTable {
    */
   bool SplitInsert(Transaction *transaction, const KeyType &key, const ValueType &value);
 
+  /**
+   * @param key the key that does not fit into its bucket
+   * @param bucket_page the key's bucket, which is full at the largest directory size
+   * @return whether splitting the key's directory can ever make room for it: some entry of the bucket must hash to
+   * a different root index than the key once the root is as deep as it gets
+   */
+  bool CanSplitDirectory(KeyType key, HASH_TABLE_BUCKET_TYPE *bucket_page);
+
+  /**
+   * Split the directory of a key in two. The root indexes sharing it are halved, doubling the root first if the
+   * directory has only one, and the upper half points to a new directory of the same shape. Each of its buckets takes
+   * the entries of the old one that hash to the upper half. Caller holds the table latch in write mode.
+   *
+   * @param key a key of the directory to split
+   * @return false if the root is as deep as it gets and the directory has a root index to itself, or if the buffer
+   * pool is out of frames; the directory is then left as it was
+   */
+  bool SplitDirectory(KeyType key);
+
+  /**
+   * Writes one directory of a bulk load: its page and the buckets of the partitions
+   * [first_partition, first_partition + 2^global_depth) of order.
+   * @return the directory page id, or INVALID_PAGE_ID if the buffer pool is out of frames
+   */
+  page_id_t BulkLoadDirectory(const std::vector<std::pair<KeyType, ValueType>> &entries,
+                              const std::vector<uint32_t> &hashes, const std::vector<uint32_t> &order,
+                              const std::vector<size_t> &partition_offsets, size_t first_partition,
+                              uint32_t global_depth, std::vector<uint32_t> *overflow);
+
   /**
    * Optionally merges an empty bucket into it's pair.  This is called by Remove,
    * if Remove makes a bucket empty.
@@ -164,11 +279,11 @@ class ExtendibleHashTable {
   void Merge(Transaction *transaction, const KeyType &key, const ValueType &value);
 
   // member variables
-  page_id_t directory_page_id_;
+  page_id_t root_page_id_;
   BufferPoolManager *buffer_pool_manager_;
   KeyComparator comparator_;
 
-  // Readers includes inserts and removes, writers are splits and merges
+  // Readers includes inserts and removes, writers are splits, merges and directory allocation
   ReaderWriterLatch table_latch_;
   HashFunction<KeyType> hash_fn_;
 };
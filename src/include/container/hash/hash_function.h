@@ -14,7 +14,9 @@
 
 #include <cstdint>
 
+#include "common/util/hash_util.h"
 #include "murmur3/MurmurHash3.h"
+#include "storage/index/generic_key.h"
 
 namespace bustub {
 
@@ -33,4 +35,17 @@ class HashFunction {
   }
 };
 
+/**
+ * Index keys are fixed-width byte arrays, hashed a word at a time with a length known at compile time.
+ */
+template <size_t KeySize>
+class HashFunction<GenericKey<KeySize>> {
+ public:
+  /**
+   * @param key the key to be hashed
+   * @return the hashed value
+   */
+  virtual uint64_t GetHash(const GenericKey<KeySize> &key) { return HashUtil::HashFixed<KeySize>(key.data_); }
+};
+
 }  // namespace bustub
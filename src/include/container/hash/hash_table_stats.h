@@ -0,0 +1,72 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// hash_table_stats.h
+//
+// Identification: src/include/container/hash/hash_table_stats.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+namespace bustub {
+
+/** Number of local depths a bucket can have, 0 to log2(DIRECTORY_ARRAY_SIZE). */
+static constexpr size_t NUM_LOCAL_DEPTHS = 10;
+
+/** Number of fill histogram buckets; bucket i counts bucket pages that are [10 * i, 10 * (i + 1)) percent full. */
+static constexpr size_t NUM_FILL_BUCKETS = 11;
+
+/**
+ * A point-in-time summary of the shape of an extendible hash table.
+ *
+ * The directory numbers (depths and page counts) are always exact. The bucket numbers (entries, tombstones, fill and
+ * probe length) cover the sampled bucket pages, all of them unless the table was asked to sample.
+ *
+ * Keys that hash alike show up as a local depth histogram with a long tail: a few buckets many splits deeper than
+ * the rest, while the average fill stays low.
+ */
+struct HashTableStats {
+  /** the largest global depth of any directory */
+  uint32_t global_depth_{0};
+  uint64_t num_directories_{0};
+  uint64_t num_buckets_{0};
+  /** root, directory and bucket pages */
+  uint64_t pages_used_{0};
+  /** local_depth_histogram_[d] is the number of bucket pages with local depth d */
+  std::array<uint64_t, NUM_LOCAL_DEPTHS> local_depth_histogram_{};
+
+  uint64_t num_sampled_buckets_{0};
+  /** slots of a bucket page */
+  uint64_t bucket_capacity_{0};
+  uint64_t num_entries_{0};
+  uint64_t num_tombstones_{0};
+  uint64_t num_full_buckets_{0};
+  std::array<uint64_t, NUM_FILL_BUCKETS> fill_histogram_{};
+  /** sum over sampled buckets of entries times slot groups a lookup scans */
+  uint64_t probe_groups_{0};
+
+  /** @return the fraction of sampled slots holding an entry */
+  double AverageFill() const;
+
+  /** @return the fraction of occupied sampled slots that are tombstones */
+  double TombstoneRatio() const;
+
+  /** @return the average number of slot groups a lookup of a stored key scans */
+  double AverageProbeLength() const;
+
+  /** @return the largest local depth of any bucket */
+  uint32_t MaxLocalDepth() const;
+
+  /** @return a human readable summary */
+  std::string ToString() const;
+};
+
+}  // namespace bustub
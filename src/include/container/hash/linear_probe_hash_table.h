@@ -12,6 +12,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <queue>
 #include <string>
 #include <vector>
@@ -31,7 +32,19 @@ namespace bustub {
 /**
  * Implementation of linear probing hash table that is backed by a buffer pool
  * manager. Non-unique keys are supported. Supports insert and delete. The
- * table dynamically grows once full.
+ * table dynamically grows once half of its slots are occupied.
+ *
+ * Growing is incremental: a resize only allocates the new blocks, and every
+ * following insert and remove migrates MIGRATE_BLOCKS_PER_OP blocks of the old
+ * table into the new one. Until the old table is drained operations probe
+ * both, the old one first. A migration step holds the table latch in read mode
+ * and latches one old block at a time while moving its pairs, so it blocks
+ * only the probes that reach that block; swapping the tables and dropping the
+ * drained one take the table latch in write mode.
+ *
+ * Inserts only claim never-occupied slots, which puts every pair after all
+ * others with its key in the probe sequence; tombstones left by removes are
+ * dropped by the next resize.
  */
 template <typename KeyType, typename ValueType, typename KeyComparator>
 class LinearProbeHashTable : public HashTable<KeyType, ValueType, KeyComparator> {
@@ -43,6 +56,7 @@ class LinearProbeHashTable : public HashTable<KeyType, ValueType, KeyComparator>
    * @param comparator comparator for keys
    * @param num_buckets initial number of buckets contained by this hash table
    * @param hash_fn the hash function
+   * @throws Exception if the buffer pool can not provide the pages of the table
    */
   explicit LinearProbeHashTable(const std::string &name, BufferPoolManager *buffer_pool_manager,
                                 const KeyComparator &comparator, size_t num_buckets, HashFunction<KeyType> hash_fn);
@@ -75,7 +89,9 @@ class LinearProbeHashTable : public HashTable<KeyType, ValueType, KeyComparator>
   bool GetValue(Transaction *transaction, const KeyType &key, std::vector<ValueType> *result) override;
 
   /**
-   * Resizes the table to at least twice the initial size provided.
+   * Resizes the table to at least twice the initial size provided. A resize
+   * that is still migrating is finished first, the new one is left for the
+   * following operations to migrate.
    * @param initial_size the initial size of the hash table
    */
   void Resize(size_t initial_size);
@@ -86,15 +102,84 @@ class LinearProbeHashTable : public HashTable<KeyType, ValueType, KeyComparator>
    */
   size_t GetSize();
 
+  /**
+   * @return true if an incremental resize is still migrating blocks of the old table
+   */
+  bool IsResizing();
+
  private:
+  /** Blocks of the old table an insert or remove migrates while a resize is in progress. */
+  static constexpr size_t MIGRATE_BLOCKS_PER_OP = 2;
+
+  /** In-memory copy of a header page, so probes fetch only block pages. */
+  struct BlockTable {
+    page_id_t header_page_id_{INVALID_PAGE_ID};
+    size_t size_{0};
+    std::vector<page_id_t> block_page_ids_;
+  };
+
+  /**
+   * Allocates the header and block pages of a table with at least num_slots slots.
+   * @return false if the buffer pool could not provide the pages
+   */
+  bool CreateTable(size_t num_slots, BlockTable *table);
+
+  /** Deletes the header and block pages of a table. */
+  void DeleteTable(const BlockTable &table);
+
+  /** Collects the values of key in a table, probing from its hash. */
+  bool GetValueFrom(const BlockTable &table, const KeyType &key, uint64_t hash, std::vector<ValueType> *result);
+
+  /**
+   * Inserts a pair into the first never-occupied slot of its probe sequence in
+   * the current table, crabbing block latches so that concurrent inserts of one
+   * pair see each other.
+   * @return false if the pair already exists or the table is full
+   */
+  bool InsertInto(const KeyType &key, const ValueType &value, uint64_t hash);
+
+  /** Turns the slot holding a pair into a tombstone. */
+  bool RemoveFrom(const BlockTable &table, const KeyType &key, const ValueType &value, uint64_t hash);
+
+  /** Swaps in a table of at least twice initial_size slots and starts migrating into it. */
+  bool BeginResize(size_t initial_size);
+
+  /**
+   * Moves the readable pairs of the next num_blocks old blocks into the current table. Called with the table latch
+   * held in either mode; concurrent calls migrate different blocks.
+   * @return true if every block of the old table has been migrated
+   */
+  bool MigrateBlocks(size_t num_blocks);
+
+  /** Drops the old table once it is drained. Called with the table latch held in write mode. */
+  void FinishResize();
+
+  /**
+   * Migrates, or starts a resize once half of the slots are occupied. Takes the table latch in write mode only to
+   * start or finish a resize.
+   */
+  void Maintain();
+
+  inline Page *FetchBlock(const BlockTable &table, size_t block_ind);
+
   // member variable
-  page_id_t header_page_id_;
   BufferPoolManager *buffer_pool_manager_;
   KeyComparator comparator_;
 
-  // Readers includes inserts and removes, writer is only resize
+  // Readers includes inserts, removes and migration steps, writers swap or drop tables
   ReaderWriterLatch table_latch_;
 
+  // current table and, while resizing, the table being migrated from
+  BlockTable table_;
+  BlockTable old_table_;
+  // next old block to claim for migration, and old blocks already migrated
+  std::atomic<size_t> next_migrate_block_{0};
+  std::atomic<size_t> num_migrated_blocks_{0};
+
+  // occupied slots of the current table, tombstones included, and readable slots of both tables
+  std::atomic<size_t> num_occupied_{0};
+  std::atomic<size_t> num_readable_{0};
+
   // Hash function
   HashFunction<KeyType> hash_fn_;
 };
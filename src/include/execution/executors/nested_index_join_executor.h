@@ -29,6 +29,14 @@ namespace bustub {
 
 /**
  * IndexJoinExecutor executes index join operations.
+ *
+ * Outer tuples are pulled from the child in batches of BATCH_SIZE. The index is probed with all keys of a batch at
+ * once, so indexes that support batched lookups pay for their latches and directory pages once per batch instead of
+ * once per outer tuple.
+ *
+ * The index is only used for a predicate of the form outer_expr = inner.key_column, in either order, where outer_expr
+ * reads only the outer tuple and key_column is the column of a single-column index. For any other predicate, e.g. one
+ * that computes on the inner column or is a conjunction, every outer tuple is joined against the whole inner table.
  */
 class NestIndexJoinExecutor : public AbstractExecutor {
  public:
@@ -48,7 +56,33 @@ class NestIndexJoinExecutor : public AbstractExecutor {
   bool Next(Tuple *tuple, RID *rid) override;
 
  private:
+  /** Number of outer tuples whose keys are looked up in the index together. */
+  static constexpr size_t BATCH_SIZE = 128;
+
+  /**
+   * Join the next batch of outer tuples into results_.
+   * @return false if the child has no more tuples
+   */
+  bool NextBatch();
+
+  /** @return the operand of the predicate to probe the index with, nullptr if the predicate can't use the index */
+  const AbstractExpression *IndexProbeOperand() const;
+
+  /** @return true if expr reads no tuple other than the one at tuple_idx of the join */
+  static bool ReadsOnly(const AbstractExpression *expr, uint32_t tuple_idx);
+
+  /** @return the index key for an outer tuple, the outer operand of the join predicate */
+  Tuple OuterKey(const Tuple &outer_tuple) const;
+
   /** The nested index join plan node. */
   const NestedIndexJoinPlanNode *plan_;
+  std::unique_ptr<AbstractExecutor> child_executor_;
+  TableInfo *inner_table_;
+  IndexInfo *index_info_;
+  /** Outer operand of the predicate to compute index keys from, nullptr to scan the inner table instead. */
+  const AbstractExpression *outer_key_expr_{nullptr};
+  /** Joined tuples of the current batch, results_[cursor_] is the next one to emit. */
+  std::vector<Tuple> results_;
+  size_t cursor_{0};
 };
 }  // namespace bustub
@@ -0,0 +1,70 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// arithmetic_expression.h
+//
+// Identification: src/include/expression/arithmetic_expression.h
+//
+// Copyright (c) 2015-19, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <vector>
+
+#include "common/macros.h"
+#include "execution/expressions/abstract_expression.h"
+
+namespace bustub {
+
+/** ArithmeticType represents the type of computation that we want to perform. */
+enum class ArithmeticType { Plus, Minus };
+
+/**
+ * ArithmeticExpression represents two expressions being added or subtracted.
+ */
+class ArithmeticExpression : public AbstractExpression {
+ public:
+  /** Creates a new arithmetic expression representing (left compute_type right). */
+  ArithmeticExpression(const AbstractExpression *left, const AbstractExpression *right, ArithmeticType compute_type)
+      : AbstractExpression({left, right}, left->GetReturnType()), compute_type_{compute_type} {}
+
+  Value Evaluate(const Tuple *tuple, const Schema *schema) const override {
+    Value lhs = GetChildAt(0)->Evaluate(tuple, schema);
+    Value rhs = GetChildAt(1)->Evaluate(tuple, schema);
+    return PerformComputation(lhs, rhs);
+  }
+
+  Value EvaluateJoin(const Tuple *left_tuple, const Schema *left_schema, const Tuple *right_tuple,
+                     const Schema *right_schema) const override {
+    Value lhs = GetChildAt(0)->EvaluateJoin(left_tuple, left_schema, right_tuple, right_schema);
+    Value rhs = GetChildAt(1)->EvaluateJoin(left_tuple, left_schema, right_tuple, right_schema);
+    return PerformComputation(lhs, rhs);
+  }
+
+  Value EvaluateAggregate(const std::vector<Value> &group_bys, const std::vector<Value> &aggregates) const override {
+    Value lhs = GetChildAt(0)->EvaluateAggregate(group_bys, aggregates);
+    Value rhs = GetChildAt(1)->EvaluateAggregate(group_bys, aggregates);
+    return PerformComputation(lhs, rhs);
+  }
+
+  /** @return the computation this expression performs */
+  ArithmeticType GetArithmeticType() const { return compute_type_; }
+
+ private:
+  Value PerformComputation(const Value &lhs, const Value &rhs) const {
+    switch (compute_type_) {
+      case ArithmeticType::Plus:
+        return lhs.Add(rhs);
+      case ArithmeticType::Minus:
+        return lhs.Subtract(rhs);
+      default:
+        BUSTUB_ASSERT(false, "Unsupported arithmetic type.");
+    }
+  }
+
+  ArithmeticType compute_type_;
+};
+}  // namespace bustub
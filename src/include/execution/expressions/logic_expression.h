@@ -0,0 +1,71 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// logic_expression.h
+//
+// Identification: src/include/expression/logic_expression.h
+//
+// Copyright (c) 2015-19, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <vector>
+
+#include "common/macros.h"
+#include "execution/expressions/abstract_expression.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+/** LogicType represents the type of logic operation that we want to perform. */
+enum class LogicType { And, Or };
+
+/**
+ * LogicExpression represents two boolean expressions combined with AND or OR.
+ */
+class LogicExpression : public AbstractExpression {
+ public:
+  /** Creates a new logic expression representing (left logic_type right). */
+  LogicExpression(const AbstractExpression *left, const AbstractExpression *right, LogicType logic_type)
+      : AbstractExpression({left, right}, TypeId::BOOLEAN), logic_type_{logic_type} {}
+
+  Value Evaluate(const Tuple *tuple, const Schema *schema) const override {
+    Value lhs = GetChildAt(0)->Evaluate(tuple, schema);
+    Value rhs = GetChildAt(1)->Evaluate(tuple, schema);
+    return ValueFactory::GetBooleanValue(PerformLogic(lhs, rhs));
+  }
+
+  Value EvaluateJoin(const Tuple *left_tuple, const Schema *left_schema, const Tuple *right_tuple,
+                     const Schema *right_schema) const override {
+    Value lhs = GetChildAt(0)->EvaluateJoin(left_tuple, left_schema, right_tuple, right_schema);
+    Value rhs = GetChildAt(1)->EvaluateJoin(left_tuple, left_schema, right_tuple, right_schema);
+    return ValueFactory::GetBooleanValue(PerformLogic(lhs, rhs));
+  }
+
+  Value EvaluateAggregate(const std::vector<Value> &group_bys, const std::vector<Value> &aggregates) const override {
+    Value lhs = GetChildAt(0)->EvaluateAggregate(group_bys, aggregates);
+    Value rhs = GetChildAt(1)->EvaluateAggregate(group_bys, aggregates);
+    return ValueFactory::GetBooleanValue(PerformLogic(lhs, rhs));
+  }
+
+  /** @return the logic operation this expression performs */
+  LogicType GetLogicType() const { return logic_type_; }
+
+ private:
+  bool PerformLogic(const Value &lhs, const Value &rhs) const {
+    switch (logic_type_) {
+      case LogicType::And:
+        return lhs.GetAs<bool>() && rhs.GetAs<bool>();
+      case LogicType::Or:
+        return lhs.GetAs<bool>() || rhs.GetAs<bool>();
+      default:
+        BUSTUB_ASSERT(false, "Unsupported logic type.");
+    }
+  }
+
+  LogicType logic_type_;
+};
+}  // namespace bustub
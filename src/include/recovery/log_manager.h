@@ -28,7 +28,7 @@ namespace bustub {
  */
 class LogManager {
  public:
-  explicit LogManager(DiskManager *disk_manager)
+  explicit LogManager(DiskInterface *disk_manager)
       : next_lsn_(0), persistent_lsn_(INVALID_LSN), disk_manager_(disk_manager) {
     log_buffer_ = new char[LOG_BUFFER_SIZE];
     flush_buffer_ = new char[LOG_BUFFER_SIZE];
@@ -68,7 +68,7 @@ class LogManager {
 
   std::condition_variable cv_;
 
-  DiskManager *disk_manager_ __attribute__((__unused__));
+  DiskInterface *disk_manager_ __attribute__((__unused__));
 };
 
 }  // namespace bustub
@@ -0,0 +1,122 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// disk_interface.h
+//
+// Identification: src/include/storage/disk/disk_interface.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <chrono>              // NOLINT
+#include <condition_variable>  // NOLINT
+#include <mutex>               // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+
+#include "common/config.h"
+#include "storage/disk/disk_stats.h"
+
+namespace bustub {
+
+/**
+ * DiskInterface is the abstract storage backend underneath the buffer pool and the log manager: the file-backed
+ * DiskManager, the read-only MmapDiskManager and the in-memory MemoryDiskManager. Callers only read and write pages
+ * and log records through it.
+ *
+ * It also keeps the bookkeeping all backends share: the write and flush counters and the per-operation I/O stats,
+ * which every backend records for every page and log operation, including the ones that fail.
+ */
+class DiskInterface {
+ public:
+  virtual ~DiskInterface();
+
+  /**
+   * Shut down the backend and release its resources.
+   */
+  virtual void ShutDown() = 0;
+
+  /**
+   * Write a page.
+   * @param page_id id of the page
+   * @param page_data raw page data
+   */
+  virtual void WritePage(page_id_t page_id, const char *page_data) = 0;
+
+  /**
+   * Read a page; a page that was never written reads back as zeroes.
+   * @param page_id id of the page
+   * @param[out] page_data output buffer
+   */
+  virtual void ReadPage(page_id_t page_id, char *page_data) = 0;
+
+  /**
+   * Append the log buffer to the log. Returns once it is durable.
+   * @param log_data raw log data
+   * @param size size of log entry
+   */
+  virtual void WriteLog(char *log_data, int size) = 0;
+
+  /**
+   * Read a log entry.
+   * @param[out] log_data output buffer
+   * @param size size of the log entry
+   * @param offset offset of the log entry in the log
+   * @return true if the read was successful, false otherwise
+   */
+  virtual bool ReadLog(char *log_data, int size, int offset) = 0;
+
+  /** @return true if pages can't be written, so that the buffer pool creates no new pages */
+  virtual bool IsReadOnly() const { return false; }
+
+  /** @return the number of log flushes */
+  int GetNumFlushes() const;
+
+  /** @return true iff the in-memory content has not been flushed yet */
+  bool GetFlushState() const;
+
+  /** @return the number of page writes */
+  int GetNumWrites() const;
+
+  /** @return the per-operation I/O counters of this backend */
+  DiskStats &GetStats() { return stats_; }
+
+  /**
+   * Start a background thread that logs the I/O counters every interval, including the throughput over that
+   * interval. Restarts the thread if it is already running.
+   * @param interval time between two dumps
+   */
+  void EnableStatsDump(std::chrono::milliseconds interval);
+
+  /** Stop the stats dump thread, if it is running. */
+  void DisableStatsDump();
+
+ protected:
+  /**
+   * @param name what the stats dump calls this backend, e.g. the database file name
+   */
+  explicit DiskInterface(std::string name);
+
+  std::atomic<int> num_flushes_{0};
+  std::atomic<int> num_writes_{0};
+  std::atomic<bool> flush_log_{false};
+  DiskStats stats_;
+
+ private:
+  /** Stats dump thread body: log the counters every interval until DisableStatsDump() is called. */
+  void StatsDumpLoop(std::chrono::milliseconds interval);
+
+  std::string name_;
+  std::thread stats_dump_thread_;
+  bool stats_dump_enabled_{false};
+  // protects stats_dump_enabled_
+  std::mutex stats_dump_latch_;
+  std::condition_variable stats_dump_cv_;
+};
+
+}  // namespace bustub
@@ -12,55 +12,111 @@
 
 #pragma once
 
-#include <atomic>
 #include <fstream>
 #include <future>  // NOLINT
-#include <mutex>   // NOLINT
+#include <memory>
+#include <mutex>  // NOLINT
 #include <string>
+#include <vector>
 
 #include "common/config.h"
+#include "storage/disk/disk_interface.h"
+#include "storage/disk/log_device.h"
 
 namespace bustub {
 
 /**
  * DiskManager takes care of the allocation and deallocation of pages within a database. It performs the reading and
  * writing of pages to and from disk, providing a logical file layer within the context of a database management system.
+ *
+ * It is the file-backed implementation of DiskInterface; MmapDiskManager and MemoryDiskManager are the others.
+ *
+ * Every page written gets a CRC32C checksum that ReadPage verifies, so a torn or corrupted page is reported when it is
+ * read instead of surfacing later as corrupt tuples. Pages have no common header to hold the checksum (hash table
+ * buckets use every byte), so the checksums live in checksum blocks of their own, and every block in the file stays
+ * PAGE_SIZE aligned:
+ *
+ *   | file header | checksum block 0 | pages 0 .. N-1 | checksum block 1 | pages N .. 2N-1 | ...
+ *
+ * with N = PAGES_PER_CHECKSUM_BLOCK. A checksum entry also records that its page was written, so a page that was never
+ * written, e.g. the hole left by writing a later page first, is told apart from one that was. The disk manager keeps
+ * all entries in memory, so reads cost no extra I/O; a write updates the page and then its entry.
+ *
+ * A file without the header is a database file from before checksums, with pages at PAGE_SIZE stride. It is read and
+ * written in that layout, without checksums.
  */
-class DiskManager {
+class DiskManager : public DiskInterface {
  public:
+  /** The first bytes of a database file with checksums. */
+  static constexpr uint64_t FILE_MAGIC = 0x314b434255545342;  // "BSTUBCK1"
+  /** Checksum entries per checksum block, each entry is a checksum and a written flag. */
+  static constexpr size_t PAGES_PER_CHECKSUM_BLOCK = PAGE_SIZE / (2 * sizeof(uint32_t));
+
+  /**
+   * @param page_id id of the page
+   * @return the offset of the page in a database file with checksums
+   */
+  static size_t PageOffset(page_id_t page_id);
+
+  /**
+   * @param page_id id of the page
+   * @return the offset of the checksum entry of the page in a database file with checksums
+   */
+  static size_t ChecksumOffset(page_id_t page_id);
+
+  /**
+   * @param data the start of a database file
+   * @param size number of bytes at data
+   * @return true if the file has the header of a database file with checksums
+   */
+  static bool HasFileHeader(const char *data, size_t size);
+
+  /** When ReadPage verifies page checksums. */
+  enum class ChecksumVerification {
+    /** Never verify; checksums are still maintained by WritePage. */
+    NEVER = 0,
+    /** Verify a page the first time it is read after startup, e.g. to catch torn writes of the last run. */
+    FIRST_READ,
+    /** Verify every read. */
+    ALWAYS,
+  };
+
   /**
    * Creates a new disk manager that writes to the specified database file.
    * @param db_file the file name of the database file to write to
+   * @param log_sync_mode how the log device makes log writes durable
    */
-  explicit DiskManager(const std::string &db_file);
+  explicit DiskManager(const std::string &db_file, LogDevice::SyncMode log_sync_mode = LogDevice::SyncMode::FDATASYNC);
 
-  ~DiskManager() = default;
+  ~DiskManager() override = default;
 
   /**
    * Shut down the disk manager and close all the file resources.
    */
-  void ShutDown();
+  void ShutDown() override;
 
   /**
    * Write a page to the database file.
    * @param page_id id of the page
    * @param page_data raw page data
    */
-  void WritePage(page_id_t page_id, const char *page_data);
+  void WritePage(page_id_t page_id, const char *page_data) override;
 
   /**
    * Read a page from the database file.
    * @param page_id id of the page
    * @param[out] page_data output buffer
+   * @throws Exception if the page does not match the checksum it was written with
    */
-  void ReadPage(page_id_t page_id, char *page_data);
+  void ReadPage(page_id_t page_id, char *page_data) override;
 
   /**
-   * Flush the entire log buffer into disk.
+   * Flush the entire log buffer into disk. Returns once the log device has synced it.
    * @param log_data raw log data
    * @param size size of log entry
+   * @throws Exception if the log device failed to write or sync it
    */
-  void WriteLog(char *log_data, int size);
+  void WriteLog(char *log_data, int size) override;
 
   /**
    * Read a log entry from the log file.
@@ -69,16 +125,13 @@ class DiskManager {
    * @param offset offset of the log entry in the file
    * @return true if the read was successful, false otherwise
    */
-  bool ReadLog(char *log_data, int size, int offset);
-
-  /** @return the number of disk flushes */
-  int GetNumFlushes() const;
+  bool ReadLog(char *log_data, int size, int offset) override;
 
-  /** @return true iff the in-memory content has not been flushed yet */
-  bool GetFlushState() const;
-
-  /** @return the number of disk writes */
-  int GetNumWrites() const;
+  /**
+   * Set when ReadPage verifies page checksums, ALWAYS by default. Files from before checksums are never verified.
+   * @param verification the new verification mode
+   */
+  void SetChecksumVerification(ChecksumVerification verification);
 
   /**
    * Sets the future which is used to check for non-blocking flushes.
@@ -89,20 +142,43 @@ class DiskManager {
   /** Checks if the non-blocking flush future was set. */
   inline bool HasFlushLogFuture() { return flush_log_f_ != nullptr; }
 
+  /** @return true if the database file has checksums, false for a file from before checksums */
+  bool HasChecksums() const { return has_checksums_; }
+
  private:
-  int GetFileSize(const std::string &file_name);
-  // stream to write log file
-  std::fstream log_io_;
+  /** The checksum entry of a page, as stored in a checksum block. */
+  struct ChecksumEntry {
+    uint32_t checksum_;
+    // non-zero once the page was written
+    uint32_t written_;
+  };
+  static_assert(sizeof(ChecksumEntry) * PAGES_PER_CHECKSUM_BLOCK == PAGE_SIZE, "checksum block must fill a page");
+
+  int64_t GetFileSize(const std::string &file_name);
+  /** Write the header of a new file, or detect the layout of an existing one and load its checksum entries. */
+  void OpenLayout();
+  /** @return the offset of the page in the database file, in the layout of the file */
+  size_t LayoutPageOffset(page_id_t page_id) const;
+  static uint32_t PageChecksum(const char *page_data);
+
+  // device to append to and read from the log file
+  std::unique_ptr<LogDevice> log_device_;
   std::string log_name_;
+  // the previous buffer passed to WriteLog, to enforce that the caller swaps log buffers
+  const char *last_log_buffer_{nullptr};
   // stream to write db file
   std::fstream db_io_;
   std::string file_name_;
-  int num_flushes_;
-  int num_writes_;
-  bool flush_log_;
-  std::future<void> *flush_log_f_;
+  // false for a file from before checksums
+  bool has_checksums_{true};
+  // the checksum entries of all pages, by page id
+  std::vector<ChecksumEntry> checksums_;
+  // pages that have been verified since startup, for ChecksumVerification::FIRST_READ
+  std::vector<bool> verified_;
+  ChecksumVerification checksum_verification_{ChecksumVerification::ALWAYS};
   // With multiple buffer pool instances, need to protect file access
   std::mutex db_io_latch_;
+  std::future<void> *flush_log_f_{nullptr};
 };
 
 }  // namespace bustub
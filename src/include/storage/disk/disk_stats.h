@@ -0,0 +1,117 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// disk_stats.h
+//
+// Identification: src/include/storage/disk/disk_stats.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <string>
+
+namespace bustub {
+
+/** The kinds of I/O a disk manager issues. */
+enum class IOType {
+  PAGE_READ = 0,
+  PAGE_WRITE,
+  /** A log write, from the caller handing over the log buffer until it is durable. */
+  LOG_WRITE,
+  /** A single device sync (fdatasync, sync_file_range, ...) issued by the log device. */
+  SYNC,
+};
+
+static constexpr size_t NUM_IO_TYPES = 4;
+
+/**
+ * Number of latency histogram buckets. Bucket 0 counts zero-latency operations and bucket i > 0 counts operations that
+ * took [2^(i-1), 2^i) nanoseconds; the last bucket is open ended (2^38 ns is about four and a half minutes).
+ */
+static constexpr size_t NUM_LATENCY_BUCKETS = 40;
+
+/**
+ * A point-in-time copy of the counters of one I/O type.
+ */
+struct IOStats {
+  uint64_t count_{0};
+  uint64_t bytes_{0};
+  uint64_t total_latency_ns_{0};
+  std::array<uint64_t, NUM_LATENCY_BUCKETS> latency_histogram_{};
+
+  /** @return the average latency in nanoseconds, 0 if there were no operations */
+  uint64_t AverageLatency() const;
+
+  /**
+   * @param percentile a value in [0, 100]
+   * @return the upper bound in nanoseconds of the histogram bucket holding the given percentile
+   */
+  uint64_t LatencyPercentile(double percentile) const;
+
+  /** @return the operations recorded between other and this snapshot */
+  IOStats operator-(const IOStats &other) const;
+};
+
+/**
+ * DiskStats collects per-operation counters for a disk manager: number of operations, bytes transferred and a
+ * log-scale latency histogram for each IOType.
+ *
+ * Recording is lock-free; every counter is a relaxed atomic, so concurrent buffer pool instances only share the cache
+ * lines of the I/O type they touch. Readers get a snapshot that may be torn across counters (e.g. count_ may already
+ * include an operation whose bytes_ are not yet visible), which is fine for monitoring.
+ */
+class DiskStats {
+ public:
+  DiskStats() = default;
+
+  /**
+   * Record one completed operation.
+   * @param type the kind of operation
+   * @param bytes number of bytes transferred
+   * @param latency how long the operation took
+   */
+  void Record(IOType type, size_t bytes, std::chrono::nanoseconds latency);
+
+  /** @return a snapshot of the counters of the given I/O type */
+  IOStats Get(IOType type) const;
+
+  /** @return a snapshot of the counters of every I/O type, indexed by IOType */
+  std::array<IOStats, NUM_IO_TYPES> Snapshot() const;
+
+  /** Zero all counters. */
+  void Reset();
+
+  /** @return a human readable summary of everything recorded so far */
+  std::string ToString() const;
+
+  /**
+   * Format a snapshot, one line per I/O type.
+   * @param stats the counters to format
+   * @param elapsed the time the counters were collected over, used for throughput; zero omits throughput
+   */
+  static std::string Format(const std::array<IOStats, NUM_IO_TYPES> &stats,
+                            std::chrono::nanoseconds elapsed = std::chrono::nanoseconds(0));
+
+  /** @return the name of the given I/O type */
+  static const char *TypeName(IOType type);
+
+ private:
+  /** Counters of one I/O type, on their own cache lines so that I/O types do not false-share. */
+  struct alignas(64) Counters {
+    std::atomic<uint64_t> count_{0};
+    std::atomic<uint64_t> bytes_{0};
+    std::atomic<uint64_t> total_latency_ns_{0};
+    std::array<std::atomic<uint64_t>, NUM_LATENCY_BUCKETS> latency_histogram_{};
+  };
+
+  std::array<Counters, NUM_IO_TYPES> counters_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,153 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// log_device.h
+//
+// Identification: src/include/storage/disk/log_device.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <condition_variable>  // NOLINT
+#include <deque>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "common/config.h"
+#include "storage/disk/disk_stats.h"
+
+namespace bustub {
+
+/**
+ * LogDevice is an append-only writer for the log file.
+ *
+ * Appenders copy their bytes into the active buffer of a ring of in-memory buffers and get back the file offset just
+ * past their data. A dedicated I/O thread drains sealed buffers in order, writes them with a single writev() on an
+ * O_APPEND descriptor and makes them durable with one device sync, so every buffer that was sealed while the previous
+ * sync was in progress is committed together. Appenders only block when every buffer is waiting for the device.
+ *
+ * WaitForDurable(offset) seals the active buffer if it holds bytes before offset, then waits for the I/O thread;
+ * commit latency is therefore bounded by the sync in progress plus one more.
+ *
+ * A failed write or sync fails the device for good: durable_offset_ stops advancing, later buffers are dropped
+ * unwritten, and every waiter for bytes past the durable offset gets an exception instead of an acknowledgement.
+ */
+class LogDevice {
+ public:
+  /** How the I/O thread makes written bytes durable. */
+  enum class SyncMode {
+    /** write() followed by fdatasync(). */
+    FDATASYNC = 0,
+    /** Open the file with O_DSYNC, every write() is synchronous. */
+    DSYNC,
+    /**
+     * write() followed by sync_file_range() over the written range. Cheaper, but does not flush file metadata or the
+     * drive's volatile cache; only use it on devices with power-loss protection.
+     */
+    SYNC_FILE_RANGE,
+  };
+
+  /**
+   * Opens (or creates) the log file and starts the I/O thread.
+   * @param log_file the file name of the log file
+   * @param sync_mode how written bytes are made durable
+   * @param num_buffers number of rotating log buffers, at least 2
+   * @param buffer_size size of each log buffer in bytes
+   * @param stats where device syncs are recorded, may be nullptr
+   */
+  explicit LogDevice(const std::string &log_file, SyncMode sync_mode = SyncMode::FDATASYNC, size_t num_buffers = 2,
+                     size_t buffer_size = LOG_BUFFER_SIZE, DiskStats *stats = nullptr);
+
+  ~LogDevice();
+
+  /**
+   * Make everything appended so far durable, stop the I/O thread and close the file.
+   */
+  void Close();
+
+  /**
+   * Append bytes to the log.
+   * @param data raw log data
+   * @param size number of bytes to append
+   * @return the file offset just past the appended bytes
+   */
+  uint64_t Append(const char *data, size_t size);
+
+  /**
+   * Block until every byte before offset is durable.
+   * @param offset a file offset returned by Append
+   * @throws Exception if the device failed before the bytes became durable
+   */
+  void WaitForDurable(uint64_t offset);
+
+  /**
+   * Read bytes from the log file.
+   * @param[out] data output buffer
+   * @param size number of bytes to read
+   * @param offset offset in the log file
+   * @return false if offset is at or past the end of the file, true otherwise
+   */
+  bool Read(char *data, size_t size, uint64_t offset);
+
+  /** @return the offset up to which the log is durable */
+  uint64_t GetDurableOffset();
+
+  /** @return true if a write or sync has failed, after which no more bytes become durable */
+  bool HasFailed();
+
+  /** @return the number of device syncs issued so far */
+  uint64_t GetNumSyncs();
+
+ private:
+  struct Buffer {
+    std::unique_ptr<char[]> data_;
+    size_t size_{0};
+  };
+
+  /** Hand the active buffer to the I/O thread. Caller must hold latch_ and the active buffer must be non-empty. */
+  void SealActive();
+
+  /** I/O thread body: drain sealed buffers until Close() is called. */
+  void FlushLoop();
+
+  /** Write the given buffers with a single writev() and sync them. @return false if the write or the sync failed */
+  bool WriteAndSync(const std::vector<size_t> &buffers);
+
+  int fd_{-1};
+  const SyncMode sync_mode_;
+  const size_t buffer_size_;
+  DiskStats *const stats_;
+  std::vector<Buffer> buffers_;
+  /** Index of the buffer appenders currently copy into, only meaningful if has_active_. */
+  size_t active_{0};
+  bool has_active_{false};
+  /** Buffers sealed and waiting for the I/O thread, in log order. */
+  std::deque<size_t> sealed_;
+  /** Buffers available to become the active buffer. */
+  std::deque<size_t> free_;
+  /** Offset just past the last appended byte. */
+  uint64_t appended_offset_{0};
+  /** Offset just past the last durable byte. */
+  uint64_t durable_offset_{0};
+  uint64_t num_syncs_{0};
+  bool closed_{false};
+  /** Set once a write or sync has failed. */
+  bool failed_{false};
+
+  /** Protects all of the buffer bookkeeping above. */
+  std::mutex latch_;
+  /** Signaled when buffers are sealed or the device is closed. */
+  std::condition_variable flush_cv_;
+  /** Signaled when buffers become free and durable_offset_ advances. */
+  std::condition_variable durable_cv_;
+  std::thread flush_thread_;
+};
+
+}  // namespace bustub
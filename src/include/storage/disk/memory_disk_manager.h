@@ -0,0 +1,112 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// memory_disk_manager.h
+//
+// Identification: src/include/storage/disk/memory_disk_manager.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <chrono>  // NOLINT
+#include <memory>
+#include <mutex>  // NOLINT
+#include <vector>
+
+#include "common/config.h"
+#include "storage/disk/disk_interface.h"
+
+namespace bustub {
+
+/**
+ * MemoryDiskManager keeps the database and the log in memory. It backs benchmarks and ephemeral tables (e.g. the
+ * TmpTuplePage spill pages of executors) that do not need durability.
+ *
+ * Pages live in a sparse vector indexed by page id; a slot is only allocated when its page is first written, and
+ * reading a page that was never written returns zeroes just like reading past the end of a database file.
+ *
+ * An optional DeviceModel adds a fixed per-operation latency and a bandwidth cap to every page and log access, so
+ * benchmarks can run against reproducible device characteristics instead of whatever disk the machine happens to
+ * have. Simulated transfers are serialized, as on a single-queue device.
+ */
+class MemoryDiskManager : public DiskInterface {
+ public:
+  /** Simulated device characteristics. A zero value disables the corresponding delay. */
+  struct DeviceModel {
+    /** Fixed latency charged to every read or write. */
+    std::chrono::microseconds latency_{0};
+    /** Transfer bandwidth in bytes per second. */
+    uint64_t bandwidth_{0};
+  };
+
+  /**
+   * Creates a new in-memory disk manager without simulated delays.
+   */
+  MemoryDiskManager();
+
+  /**
+   * Creates a new in-memory disk manager.
+   * @param device_model simulated device characteristics
+   */
+  explicit MemoryDiskManager(DeviceModel device_model);
+
+  ~MemoryDiskManager() override = default;
+
+  /**
+   * Release all pages and log records.
+   */
+  void ShutDown() override;
+
+  /**
+   * Write a page to memory.
+   * @param page_id id of the page
+   * @param page_data raw page data
+   */
+  void WritePage(page_id_t page_id, const char *page_data) override;
+
+  /**
+   * Read a page from memory.
+   * @param page_id id of the page
+   * @param[out] page_data output buffer
+   */
+  void ReadPage(page_id_t page_id, char *page_data) override;
+
+  /**
+   * Append the log buffer to the in-memory log.
+   * @param log_data raw log data
+   * @param size size of log entry
+   */
+  void WriteLog(char *log_data, int size) override;
+
+  /**
+   * Read a log entry from the in-memory log.
+   * @param[out] log_data output buffer
+   * @param size size of the log entry
+   * @param offset offset of the log entry in the log
+   * @return true if the read was successful, false otherwise
+   */
+  bool ReadLog(char *log_data, int size, int offset) override;
+
+ private:
+  /**
+   * Block the caller for as long as the simulated device needs to transfer the given number of bytes.
+   * @return the time spent in the device, including the wait for earlier transfers to finish
+   */
+  std::chrono::steady_clock::duration SimulateTransfer(size_t bytes);
+
+  const DeviceModel device_model_;
+  /** Pages indexed by page id, nullptr if the page was never written. */
+  std::vector<std::unique_ptr<char[]>> pages_;
+  /** The log, as one contiguous byte stream. */
+  std::vector<char> log_;
+  /** Protects pages_ and log_. */
+  std::mutex latch_;
+  /** Serializes simulated transfers. */
+  std::mutex device_latch_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,103 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// mmap_disk_manager.h
+//
+// Identification: src/include/storage/disk/mmap_disk_manager.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <string>
+
+#include "common/config.h"
+#include "storage/disk/disk_interface.h"
+
+namespace bustub {
+
+/**
+ * MmapDiskManager is a read-only disk backend that maps the whole database file into memory. It is meant for
+ * read-only reporting replicas: ReadPage is a memcpy out of the mapping instead of a seek + read syscall pair, and
+ * the kernel's page cache is steered with madvise hints derived from the observed access pattern.
+ *
+ * The mapping is advised MADV_RANDOM so point lookups do not drag in readahead. Once ReadPage sees a run of
+ * SEQUENTIAL_THRESHOLD consecutive page ids, it asks for the next READAHEAD_PAGES pages with MADV_WILLNEED, keeping
+ * one window ahead of the scan until the run breaks.
+ *
+ * The file is mapped once at construction; pages beyond the end of the file at that time read back as zeroes. Pages
+ * are laid out as DiskManager writes them, with or without checksum blocks; checksums are not verified. Any attempt
+ * to write a page or a log record throws, so a buffer pool on top of it creates no pages and fails to evict a page
+ * that was unpinned dirty.
+ */
+class MmapDiskManager : public DiskInterface {
+ public:
+  /** Number of consecutive page reads after which an access pattern is treated as a sequential scan. */
+  static constexpr int SEQUENTIAL_THRESHOLD = 4;
+  /** Number of pages to prefetch ahead of a sequential scan. */
+  static constexpr int READAHEAD_PAGES = 32;
+
+  /**
+   * Creates a new read-only disk manager over the specified database file.
+   * @param db_file the file name of the database file to map
+   */
+  explicit MmapDiskManager(const std::string &db_file);
+
+  ~MmapDiskManager() override;
+
+  /**
+   * Unmap the database file and close it.
+   */
+  void ShutDown() override;
+
+  /**
+   * Always throws: the mapping is read-only.
+   */
+  void WritePage(page_id_t page_id, const char *page_data) override;
+
+  /**
+   * Copy a page out of the mapping.
+   * @param page_id id of the page
+   * @param[out] page_data output buffer
+   */
+  void ReadPage(page_id_t page_id, char *page_data) override;
+
+  /**
+   * Throws if log_data is non-empty: read-only replicas do not generate log records.
+   */
+  void WriteLog(char *log_data, int size) override;
+
+  /**
+   * Read-only replicas have no log file.
+   * @return always false
+   */
+  bool ReadLog(char *log_data, int size, int offset) override;
+
+  /** @return always true */
+  bool IsReadOnly() const override { return true; }
+
+ private:
+  /** Update the scan detector with the page just read and issue readahead hints. */
+  void AdviseAccess(page_id_t page_id);
+  /** @return the offset of the page in the mapping, in the layout of the file */
+  size_t PageOffset(page_id_t page_id) const;
+
+  std::string file_name_;
+  int fd_{-1};
+  /** Start of the mapping, nullptr if the file was empty or the manager was shut down. */
+  char *data_{nullptr};
+  /** Size of the mapping in bytes. */
+  size_t size_{0};
+  /** False for a file from before checksums, which has no header and no checksum blocks. */
+  bool has_checksums_{false};
+  /** Page id of the most recent read, used to detect sequential scans. */
+  std::atomic<page_id_t> last_page_id_{INVALID_PAGE_ID};
+  /** Length of the current run of consecutive page reads. */
+  std::atomic<int> sequential_run_{0};
+};
+
+}  // namespace bustub
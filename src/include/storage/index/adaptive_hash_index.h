@@ -0,0 +1,80 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// adaptive_hash_index.h
+//
+// Identification: src/include/storage/index/adaptive_hash_index.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <mutex>  // NOLINT
+#include <vector>
+
+#include "common/config.h"
+#include "container/hash/hash_function.h"
+
+namespace bustub {
+
+/**
+ * An in-memory map from the keys a BPlusTree looks up most to the leaf and slot they were found at, so that point
+ * lookups of hot keys go straight to their leaf instead of descending from the root.
+ *
+ * The map is a fixed array of buckets, each remembering a single key. Every descent for a key votes for it in its
+ * bucket and against any other key there; a key takes over the bucket once the votes against the previous one have
+ * run out, and its leaf is handed out once it has won threshold votes in a row. So a bucket ends up with the key that
+ * is looked up most of those hashed to it, without keeping a count for every key.
+ *
+ * The map holds no pins or latches. A leaf it hands out is only a hint: the caller checks that it is still a live
+ * leaf whose fences cover the key, and that the slot still holds the key, before trusting either.
+ */
+template <typename KeyType, typename KeyComparator>
+class AdaptiveHashIndex {
+ public:
+  /** The number of descents after which a key is hot. */
+  static constexpr uint32_t DEFAULT_THRESHOLD = 2;
+
+  AdaptiveHashIndex(size_t num_buckets, const KeyComparator &comparator, uint32_t threshold = DEFAULT_THRESHOLD);
+
+  /**
+   * @return true and the leaf and slot key was last found at if the key is hot, false otherwise. The slot is -1 if
+   * the key was not in the leaf.
+   */
+  bool Lookup(const KeyType &key, page_id_t *page_id, int *slot);
+
+  /** Records a descent that ended at the slot of key in a leaf, or -1 if the key was not there. */
+  void RecordDescent(const KeyType &key, page_id_t page_id, int slot);
+
+  /** Forgets the leaf of key, after it turned out to be stale. */
+  void Invalidate(const KeyType &key);
+
+  /** @return the number of lookups that found a hot key */
+  size_t GetHitCount() const { return hits_; }
+
+ private:
+  struct Bucket {
+    KeyType key_;
+    page_id_t page_id_{INVALID_PAGE_ID};
+    int slot_{-1};
+    uint32_t votes_{0};
+  };
+
+  /** Buckets share latches in stripes, which keeps the latches few and the buckets small. */
+  static constexpr size_t NUM_STRIPES = 64;
+
+  size_t BucketIndex(const KeyType &key) { return hash_fn_.GetHash(key) % buckets_.size(); }
+
+  std::vector<Bucket> buckets_;
+  std::vector<std::mutex> latches_;
+  KeyComparator comparator_;
+  HashFunction<KeyType> hash_fn_;
+  uint32_t threshold_;
+  std::atomic<size_t> hits_{0};
+};
+
+}  // namespace bustub
@@ -10,12 +10,17 @@
 //===----------------------------------------------------------------------===//
 #pragma once
 
+#include <deque>
+#include <memory>
 #include <queue>
 #include <string>
 #include <vector>
 
+#include "common/rwlatch.h"
 #include "concurrency/transaction.h"
+#include "storage/index/adaptive_hash_index.h"
 #include "storage/index/index_iterator.h"
+#include "storage/page/b_plus_tree_buffer_page.h"
 #include "storage/page/b_plus_tree_internal_page.h"
 #include "storage/page/b_plus_tree_leaf_page.h"
 
@@ -23,40 +28,130 @@ namespace bustub {
 
 #define BPLUSTREE_TYPE BPlusTree<KeyType, ValueType, KeyComparator>
 
+/**
+ * BPLUSTREE_FILL_FACTOR is how full, in percent, BulkLoad() leaves pages by default, so that the first inserts after
+ * the load do not split every leaf.
+ */
+#define BPLUSTREE_FILL_FACTOR 90
+
+/**
+ * BPLUSTREE_BUFFERED_FANOUT caps the children of an internal page in buffered mode. A page of a few hundred children
+ * sends only a message or two to each when its buffer flushes, so a leaf would still be written about once per write;
+ * with fewer children per page, each flush moves a batch, at the cost of a taller tree.
+ */
+#define BPLUSTREE_BUFFERED_FANOUT 16
+
+/**
+ * How writers of a BPlusTree change its structure:
+ * LATCH_COUPLING: a split or merge holds write latches on every page it changes, from the highest one down.
+ * B_LINK: a split latches one page at a time and pages never merge (Lehman and Yao), see BPlusTree.
+ * BUFFERED: writes are buffered as messages in internal pages and reach the leaves in batches (a B^epsilon tree).
+ */
+enum class BPlusTreeMode { LATCH_COUPLING, B_LINK, BUFFERED };
+
 /**
  * Main class providing the API for the Interactive B+ Tree.
  *
  * Implementation of simple b+ tree data structure where internal pages direct
  * the search and leaf pages contain actual data.
- * (1) We only support unique key
+ * (1) Keys are unique, or, in a non-unique tree, stored once with a posting list of all their values (see PostingList)
  * (2) support insert & remove
  * (3) The structure should shrink and grow dynamically
  * (4) Implement index iterator for range scan
+ *
+ * Concurrency: readers crab down with read latches, holding at most a parent and a child at a time. Iterators copy
+ * out a leaf at a time and hold no latches in between (see IndexIterator). Writers first try
+ * an optimistic descent that read-latches internal pages and write-latches only the leaf; if the leaf could split or
+ * underflow, they let go of everything and descend again with write latches, releasing the ancestors as soon as a
+ * page is found that cannot split or underflow. The root page id is protected by its own latch, which pessimistic
+ * writers hold for as long as the root itself may change.
+ *
+ * In B-link mode, every page links to its right sibling, whose low fence is the page's high fence. A split links
+ * the new page into its level first and releases the page it split before it latches the parent to add the
+ * separator, so writers hold a single latch at a time, apart from moving right. Readers and writers that reach a page
+ * whose high fence is at or below their key, because it split after they read its parent, move right along the
+ * links instead of starting over. Writers find the parent through the pages they visited on the way down. Pages never
+ * merge: removes only take entries out of leaves, which may empty out, and the tree does not shrink. Parent page ids
+ * are not kept up to date.
+ *
+ * In buffered mode, which needs a unique tree, writes do not go down to the leaves. An insert, upsert or delete is
+ * added as a message to the buffer page of the root (see BPlusTreeBufferPage), where it is combined with any older
+ * message of its key. Insert() looks its key up first to report a duplicate, so only upserts and deletes are blind
+ * writes. When a buffer is full, the messages for the child with the most of them move down into the child's buffer,
+ * or are applied to the child if it is a leaf; so a leaf is written once for a batch of writes rather than once for
+ * each.
+ * Internal pages have at most BPLUSTREE_BUFFERED_FANOUT children, so that the batches are large. A newer message of a
+ * key is always above an older one, and GetValue() returns the first upsert or delete of the key it meets on the way
+ * down, or else the leaf entry, with the oldest insert it passed filling in for a missing value. Scans flush all
+ * buffers first (see FlushBuffers()). Writers are serialized by the root latch, which readers hold until they reach a
+ * leaf, so only leaves are latched while a writer changes them. Pages never merge, like in B-link mode.
+ *
+ * Point lookups may go through an adaptive hash index (see AdaptiveHashIndex), which learns the leaves of the keys
+ * looked up most and lets GetValue() latch them directly. A leaf from the hash index is used only if it is still a
+ * live leaf whose fences cover the key; otherwise the lookup descends from the root as usual.
+ *
+ * A leaf holds up to leaf_max_size - 1 entries and splits when it reaches leaf_max_size. An internal page holds up to
+ * internal_max_size children and splits when it exceeds it, so it needs room for one more entry and
+ * internal_max_size must be at least 3. Pages also split when they run out of bytes, since keys are stored truncated
+ * (see BPlusTreePage) and take varying space; a page counts as half full by entries or by bytes.
  */
 INDEX_TEMPLATE_ARGUMENTS
 class BPlusTree {
   using InternalPage = BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator>;
   using LeafPage = BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>;
+  using BufferPage = BPlusTreeBufferPage<KeyType, ValueType, KeyComparator>;
+  using Message = typename BufferPage::Message;
 
  public:
   explicit BPlusTree(std::string name, BufferPoolManager *buffer_pool_manager, const KeyComparator &comparator,
-                     int leaf_max_size = LEAF_PAGE_SIZE, int internal_max_size = INTERNAL_PAGE_SIZE);
+                     int leaf_max_size = LEAF_PAGE_SIZE, int internal_max_size = INTERNAL_PAGE_SIZE,
+                     bool unique = true, BPlusTreeMode mode = BPlusTreeMode::LATCH_COUPLING);
 
   // Returns true if this B+ tree has no keys and values.
   bool IsEmpty() const;
 
-  // Insert a key-value pair into this B+ tree.
+  // Insert a key-value pair into this B+ tree; a non-unique tree rejects only a pair that it holds already.
   bool Insert(const KeyType &key, const ValueType &value, Transaction *transaction = nullptr);
 
-  // Remove a key and its value from this B+ tree.
+  // Remove a key and all of its values from this B+ tree.
   void Remove(const KeyType &key, Transaction *transaction = nullptr);
 
-  // return the value associated with a given key
+  // Remove a key-value pair from this B+ tree.
+  void Remove(const KeyType &key, const ValueType &value, Transaction *transaction = nullptr);
+
+  // return the values associated with a given key
   bool GetValue(const KeyType &key, std::vector<ValueType> *result, Transaction *transaction = nullptr);
 
+  // Set the value of a key, inserting it if it is missing; a non-unique tree adds the value, like Insert().
+  void Upsert(const KeyType &key, const ValueType &value, Transaction *transaction = nullptr);
+
+  // apply all buffered messages to the leaves; a no-op unless the tree is in buffered mode
+  void FlushBuffers();
+
+  // look up hot keys through an adaptive hash index of num_buckets buckets; call before the tree is shared
+  void EnableAdaptiveHashIndex(size_t num_buckets);
+
+  // the adaptive hash index, or nullptr if it is not enabled
+  const AdaptiveHashIndex<KeyType, KeyComparator> *GetAdaptiveHashIndex() const { return adaptive_hash_index_.get(); }
+
+  /**
+   * Builds the tree bottom-up from sorted pairs: leaves are written left to right at fill_factor percent full, in
+   * entries and in bytes, then each internal level above them, so every page is written once and no page ever
+   * splits. Pages are filled to at least half full whatever the fill factor. Pairs that do not extend the sorted run, e.g. duplicates, and all
+   * pairs loaded into a non-empty tree go through Insert().
+   * @return true if every pair was loaded, false if Insert() refused some, e.g. a duplicate key of a unique tree
+   */
+  bool BulkLoad(const std::vector<MappingType> &entries, int fill_factor = BPLUSTREE_FILL_FACTOR,
+                Transaction *transaction = nullptr);
+
   // index iterator
   INDEXITERATOR_TYPE Begin();
   INDEXITERATOR_TYPE Begin(const KeyType &key);
+  // forward range scan from key up to end_key, which is included if end_inclusive
+  INDEXITERATOR_TYPE Begin(const KeyType &key, const KeyType &end_key, bool end_inclusive = true);
+  // backward scan from the last pair, or from the last pair with a key up to key, which is included if inclusive
+  INDEXITERATOR_TYPE RBegin();
+  INDEXITERATOR_TYPE RBegin(const KeyType &key, bool inclusive = true);
   INDEXITERATOR_TYPE End();
 
   // print the B+ tree
@@ -70,26 +165,120 @@ class BPlusTree {
 
   // read data from file and remove one by one
   void RemoveFromFile(const std::string &file_name, Transaction *transaction = nullptr);
-  // expose for test purpose
+  // expose for test purpose; the leaf comes back pinned and read-latched, or nullptr if the tree is empty
   Page *FindLeafPage(const KeyType &key, bool leftMost = false);
 
  private:
+  friend class IndexIterator<KeyType, ValueType, KeyComparator>;
+
+  enum class Operation { INSERT, REMOVE };
+
+  /** Latches held by a pessimistic writer: the root latch, the write-latched pages top-down and the pages it freed. */
+  struct WriteContext {
+    bool root_latched_{false};
+    std::deque<Page *> path_;
+    std::vector<page_id_t> deleted_pages_;
+  };
+
+  /** Node sizes and low fences of every level of a bulk load, bottom-up, and the rightmost page of each level. */
+  struct BulkLoadLevels {
+    std::vector<std::vector<int>> node_sizes_;
+    std::vector<std::vector<KeyType>> node_lows_;
+    std::vector<Page *> open_pages_;
+    std::vector<size_t> nodes_started_;
+  };
+
+  // build an empty tree from strictly increasing pairs; the root latch is held
+  void BulkLoadSorted(const MappingType *entries, int count, int fill_factor);
+
+  // append a child to the rightmost page of a level, starting a new page when it is full; returns that page's id
+  page_id_t BulkLoadAppend(size_t level, const KeyType &key, page_id_t child_page_id, BulkLoadLevels *levels);
+
+  Page *FetchNode(page_id_t page_id);
+
+  // the leaf with the greatest keys below key, or the rightmost leaf if key is nullptr; like FindLeafPage()
+  Page *FindLeafPageBefore(const KeyType *key);
+
+  // read-latch crabbing down to the leaf that covers key, or the keys before it if before; a key of nullptr goes to
+  // the leftmost leaf, or the rightmost if before. The internal pages on the way are added to path, if given.
+  Page *DescendToLeaf(const KeyType *key, bool before, std::vector<page_id_t> *path = nullptr);
+
+  // follow the right links from a latched page while it does not cover key, or the keys before it if before
+  Page *MoveRight(Page *page, const KeyType *key, bool before, bool exclusive);
+
+  // pin and read-latch a leaf if it is live and covers key, or the keys just below it if below; nullptr otherwise
+  Page *LatchLeafHint(page_id_t page_id, const KeyType &key, bool below);
+
+  // point the prev link of a leaf at prev_page_id if the leaf is not latched
+  void LinkPrevPage(page_id_t page_id, page_id_t prev_page_id);
+
+  // descend with read latches and write-latch only the leaf; nullptr if the tree is empty
+  Page *FindLeafOptimistic(const KeyType &key, std::vector<page_id_t> *path = nullptr);
+
+  // descend with write latches, keeping every page that may still split or underflow; nullptr if the tree is empty
+  Page *FindLeafPessimistic(const KeyType &key, Operation op, WriteContext *context);
+
+  // true if the operation cannot propagate past this page
+  bool IsSafe(BPlusTreePage *node, Operation op) const;
+
+  void ReleaseAncestors(WriteContext *context);
+
+  void ReleaseWriteContext(WriteContext *context);
+
   void StartNewTree(const KeyType &key, const ValueType &value);
 
-  bool InsertIntoLeaf(const KeyType &key, const ValueType &value, Transaction *transaction = nullptr);
+  bool InsertIntoLeaf(const KeyType &key, const ValueType &value, WriteContext *context);
+
+  // insert in B-link mode, holding one latch at a time
+  bool InsertBLink(const KeyType &key, const ValueType &value);
+
+  // add the separator of a split in B-link mode to the parent found through the path, splitting further up as needed
+  void InsertIntoParentBLink(std::vector<page_id_t> *path, page_id_t left_page_id, const KeyType &key,
+                             page_id_t right_page_id);
+
+  // buffered mode, all with the root latch held: the newest value of key, through the buffers down to the leaf
+  bool LookupBuffered(const KeyType &key, ValueType *value);
+
+  // add a message to the root buffer, flushing buffers below it until it has room; false if it was dropped
+  bool PutMessage(const Message &message);
+
+  // apply a message to the leaf of its key, splitting the leaf if needed; false if it was dropped
+  bool ApplyToLeaf(const Message &message);
+
+  // move the messages for the fullest child of the root down a level, or of the first full buffer below it
+  void FlushStep();
+
+  // apply all messages in the buffers of a subtree to its leaves
+  void FlushSubtree(page_id_t page_id);
+
+  // the pinned buffer page of an internal page, allocated if create; nullptr if there is none
+  BufferPage *FetchBuffer(InternalPage *node, bool create);
+
+  // the child of a page with the most messages in its buffer, and the range [begin, end) of those messages
+  int FullestChild(InternalPage *node, BufferPage *buffer, int *begin, int *end) const;
+
+  // insert into a leaf that has room for the key, found at index or -1 if it is new
+  bool InsertIntoLeafPage(LeafPage *leaf, int index, const KeyType &key, const ValueType &value);
+
+  // remove a value of the key, or the key and all of its values if value is nullptr
+  void RemoveValues(const KeyType &key, const ValueType *value, Transaction *transaction);
+
+  // whether removing from the key at index removes its entry as well
+  bool RemovesEntry(const LeafPage *leaf, int index, const ValueType *value) const;
+
+  bool RemoveFromLeafPage(LeafPage *leaf, const KeyType &key, const ValueType *value);
 
-  void InsertIntoParent(BPlusTreePage *old_node, const KeyType &key, BPlusTreePage *new_node,
-                        Transaction *transaction = nullptr);
+  void InsertIntoParent(BPlusTreePage *old_node, const KeyType &key, BPlusTreePage *new_node);
 
   template <typename N>
   N *Split(N *node);
 
   template <typename N>
-  bool CoalesceOrRedistribute(N *node, Transaction *transaction = nullptr);
+  bool CoalesceOrRedistribute(N *node, WriteContext *context);
 
   template <typename N>
   bool Coalesce(N **neighbor_node, N **node, BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator> **parent,
-                int index, Transaction *transaction = nullptr);
+                int index, WriteContext *context);
 
   template <typename N>
   void Redistribute(N *neighbor_node, N *node, int index);
@@ -110,6 +299,11 @@ class BPlusTree {
   KeyComparator comparator_;
   int leaf_max_size_;
   int internal_max_size_;
+  bool unique_;
+  BPlusTreeMode mode_;
+  std::unique_ptr<AdaptiveHashIndex<KeyType, KeyComparator>> adaptive_hash_index_;
+  // protects root_page_id_
+  mutable ReaderWriterLatch root_latch_;
 };
 
 }  // namespace bustub
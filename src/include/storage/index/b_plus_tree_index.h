@@ -26,10 +26,13 @@ namespace bustub {
 INDEX_TEMPLATE_ARGUMENTS
 class BPlusTreeIndex : public Index {
  public:
-  BPlusTreeIndex(std::unique_ptr<IndexMetadata> &&metadata, BufferPoolManager *buffer_pool_manager);
+  BPlusTreeIndex(std::unique_ptr<IndexMetadata> &&metadata, BufferPoolManager *buffer_pool_manager,
+                 BPlusTreeMode mode = BPlusTreeMode::LATCH_COUPLING);
 
   void InsertEntry(const Tuple &key, RID rid, Transaction *transaction) override;
 
+  bool InsertEntries(const std::vector<Tuple> &keys, const std::vector<RID> &rids, Transaction *transaction) override;
+
   void DeleteEntry(const Tuple &key, RID rid, Transaction *transaction) override;
 
   void ScanKey(const Tuple &key, std::vector<RID> *result, Transaction *transaction) override;
@@ -38,6 +41,12 @@ class BPlusTreeIndex : public Index {
 
   INDEXITERATOR_TYPE GetBeginIterator(const KeyType &key);
 
+  INDEXITERATOR_TYPE GetBeginIterator(const KeyType &key, const KeyType &end_key, bool end_inclusive = true);
+
+  INDEXITERATOR_TYPE GetReverseBeginIterator();
+
+  INDEXITERATOR_TYPE GetReverseBeginIterator(const KeyType &key, bool inclusive = true);
+
   INDEXITERATOR_TYPE GetEndIterator();
 
  protected:
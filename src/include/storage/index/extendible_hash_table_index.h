@@ -35,10 +35,18 @@ class ExtendibleHashTableIndex : public Index {
 
   void InsertEntry(const Tuple &key, RID rid, Transaction *transaction) override;
 
+  bool InsertEntries(const std::vector<Tuple> &keys, const std::vector<RID> &rids, Transaction *transaction) override;
+
   void DeleteEntry(const Tuple &key, RID rid, Transaction *transaction) override;
 
   void ScanKey(const Tuple &key, std::vector<RID> *result, Transaction *transaction) override;
 
+  void ScanKeys(const std::vector<Tuple> &keys, std::vector<std::vector<RID>> *results,
+                Transaction *transaction) override;
+
+  /** @return the statistics of the underlying hash table, see ExtendibleHashTable::GetStats */
+  HashTableStats GetStats(uint32_t bucket_sample_step = 1);
+
  protected:
   // comparator for key
   KeyComparator comparator_;
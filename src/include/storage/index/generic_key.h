@@ -19,45 +19,81 @@
 
 namespace bustub {
 
+/**
+ * KeyNormalizer encodes key columns into an order-preserving byte string, so that comparing two keys is a single
+ * unsigned byte comparison instead of deserializing and comparing every column as a Value.
+ *
+ * Each column is encoded in key schema order: integers big-endian with the sign bit flipped, decimals as their IEEE
+ * bits with the sign bit flipped (all bits flipped if negative), timestamps big-endian, and varchars as their bytes
+ * with 0x00 escaped to 0x00 0xFF and terminated by 0x00 0x01. A NULL varchar is the 0x00 0x00 terminator alone; the
+ * NULL of every other type is its sentinel value, which is the smallest (or, for timestamps, largest) of the type.
+ */
+class KeyNormalizer {
+ public:
+  /**
+   * Encodes the columns of a key tuple and zero-fills the rest of the buffer.
+   * @throw Exception OUT_OF_RANGE if the encoded key does not fit into size bytes
+   */
+  static void Encode(const Tuple &key, const Schema *key_schema, char *data, size_t size);
+
+  /** Decodes a column of an encoded key. */
+  static Value Decode(const char *data, size_t size, const Schema *key_schema, uint32_t column_idx);
+
+  /** Encodes a single bigint into the first 8 bytes. */
+  static void EncodeBigint(int64_t key, char *data);
+
+  /** Decodes the bigint in the first 8 bytes. */
+  static int64_t DecodeBigint(const char *data);
+
+  /** @return the big-endian word at data; comparing these compares the bytes they were loaded from */
+  static inline uint64_t LoadBigEndian64(const char *data) {
+    uint64_t word;
+    memcpy(&word, data, sizeof(word));
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    word = __builtin_bswap64(word);
+#endif
+    return word;
+  }
+
+  static inline uint32_t LoadBigEndian32(const char *data) {
+    uint32_t word;
+    memcpy(&word, data, sizeof(word));
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    word = __builtin_bswap32(word);
+#endif
+    return word;
+  }
+};
+
 /**
  * Generic key is used for indexing with opaque data.
  *
  * This key type uses an fixed length array to hold data for indexing
  * purposes, the actual size of which is specified and instantiated
- * with a template argument.
+ * with a template argument. The data is normalized (see KeyNormalizer), so
+ * keys compare with memcmp.
  */
 template <size_t KeySize>
 class GenericKey {
  public:
-  inline void SetFromKey(const Tuple &tuple) {
-    // intialize to 0
-    memset(data_, 0, KeySize);
-    memcpy(data_, tuple.GetData(), tuple.GetLength());
+  inline void SetFromKey(const Tuple &tuple, const Schema *key_schema) {
+    KeyNormalizer::Encode(tuple, key_schema, data_, KeySize);
   }
 
   // NOTE: for test purpose only
+  // encoded like a key of a single bigint column
   inline void SetFromInteger(int64_t key) {
     memset(data_, 0, KeySize);
-    memcpy(data_, &key, sizeof(int64_t));
+    KeyNormalizer::EncodeBigint(key, data_);
   }
 
   inline Value ToValue(Schema *schema, uint32_t column_idx) const {
-    const char *data_ptr;
-    const auto &col = schema->GetColumn(column_idx);
-    const TypeId column_type = col.GetType();
-    const bool is_inlined = col.IsInlined();
-    if (is_inlined) {
-      data_ptr = (data_ + col.GetOffset());
-    } else {
-      int32_t offset = *reinterpret_cast<int32_t *>(const_cast<char *>(data_ + col.GetOffset()));
-      data_ptr = (data_ + offset);
-    }
-    return Value::DeserializeFrom(data_ptr, column_type);
+    return KeyNormalizer::Decode(data_, KeySize, schema, column_idx);
   }
 
   // NOTE: for test purpose only
-  // interpret the first 8 bytes as int64_t from data vector
-  inline int64_t ToString() const { return *reinterpret_cast<int64_t *>(const_cast<char *>(data_)); }
+  // interpret the first 8 bytes as the int64_t set by SetFromInteger
+  inline int64_t ToString() const { return KeyNormalizer::DecodeBigint(data_); }
 
   // NOTE: for test purpose only
   // interpret the first 8 bytes as int64_t from data vector
@@ -76,19 +112,27 @@ class GenericKey {
 template <size_t KeySize>
 class GenericComparator {
  public:
+  // keys are normalized, so this is memcmp unrolled into big-endian word compares
   inline int operator()(const GenericKey<KeySize> &lhs, const GenericKey<KeySize> &rhs) const {
-    uint32_t column_count = key_schema_->GetColumnCount();
-
-    for (uint32_t i = 0; i < column_count; i++) {
-      Value lhs_value = (lhs.ToValue(key_schema_, i));
-      Value rhs_value = (rhs.ToValue(key_schema_, i));
-
-      if (lhs_value.CompareLessThan(rhs_value) == CmpBool::CmpTrue) {
-        return -1;
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= KeySize; i += sizeof(uint64_t)) {
+      uint64_t lhs_word = KeyNormalizer::LoadBigEndian64(lhs.data_ + i);
+      uint64_t rhs_word = KeyNormalizer::LoadBigEndian64(rhs.data_ + i);
+      if (lhs_word != rhs_word) {
+        return lhs_word < rhs_word ? -1 : 1;
       }
-      if (lhs_value.CompareGreaterThan(rhs_value) == CmpBool::CmpTrue) {
-        return 1;
+    }
+    if constexpr (KeySize % sizeof(uint64_t) >= sizeof(uint32_t)) {
+      uint32_t lhs_word = KeyNormalizer::LoadBigEndian32(lhs.data_ + i);
+      uint32_t rhs_word = KeyNormalizer::LoadBigEndian32(rhs.data_ + i);
+      if (lhs_word != rhs_word) {
+        return lhs_word < rhs_word ? -1 : 1;
       }
+      i += sizeof(uint32_t);
+    }
+    if constexpr (KeySize % sizeof(uint32_t) != 0) {
+      int cmp = memcmp(lhs.data_ + i, rhs.data_ + i, KeySize - i);
+      return cmp < 0 ? -1 : (cmp > 0 ? 1 : 0);
     }
     // equals
     return 0;
@@ -99,6 +143,8 @@ class GenericComparator {
   // constructor
   explicit GenericComparator(Schema *key_schema) : key_schema_(key_schema) {}
 
+  inline Schema *GetKeySchema() const { return key_schema_; }
+
  private:
   Schema *key_schema_;
 };
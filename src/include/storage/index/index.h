@@ -43,10 +43,14 @@ class IndexMetadata {
    * @param table_name The name of the table on which the index is created
    * @param tuple_schema The schema of the indexed key
    * @param key_attrs The mapping from indexed columns to base table columns
+   * @param is_unique Whether a key may appear at most once in the index
    */
   IndexMetadata(std::string index_name, std::string table_name, const Schema *tuple_schema,
-                std::vector<uint32_t> key_attrs)
-      : name_(std::move(index_name)), table_name_(std::move(table_name)), key_attrs_(std::move(key_attrs)) {
+                std::vector<uint32_t> key_attrs, bool is_unique = true)
+      : name_(std::move(index_name)),
+        table_name_(std::move(table_name)),
+        key_attrs_(std::move(key_attrs)),
+        is_unique_(is_unique) {
     key_schema_ = Schema::CopySchema(tuple_schema, key_attrs_);
   }
 
@@ -72,6 +76,9 @@ class IndexMetadata {
   /** @return The mapping relation between indexed columns and base table columns */
   inline const std::vector<uint32_t> &GetKeyAttrs() const { return key_attrs_; }
 
+  /** @return Whether a key may appear at most once in the index */
+  inline bool IsUnique() const { return is_unique_; }
+
   /** @return A string representation for debugging */
   std::string ToString() const {
     std::stringstream os;
@@ -92,6 +99,8 @@ class IndexMetadata {
   std::string table_name_;
   /** The mapping relation between key schema and tuple schema */
   const std::vector<uint32_t> key_attrs_;
+  /** Whether a key may appear at most once in the index */
+  bool is_unique_;
   /** The schema of the indexed key */
   Schema *key_schema_;
 };
@@ -159,6 +168,21 @@ class Index {
    */
   virtual void InsertEntry(const Tuple &key, RID rid, Transaction *transaction) = 0;
 
+  /**
+   * Insert a batch of distinct entries into the index. Indexes that can build themselves faster from a whole batch
+   * override this, the default inserts the entries one by one.
+   * @param keys The index keys
+   * @param rids rids[i] is the RID associated with keys[i]
+   * @param transaction The transaction context
+   * @return true if every entry was inserted
+   */
+  virtual bool InsertEntries(const std::vector<Tuple> &keys, const std::vector<RID> &rids, Transaction *transaction) {
+    for (size_t i = 0; i < keys.size(); i++) {
+      InsertEntry(keys[i], rids[i], transaction);
+    }
+    return true;
+  }
+
   /**
    * Delete an index entry by key.
    * @param key The index key
@@ -175,6 +199,21 @@ class Index {
    */
   virtual void ScanKey(const Tuple &key, std::vector<RID> *result, Transaction *transaction) = 0;
 
+  /**
+   * Search the index for each of a batch of keys. Indexes that can share work across lookups override this, the
+   * default looks the keys up one by one.
+   * @param keys The index keys
+   * @param results results->at(i) is populated with the RIDs matching keys[i]
+   * @param transaction The transaction context
+   */
+  virtual void ScanKeys(const std::vector<Tuple> &keys, std::vector<std::vector<RID>> *results,
+                        Transaction *transaction) {
+    results->assign(keys.size(), {});
+    for (size_t i = 0; i < keys.size(); i++) {
+      ScanKey(keys[i], &(*results)[i], transaction);
+    }
+  }
+
  private:
   /** The Index structure owns its metadata */
   std::unique_ptr<IndexMetadata> metadata_;
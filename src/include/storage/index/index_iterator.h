@@ -13,31 +13,107 @@
  * For range scan of b+ tree
  */
 #pragma once
+#include <vector>
+
+#include "common/macros.h"
 #include "storage/page/b_plus_tree_leaf_page.h"
 
 namespace bustub {
 
 #define INDEXITERATOR_TYPE IndexIterator<KeyType, ValueType, KeyComparator>
 
+INDEX_TEMPLATE_ARGUMENTS
+class BPlusTree;
+
+/**
+ * Bidirectional iterator over the leaf level. The iterator copies the items of a leaf into a batch under a single
+ * read latch and hands them out from there, so it holds no latch between calls and writers never wait for it. When
+ * the batch runs out, the next one comes from the neighbouring leaf if its fences still cover the keys after (or
+ * before) the batch, and from a descent from the root otherwise. Items that are inserted or removed concurrently may
+ * or may not be seen, but no item is seen twice and all come in key order.
+ *
+ * Moving forward follows the next links, moving backward the prev links, which are only hints (see
+ * BPlusTreeLeafPage). Once a batch is loaded, the leaf after it in the direction of the last move is fetched and
+ * kept pinned, so that it is read while the batch is consumed rather than when the scan runs out of items.
+ *
+ * A forward scan may end at an upper bound, inclusive or exclusive. In a non-unique tree, the iterator yields a pair
+ * for every value of a key, in the order of its posting list.
+ */
 INDEX_TEMPLATE_ARGUMENTS
 class IndexIterator {
+  using LeafPage = BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>;
+  using BPlusTreeType = BPlusTree<KeyType, ValueType, KeyComparator>;
+
  public:
-  // you may define your own constructor based on your member variables
+  /** Creates the end iterator. */
   IndexIterator();
+  /**
+   * Creates an iterator at the first item >= key, or at the first item of the tree if key is nullptr. Moving forward
+   * ends after end_key, or before it if end_inclusive is false; there is no bound if end_key is nullptr.
+   */
+  IndexIterator(BPlusTreeType *tree, const KeyType *key, const KeyType *end_key = nullptr, bool end_inclusive = true);
   ~IndexIterator();  // NOLINT
 
+  /** @return an iterator at the last item <= key (< key if inclusive is false), or the last item if key is nullptr */
+  static IndexIterator ReverseFrom(BPlusTreeType *tree, const KeyType *key, bool inclusive = true);
+
+  IndexIterator(IndexIterator &&other) noexcept;
+  IndexIterator &operator=(IndexIterator &&other) noexcept;
+  DISALLOW_COPY(IndexIterator);
+
   bool IsEnd();
 
   const MappingType &operator*();
 
+  /** Moves to the next item, or to the end past the last item or the upper bound. */
   IndexIterator &operator++();
 
-  bool operator==(const IndexIterator &itr) const { throw std::runtime_error("unimplemented"); }
+  /** Moves to the previous item, or to the end before the first item. */
+  IndexIterator &operator--();
 
-  bool operator!=(const IndexIterator &itr) const { throw std::runtime_error("unimplemented"); }
+  bool operator==(const IndexIterator &itr) const;
+
+  bool operator!=(const IndexIterator &itr) const { return !(*this == itr); }
 
  private:
-  // add your own private member variables here
+  /** Loads the batch of the first leaf with items after key (or at or after it if inclusive), trying hint first. */
+  void LoadForward(const KeyType &key, bool inclusive, page_id_t hint);
+  /** Loads the batch of the last leaf with items before key (or at or before it if inclusive), trying hint first. */
+  void LoadBackward(KeyType key, bool has_key, bool inclusive, page_id_t hint);
+  /** Crabs from a pinned, read-latched leaf to the first one with items from begin on, and loads its batch. */
+  void LoadFrom(Page *page, int begin);
+  /** Copies the items [begin, end) of a read-latched leaf into the batch, up to the upper bound. */
+  void CopyItems(Page *page, int begin, int end);
+  /** @return the pinned and read-latched page hint if it is a leaf with items around key, else nullptr */
+  Page *LatchHint(page_id_t hint, const KeyType &key, bool before, bool inclusive);
+  /** Pins the leaf after the batch in the direction of the scan, and unpins the one pinned before. */
+  void Prefetch(bool forward);
+  /** Makes this the end iterator. */
+  void Clear();
+
+  BPlusTreeType *tree_{nullptr};
+  BufferPoolManager *buffer_pool_manager_{nullptr};
+  // the upper bound of forward moves
+  bool has_end_key_{false};
+  KeyType end_key_{};
+  bool end_inclusive_{true};
+  // the items copied from a leaf, in order, and the current one; the iterator is at the end if there are none
+  std::vector<MappingType> batch_;
+  size_t index_{0};
+  // the leaf the batch was copied from, as it was then: its key range, its links, and whether the batch starts at
+  // its first item and ends at its last one or at the upper bound
+  page_id_t page_id_{INVALID_PAGE_ID};
+  bool has_low_fence_{false};
+  KeyType low_fence_{};
+  bool has_high_fence_{false};
+  KeyType high_fence_{};
+  page_id_t prev_page_id_{INVALID_PAGE_ID};
+  page_id_t next_page_id_{INVALID_PAGE_ID};
+  bool at_first_{false};
+  bool at_last_{false};
+  bool at_end_key_{false};
+  // the pinned neighbour of the batch leaf, if any
+  Page *prefetched_page_{nullptr};
 };
 
 }  // namespace bustub
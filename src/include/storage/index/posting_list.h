@@ -0,0 +1,69 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// posting_list.h
+//
+// Identification: src/include/storage/index/posting_list.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "common/rid.h"
+
+namespace bustub {
+
+/**
+ * The RIDs of a key in a non-unique B+ tree, stored once per key as the value of its leaf entry. The RIDs are sorted
+ * by RID::Get() and delta-compressed into a run: every RID after the first stores the difference of its page id to
+ * the previous one, then its slot, which is also a difference if the page is the same. Both are varints, so RIDs of
+ * the same or nearby pages take two bytes.
+ *
+ * Small lists are stored in the leaf, large ones in a chain of overflow pages (see PostingListPage):
+ * Inline format:   | Tag (1) = INLINE | Run |
+ * Overflow format: | Tag (1) = OVERFLOW | Count (4) | FirstPageId (4) | LastPageId (4) |
+ *
+ * Overflow pages are only reachable through their leaf entry, so the latch of the leaf protects them as well.
+ */
+class PostingList {
+ public:
+  /** The largest list stored in a leaf, which is the largest value of a non-unique leaf. */
+  static constexpr int MAX_INLINE_SIZE = 128;
+  /** The largest list of a single RID: a tag and two 5-byte varints. */
+  static constexpr int MAX_SINGLE_SIZE = 11;
+
+  /** @return a list of a single RID */
+  static std::string Make(const RID &rid);
+
+  /** @return the number of RIDs in the list */
+  static uint32_t Count(const std::string &list);
+
+  /** Append all RIDs of the list to result, in order. */
+  static void GetValues(BufferPoolManager *buffer_pool_manager, const std::string &list, std::vector<RID> *result);
+
+  /**
+   * Insert a RID into the list, which moves to overflow pages once it outgrows the leaf. The list never grows by more
+   * than MAX_SINGLE_SIZE - 1 bytes.
+   * @return false if the RID is in the list already
+   */
+  static bool Insert(BufferPoolManager *buffer_pool_manager, std::string *list, const RID &rid);
+
+  /**
+   * Remove a RID from the list; a list that no longer needs overflow pages moves back into the leaf if it takes at
+   * most max_size bytes there. The list is cleared once its last RID is removed.
+   * @return false if the RID is not in the list
+   */
+  static bool Remove(BufferPoolManager *buffer_pool_manager, std::string *list, const RID &rid, int max_size);
+
+  /** Delete the overflow pages of the list, if any. */
+  static void Free(BufferPoolManager *buffer_pool_manager, const std::string &list);
+};
+
+}  // namespace bustub
@@ -0,0 +1,82 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// b_plus_tree_buffer_page.h
+//
+// Identification: src/include/storage/page/b_plus_tree_buffer_page.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <vector>
+
+#include "storage/page/b_plus_tree_page.h"
+
+namespace bustub {
+
+#define B_PLUS_TREE_BUFFER_PAGE_TYPE BPlusTreeBufferPage<KeyType, ValueType, KeyComparator>
+
+/**
+ * The kinds of writes a buffered BPlusTree defers: UPSERT sets the value of a key, DELETE removes it and INSERT sets
+ * it only if the key has none, so an INSERT that meets a value of its key, in a buffer or at the leaf, is dropped.
+ */
+enum class BufferedOp : int32_t { INSERT = 0, UPSERT, DELETE };
+
+/**
+ * The message buffer of an internal page of a BPlusTree in buffered mode, holding writes that have not reached the
+ * leaves yet. Messages are sorted by key, with at most one per key: a message replaces an older one of its key.
+ *
+ * Page format (size in byte, 12 bytes of header):
+ * ------------------------------------------------------------------------
+ * | PageId (4) | LSN (4) | Count (4) | MESSAGE(1) | ... | MESSAGE(Count) |
+ * ------------------------------------------------------------------------
+ * Message format: | Key | Value | Op (4) |
+ */
+INDEX_TEMPLATE_ARGUMENTS
+class BPlusTreeBufferPage {
+ public:
+  struct Message {
+    KeyType key_;
+    ValueType value_;
+    BufferedOp op_;
+  };
+
+  static constexpr int HEADER_SIZE = 12;
+  static constexpr int MAX_COUNT = (PAGE_SIZE - HEADER_SIZE) / sizeof(Message);
+
+  /** Initialize a newly allocated page with no messages. */
+  void Init(page_id_t page_id);
+
+  page_id_t GetPageId() const;
+  int GetCount() const;
+  bool IsFull() const { return count_ >= MAX_COUNT; }
+
+  const Message &MessageAt(int index) const;
+  /** @return the index of the first message with a key >= key */
+  int LowerBound(const KeyType &key, const KeyComparator &comparator) const;
+  /** @return the message of key, or nullptr if there is none */
+  const Message *Find(const KeyType &key, const KeyComparator &comparator) const;
+  /** @return whether a message of key fits, because the page has room or holds a message of the key already */
+  bool HasRoomFor(const KeyType &key, const KeyComparator &comparator) const;
+
+  /**
+   * Add a message, which must fit, combining it with the older message of its key if there is one: an INSERT after an
+   * INSERT or UPSERT is dropped, an INSERT after a DELETE becomes an UPSERT, and any other message replaces the old one.
+   * @return false if the message was dropped
+   */
+  bool Put(const Message &message, const KeyComparator &comparator);
+  /** Remove the messages [begin, end) and append them to result. */
+  void Take(int begin, int end, std::vector<Message> *result);
+
+ private:
+  page_id_t page_id_;
+  lsn_t lsn_;
+  int32_t count_;
+  Message messages_[MAX_COUNT];
+};
+
+}  // namespace bustub
@@ -11,57 +11,92 @@
 #pragma once
 
 #include <queue>
+#include <utility>
+#include <vector>
 
 #include "storage/page/b_plus_tree_page.h"
 
 namespace bustub {
 
 #define B_PLUS_TREE_INTERNAL_PAGE_TYPE BPlusTreeInternalPage<KeyType, ValueType, KeyComparator>
-#define INTERNAL_PAGE_HEADER_SIZE 24
-#define INTERNAL_PAGE_SIZE ((PAGE_SIZE - INTERNAL_PAGE_HEADER_SIZE) / (sizeof(MappingType)))
+#define INTERNAL_PAGE_HEADER_SIZE 44
+// the most children an internal page can hold, reached when every key is all prefix
+#define INTERNAL_PAGE_SIZE \
+  ((PAGE_SIZE - INTERNAL_PAGE_HEADER_SIZE - 2 * sizeof(KeyType)) / (BPlusTreePage::SLOT_SIZE + 1 + sizeof(ValueType)))
 /**
  * Store n indexed keys and n+1 child pointers (page_id) within internal page.
  * Pointer PAGE_ID(i) points to a subtree in which all keys K satisfy:
  * K(i) <= K < K(i+1).
  * NOTE: since the number of keys does not equal to number of child pointers,
- * the first key always remains invalid. That is to say, any search/lookup
- * should ignore the first key.
+ * the first key is not stored. KeyAt(0) returns the low fence of the page instead,
+ * which is the key of this page in its parent.
  *
- * Internal page format (keys are stored in increasing order):
- *  --------------------------------------------------------------------------
- * | HEADER | KEY(1)+PAGE_ID(1) | KEY(2)+PAGE_ID(2) | ... | KEY(n)+PAGE_ID(n) |
- *  --------------------------------------------------------------------------
+ * Internal page format (keys are stored in increasing order, as suffixes after the prefix of the fences, see
+ * BPlusTreePage):
+ *  -------------------------------------------------------------------------------------------------------
+ * | HEADER | LOW FENCE | HIGH FENCE | SLOT(1) ... SLOT(n) | FREE | ... SUFFIX(2)+PAGE_ID(2) | PAGE_ID(1) |
+ *  -------------------------------------------------------------------------------------------------------
+ *
+ *  Header format (size in byte, 44 bytes in total):
+ *  ---------------------------------------------------------------------
+ * | BPlusTreePage header (36) | NextPageId (4) | BufferPageId (4) |
+ *  ---------------------------------------------------------------------
+ *
+ * The next page id links the page to its right sibling, whose low fence is my high fence, like in leaves. The buffer
+ * page holds the messages of a buffered tree that are on their way to my children (see BPlusTreeBufferPage); it is
+ * invalid while there are none.
  */
 INDEX_TEMPLATE_ARGUMENTS
 class BPlusTreeInternalPage : public BPlusTreePage {
  public:
-  // must call initialize method after "create" a new node
-  void Init(page_id_t page_id, page_id_t parent_id = INVALID_PAGE_ID, int max_size = INTERNAL_PAGE_SIZE);
+  // must call initialize method after "create" a new node; the page covers [low_fence, high_fence), where nullptr
+  // is unbounded
+  void Init(page_id_t page_id, page_id_t parent_id = INVALID_PAGE_ID, int max_size = INTERNAL_PAGE_SIZE,
+            const KeyType *low_fence = nullptr, const KeyType *high_fence = nullptr);
 
+  page_id_t GetNextPageId() const;
+  void SetNextPageId(page_id_t next_page_id);
+  page_id_t GetBufferPageId() const;
+  void SetBufferPageId(page_id_t buffer_page_id);
   KeyType KeyAt(int index) const;
   void SetKeyAt(int index, const KeyType &key);
   int ValueIndex(const ValueType &value) const;
   ValueType ValueAt(int index) const;
+  void SetValueAt(int index, const ValueType &value);
+  // the key range of the page, nullptr if unbounded
+  const KeyType *GetLowFence() const;
+  const KeyType *GetHighFence() const;
+  bool HasRoomFor(const KeyType &key) const;
 
   ValueType Lookup(const KeyType &key, const KeyComparator &comparator) const;
+  // the child that covers the greatest keys below key
+  ValueType LookupBefore(const KeyType &key, const KeyComparator &comparator) const;
   void PopulateNewRoot(const ValueType &old_value, const KeyType &new_key, const ValueType &new_value);
   int InsertNodeAfter(const ValueType &old_value, const KeyType &new_key, const ValueType &new_value);
+  // insert a child at the position of its key, for a parent that may not hold the child's left sibling yet
+  int InsertNode(const KeyType &new_key, const ValueType &new_value, const KeyComparator &comparator);
   void Remove(int index);
   ValueType RemoveAndReturnOnlyChild();
+  // append a child within the fences, without adopting it; used by the bulk load
+  void Append(const KeyType &key, const ValueType &value);
 
-  // Split and Merge utility methods
+  // Split and Merge utility methods; merges and redistributions return false if the entries do not fit
+  bool CanMoveAllTo(const BPlusTreeInternalPage *recipient, const KeyType &middle_key) const;
   void MoveAllTo(BPlusTreeInternalPage *recipient, const KeyType &middle_key, BufferPoolManager *buffer_pool_manager);
+  // the moved children are not adopted if buffer_pool_manager is nullptr
   void MoveHalfTo(BPlusTreeInternalPage *recipient, BufferPoolManager *buffer_pool_manager);
-  void MoveFirstToEndOf(BPlusTreeInternalPage *recipient, const KeyType &middle_key,
+  bool MoveFirstToEndOf(BPlusTreeInternalPage *recipient, const KeyType &middle_key,
                         BufferPoolManager *buffer_pool_manager);
-  void MoveLastToFrontOf(BPlusTreeInternalPage *recipient, const KeyType &middle_key,
+  bool MoveLastToFrontOf(BPlusTreeInternalPage *recipient, const KeyType &middle_key,
                          BufferPoolManager *buffer_pool_manager);
 
  private:
-  void CopyNFrom(MappingType *items, int size, BufferPoolManager *buffer_pool_manager);
-  void CopyLastFrom(const MappingType &pair, BufferPoolManager *buffer_pool_manager);
-  void CopyFirstFrom(const MappingType &pair, BufferPoolManager *buffer_pool_manager);
-  // Flexible array member for page data.
-  MappingType array_[1];
+  std::vector<MappingType> GetItems() const;
+  bool Fits(const std::vector<MappingType> &items, const KeyType *low_fence, const KeyType *high_fence) const;
+  // replace all children of the page and its key range; the key of the first item is not stored
+  void Rebuild(const KeyType *low_fence, const KeyType *high_fence, const MappingType *items, int size);
+  void Adopt(const ValueType &child, BufferPoolManager *buffer_pool_manager);
+  page_id_t next_page_id_;
+  page_id_t buffer_page_id_;
 };
 }  // namespace bustub
@@ -10,6 +10,7 @@
 //===----------------------------------------------------------------------===//
 #pragma once
 
+#include <string>
 #include <utility>
 #include <vector>
 
@@ -18,57 +19,88 @@
 namespace bustub {
 
 #define B_PLUS_TREE_LEAF_PAGE_TYPE BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>
-#define LEAF_PAGE_HEADER_SIZE 28
-#define LEAF_PAGE_SIZE ((PAGE_SIZE - LEAF_PAGE_HEADER_SIZE) / sizeof(MappingType))
+#define LEAF_PAGE_HEADER_SIZE 44
+// the most entries a leaf can hold, reached when every key is all prefix
+#define LEAF_PAGE_SIZE \
+  ((PAGE_SIZE - LEAF_PAGE_HEADER_SIZE - 2 * sizeof(KeyType)) / (BPlusTreePage::SLOT_SIZE + 1 + sizeof(ValueType)))
 
 /**
  * Store indexed key and record id(record id = page id combined with slot id,
  * see include/common/rid.h for detailed implementation) together within leaf
- * page. Only support unique key.
+ * page. A unique leaf stores one value per key; a non-unique leaf stores every key once, with all of its values in a
+ * posting list (see PostingList) that is kept as a variable-size value.
  *
- * Leaf page format (keys are stored in order):
- *  ----------------------------------------------------------------------
- * | HEADER | KEY(1) + RID(1) | KEY(2) + RID(2) | ... | KEY(n) + RID(n)
- *  ----------------------------------------------------------------------
+ * Leaf page format (keys are stored in order, as suffixes after the prefix of the fences, see BPlusTreePage):
+ *  ----------------------------------------------------------------------------------------
+ * | HEADER | LOW FENCE | HIGH FENCE | SLOT(1) ... SLOT(n) | FREE | SUFFIX(n) + RID(n) ... |
+ *  ----------------------------------------------------------------------------------------
  *
- *  Header format (size in byte, 28 bytes in total):
+ *  Header format (size in byte, 44 bytes in total):
  *  ---------------------------------------------------------------------
- * | PageType (4) | LSN (4) | CurrentSize (4) | MaxSize (4) |
+ * | BPlusTreePage header (36) | NextPageId (4) | PrevPageId (4) |
  *  ---------------------------------------------------------------------
- *  -----------------------------------------------
- * | ParentPageId (4) | PageId (4) | NextPageId (4)
- *  -----------------------------------------------
+ *
+ * The fences of a leaf are the separators around it in its parent. Separators are cut down to the shortest key that
+ * still tells the last key of the left leaf from the first key of the right one, which keeps them, and the prefix
+ * of the fences, short.
+ *
+ * The next page id is exact, but the prev page id is only a hint: writers update it when they can latch the page
+ * without waiting, so readers check it against the fences (see IndexIterator). A leaf merged into its left sibling
+ * is left without fences or links.
  */
 INDEX_TEMPLATE_ARGUMENTS
 class BPlusTreeLeafPage : public BPlusTreePage {
  public:
   // After creating a new leaf page from buffer pool, must call initialize
-  // method to set default values
-  void Init(page_id_t page_id, page_id_t parent_id = INVALID_PAGE_ID, int max_size = LEAF_PAGE_SIZE);
+  // method to set default values; the page covers [low_fence, high_fence), where nullptr is unbounded
+  void Init(page_id_t page_id, page_id_t parent_id = INVALID_PAGE_ID, int max_size = LEAF_PAGE_SIZE,
+            const KeyType *low_fence = nullptr, const KeyType *high_fence = nullptr, bool unique = true);
   // helper methods
   page_id_t GetNextPageId() const;
   void SetNextPageId(page_id_t next_page_id);
+  page_id_t GetPrevPageId() const;
+  void SetPrevPageId(page_id_t prev_page_id);
   KeyType KeyAt(int index) const;
+  ValueType ValueAt(int index) const;
+  // replace the value of a unique leaf
+  void SetValueAt(int index, const ValueType &value);
   int KeyIndex(const KeyType &key, const KeyComparator &comparator) const;
-  const MappingType &GetItem(int index);
+  int UpperKeyIndex(const KeyType &key, const KeyComparator &comparator) const;
+  MappingType GetItem(int index) const;
+  // the key range of the page, nullptr if unbounded
+  const KeyType *GetLowFence() const;
+  const KeyType *GetHighFence() const;
+  bool HasRoomFor(const KeyType &key) const;
+  bool IsUnique() const;
+
+  // posting lists of a non-unique leaf; a list may grow by the free space of the page
+  int Find(const KeyType &key, const KeyComparator &comparator) const;
+  std::string PostingAt(int index) const;
+  void SetPostingAt(int index, const std::string &posting);
 
-  // insert and delete methods
+  // insert and delete methods; a non-unique leaf stores a new key with a posting list of the value
   int Insert(const KeyType &key, const ValueType &value, const KeyComparator &comparator);
   bool Lookup(const KeyType &key, ValueType *value, const KeyComparator &comparator) const;
   int RemoveAndDeleteRecord(const KeyType &key, const KeyComparator &comparator);
 
-  // Split and Merge utility methods
+  // Split and Merge utility methods; merges and redistributions return false if the entries do not fit
   void MoveHalfTo(BPlusTreeLeafPage *recipient);
+  bool CanMoveAllTo(const BPlusTreeLeafPage *recipient) const;
   void MoveAllTo(BPlusTreeLeafPage *recipient);
-  void MoveFirstToEndOf(BPlusTreeLeafPage *recipient);
-  void MoveLastToFrontOf(BPlusTreeLeafPage *recipient);
+  bool MoveFirstToEndOf(BPlusTreeLeafPage *recipient);
+  bool MoveLastToFrontOf(BPlusTreeLeafPage *recipient);
+
+  // append sorted items within the fences, used by the bulk load as well
+  void CopyNFrom(const MappingType *items, int size);
 
  private:
-  void CopyNFrom(MappingType *items, int size);
-  void CopyLastFrom(const MappingType &item);
-  void CopyFirstFrom(const MappingType &item);
+  // entries with their values as stored, which are posting lists in a non-unique leaf
+  using Entry = std::pair<KeyType, std::string>;
+
+  std::vector<Entry> GetEntries() const;
+  bool Fits(const std::vector<Entry> &entries, const KeyType *low_fence, const KeyType *high_fence) const;
+  void Rebuild(const KeyType *low_fence, const KeyType *high_fence, const Entry *entries, int size);
   page_id_t next_page_id_;
-  // Flexible array member for page data.
-  MappingType array_[1];
+  page_id_t prev_page_id_;
 };
 }  // namespace bustub
@@ -16,6 +16,7 @@
 #include <string>
 
 #include "buffer/buffer_pool_manager.h"
+#include "common/config.h"
 #include "storage/index/generic_key.h"
 
 namespace bustub {
@@ -33,15 +34,38 @@ enum class IndexPageType { INVALID_INDEX_PAGE = 0, LEAF_PAGE, INTERNAL_PAGE };
  * It actually serves as a header part for each B+ tree page and
  * contains information shared by both leaf page and internal page.
  *
- * Header format (size in byte, 24 bytes in total):
+ * Header format (size in byte, 36 bytes in total, including 2 bytes of padding):
  * ----------------------------------------------------------------------------
  * | PageType (4) | LSN (4) | CurrentSize (4) | MaxSize (4) |
  * ----------------------------------------------------------------------------
- * | ParentPageId (4) | PageId(4) |
+ * | ParentPageId (4) | PageId(4) | DataOffset (2) | HeapOffset (2) | GarbageSize (2) |
  * ----------------------------------------------------------------------------
+ * | KeySize (1) | ValueSize (1) | PrefixSize (1) | Flags (1) |
+ * ----------------------------------------------------------------------------
+ *
+ * It also manages the entries of both page types, which are stored with prefix and suffix truncation. Every page
+ * covers a key range [low fence, high fence), where a missing fence is unbounded; the fences are the separators around
+ * the page in its parent. All keys in the range share the common prefix of the fences, so entries store only the key
+ * bytes after that prefix, without the zero padding at the end of the key. Keys must be normalized (see
+ * KeyNormalizer) so that they compare as bytes.
+ *
+ * The derived page header is followed by the two fences, then a slot array that grows towards the end of the page,
+ * and the entries themselves, which grow from the end of the page towards the slots:
+ * ----------------------------------------------------------------------------------------
+ * | HEADER | LOW FENCE | HIGH FENCE | SLOT(1) ... SLOT(n) | FREE | ... ENTRY(2) | ENTRY(1) |
+ * ----------------------------------------------------------------------------------------
+ * Slot format (a 4-byte word): | Head (2) | EntryOffset (2) |
+ * Entry format: | SuffixSize (1) | Suffix (SuffixSize) | Value (ValueSize) |
+ * Entry format with variable-size values: | SuffixSize (1) | Suffix (SuffixSize) | Size (1) | Value (Size) |
+ * In a page with variable-size values, ValueSize is the largest size of a value.
+ *
+ * The head of a slot is the first two bytes of the suffix, zero padded, so the sorted heads form a dense array that a
+ * search scans without touching the entries; only entries whose head ties with the key are compared in full.
  */
 class BPlusTreePage {
  public:
+  static constexpr int SLOT_SIZE = sizeof(uint32_t);
+
   bool IsLeafPage() const;
   bool IsRootPage() const;
   void SetPageType(IndexPageType page_type);
@@ -62,14 +86,77 @@ class BPlusTreePage {
 
   void SetLSN(lsn_t lsn = INVALID_LSN);
 
+  // space management, in bytes of slots and entries
+  int GetCapacity() const;
+  int GetUsedSpace() const;
+  int GetFreeSpace() const;
+  // the space of an entry with the longest possible key
+  int GetMaxEntrySpace() const;
+  // a page is half full if it holds at least min size entries or uses at least half of its capacity
+  bool IsHalfFull() const;
+  bool IsHalfFullAfterRemove() const;
+  bool HasRoomForAnyEntry() const;
+
+  /** @return the bytes of a page that hold slots and entries, behind the header and the fences */
+  static int EntryAreaSize(int header_size, int key_size) { return PAGE_SIZE - header_size - 2 * key_size; }
+  /** @return the space a key and value take in a page whose keys share prefix_size bytes */
+  static int EntrySpace(const char *key, int key_size, int value_size, int prefix_size);
+  /** @return the length of the prefix shared by all keys in [low_fence, high_fence); nullptr is unbounded */
+  static int CommonPrefixSize(const char *low_fence, const char *high_fence, int key_size);
+  /** Writes the shortest key in (left, right], so that separators in internal pages are as short as possible. */
+  static void SeparatorBetween(const char *left, const char *right, int key_size, char *separator);
+
+ protected:
+  // set up an empty entry area behind a header of header_size bytes, for keys in [-inf, +inf)
+  void InitEntries(int header_size, int key_size, int value_size, bool variable_values = false);
+  // drop all entries and change the key range to [low_fence, high_fence); nullptr is unbounded
+  void ResetEntries(const char *low_fence, const char *high_fence);
+  const char *LowFenceData() const;
+  const char *HighFenceData() const;
+  int GetPrefixSize() const { return prefix_size_; }
+  bool HasVariableValues() const;
+
+  void KeyDataAt(int index, char *key) const;
+  const char *ValueDataAt(int index) const;
+  int ValueSizeAt(int index) const;
+  void SetValueDataAt(int index, const char *value);
+  // replace a variable-size value; the entry must fit
+  void SetValueDataAt(int index, const char *value, int value_size);
+  // first index in [begin, size) whose key is >= key (or > key if upper), by binary search over the slot heads
+  int SearchEntries(const char *key, int begin, bool upper) const;
+  // whether the key at index equals key, without rebuilding it
+  bool EntryMatches(int index, const char *key) const;
+  // the space of an entry with the largest value, or with a value of value_size bytes
+  int EntrySpace(const char *key) const;
+  int EntrySpace(const char *key, int value_size) const;
+  // insert an entry, a key of nullptr stores no key; the entry must fit
+  void InsertEntryAt(int index, const char *key, const char *value);
+  void InsertEntryAt(int index, const char *key, const char *value, int value_size);
+  void RemoveEntryAt(int index);
+
  private:
+  uint32_t *Slots();
+  const uint32_t *Slots() const;
+  // the slot head of a key in this page, 0 for no key
+  uint32_t HeadOf(const char *key) const;
+  const char *EntryAt(int index) const;
+  int EntryDataSize(int index) const;
+  void Compact();
+
   // member variable, attributes that both internal and leaf page share
-  IndexPageType page_type_ __attribute__((__unused__));
-  lsn_t lsn_ __attribute__((__unused__));
-  int size_ __attribute__((__unused__));
-  int max_size_ __attribute__((__unused__));
-  page_id_t parent_page_id_ __attribute__((__unused__));
-  page_id_t page_id_ __attribute__((__unused__));
+  IndexPageType page_type_;
+  lsn_t lsn_;
+  int size_;
+  int max_size_;
+  page_id_t parent_page_id_;
+  page_id_t page_id_;
+  uint16_t data_offset_;
+  uint16_t heap_offset_;
+  uint16_t garbage_size_;
+  uint8_t key_size_;
+  uint8_t value_size_;
+  uint8_t prefix_size_;
+  uint8_t flags_;
 };
 
 }  // namespace bustub
@@ -12,6 +12,7 @@
 
 #pragma once
 
+#include <cstdint>
 #include <utility>
 #include <vector>
 
@@ -33,6 +34,15 @@ namespace bustub {
  *  The above format omits the space required for the occupied_ and
  *  readable_ arrays. More information is in storage/page/hash_table_page_defs.h.
  *
+ *  The page header counts readable slots and tombstones (occupied but not
+ *  readable), so size checks are O(1) and inserts into a bucket without
+ *  tombstones know the free slot without scanning.
+ *
+ *  Every slot also stores a one-byte fingerprint of its key's hash. Lookups
+ *  compare the fingerprints of a group of slots at once with SIMD and only
+ *  call the comparator on slots whose fingerprint matches, so a miss
+ *  usually compares no key at all. The caller computes fingerprints and must
+ *  derive them the same way for every operation on a bucket.
  */
 template <typename KeyType, typename ValueType, typename KeyComparator>
 class HashTableBucketPage {
@@ -43,9 +53,11 @@ class HashTableBucketPage {
   /**
    * Scan the bucket and collect values that have the matching key
    *
+   * @param key key to look up
+   * @param fingerprint fingerprint of the key's hash
    * @return true if at least one key matched
    */
-  bool GetValue(KeyType key, KeyComparator cmp, std::vector<ValueType> *result);
+  bool GetValue(KeyType key, uint8_t fingerprint, KeyComparator cmp, std::vector<ValueType> *result);
 
   void GetAllValue(std::vector<MappingType> *result);
 
@@ -57,16 +69,29 @@ class HashTableBucketPage {
    *
    * @param key key to insert
    * @param value value to insert
+   * @param fingerprint fingerprint of the key's hash
    * @return true if inserted, false if duplicate KV pair or bucket is full
    */
-  bool Insert(KeyType key, ValueType value, KeyComparator cmp);
+  bool Insert(KeyType key, ValueType value, uint8_t fingerprint, KeyComparator cmp);
+
+  /**
+   * Store a key and value in a free slot without looking for duplicates. Used to fill a split image, whose entries
+   * are known to be unique.
+   *
+   * @param bucket_idx a slot that is not readable
+   * @param key key to insert
+   * @param value value to insert
+   * @param fingerprint fingerprint of the key's hash
+   */
+  void InsertAt(uint32_t bucket_idx, KeyType key, ValueType value, uint8_t fingerprint);
 
   /**
    * Removes a key and value.
    *
+   * @param fingerprint fingerprint of the key's hash
    * @return true if removed, false if not found
    */
-  bool Remove(KeyType key, ValueType value, KeyComparator cmp);
+  bool Remove(KeyType key, ValueType value, uint8_t fingerprint, KeyComparator cmp);
 
   /**
    * Gets the key at an index in the bucket.
@@ -84,6 +109,14 @@ class HashTableBucketPage {
    */
   ValueType ValueAt(uint32_t bucket_idx) const;
 
+  /**
+   * Gets the fingerprint at an index in the bucket.
+   *
+   * @param bucket_idx the index in the bucket to get the fingerprint at
+   * @return fingerprint at index bucket_idx of the bucket
+   */
+  uint8_t FingerprintAt(uint32_t bucket_idx) const;
+
   /**
    * Remove the KV pair at bucket_idx
    */
@@ -126,6 +159,11 @@ class HashTableBucketPage {
    */
   uint32_t NumReadable();
 
+  /**
+   * @return the number of tombstones, slots that are occupied but not readable
+   */
+  uint32_t NumTombstones();
+
   /**
    * @return whether the bucket is full
    */
@@ -136,16 +174,42 @@ class HashTableBucketPage {
    */
   bool IsEmpty();
 
+  /**
+   * Hint the CPU to load the counters, bitmaps and fingerprints of the bucket into the cache, so a probe issued a
+   * little later does not wait on memory.
+   */
+  void Prefetch() const;
+
   /**
    * Prints the bucket's occupancy information
    */
   void PrintBucket();
 
  private:
+  /**
+   * @param group index of a slot group
+   * @return bit i set if slot group * BUCKET_GROUP_SIZE + i is readable and has the fingerprint
+   */
+  uint32_t MatchGroup(uint32_t group, uint8_t fingerprint) const;
+
+  /**
+   * @return the number of slot groups that contain occupied slots
+   */
+  uint32_t NumOccupiedGroups() const;
+
+  /**
+   * @return the first slot that is not readable, BUCKET_ARRAY_SIZE if the bucket is full
+   */
+  uint32_t FirstFreeSlot() const;
+
+  uint32_t num_readable_;
+  uint32_t num_tombstones_;
   //  For more on BUCKET_ARRAY_SIZE see storage/page/hash_table_page_defs.h
-  char occupied_[(BUCKET_ARRAY_SIZE - 1) / 8 + 1];
+  //  Bit i % 8 of byte i / 8 is the flag of slot i, padding slots are never set.
+  char occupied_[BUCKET_BITMAP_WORDS * 8];
   // 0 if tombstone/brand new (never occupied), 1 otherwise.
-  char readable_[(BUCKET_ARRAY_SIZE - 1) / 8 + 1];
+  char readable_[BUCKET_BITMAP_WORDS * 8];
+  uint8_t fingerprints_[BUCKET_NUM_GROUPS * BUCKET_GROUP_SIZE];
   MappingType array_[1];
 };
 
@@ -171,6 +171,23 @@ class HashTableDirectoryPage {
    */
   uint32_t GetLocalHighBit(uint32_t bucket_idx);
 
+  /**
+   * Split the bucket at bucket_idx: every slot that points to it gets local depth + 1, and the slots whose new
+   * local depth bit is set point to the split image instead. The local depth must be below the global depth.
+   *
+   * @param bucket_idx any directory index of the bucket to split
+   * @param image_page_id page_id of the split image
+   */
+  void SplitBucket(uint32_t bucket_idx, page_id_t image_page_id);
+
+  /**
+   * Merge the bucket at bucket_idx into its split image: every slot of either bucket points to the split image,
+   * with local depth - 1. Both buckets must have the same, non-zero local depth.
+   *
+   * @param bucket_idx any directory index of the bucket to merge away
+   */
+  void MergeBucket(uint32_t bucket_idx);
+
   /**
    * VerifyIntegrity
    *
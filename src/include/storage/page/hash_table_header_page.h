@@ -26,10 +26,10 @@ namespace bustub {
  *
  * Header Page for linear probing hash table.
  *
- * Header format (size in byte, 16 bytes in total):
- * -------------------------------------------------------------
- * | LSN (4) | Size (4) | PageId(4) | NextBlockIndex(4)
- * -------------------------------------------------------------
+ * Header format (size in byte, 32 bytes in total, followed by up to HEADER_ARRAY_SIZE block page ids):
+ * ------------------------------------------------------------------------------
+ * | LSN (4) | padding (4) | Size (8) | PageId (4) | padding (4) | NextBlockIndex (8)
+ * ------------------------------------------------------------------------------
  */
 class HashTableHeaderPage {
  public:
@@ -89,13 +89,18 @@ class HashTableHeaderPage {
    */
   size_t NumBlocks();
 
+  /**
+   * @return true if no more block page ids fit into the header page
+   */
+  bool IsFull();
+
  private:
-  __attribute__((unused)) lsn_t lsn_;
-  __attribute__((unused)) size_t size_;
-  __attribute__((unused)) page_id_t page_id_;
-  __attribute__((unused)) size_t next_ind_;
+  lsn_t lsn_;
+  size_t size_;
+  page_id_t page_id_;
+  size_t next_ind_;
   // Flexible array member for page data.
-  __attribute__((unused)) page_id_t block_page_ids_[1];
+  page_id_t block_page_ids_[1];
 };
 
 }  // namespace bustub
@@ -28,17 +28,53 @@
  */
 #define BLOCK_ARRAY_SIZE (4 * PAGE_SIZE / (4 * sizeof(MappingType) + 1))
 
+/**
+ * HEADER_ARRAY_SIZE is the number of block page ids a linear probe hash table header page holds after its 32 bytes of
+ * fields, and so the largest number of blocks a linear probe hash table can have.
+ */
+#define HEADER_ARRAY_SIZE ((PAGE_SIZE - 32) / sizeof(page_id_t))
+
 /**
  * Extendible Hashing Definitions
  */
 #define HASH_TABLE_BUCKET_TYPE HashTableBucketPage<KeyType, ValueType, KeyComparator>
 #define DIRECTORY_ARRAY_SIZE 512
 
+/**
+ * ROOT_MAX_DEPTH is the largest number of high hash bits the root page uses to pick a directory page, ROOT_ARRAY_SIZE
+ * the number of directory pages it can fan out to. With 512 directories of 512 buckets each a table holds up to 2^18
+ * buckets, so at most 2^18 * BUCKET_ARRAY_SIZE pairs, which depends on the key and value sizes: 435 int/int pairs a
+ * bucket give about 114 million, while 55 GenericKey<64>/RID pairs a bucket give only about 14 million. Buckets split
+ * before they are all full, so tables run out of directories well short of these bounds.
+ *
+ * Every directory a key hashes to is allocated with a bucket of its own, so even a tiny table spreads over up to
+ * 2^depth directories. Tables therefore start at ROOT_DEFAULT_DEPTH, four directories, and the root doubles whenever
+ * a directory it cannot split any more fills up.
+ */
+#define ROOT_MAX_DEPTH 9
+#define ROOT_ARRAY_SIZE (1 << ROOT_MAX_DEPTH)
+#define ROOT_DEFAULT_DEPTH 2
+
 /**
  * BUCKET_ARRAY_SIZE is the number of (key, value) pairs that can be stored in an extendible hashing bucket page.
  * It is an approximate calculation based on the size of MappingType (which is a std::pair of KeyType and ValueType).
- * For each key/value pair, we need two additional bits for occupied_ and readable_. 4 * (PAGE_SIZE - 4) / (4 * sizeof
- * (MappingType) + 1) = (PAGE_SIZE - 4)/(sizeof (MappingType) + 0.25) because 0.25 bytes = 2 bits is the space required
- * to maintain the occupied and readable flags for a key value pair.
+ * For each key/value pair, we need one fingerprint byte and two additional bits for occupied_ and readable_.
+ * 4 * (PAGE_SIZE - 64) / (4 * sizeof (MappingType) + 5) = (PAGE_SIZE - 64) / (sizeof (MappingType) + 1.25) because
+ * 1.25 bytes = 10 bits is the space required for the fingerprint and the flags of a key value pair. The 64 bytes
+ * cover the occupancy counters and rounding the per-slot arrays up to whole slot groups and bitmap words.
+ */
+#define BUCKET_ARRAY_SIZE (4 * (PAGE_SIZE - 64) / (4 * sizeof(MappingType) + 5))
+
+/**
+ * BULK_FILL_FACTOR is how full, in percent, a bulk load leaves bucket pages, so that the first inserts after it do not
+ * split right away.
+ */
+#define BULK_FILL_FACTOR 75
+
+/**
+ * Bucket pages probe BUCKET_GROUP_SIZE fingerprints at a time, the per-slot arrays are padded to BUCKET_NUM_GROUPS
+ * whole groups. Their bitmaps are scanned a 64-bit word at a time and padded to BUCKET_BITMAP_WORDS words.
  */
-#define BUCKET_ARRAY_SIZE (4 * PAGE_SIZE / (4 * sizeof(MappingType) + 1))
+#define BUCKET_GROUP_SIZE 32
+#define BUCKET_NUM_GROUPS ((BUCKET_ARRAY_SIZE + BUCKET_GROUP_SIZE - 1) / BUCKET_GROUP_SIZE)
+#define BUCKET_BITMAP_WORDS ((BUCKET_NUM_GROUPS * BUCKET_GROUP_SIZE + 63) / 64)
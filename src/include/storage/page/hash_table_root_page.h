@@ -0,0 +1,119 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// hash_table_root_page.h
+//
+// Identification: src/include/storage/page/hash_table_root_page.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+
+#include "common/config.h"
+#include "storage/page/hash_table_page_defs.h"
+
+namespace bustub {
+
+/**
+ *
+ * Root Page for extendible hash table. It sits above the directories and maps the high bits of a key's hash to a
+ * directory page, which maps the low bits to a bucket page. Directory pages are only allocated once a key hashes to
+ * them, so a small table costs a root, one directory and its buckets.
+ *
+ * The root is itself extendible: IncrDepth() doubles it, and the two halves of every old slot point to the same
+ * directory until that directory is split. The slots sharing a directory are therefore always a contiguous, aligned
+ * run.
+ *
+ * Root format (size in byte):
+ * --------------------------------------------------------------------------
+ * | PageId(4) | LSN (4) | Depth(4) | DirectoryPageIds(2048) | Free(2036)
+ * --------------------------------------------------------------------------
+ */
+class HashTableRootPage {
+ public:
+  /**
+   * Initialize a newly allocated root page: no directory pages yet.
+   *
+   * @param page_id the page ID of this page
+   * @param depth number of hash bits used to pick a directory, at most ROOT_MAX_DEPTH
+   */
+  void Init(page_id_t page_id, uint32_t depth = ROOT_DEFAULT_DEPTH);
+
+  /**
+   * @return the page ID of this page
+   */
+  page_id_t GetPageId() const;
+
+  /**
+   * @return the lsn of this page
+   */
+  lsn_t GetLSN() const;
+
+  /**
+   * Sets the LSN of this page
+   *
+   * @param lsn the log sequence number to which to set the lsn field
+   */
+  void SetLSN(lsn_t lsn);
+
+  /**
+   * Map a hash to a directory index using its depth high bits.
+   *
+   * @param hash the hash of a key
+   * @return the directory index the key belongs to
+   */
+  uint32_t HashToDirectoryIndex(uint32_t hash) const;
+
+  /**
+   * @param directory_idx a directory index
+   * @return the directory page_id at directory_idx, INVALID_PAGE_ID if it was not allocated yet
+   */
+  page_id_t GetDirectoryPageId(uint32_t directory_idx) const;
+
+  /**
+   * @param directory_idx a directory index
+   * @param directory_page_id the directory page_id to store at directory_idx
+   */
+  void SetDirectoryPageId(uint32_t directory_idx, page_id_t directory_page_id);
+
+  /**
+   * @param directory_idx a directory index
+   * @return the first directory index of the run of indexes that share the directory page at directory_idx
+   */
+  uint32_t GetRunStart(uint32_t directory_idx) const;
+
+  /**
+   * @param directory_idx a directory index
+   * @return the number of directory indexes that share the directory page at directory_idx, a power of two
+   */
+  uint32_t GetRunLength(uint32_t directory_idx) const;
+
+  /**
+   * @return the number of directory indexes, 2^depth
+   */
+  uint32_t MaxSize() const;
+
+  /**
+   * @return the number of hash bits used to pick a directory
+   */
+  uint32_t GetDepth() const;
+
+  /**
+   * Double the root: use one more hash bit to pick a directory, with both new indexes of an old one pointing to its
+   * directory. The depth must be below ROOT_MAX_DEPTH.
+   */
+  void IncrDepth();
+
+ private:
+  page_id_t page_id_;
+  lsn_t lsn_;
+  uint32_t depth_;
+  page_id_t directory_page_ids_[ROOT_ARRAY_SIZE];
+};
+
+}  // namespace bustub
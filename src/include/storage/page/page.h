@@ -51,6 +51,9 @@ class Page {
   /** Acquire the page write latch. */
   inline void WLatch() { rwlatch_.WLock(); }
 
+  /** Acquire the page write latch if it is free, without waiting. */
+  inline bool TryWLatch() { return rwlatch_.TryWLock(); }
+
   /** Release the page write latch. */
   inline void WUnlatch() { rwlatch_.WUnlock(); }
 
@@ -0,0 +1,67 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// posting_list_page.h
+//
+// Identification: src/include/storage/page/posting_list_page.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+
+#include "common/config.h"
+
+namespace bustub {
+
+/**
+ * Overflow page of a posting list that is too large for its leaf entry (see PostingList). The pages of a list form a
+ * chain in RID order, each holding a run of delta-compressed RIDs; the first and last RID of the run are kept in the
+ * header, so that a page is found without decoding the runs before it.
+ *
+ * Page format (size in byte, 32 bytes of header):
+ * -------------------------------------------------------------------------------------------------------
+ * | PageId (4) | LSN (4) | NextPageId (4) | Count (2) | RunSize (2) | FirstRid (8) | LastRid (8) | Run ... |
+ * -------------------------------------------------------------------------------------------------------
+ * RIDs are stored as the unsigned value of RID::Get(), which is their order in the list.
+ */
+class PostingListPage {
+ public:
+  static constexpr int HEADER_SIZE = 32;
+  static constexpr int RUN_CAPACITY = PAGE_SIZE - HEADER_SIZE;
+
+  /** Initialize a newly allocated page with an empty run and no next page. */
+  void Init(page_id_t page_id);
+
+  page_id_t GetPageId() const;
+  page_id_t GetNextPageId() const;
+  void SetNextPageId(page_id_t next_page_id);
+
+  int GetCount() const;
+  uint64_t GetFirstRid() const;
+  uint64_t GetLastRid() const;
+  const char *GetRun() const;
+  int GetRunSize() const;
+
+  /** Replace the run, which must be at most RUN_CAPACITY bytes and hold count RIDs from first to last. */
+  void SetRun(const char *run, int run_size, int count, uint64_t first_rid, uint64_t last_rid);
+
+  /** Append the encoding of one RID after the last one; it must fit. */
+  void AppendToRun(const char *data, int size, uint64_t rid);
+
+ private:
+  page_id_t page_id_;
+  lsn_t lsn_;
+  page_id_t next_page_id_;
+  uint16_t count_;
+  uint16_t run_size_;
+  uint64_t first_rid_;
+  uint64_t last_rid_;
+  char run_[RUN_CAPACITY];
+};
+
+}  // namespace bustub
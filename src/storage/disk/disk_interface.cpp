@@ -0,0 +1,79 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// disk_interface.cpp
+//
+// Identification: src/storage/disk/disk_interface.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <array>
+#include <string>
+#include <utility>
+
+#include "common/logger.h"
+#include "storage/disk/disk_interface.h"
+
+namespace bustub {
+
+DiskInterface::DiskInterface(std::string name) : name_(std::move(name)) {}
+
+DiskInterface::~DiskInterface() { DisableStatsDump(); }
+
+/**
+ * Returns number of flushes made so far
+ */
+int DiskInterface::GetNumFlushes() const { return num_flushes_; }
+
+/**
+ * Returns number of Writes made so far
+ */
+int DiskInterface::GetNumWrites() const { return num_writes_; }
+
+/**
+ * Returns true if the log is currently being flushed
+ */
+bool DiskInterface::GetFlushState() const { return flush_log_; }
+
+void DiskInterface::EnableStatsDump(std::chrono::milliseconds interval) {
+  DisableStatsDump();
+  std::scoped_lock scoped_stats_dump_latch(stats_dump_latch_);
+  stats_dump_enabled_ = true;
+  stats_dump_thread_ = std::thread(&DiskInterface::StatsDumpLoop, this, interval);
+}
+
+void DiskInterface::DisableStatsDump() {
+  {
+    std::scoped_lock scoped_stats_dump_latch(stats_dump_latch_);
+    stats_dump_enabled_ = false;
+  }
+  stats_dump_cv_.notify_all();
+  if (stats_dump_thread_.joinable()) {
+    stats_dump_thread_.join();
+  }
+}
+
+/**
+ * Log the operations of the last interval, so that throughput and latency can be watched while a workload runs
+ */
+void DiskInterface::StatsDumpLoop(std::chrono::milliseconds interval) {
+  auto last = stats_.Snapshot();
+  auto last_time = std::chrono::steady_clock::now();
+  std::unique_lock<std::mutex> latch(stats_dump_latch_);
+  while (!stats_dump_cv_.wait_for(latch, interval, [&] { return !stats_dump_enabled_; })) {
+    auto current = stats_.Snapshot();
+    auto now = std::chrono::steady_clock::now();
+    std::array<IOStats, NUM_IO_TYPES> delta;
+    for (size_t i = 0; i < NUM_IO_TYPES; i++) {
+      delta[i] = current[i] - last[i];
+    }
+    LOG_INFO("I/O stats for %s:\n%s", name_.c_str(), DiskStats::Format(delta, now - last_time).c_str());
+    last = current;
+    last_time = now;
+  }
+}
+
+}  // namespace bustub
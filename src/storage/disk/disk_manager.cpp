@@ -11,27 +11,28 @@
 //===----------------------------------------------------------------------===//
 
 #include <sys/stat.h>
+#include <algorithm>
 #include <cassert>
+#include <chrono>  // NOLINT
 #include <cstring>
 #include <iostream>
 #include <mutex>  // NOLINT
 #include <string>
-#include <thread>  // NOLINT
 
 #include "common/exception.h"
 #include "common/logger.h"
+#include "common/util/crc32c_util.h"
 #include "storage/disk/disk_manager.h"
 
 namespace bustub {
 
-static char *buffer_used;
-
 /**
  * Constructor: open/create a single database file & log file
  * @input db_file: database file name
+ * @input log_sync_mode: how the log device makes log writes durable
  */
-DiskManager::DiskManager(const std::string &db_file)
-    : file_name_(db_file), num_flushes_(0), num_writes_(0), flush_log_(false), flush_log_f_(nullptr) {
+DiskManager::DiskManager(const std::string &db_file, LogDevice::SyncMode log_sync_mode)
+    : DiskInterface(db_file), file_name_(db_file) {
   std::string::size_type n = file_name_.rfind('.');
   if (n == std::string::npos) {
     LOG_DEBUG("wrong file format");
@@ -39,19 +40,7 @@ DiskManager::DiskManager(const std::string &db_file)
   }
   log_name_ = file_name_.substr(0, n) + ".log";
 
-  log_io_.open(log_name_, std::ios::binary | std::ios::in | std::ios::app | std::ios::out);
-  // directory or file does not exist
-  if (!log_io_.is_open()) {
-    log_io_.clear();
-    // create a new file
-    log_io_.open(log_name_, std::ios::binary | std::ios::trunc | std::ios::app | std::ios::out);
-    log_io_.close();
-    // reopen with original mode
-    log_io_.open(log_name_, std::ios::binary | std::ios::in | std::ios::app | std::ios::out);
-    if (!log_io_.is_open()) {
-      throw Exception("can't open dblog file");
-    }
-  }
+  log_device_ = std::make_unique<LogDevice>(log_name_, log_sync_mode, 2, LOG_BUFFER_SIZE, &stats_);
 
   std::scoped_lock scoped_db_io_latch(db_io_latch_);
   db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
@@ -67,65 +56,131 @@ DiskManager::DiskManager(const std::string &db_file)
       throw Exception("can't open db file");
     }
   }
-  buffer_used = nullptr;
+  OpenLayout();
 }
 
 /**
  * Close all file streams
  */
 void DiskManager::ShutDown() {
+  DisableStatsDump();
   {
     std::scoped_lock scoped_db_io_latch(db_io_latch_);
     db_io_.close();
   }
-  log_io_.close();
+  if (log_device_ != nullptr) {
+    log_device_->Close();
+  }
 }
 
 /**
- * Write the contents of the specified page into disk file
+ * Write the contents of the specified page into disk file, then its checksum entry
  */
 void DiskManager::WritePage(page_id_t page_id, const char *page_data) {
+  if (page_id < 0) {
+    LOG_DEBUG("I/O error writing an invalid page id");
+    stats_.Record(IOType::PAGE_WRITE, 0, std::chrono::nanoseconds(0));
+    return;
+  }
+  ChecksumEntry entry{PageChecksum(page_data), 1};
   std::scoped_lock scoped_db_io_latch(db_io_latch_);
-  size_t offset = static_cast<size_t>(page_id) * PAGE_SIZE;
+  // time the device only, waiting for other buffer pool instances to release the latch is not I/O latency
+  auto start = std::chrono::steady_clock::now();
+  size_t offset = LayoutPageOffset(page_id);
   // set write cursor to offset
   num_writes_ += 1;
   db_io_.seekp(offset);
   db_io_.write(page_data, PAGE_SIZE);
+  // the page goes out before its entry: a crash in between leaves a page that doesn't match its checksum, which
+  // verification reports like a torn page
+  if (has_checksums_ && !db_io_.bad()) {
+    db_io_.seekp(ChecksumOffset(page_id));
+    db_io_.write(reinterpret_cast<const char *>(&entry), sizeof(entry));
+  }
   // check for I/O error
   if (db_io_.bad()) {
     LOG_DEBUG("I/O error while writing");
+    stats_.Record(IOType::PAGE_WRITE, 0, std::chrono::steady_clock::now() - start);
     return;
   }
   // needs to flush to keep disk file in sync
   db_io_.flush();
+
+  auto slot = static_cast<size_t>(page_id);
+  if (has_checksums_) {
+    if (slot >= checksums_.size()) {
+      checksums_.resize(slot + 1, ChecksumEntry{0, 0});
+    }
+    checksums_[slot] = entry;
+  }
+  if (slot >= verified_.size()) {
+    verified_.resize(slot + 1, false);
+  }
+  verified_[slot] = true;
+  stats_.Record(IOType::PAGE_WRITE, PAGE_SIZE, std::chrono::steady_clock::now() - start);
 }
 
 /**
  * Read the contents of the specified page into the given memory area
  */
 void DiskManager::ReadPage(page_id_t page_id, char *page_data) {
-  std::scoped_lock scoped_db_io_latch(db_io_latch_);
-  int offset = page_id * PAGE_SIZE;
-  // check if read beyond file length
-  if (offset > GetFileSize(file_name_)) {
-    LOG_DEBUG("I/O error reading past end of file");
-    // std::cerr << "I/O error while reading" << std::endl;
-  } else {
+  auto slot = static_cast<size_t>(page_id);
+  bool verify = false;
+  uint32_t expected = 0;
+  bool first_read = false;
+  {
+    std::scoped_lock scoped_db_io_latch(db_io_latch_);
+    auto start = std::chrono::steady_clock::now();
+    // check if read beyond file length
+    int64_t file_size = GetFileSize(file_name_);
+    if (page_id < 0 || file_size < 0 || LayoutPageOffset(page_id) > static_cast<size_t>(file_size)) {
+      LOG_DEBUG("I/O error reading past end of file");
+      // std::cerr << "I/O error while reading" << std::endl;
+      memset(page_data, 0, PAGE_SIZE);
+      stats_.Record(IOType::PAGE_READ, 0, std::chrono::steady_clock::now() - start);
+      return;
+    }
     // set read cursor to offset
-    db_io_.seekp(offset);
+    db_io_.seekp(LayoutPageOffset(page_id));
     db_io_.read(page_data, PAGE_SIZE);
     if (db_io_.bad()) {
       LOG_DEBUG("I/O error while reading");
+      stats_.Record(IOType::PAGE_READ, 0, std::chrono::steady_clock::now() - start);
       return;
     }
     // if file ends before reading PAGE_SIZE
-    int read_count = db_io_.gcount();
+    int read_count = static_cast<int>(db_io_.gcount());
     if (read_count < PAGE_SIZE) {
       LOG_DEBUG("Read less than a page");
       db_io_.clear();
       // std::cerr << "Read less than a page" << std::endl;
       memset(page_data + read_count, 0, PAGE_SIZE - read_count);
     }
+    stats_.Record(IOType::PAGE_READ, read_count, std::chrono::steady_clock::now() - start);
+
+    if (slot >= verified_.size()) {
+      verified_.resize(slot + 1, false);
+    }
+    // a page that was never written has no checksum, e.g. the hole left by writing a later page first
+    verify = has_checksums_ && slot < checksums_.size() && checksums_[slot].written_ != 0 &&
+             (checksum_verification_ == ChecksumVerification::ALWAYS ||
+              (checksum_verification_ == ChecksumVerification::FIRST_READ && !verified_[slot]));
+    if (verify) {
+      expected = checksums_[slot].checksum_;
+    }
+    first_read = checksum_verification_ == ChecksumVerification::FIRST_READ;
+  }
+
+  // checksum outside of the latch, other buffer pool instances can do I/O in the meantime
+  if (!verify) {
+    return;
+  }
+  if (PageChecksum(page_data) != expected) {
+    throw Exception("checksum mismatch on page " + std::to_string(page_id) + " of " + file_name_);
+  }
+  if (first_read) {
+    std::scoped_lock scoped_db_io_latch(db_io_latch_);
+    verified_[slot] = true;
   }
 }
 
@@ -135,8 +190,8 @@ void DiskManager::ReadPage(page_id_t page_id, char *page_data) {
  */
 void DiskManager::WriteLog(char *log_data, int size) {
   // enforce swap log buffer
-  assert(log_data != buffer_used);
-  buffer_used = log_data;
+  assert(log_data != last_log_buffer_);
+  last_log_buffer_ = log_data;
 
   if (size == 0) {  // no effect on num_flushes_ if log buffer is empty
     return;
@@ -150,16 +205,20 @@ void DiskManager::WriteLog(char *log_data, int size) {
   }
 
   num_flushes_ += 1;
-  // sequence write
-  log_io_.write(log_data, size);
-
-  // check for I/O error
-  if (log_io_.bad()) {
+  if (log_device_ == nullptr) {
     LOG_DEBUG("I/O error while writing log");
+    flush_log_ = false;
     return;
   }
-  // needs to flush to keep disk file in sync
-  log_io_.flush();
+  // sequence write, returns once the device has synced it
+  auto start = std::chrono::steady_clock::now();
+  try {
+    log_device_->WaitForDurable(log_device_->Append(log_data, size));
+  } catch (Exception &e) {
+    flush_log_ = false;
+    throw;
+  }
+  stats_.Record(IOType::LOG_WRITE, size, std::chrono::steady_clock::now() - start);
   flush_log_ = false;
 }
 
@@ -169,50 +228,94 @@ void DiskManager::WriteLog(char *log_data, int size) {
  * @return: false means already reach the end
  */
 bool DiskManager::ReadLog(char *log_data, int size, int offset) {
-  if (offset >= GetFileSize(log_name_)) {
-    // LOG_DEBUG("end of log file");
-    // LOG_DEBUG("file size is %d", GetFileSize(log_name_));
+  if (log_device_ == nullptr) {
     return false;
   }
-  log_io_.seekp(offset);
-  log_io_.read(log_data, size);
+  return log_device_->Read(log_data, size, offset);
+}
+
+void DiskManager::SetChecksumVerification(ChecksumVerification verification) {
+  std::scoped_lock scoped_db_io_latch(db_io_latch_);
+  checksum_verification_ = verification;
+}
+
+size_t DiskManager::PageOffset(page_id_t page_id) {
+  auto slot = static_cast<size_t>(page_id);
+  size_t block = slot / PAGES_PER_CHECKSUM_BLOCK;
+  // the file header, then a checksum block and its pages per block
+  return (2 + block * (PAGES_PER_CHECKSUM_BLOCK + 1) + slot % PAGES_PER_CHECKSUM_BLOCK) * PAGE_SIZE;
+}
+
+size_t DiskManager::ChecksumOffset(page_id_t page_id) {
+  auto slot = static_cast<size_t>(page_id);
+  size_t block = slot / PAGES_PER_CHECKSUM_BLOCK;
+  return (1 + block * (PAGES_PER_CHECKSUM_BLOCK + 1)) * PAGE_SIZE +
+         slot % PAGES_PER_CHECKSUM_BLOCK * sizeof(ChecksumEntry);
+}
 
-  if (log_io_.bad()) {
-    LOG_DEBUG("I/O error while reading log");
+bool DiskManager::HasFileHeader(const char *data, size_t size) {
+  uint64_t magic = 0;
+  if (size < sizeof(magic)) {
     return false;
   }
-  // if log file ends before reading "size"
-  int read_count = log_io_.gcount();
-  if (read_count < size) {
-    log_io_.clear();
-    memset(log_data + read_count, 0, size - read_count);
-  }
-
-  return true;
+  memcpy(&magic, data, sizeof(magic));
+  return magic == FILE_MAGIC;
 }
 
 /**
- * Returns number of flushes made so far
+ * Private helper function to get disk file size
  */
-int DiskManager::GetNumFlushes() const { return num_flushes_; }
+int64_t DiskManager::GetFileSize(const std::string &file_name) {
+  struct stat stat_buf;
+  int rc = stat(file_name.c_str(), &stat_buf);
+  return rc == 0 ? static_cast<int64_t>(stat_buf.st_size) : -1;
+}
 
 /**
- * Returns number of Writes made so far
+ * Private helper function, called with db_io_latch_ held by the constructor
  */
-int DiskManager::GetNumWrites() const { return num_writes_; }
+void DiskManager::OpenLayout() {
+  int64_t file_size = GetFileSize(file_name_);
+  char block[PAGE_SIZE] = {0};
+  if (file_size <= 0) {
+    memcpy(block, &FILE_MAGIC, sizeof(FILE_MAGIC));
+    db_io_.seekp(0);
+    db_io_.write(block, PAGE_SIZE);
+    db_io_.flush();
+    if (db_io_.bad()) {
+      throw Exception("can't write header of db file");
+    }
+    return;
+  }
 
-/**
- * Returns true if the log is currently being flushed
- */
-bool DiskManager::GetFlushState() const { return flush_log_; }
+  db_io_.seekp(0);
+  db_io_.read(block, PAGE_SIZE);
+  has_checksums_ = HasFileHeader(block, db_io_.gcount());
+  db_io_.clear();
+  if (!has_checksums_) {
+    LOG_INFO("%s has no checksums, reading it without verification", file_name_.c_str());
+    return;
+  }
+
+  // load the entries of every checksum block in the file, a block past the end has no written pages yet
+  for (page_id_t first = 0; ChecksumOffset(first) < static_cast<size_t>(file_size);
+       first += PAGES_PER_CHECKSUM_BLOCK) {
+    memset(block, 0, PAGE_SIZE);
+    db_io_.seekp(ChecksumOffset(first));
+    db_io_.read(block, PAGE_SIZE);
+    db_io_.clear();
+    checksums_.resize(first + PAGES_PER_CHECKSUM_BLOCK);
+    memcpy(&checksums_[first], block, PAGE_SIZE);
+  }
+}
+
+size_t DiskManager::LayoutPageOffset(page_id_t page_id) const {
+  return has_checksums_ ? PageOffset(page_id) : static_cast<size_t>(page_id) * PAGE_SIZE;
+}
 
 /**
- * Private helper function to get disk file size
+ * Private helper function to checksum a page
  */
-int DiskManager::GetFileSize(const std::string &file_name) {
-  struct stat stat_buf;
-  int rc = stat(file_name.c_str(), &stat_buf);
-  return rc == 0 ? static_cast<int>(stat_buf.st_size) : -1;
-}
+uint32_t DiskManager::PageChecksum(const char *page_data) { return Crc32cUtil::Crc32c(page_data, PAGE_SIZE); }
 
 }  // namespace bustub
@@ -0,0 +1,151 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// disk_stats.cpp
+//
+// Identification: src/storage/disk/disk_stats.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <string>
+
+#include "storage/disk/disk_stats.h"
+
+namespace bustub {
+
+namespace {
+
+/** Histogram bucket of a latency: the number of significant bits, capped at the last bucket. */
+size_t LatencyBucket(uint64_t latency_ns) {
+  if (latency_ns == 0) {
+    return 0;
+  }
+  auto bits = static_cast<size_t>(64 - __builtin_clzll(latency_ns));
+  return std::min(bits, NUM_LATENCY_BUCKETS - 1);
+}
+
+/** Upper bound of a histogram bucket in nanoseconds. */
+uint64_t BucketUpperBound(size_t bucket) { return bucket == 0 ? 0 : (1ULL << bucket); }
+
+}  // namespace
+
+uint64_t IOStats::AverageLatency() const { return count_ == 0 ? 0 : total_latency_ns_ / count_; }
+
+uint64_t IOStats::LatencyPercentile(double percentile) const {
+  uint64_t total = 0;
+  for (auto bucket_count : latency_histogram_) {
+    total += bucket_count;
+  }
+  if (total == 0) {
+    return 0;
+  }
+  // rank of the operation we are looking for, 1-based
+  auto rank = static_cast<uint64_t>(percentile / 100.0 * static_cast<double>(total));
+  rank = std::clamp<uint64_t>(rank, 1, total);
+  uint64_t seen = 0;
+  for (size_t i = 0; i < NUM_LATENCY_BUCKETS; i++) {
+    seen += latency_histogram_[i];
+    if (seen >= rank) {
+      return BucketUpperBound(i);
+    }
+  }
+  return BucketUpperBound(NUM_LATENCY_BUCKETS - 1);
+}
+
+IOStats IOStats::operator-(const IOStats &other) const {
+  IOStats diff;
+  diff.count_ = count_ - other.count_;
+  diff.bytes_ = bytes_ - other.bytes_;
+  diff.total_latency_ns_ = total_latency_ns_ - other.total_latency_ns_;
+  for (size_t i = 0; i < NUM_LATENCY_BUCKETS; i++) {
+    diff.latency_histogram_[i] = latency_histogram_[i] - other.latency_histogram_[i];
+  }
+  return diff;
+}
+
+void DiskStats::Record(IOType type, size_t bytes, std::chrono::nanoseconds latency) {
+  auto latency_ns = static_cast<uint64_t>(std::max<int64_t>(latency.count(), 0));
+  auto &counters = counters_[static_cast<size_t>(type)];
+  counters.count_.fetch_add(1, std::memory_order_relaxed);
+  counters.bytes_.fetch_add(bytes, std::memory_order_relaxed);
+  counters.total_latency_ns_.fetch_add(latency_ns, std::memory_order_relaxed);
+  counters.latency_histogram_[LatencyBucket(latency_ns)].fetch_add(1, std::memory_order_relaxed);
+}
+
+IOStats DiskStats::Get(IOType type) const {
+  const auto &counters = counters_[static_cast<size_t>(type)];
+  IOStats stats;
+  stats.count_ = counters.count_.load(std::memory_order_relaxed);
+  stats.bytes_ = counters.bytes_.load(std::memory_order_relaxed);
+  stats.total_latency_ns_ = counters.total_latency_ns_.load(std::memory_order_relaxed);
+  for (size_t i = 0; i < NUM_LATENCY_BUCKETS; i++) {
+    stats.latency_histogram_[i] = counters.latency_histogram_[i].load(std::memory_order_relaxed);
+  }
+  return stats;
+}
+
+std::array<IOStats, NUM_IO_TYPES> DiskStats::Snapshot() const {
+  std::array<IOStats, NUM_IO_TYPES> stats;
+  for (size_t i = 0; i < NUM_IO_TYPES; i++) {
+    stats[i] = Get(static_cast<IOType>(i));
+  }
+  return stats;
+}
+
+void DiskStats::Reset() {
+  for (auto &counters : counters_) {
+    counters.count_.store(0, std::memory_order_relaxed);
+    counters.bytes_.store(0, std::memory_order_relaxed);
+    counters.total_latency_ns_.store(0, std::memory_order_relaxed);
+    for (auto &bucket : counters.latency_histogram_) {
+      bucket.store(0, std::memory_order_relaxed);
+    }
+  }
+}
+
+std::string DiskStats::ToString() const { return Format(Snapshot()); }
+
+std::string DiskStats::Format(const std::array<IOStats, NUM_IO_TYPES> &stats, std::chrono::nanoseconds elapsed) {
+  std::string result;
+  char line[256];
+  double seconds = std::chrono::duration<double>(elapsed).count();
+  for (size_t i = 0; i < NUM_IO_TYPES; i++) {
+    const auto &io = stats[i];
+    int len = snprintf(line, sizeof(line),
+                       "%-10s %10" PRIu64 " ops %12" PRIu64 " bytes  avg %.1fus p50 <%.1fus p99 <%.1fus",
+                       TypeName(static_cast<IOType>(i)), io.count_, io.bytes_,
+                       static_cast<double>(io.AverageLatency()) / 1000.0,
+                       static_cast<double>(io.LatencyPercentile(50)) / 1000.0,
+                       static_cast<double>(io.LatencyPercentile(99)) / 1000.0);
+    result.append(line, std::min<size_t>(std::max(len, 0), sizeof(line) - 1));
+    if (seconds > 0) {
+      len = snprintf(line, sizeof(line), "  %.1f ops/s %.2f MB/s", static_cast<double>(io.count_) / seconds,
+                     static_cast<double>(io.bytes_) / seconds / (1024.0 * 1024.0));
+      result.append(line, std::min<size_t>(std::max(len, 0), sizeof(line) - 1));
+    }
+    result.push_back('\n');
+  }
+  return result;
+}
+
+const char *DiskStats::TypeName(IOType type) {
+  switch (type) {
+    case IOType::PAGE_READ:
+      return "page_read";
+    case IOType::PAGE_WRITE:
+      return "page_write";
+    case IOType::LOG_WRITE:
+      return "log_write";
+    case IOType::SYNC:
+      return "sync";
+  }
+  return "unknown";
+}
+
+}  // namespace bustub
@@ -0,0 +1,278 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// log_device.cpp
+//
+// Identification: src/storage/disk/log_device.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>  // NOLINT
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "common/exception.h"
+#include "common/logger.h"
+#include "storage/disk/log_device.h"
+
+namespace bustub {
+
+/**
+ * Constructor: open/create the log file in append mode and start the I/O thread
+ */
+LogDevice::LogDevice(const std::string &log_file, SyncMode sync_mode, size_t num_buffers, size_t buffer_size,
+                     DiskStats *stats)
+    : sync_mode_(sync_mode), buffer_size_(buffer_size), stats_(stats) {
+  int flags = O_RDWR | O_APPEND | O_CREAT;
+  if (sync_mode_ == SyncMode::DSYNC) {
+    flags |= O_DSYNC;
+  }
+  fd_ = open(log_file.c_str(), flags, 0644);
+  if (fd_ < 0) {
+    throw Exception("can't open dblog file");
+  }
+
+  struct stat stat_buf;
+  if (fstat(fd_, &stat_buf) == 0) {
+    appended_offset_ = durable_offset_ = static_cast<uint64_t>(stat_buf.st_size);
+  }
+
+  buffers_.resize(std::max<size_t>(num_buffers, 2));
+  for (size_t i = 0; i < buffers_.size(); i++) {
+    buffers_[i].data_ = std::make_unique<char[]>(buffer_size_);
+    free_.push_back(i);
+  }
+
+  flush_thread_ = std::thread(&LogDevice::FlushLoop, this);
+}
+
+LogDevice::~LogDevice() { Close(); }
+
+void LogDevice::Close() {
+  {
+    std::scoped_lock scoped_latch(latch_);
+    if (closed_) {
+      return;
+    }
+    if (has_active_ && buffers_[active_].size_ > 0) {
+      SealActive();
+    }
+    closed_ = true;
+  }
+  flush_cv_.notify_one();
+  flush_thread_.join();
+  close(fd_);
+  fd_ = -1;
+}
+
+uint64_t LogDevice::Append(const char *data, size_t size) {
+  std::unique_lock<std::mutex> latch(latch_);
+  if (closed_) {
+    LOG_DEBUG("append to a closed log device");
+    return appended_offset_;
+  }
+
+  while (size > 0) {
+    if (!has_active_) {
+      // every buffer is waiting for the device, this is the only place an appender blocks
+      durable_cv_.wait(latch, [&] { return has_active_ || !free_.empty(); });
+      if (!has_active_) {
+        active_ = free_.front();
+        free_.pop_front();
+        has_active_ = true;
+      }
+    }
+
+    auto &buffer = buffers_[active_];
+    size_t count = std::min(size, buffer_size_ - buffer.size_);
+    memcpy(buffer.data_.get() + buffer.size_, data, count);
+    buffer.size_ += count;
+    appended_offset_ += count;
+    data += count;
+    size -= count;
+
+    if (buffer.size_ == buffer_size_) {
+      SealActive();
+    }
+  }
+  return appended_offset_;
+}
+
+void LogDevice::WaitForDurable(uint64_t offset) {
+  std::unique_lock<std::mutex> latch(latch_);
+  if (durable_offset_ >= offset) {
+    return;
+  }
+  if (failed_) {
+    throw Exception("log device failed, log up to offset " + std::to_string(offset) + " is not durable");
+  }
+  // the active buffer holds bytes we are waiting for, hand it to the device now instead of waiting for it to fill up
+  if (has_active_ && buffers_[active_].size_ > 0 && offset > appended_offset_ - buffers_[active_].size_) {
+    SealActive();
+  }
+  durable_cv_.wait(latch, [&] { return durable_offset_ >= offset || failed_ || (closed_ && sealed_.empty()); });
+  if (durable_offset_ < offset && failed_) {
+    throw Exception("log device failed, log up to offset " + std::to_string(offset) + " is not durable");
+  }
+}
+
+bool LogDevice::Read(char *data, size_t size, uint64_t offset) {
+  struct stat stat_buf;
+  if (fstat(fd_, &stat_buf) != 0 || offset >= static_cast<uint64_t>(stat_buf.st_size)) {
+    return false;
+  }
+
+  size_t read_count = 0;
+  while (read_count < size) {
+    ssize_t ret = pread(fd_, data + read_count, size - read_count, offset + read_count);
+    if (ret < 0 && errno == EINTR) {
+      continue;
+    }
+    if (ret < 0) {
+      LOG_DEBUG("I/O error while reading log");
+      return false;
+    }
+    if (ret == 0) {
+      break;
+    }
+    read_count += ret;
+  }
+  // if log file ends before reading "size"
+  if (read_count < size) {
+    memset(data + read_count, 0, size - read_count);
+  }
+  return true;
+}
+
+uint64_t LogDevice::GetDurableOffset() {
+  std::scoped_lock scoped_latch(latch_);
+  return durable_offset_;
+}
+
+bool LogDevice::HasFailed() {
+  std::scoped_lock scoped_latch(latch_);
+  return failed_;
+}
+
+uint64_t LogDevice::GetNumSyncs() {
+  std::scoped_lock scoped_latch(latch_);
+  return num_syncs_;
+}
+
+void LogDevice::SealActive() {
+  sealed_.push_back(active_);
+  has_active_ = false;
+  flush_cv_.notify_one();
+}
+
+void LogDevice::FlushLoop() {
+  std::unique_lock<std::mutex> latch(latch_);
+  while (true) {
+    flush_cv_.wait(latch, [&] { return !sealed_.empty() || closed_; });
+    if (sealed_.empty()) {
+      // closed and fully drained
+      break;
+    }
+
+    // group commit: everything sealed while the previous sync was running goes out with one sync
+    std::vector<size_t> batch(sealed_.begin(), sealed_.end());
+    sealed_.clear();
+    // once a write or sync has failed nothing after it can be made durable: the page cache may have dropped the
+    // failed bytes, so a later sync that succeeds proves nothing about them. Drop the rest instead of writing it.
+    bool failed = failed_;
+    latch.unlock();
+    if (!failed) {
+      failed = !WriteAndSync(batch);
+    }
+    latch.lock();
+
+    for (auto idx : batch) {
+      if (!failed) {
+        durable_offset_ += buffers_[idx].size_;
+      }
+      buffers_[idx].size_ = 0;
+      free_.push_back(idx);
+    }
+    if (failed) {
+      failed_ = true;
+    } else {
+      num_syncs_ += 1;
+    }
+    durable_cv_.notify_all();
+  }
+}
+
+bool LogDevice::WriteAndSync(const std::vector<size_t> &buffers) {
+  // sealed buffers are only touched by the I/O thread until they are returned to free_
+  std::vector<struct iovec> iov;
+  size_t total = 0;
+  for (auto idx : buffers) {
+    iov.push_back({buffers_[idx].data_.get(), buffers_[idx].size_});
+    total += buffers_[idx].size_;
+  }
+
+  // time the write together with the sync, with O_DSYNC the writes themselves are the sync
+  auto sync_start = std::chrono::steady_clock::now();
+  size_t first = 0;
+  size_t written = 0;
+  while (written < total) {
+    ssize_t ret = writev(fd_, iov.data() + first, static_cast<int>(iov.size() - first));
+    if (ret < 0 && errno == EINTR) {
+      continue;
+    }
+    if (ret <= 0) {
+      LOG_ERROR("I/O error while writing log: %s", ret < 0 ? strerror(errno) : "no progress");
+      return false;
+    }
+    written += ret;
+    // skip the fully written iovecs and trim the partially written one
+    auto remaining = static_cast<size_t>(ret);
+    while (first < iov.size() && remaining >= iov[first].iov_len) {
+      remaining -= iov[first].iov_len;
+      first++;
+    }
+    if (first < iov.size()) {
+      iov[first].iov_base = static_cast<char *>(iov[first].iov_base) + remaining;
+      iov[first].iov_len -= remaining;
+    }
+  }
+
+  int ret = 0;
+  switch (sync_mode_) {
+    case SyncMode::DSYNC:
+      // every write was already synchronous
+      break;
+    case SyncMode::SYNC_FILE_RANGE:
+#ifdef __linux__
+      ret = sync_file_range(fd_, static_cast<off64_t>(durable_offset_), static_cast<off64_t>(total),
+                            SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER);
+#else
+      ret = fdatasync(fd_);
+#endif
+      break;
+    case SyncMode::FDATASYNC:
+    default:
+      ret = fdatasync(fd_);
+      break;
+  }
+  if (ret != 0) {
+    LOG_ERROR("I/O error while syncing log: %s", strerror(errno));
+    return false;
+  }
+  if (stats_ != nullptr) {
+    stats_->Record(IOType::SYNC, total, std::chrono::steady_clock::now() - sync_start);
+  }
+  return true;
+}
+
+}  // namespace bustub
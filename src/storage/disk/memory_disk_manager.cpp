@@ -0,0 +1,139 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// memory_disk_manager.cpp
+//
+// Identification: src/storage/disk/memory_disk_manager.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cstring>
+#include <mutex>   // NOLINT
+#include <thread>  // NOLINT
+
+#include "common/logger.h"
+#include "storage/disk/memory_disk_manager.h"
+
+namespace bustub {
+
+MemoryDiskManager::MemoryDiskManager() : MemoryDiskManager(DeviceModel{}) {}
+
+MemoryDiskManager::MemoryDiskManager(DeviceModel device_model) : DiskInterface("memory"), device_model_(device_model) {}
+
+/**
+ * Drop all pages and the log
+ */
+void MemoryDiskManager::ShutDown() {
+  std::scoped_lock scoped_latch(latch_);
+  pages_.clear();
+  pages_.shrink_to_fit();
+  log_.clear();
+  log_.shrink_to_fit();
+}
+
+/**
+ * Copy the contents of the specified page into its memory slot, allocating the slot on first write
+ */
+void MemoryDiskManager::WritePage(page_id_t page_id, const char *page_data) {
+  if (page_id < 0) {
+    LOG_DEBUG("I/O error writing an invalid page id");
+    stats_.Record(IOType::PAGE_WRITE, 0, std::chrono::nanoseconds(0));
+    return;
+  }
+  auto transfer_time = SimulateTransfer(PAGE_SIZE);
+  std::scoped_lock scoped_latch(latch_);
+  // the simulated transfer plus the copy, but not the wait for the latch
+  auto start = std::chrono::steady_clock::now() - transfer_time;
+  num_writes_ += 1;
+  auto slot = static_cast<size_t>(page_id);
+  if (slot >= pages_.size()) {
+    pages_.resize(slot + 1);
+  }
+  if (pages_[slot] == nullptr) {
+    pages_[slot] = std::make_unique<char[]>(PAGE_SIZE);
+  }
+  memcpy(pages_[slot].get(), page_data, PAGE_SIZE);
+  stats_.Record(IOType::PAGE_WRITE, PAGE_SIZE, std::chrono::steady_clock::now() - start);
+}
+
+/**
+ * Copy the contents of the specified page into the given memory area
+ */
+void MemoryDiskManager::ReadPage(page_id_t page_id, char *page_data) {
+  if (page_id < 0) {
+    LOG_DEBUG("I/O error reading an invalid page id");
+    memset(page_data, 0, PAGE_SIZE);
+    stats_.Record(IOType::PAGE_READ, 0, std::chrono::nanoseconds(0));
+    return;
+  }
+  auto transfer_time = SimulateTransfer(PAGE_SIZE);
+  std::scoped_lock scoped_latch(latch_);
+  auto start = std::chrono::steady_clock::now() - transfer_time;
+  auto slot = static_cast<size_t>(page_id);
+  if (slot >= pages_.size() || pages_[slot] == nullptr) {
+    // reads back as zeroes, like a hole in a database file
+    memset(page_data, 0, PAGE_SIZE);
+  } else {
+    memcpy(page_data, pages_[slot].get(), PAGE_SIZE);
+  }
+  stats_.Record(IOType::PAGE_READ, PAGE_SIZE, std::chrono::steady_clock::now() - start);
+}
+
+/**
+ * Append the contents of the log buffer to the in-memory log
+ */
+void MemoryDiskManager::WriteLog(char *log_data, int size) {
+  if (size == 0) {  // no effect on num_flushes_ if log buffer is empty
+    return;
+  }
+
+  flush_log_ = true;
+  auto transfer_time = SimulateTransfer(size);
+  {
+    std::scoped_lock scoped_latch(latch_);
+    auto start = std::chrono::steady_clock::now() - transfer_time;
+    num_flushes_ += 1;
+    log_.insert(log_.end(), log_data, log_data + size);
+    stats_.Record(IOType::LOG_WRITE, size, std::chrono::steady_clock::now() - start);
+  }
+  flush_log_ = false;
+}
+
+/**
+ * Read the contents of the log into the given memory area
+ * @return: false means already reach the end
+ */
+bool MemoryDiskManager::ReadLog(char *log_data, int size, int offset) {
+  std::scoped_lock scoped_latch(latch_);
+  if (offset < 0 || static_cast<size_t>(offset) >= log_.size()) {
+    return false;
+  }
+  auto read_count = std::min(static_cast<size_t>(size), log_.size() - offset);
+  memcpy(log_data, log_.data() + offset, read_count);
+  // if the log ends before reading "size"
+  if (read_count < static_cast<size_t>(size)) {
+    memset(log_data + read_count, 0, size - read_count);
+  }
+  return true;
+}
+
+std::chrono::steady_clock::duration MemoryDiskManager::SimulateTransfer(size_t bytes) {
+  if (device_model_.latency_.count() == 0 && device_model_.bandwidth_ == 0) {
+    return std::chrono::steady_clock::duration::zero();
+  }
+  auto start = std::chrono::steady_clock::now();
+  auto delay = std::chrono::duration_cast<std::chrono::nanoseconds>(device_model_.latency_);
+  if (device_model_.bandwidth_ != 0) {
+    delay += std::chrono::nanoseconds(bytes * 1000000000ULL / device_model_.bandwidth_);
+  }
+  std::scoped_lock scoped_device_latch(device_latch_);
+  std::this_thread::sleep_until(std::chrono::steady_clock::now() + delay);
+  return std::chrono::steady_clock::now() - start;
+}
+
+}  // namespace bustub
@@ -0,0 +1,147 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// mmap_disk_manager.cpp
+//
+// Identification: src/storage/disk/mmap_disk_manager.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cstring>
+#include <string>
+
+#include "common/exception.h"
+#include "common/logger.h"
+#include "storage/disk/disk_manager.h"
+#include "storage/disk/mmap_disk_manager.h"
+
+namespace bustub {
+
+/**
+ * Constructor: open the database file read-only and map it
+ * @input db_file: database file name
+ */
+MmapDiskManager::MmapDiskManager(const std::string &db_file) : DiskInterface(db_file), file_name_(db_file) {
+  fd_ = open(db_file.c_str(), O_RDONLY);
+  if (fd_ < 0) {
+    throw Exception("can't open db file");
+  }
+
+  struct stat stat_buf;
+  if (fstat(fd_, &stat_buf) != 0) {
+    close(fd_);
+    throw Exception("can't stat db file");
+  }
+  size_ = static_cast<size_t>(stat_buf.st_size);
+  if (size_ == 0) {
+    // nothing to map, every read is past the end of the file
+    return;
+  }
+
+  void *addr = mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd_, 0);
+  if (addr == MAP_FAILED) {
+    close(fd_);
+    throw Exception("can't mmap db file");
+  }
+  data_ = static_cast<char *>(addr);
+  has_checksums_ = DiskManager::HasFileHeader(data_, size_);
+  // point lookups should only fault in the page they touch; scans ask for readahead explicitly
+  madvise(data_, size_, MADV_RANDOM);
+}
+
+MmapDiskManager::~MmapDiskManager() { ShutDown(); }
+
+/**
+ * Unmap and close the database file
+ */
+void MmapDiskManager::ShutDown() {
+  if (data_ != nullptr) {
+    munmap(data_, size_);
+    data_ = nullptr;
+  }
+  if (fd_ >= 0) {
+    close(fd_);
+    fd_ = -1;
+  }
+}
+
+void MmapDiskManager::WritePage(page_id_t page_id, const char *page_data) {
+  throw Exception("can't write page to read-only db file " + file_name_);
+}
+
+/**
+ * Copy the contents of the specified page out of the mapping into the given memory area
+ */
+void MmapDiskManager::ReadPage(page_id_t page_id, char *page_data) {
+  auto start = std::chrono::steady_clock::now();
+  // check if read beyond file length
+  if (data_ == nullptr || page_id < 0 || PageOffset(page_id) >= size_) {
+    LOG_DEBUG("I/O error reading past end of file");
+    memset(page_data, 0, PAGE_SIZE);
+    stats_.Record(IOType::PAGE_READ, 0, std::chrono::steady_clock::now() - start);
+    return;
+  }
+
+  size_t offset = PageOffset(page_id);
+  size_t read_count = std::min(static_cast<size_t>(PAGE_SIZE), size_ - offset);
+  memcpy(page_data, data_ + offset, read_count);
+  // if file ends before reading PAGE_SIZE
+  if (read_count < static_cast<size_t>(PAGE_SIZE)) {
+    LOG_DEBUG("Read less than a page");
+    memset(page_data + read_count, 0, PAGE_SIZE - read_count);
+  }
+
+  AdviseAccess(page_id);
+  // includes the page fault, if the page was not resident yet
+  stats_.Record(IOType::PAGE_READ, read_count, std::chrono::steady_clock::now() - start);
+}
+
+void MmapDiskManager::WriteLog(char *log_data, int size) {
+  if (size == 0) {
+    return;
+  }
+  throw Exception("can't write log for read-only db file " + file_name_);
+}
+
+bool MmapDiskManager::ReadLog(char *log_data, int size, int offset) { return false; }
+
+/**
+ * Track runs of consecutive page ids. The detector state is only a hint, so concurrent readers racing on it
+ * merely cost a missed or duplicated madvise call.
+ */
+void MmapDiskManager::AdviseAccess(page_id_t page_id) {
+  page_id_t last = last_page_id_.exchange(page_id, std::memory_order_relaxed);
+  if (last == INVALID_PAGE_ID || page_id != last + 1) {
+    sequential_run_.store(0, std::memory_order_relaxed);
+    return;
+  }
+
+  int run = sequential_run_.fetch_add(1, std::memory_order_relaxed) + 1;
+  if (run < SEQUENTIAL_THRESHOLD || (run - SEQUENTIAL_THRESHOLD) % READAHEAD_PAGES != 0) {
+    return;
+  }
+
+  // prefetch the next window while the scan is consuming the current one
+  // a window that crosses a checksum block prefetches the block as well, one page short of the window
+  size_t start = PageOffset(page_id + 1);
+  if (start >= size_) {
+    return;
+  }
+  size_t length = std::min(static_cast<size_t>(READAHEAD_PAGES) * PAGE_SIZE, size_ - start);
+  madvise(data_ + start, length, MADV_WILLNEED);
+}
+
+size_t MmapDiskManager::PageOffset(page_id_t page_id) const {
+  return has_checksums_ ? DiskManager::PageOffset(page_id) : static_cast<size_t>(page_id) * PAGE_SIZE;
+}
+
+}  // namespace bustub
@@ -0,0 +1,74 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// adaptive_hash_index.cpp
+//
+// Identification: src/storage/index/adaptive_hash_index.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/index/adaptive_hash_index.h"
+
+#include "storage/index/generic_key.h"
+
+namespace bustub {
+
+template <typename KeyType, typename KeyComparator>
+AdaptiveHashIndex<KeyType, KeyComparator>::AdaptiveHashIndex(size_t num_buckets, const KeyComparator &comparator,
+                                                             uint32_t threshold)
+    : buckets_(num_buckets), latches_(NUM_STRIPES), comparator_(comparator), threshold_(threshold) {}
+
+template <typename KeyType, typename KeyComparator>
+bool AdaptiveHashIndex<KeyType, KeyComparator>::Lookup(const KeyType &key, page_id_t *page_id, int *slot) {
+  size_t index = BucketIndex(key);
+  std::lock_guard<std::mutex> guard(latches_[index % NUM_STRIPES]);
+  const Bucket &bucket = buckets_[index];
+  if (bucket.votes_ < threshold_ || bucket.page_id_ == INVALID_PAGE_ID || comparator_(bucket.key_, key) != 0) {
+    return false;
+  }
+  *page_id = bucket.page_id_;
+  *slot = bucket.slot_;
+  hits_++;
+  return true;
+}
+
+template <typename KeyType, typename KeyComparator>
+void AdaptiveHashIndex<KeyType, KeyComparator>::RecordDescent(const KeyType &key, page_id_t page_id, int slot) {
+  size_t index = BucketIndex(key);
+  std::lock_guard<std::mutex> guard(latches_[index % NUM_STRIPES]);
+  Bucket &bucket = buckets_[index];
+  if (bucket.votes_ > 0 && comparator_(bucket.key_, key) != 0) {
+    bucket.votes_--;
+    return;
+  }
+  if (bucket.votes_ == 0) {
+    bucket.key_ = key;
+  }
+  bucket.page_id_ = page_id;
+  bucket.slot_ = slot;
+  // stop counting at the threshold, so that a key that goes cold loses its bucket as quickly as it won it
+  if (bucket.votes_ < threshold_) {
+    bucket.votes_++;
+  }
+}
+
+template <typename KeyType, typename KeyComparator>
+void AdaptiveHashIndex<KeyType, KeyComparator>::Invalidate(const KeyType &key) {
+  size_t index = BucketIndex(key);
+  std::lock_guard<std::mutex> guard(latches_[index % NUM_STRIPES]);
+  Bucket &bucket = buckets_[index];
+  if (bucket.votes_ > 0 && comparator_(bucket.key_, key) == 0) {
+    bucket.page_id_ = INVALID_PAGE_ID;
+  }
+}
+
+template class AdaptiveHashIndex<GenericKey<4>, GenericComparator<4>>;
+template class AdaptiveHashIndex<GenericKey<8>, GenericComparator<8>>;
+template class AdaptiveHashIndex<GenericKey<16>, GenericComparator<16>>;
+template class AdaptiveHashIndex<GenericKey<32>, GenericComparator<32>>;
+template class AdaptiveHashIndex<GenericKey<64>, GenericComparator<64>>;
+
+}  // namespace bustub
@@ -9,41 +9,350 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
 #include <string>
+#include <thread>  // NOLINT
+#include <type_traits>
+#include <utility>
 
 #include "common/exception.h"
 #include "common/logger.h"
 #include "common/rid.h"
 #include "storage/index/b_plus_tree.h"
+#include "storage/index/posting_list.h"
 #include "storage/page/header_page.h"
 
 namespace bustub {
+
+namespace {
+
+/**
+ * Splits a level of a bulk load into nodes, filling each to fill_factor percent of both its max size and its capacity
+ * in bytes. Element i of the level stores key_at(i), except at the start of an internal node, and bounds[i] is the low
+ * fence of a node that starts at element i; the first node has no low fence and the last one no high fence. A short
+ * last node takes the rest into the node before it if they fit together, and otherwise takes elements from it until
+ * it is half full, so that no node but a lone one is less than half full.
+ */
+template <typename KeyType, typename KeyAt>
+std::vector<int> BulkLoadNodeSizes(int count, const KeyAt &key_at, const std::vector<KeyType> &bounds, bool leaf,
+                                   int value_size, int fill_factor, int min_size, int max_size) {
+  const int key_size = sizeof(KeyType);
+  const int capacity =
+      BPlusTreePage::EntryAreaSize(leaf ? LEAF_PAGE_HEADER_SIZE : INTERNAL_PAGE_HEADER_SIZE, key_size);
+  const int fill = std::clamp(max_size * fill_factor / 100, min_size, max_size);
+  const int space_fill = std::clamp(capacity * fill_factor / 100, capacity / 2, capacity);
+  auto prefix_size = [&](int start, int end) {
+    if (start == 0 || end == count) {
+      return 0;
+    }
+    return BPlusTreePage::CommonPrefixSize(reinterpret_cast<const char *>(&bounds[start]),
+                                           reinterpret_cast<const char *>(&bounds[end]), key_size);
+  };
+  auto entry_space = [&](int i, int start, int prefix) {
+    const char *key = !leaf && i == start ? nullptr : reinterpret_cast<const char *>(&key_at(i));
+    return BPlusTreePage::EntrySpace(key, key_size, value_size, prefix);
+  };
+  auto node_space = [&](int start, int end, int prefix) {
+    int space = 0;
+    for (int i = start; i < end; i++) {
+      space += entry_space(i, start, prefix);
+    }
+    return space;
+  };
+
+  std::vector<int> starts;
+  for (int start = 0; start < count;) {
+    starts.push_back(start);
+    int end = start + 1;
+    int prefix = prefix_size(start, end);
+    int space = entry_space(start, start, prefix);
+    while (end < count && end - start < fill) {
+      // the prefix can only shrink as the node grows, which grows the elements already in it
+      if (prefix_size(start, end + 1) != prefix) {
+        prefix = prefix_size(start, end + 1);
+        space = node_space(start, end, prefix);
+      }
+      if (space + entry_space(end, start, prefix) > space_fill) {
+        break;
+      }
+      space += entry_space(end, start, prefix);
+      end++;
+    }
+    start = end;
+  }
+
+  auto half_full = [&](int start, int end) {
+    return end - start >= min_size || 2 * node_space(start, end, prefix_size(start, end)) >= capacity;
+  };
+  if (starts.size() > 1 && !half_full(starts.back(), count)) {
+    int prev = starts[starts.size() - 2];
+    if (count - prev <= max_size && node_space(prev, count, prefix_size(prev, count)) <= capacity) {
+      starts.pop_back();
+    } else {
+      while (starts.back() - prev > 1 && !half_full(starts.back(), count)) {
+        starts.back()--;
+      }
+    }
+  }
+  std::vector<int> sizes;
+  for (size_t i = 0; i < starts.size(); i++) {
+    sizes.push_back((i + 1 < starts.size() ? starts[i + 1] : count) - starts[i]);
+  }
+  return sizes;
+}
+
+/** @return the low fence of every node of a level, bounds[i] being the low fence of a node that starts at element i */
+template <typename KeyType>
+std::vector<KeyType> BulkLoadNodeLows(const std::vector<KeyType> &bounds, const std::vector<int> &node_sizes) {
+  std::vector<KeyType> lows;
+  int start = 0;
+  for (int size : node_sizes) {
+    lows.push_back(bounds[start]);
+    start += size;
+  }
+  return lows;
+}
+
+}  // namespace
+
 INDEX_TEMPLATE_ARGUMENTS
 BPLUSTREE_TYPE::BPlusTree(std::string name, BufferPoolManager *buffer_pool_manager, const KeyComparator &comparator,
-                          int leaf_max_size, int internal_max_size)
+                          int leaf_max_size, int internal_max_size, bool unique, BPlusTreeMode mode)
     : index_name_(std::move(name)),
       root_page_id_(INVALID_PAGE_ID),
       buffer_pool_manager_(buffer_pool_manager),
       comparator_(comparator),
       leaf_max_size_(leaf_max_size),
-      internal_max_size_(internal_max_size) {}
+      internal_max_size_(mode == BPlusTreeMode::BUFFERED ? std::min(internal_max_size, BPLUSTREE_BUFFERED_FANOUT)
+                                                         : internal_max_size),
+      unique_(unique),
+      mode_(mode) {
+  if (mode_ == BPlusTreeMode::BUFFERED && !unique_) {
+    throw Exception(ExceptionType::NOT_IMPLEMENTED, "BPlusTree: buffered mode needs a unique tree");
+  }
+}
 
 /*
  * Helper function to decide whether current b+tree is empty
+ * A tree in B-link or buffered mode keeps its leaves once they empty out, so it is only empty until the first insert.
  */
 INDEX_TEMPLATE_ARGUMENTS
-bool BPLUSTREE_TYPE::IsEmpty() const { return true; }
+bool BPLUSTREE_TYPE::IsEmpty() const {
+  root_latch_.RLock();
+  bool empty = root_page_id_ == INVALID_PAGE_ID;
+  root_latch_.RUnlock();
+  return empty;
+}
 /*****************************************************************************
  * SEARCH
  *****************************************************************************/
 /*
- * Return the only value that associated with input key
+ * Return the only value that associated with input key, or all of them in a non-unique tree
  * This method is used for point query
  * @return : true means key exists
  */
 INDEX_TEMPLATE_ARGUMENTS
 bool BPLUSTREE_TYPE::GetValue(const KeyType &key, std::vector<ValueType> *result, Transaction *transaction) {
-  return false;
+  if (mode_ == BPlusTreeMode::BUFFERED) {
+    ValueType value;
+    root_latch_.RLock();
+    bool found = LookupBuffered(key, &value);
+    root_latch_.RUnlock();
+    if (found) {
+      result->push_back(value);
+    }
+    return found;
+  }
+  Page *leaf_page = nullptr;
+  page_id_t hint;
+  int slot;
+  if (adaptive_hash_index_ != nullptr && adaptive_hash_index_->Lookup(key, &hint, &slot)) {
+    leaf_page = LatchLeafHint(hint, key, false);
+    if (leaf_page == nullptr) {
+      adaptive_hash_index_->Invalidate(key);
+    }
+  }
+  int index;
+  if (leaf_page != nullptr) {
+    auto leaf = reinterpret_cast<LeafPage *>(leaf_page->GetData());
+    // the slot moves as keys come and go, so it is only used if it still holds the key
+    bool at_slot = slot >= 0 && slot < leaf->GetSize() && comparator_(leaf->KeyAt(slot), key) == 0;
+    index = at_slot ? slot : leaf->Find(key, comparator_);
+  } else {
+    leaf_page = FindLeafPage(key);
+    if (leaf_page == nullptr) {
+      return false;
+    }
+    index = reinterpret_cast<LeafPage *>(leaf_page->GetData())->Find(key, comparator_);
+    if (adaptive_hash_index_ != nullptr) {
+      adaptive_hash_index_->RecordDescent(key, leaf_page->GetPageId(), index);
+    }
+  }
+  auto leaf = reinterpret_cast<LeafPage *>(leaf_page->GetData());
+  bool found = index >= 0;
+  if (found && unique_) {
+    result->push_back(leaf->ValueAt(index));
+  } else if (found) {
+    // the overflow pages of the posting list are protected by the latch of the leaf
+    PostingList::GetValues(buffer_pool_manager_, leaf->PostingAt(index), result);
+  }
+  leaf_page->RUnlatch();
+  buffer_pool_manager_->UnpinPage(leaf_page->GetPageId(), false);
+  return found;
+}
+
+/*
+ * The hash index takes GetValue() past the internal pages, so it is left to lookups; writers and iterators descend.
+ * A buffered tree gets none, since the value of a key may be buffered above its leaf.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::EnableAdaptiveHashIndex(size_t num_buckets) {
+  if (mode_ == BPlusTreeMode::BUFFERED) {
+    return;
+  }
+  adaptive_hash_index_ = std::make_unique<AdaptiveHashIndex<KeyType, KeyComparator>>(num_buckets, comparator_);
+}
+
+/*****************************************************************************
+ * BULK LOAD
+ *****************************************************************************/
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::BulkLoad(const std::vector<MappingType> &entries, int fill_factor, Transaction *transaction) {
+  root_latch_.WLock();
+  if (root_page_id_ != INVALID_PAGE_ID) {
+    root_latch_.WUnlock();
+    bool loaded = true;
+    for (const auto &entry : entries) {
+      loaded = Insert(entry.first, entry.second, transaction) && loaded;
+    }
+    return loaded;
+  }
+
+  // load the longest strictly increasing run; copy it only if something has to be left out
+  size_t sorted_prefix = entries.empty() ? 0 : 1;
+  while (sorted_prefix < entries.size() &&
+         comparator_(entries[sorted_prefix - 1].first, entries[sorted_prefix].first) < 0) {
+    sorted_prefix++;
+  }
+  std::vector<MappingType> run;
+  std::vector<MappingType> deferred;
+  if (sorted_prefix < entries.size()) {
+    run.assign(entries.begin(), entries.begin() + sorted_prefix);
+    for (size_t i = sorted_prefix; i < entries.size(); i++) {
+      if (comparator_(run.back().first, entries[i].first) < 0) {
+        run.push_back(entries[i]);
+      } else {
+        deferred.push_back(entries[i]);
+      }
+    }
+    BulkLoadSorted(run.data(), static_cast<int>(run.size()), fill_factor);
+  } else if (!entries.empty()) {
+    BulkLoadSorted(entries.data(), static_cast<int>(entries.size()), fill_factor);
+  }
+  root_latch_.WUnlock();
+
+  bool loaded = true;
+  for (const auto &entry : deferred) {
+    loaded = Insert(entry.first, entry.second, transaction) && loaded;
+  }
+  return loaded;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::BulkLoadSorted(const MappingType *entries, int count, int fill_factor) {
+  BulkLoadLevels levels;
+  // a leaf that starts at entry i has the shortest separator from the entry before it as its low fence
+  std::vector<KeyType> bounds(count);
+  for (int i = 1; i < count; i++) {
+    BPlusTreePage::SeparatorBetween(reinterpret_cast<const char *>(&entries[i - 1].first),
+                                    reinterpret_cast<const char *>(&entries[i].first), sizeof(KeyType),
+                                    reinterpret_cast<char *>(&bounds[i]));
+  }
+  // a leaf holds at most leaf_max_size_ - 1 entries, an internal page at most internal_max_size_ children
+  auto entry_key = [entries](int i) -> const KeyType & { return entries[i].first; };
+  // a non-unique leaf stores a posting list of a single value, with its size
+  int value_size = unique_ ? sizeof(ValueType) : 1 + PostingList::MAX_SINGLE_SIZE;
+  levels.node_sizes_.push_back(BulkLoadNodeSizes(count, entry_key, bounds, true, value_size, fill_factor,
+                                                 leaf_max_size_ / 2, leaf_max_size_ - 1));
+  levels.node_lows_.push_back(BulkLoadNodeLows(bounds, levels.node_sizes_.back()));
+  while (levels.node_sizes_.back().size() > 1) {
+    // the children of a level are the nodes of the level below, keyed by their low fences
+    std::vector<KeyType> child_lows = levels.node_lows_.back();
+    auto child_key = [&child_lows](int i) -> const KeyType & { return child_lows[i]; };
+    std::vector<int> node_sizes =
+        BulkLoadNodeSizes(static_cast<int>(child_lows.size()), child_key, child_lows, false, sizeof(page_id_t),
+                          fill_factor, (internal_max_size_ + 1) / 2, internal_max_size_);
+    levels.node_lows_.push_back(BulkLoadNodeLows(child_lows, node_sizes));
+    levels.node_sizes_.push_back(std::move(node_sizes));
+  }
+  levels.open_pages_.resize(levels.node_sizes_.size(), nullptr);
+  levels.nodes_started_.resize(levels.node_sizes_.size(), 0);
+
+  Page *prev_leaf_page = nullptr;
+  page_id_t first_leaf_page_id = INVALID_PAGE_ID;
+  const MappingType *next_entry = entries;
+  const std::vector<KeyType> &leaf_lows = levels.node_lows_[0];
+  for (size_t i = 0; i < leaf_lows.size(); i++) {
+    page_id_t leaf_page_id;
+    Page *leaf_page = buffer_pool_manager_->NewPage(&leaf_page_id);
+    if (leaf_page == nullptr) {
+      throw Exception(ExceptionType::OUT_OF_MEMORY, "BPlusTree: cannot allocate leaf page for bulk load");
+    }
+    auto leaf = reinterpret_cast<LeafPage *>(leaf_page->GetData());
+    int leaf_size = levels.node_sizes_[0][i];
+    leaf->Init(leaf_page_id, BulkLoadAppend(1, leaf_lows[i], leaf_page_id, &levels), leaf_max_size_,
+               i == 0 ? nullptr : &leaf_lows[i], i + 1 < leaf_lows.size() ? &leaf_lows[i + 1] : nullptr, unique_);
+    leaf->CopyNFrom(next_entry, leaf_size);
+    next_entry += leaf_size;
+    if (prev_leaf_page != nullptr) {
+      leaf->SetPrevPageId(prev_leaf_page->GetPageId());
+      reinterpret_cast<LeafPage *>(prev_leaf_page->GetData())->SetNextPageId(leaf_page_id);
+      buffer_pool_manager_->UnpinPage(prev_leaf_page->GetPageId(), true);
+    } else {
+      first_leaf_page_id = leaf_page_id;
+    }
+    prev_leaf_page = leaf_page;
+  }
+  buffer_pool_manager_->UnpinPage(prev_leaf_page->GetPageId(), true);
+
+  root_page_id_ = first_leaf_page_id;
+  for (size_t level = 1; level < levels.open_pages_.size(); level++) {
+    root_page_id_ = levels.open_pages_[level]->GetPageId();
+    buffer_pool_manager_->UnpinPage(root_page_id_, true);
+  }
+  UpdateRootPageId(1);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+page_id_t BPLUSTREE_TYPE::BulkLoadAppend(size_t level, const KeyType &key, page_id_t child_page_id,
+                                         BulkLoadLevels *levels) {
+  if (level == levels->node_sizes_.size()) {
+    // the child is the root
+    return INVALID_PAGE_ID;
+  }
+  Page *&page = levels->open_pages_[level];
+  auto node = page == nullptr ? nullptr : reinterpret_cast<InternalPage *>(page->GetData());
+  size_t &started = levels->nodes_started_[level];
+  if (node == nullptr || node->GetSize() == levels->node_sizes_[level][started - 1]) {
+    page_id_t page_id;
+    Page *new_page = buffer_pool_manager_->NewPage(&page_id);
+    if (new_page == nullptr) {
+      throw Exception(ExceptionType::OUT_OF_MEMORY, "BPlusTree: cannot allocate internal page for bulk load");
+    }
+    if (page != nullptr) {
+      node->SetNextPageId(page_id);
+      buffer_pool_manager_->UnpinPage(page->GetPageId(), true);
+    }
+    page = new_page;
+    node = reinterpret_cast<InternalPage *>(page->GetData());
+    // the key of the first child of a page is its low fence, and the separator in its parent
+    const std::vector<KeyType> &lows = levels->node_lows_[level];
+    node->Init(page_id, BulkLoadAppend(level + 1, key, page_id, levels), internal_max_size_,
+               started == 0 ? nullptr : &lows[started], started + 1 < lows.size() ? &lows[started + 1] : nullptr);
+    started++;
+  }
+  node->Append(key, child_page_id);
+  return node->GetPageId();
 }
 
 /*****************************************************************************
@@ -53,11 +362,83 @@ bool BPLUSTREE_TYPE::GetValue(const KeyType &key, std::vector<ValueType> *result
  * Insert constant key & value pair into b+ tree
  * if current tree is empty, start new tree, update root page id and insert
  * entry, otherwise insert into leaf page.
- * @return: since we only support unique key, if user try to insert duplicate
- * keys return false, otherwise return true.
+ * @return: if user try to insert a duplicate key into a unique tree, or a
+ * duplicate pair into a non-unique one, return false, otherwise return true.
+ * A buffered tree looks the key up first, then adds the insert to the root buffer (see PutMessage()).
  */
 INDEX_TEMPLATE_ARGUMENTS
-bool BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value, Transaction *transaction) { return false; }
+bool BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value, Transaction *transaction) {
+  if (mode_ == BPlusTreeMode::B_LINK) {
+    return InsertBLink(key, value);
+  }
+  if (mode_ == BPlusTreeMode::BUFFERED) {
+    // reads the key down to its leaf to report a duplicate, but the write itself still reaches the leaf in a batch;
+    // Upsert() is the blind write
+    root_latch_.WLock();
+    ValueType existing;
+    bool inserted = !LookupBuffered(key, &existing) && PutMessage(Message{key, value, BufferedOp::INSERT});
+    root_latch_.WUnlock();
+    return inserted;
+  }
+  Page *leaf_page = FindLeafOptimistic(key);
+  if (leaf_page != nullptr) {
+    auto leaf = reinterpret_cast<LeafPage *>(leaf_page->GetData());
+    int index = leaf->Find(key, comparator_);
+    bool duplicate = index >= 0 && unique_;
+    // a value added to a posting list does not add an entry
+    bool safe = !duplicate && (index >= 0 || leaf->GetSize() + 1 < leaf->GetMaxSize()) && leaf->HasRoomFor(key);
+    bool inserted = safe && InsertIntoLeafPage(leaf, index, key, value);
+    leaf_page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(leaf_page->GetPageId(), inserted);
+    if (duplicate || safe) {
+      return inserted;
+    }
+  }
+
+  // the leaf may split, or the tree is empty: retry holding every latch the insert may need
+  WriteContext context;
+  bool inserted = true;
+  if (FindLeafPessimistic(key, Operation::INSERT, &context) == nullptr) {
+    StartNewTree(key, value);
+  } else {
+    inserted = InsertIntoLeaf(key, value, &context);
+  }
+  ReleaseWriteContext(&context);
+  return inserted;
+}
+/*
+ * The value of a key that is there already is replaced in its leaf, under the leaf latch alone
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::Upsert(const KeyType &key, const ValueType &value, Transaction *transaction) {
+  if (mode_ == BPlusTreeMode::BUFFERED) {
+    root_latch_.WLock();
+    PutMessage(Message{key, value, BufferedOp::UPSERT});
+    root_latch_.WUnlock();
+    return;
+  }
+  while (unique_) {
+    Page *leaf_page = FindLeafOptimistic(key);
+    if (leaf_page != nullptr) {
+      auto leaf = reinterpret_cast<LeafPage *>(leaf_page->GetData());
+      int index = leaf->Find(key, comparator_);
+      if (index >= 0) {
+        leaf->SetValueAt(index, value);
+      }
+      leaf_page->WUnlatch();
+      buffer_pool_manager_->UnpinPage(leaf_page->GetPageId(), index >= 0);
+      if (index >= 0) {
+        return;
+      }
+    }
+    // the key is missing: insert it, unless another writer got there first
+    if (Insert(key, value, transaction)) {
+      return;
+    }
+  }
+  Insert(key, value, transaction);
+}
+
 /*
  * Insert constant key & value pair into an empty tree
  * User needs to first ask for new page from buffer pool manager(NOTICE: throw
@@ -65,19 +446,197 @@ bool BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value, Transact
  * tree's root page id and insert entry directly into leaf page.
  */
 INDEX_TEMPLATE_ARGUMENTS
-void BPLUSTREE_TYPE::StartNewTree(const KeyType &key, const ValueType &value) {}
+void BPLUSTREE_TYPE::StartNewTree(const KeyType &key, const ValueType &value) {
+  page_id_t root_page_id;
+  Page *root_page = buffer_pool_manager_->NewPage(&root_page_id);
+  if (root_page == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "BPlusTree: cannot allocate root page");
+  }
+  auto root = reinterpret_cast<LeafPage *>(root_page->GetData());
+  root->Init(root_page_id, INVALID_PAGE_ID, leaf_max_size_, nullptr, nullptr, unique_);
+  root->Insert(key, value, comparator_);
+  root_page_id_ = root_page_id;
+  UpdateRootPageId(1);
+  buffer_pool_manager_->UnpinPage(root_page_id, true);
+}
 
 /*
  * Insert constant key & value pair into leaf page
  * User needs to first find the right leaf page as insertion target, then look
  * through leaf page to see whether insert key exist or not. If exist, return
  * immdiately, otherwise insert entry. Remember to deal with split if necessary.
- * @return: since we only support unique key, if user try to insert duplicate
- * keys return false, otherwise return true.
+ * @return: if user try to insert a duplicate key into a unique tree, or a
+ * duplicate pair into a non-unique one, return false, otherwise return true.
  */
 INDEX_TEMPLATE_ARGUMENTS
-bool BPLUSTREE_TYPE::InsertIntoLeaf(const KeyType &key, const ValueType &value, Transaction *transaction) {
-  return false;
+bool BPLUSTREE_TYPE::InsertIntoLeaf(const KeyType &key, const ValueType &value, WriteContext *context) {
+  auto leaf = reinterpret_cast<LeafPage *>(context->path_.back()->GetData());
+  int index = leaf->Find(key, comparator_);
+  if (index >= 0 && unique_) {
+    return false;
+  }
+  if (!leaf->HasRoomFor(key)) {
+    // the leaf is full in bytes: split it first, then insert into the half that covers the key
+    LeafPage *new_leaf = Split(leaf);
+    LeafPage *target = comparator_(key, *new_leaf->GetLowFence()) < 0 ? leaf : new_leaf;
+    bool inserted = InsertIntoLeafPage(target, target->Find(key, comparator_), key, value);
+    InsertIntoParent(leaf, *new_leaf->GetLowFence(), new_leaf);
+    buffer_pool_manager_->UnpinPage(new_leaf->GetPageId(), true);
+    return inserted;
+  }
+  bool inserted = InsertIntoLeafPage(leaf, index, key, value);
+  if (leaf->GetSize() >= leaf->GetMaxSize()) {
+    LeafPage *new_leaf = Split(leaf);
+    InsertIntoParent(leaf, *new_leaf->GetLowFence(), new_leaf);
+    buffer_pool_manager_->UnpinPage(new_leaf->GetPageId(), true);
+  }
+  return inserted;
+}
+
+/*
+ * Insert in B-link mode: the leaf is found like in the optimistic descent, remembering the internal pages on the way.
+ * A leaf that splits is released before its separator goes into the parent; until then, the new leaf is reachable
+ * through the right link of the old one.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::InsertBLink(const KeyType &key, const ValueType &value) {
+  std::vector<page_id_t> path;
+  Page *leaf_page = FindLeafOptimistic(key, &path);
+  if (leaf_page == nullptr) {
+    root_latch_.WLock();
+    // the tree never shrinks in B-link mode, so only a first insert finds it empty
+    bool empty = root_page_id_ == INVALID_PAGE_ID;
+    if (empty) {
+      StartNewTree(key, value);
+    }
+    root_latch_.WUnlock();
+    return empty || InsertBLink(key, value);
+  }
+  auto leaf = reinterpret_cast<LeafPage *>(leaf_page->GetData());
+  int index = leaf->Find(key, comparator_);
+  if (index >= 0 && unique_) {
+    leaf_page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(leaf_page->GetPageId(), false);
+    return false;
+  }
+  LeafPage *new_leaf = nullptr;
+  bool inserted;
+  if (!leaf->HasRoomFor(key)) {
+    new_leaf = Split(leaf);
+    LeafPage *target = comparator_(key, *new_leaf->GetLowFence()) < 0 ? leaf : new_leaf;
+    inserted = InsertIntoLeafPage(target, target->Find(key, comparator_), key, value);
+  } else {
+    inserted = InsertIntoLeafPage(leaf, index, key, value);
+    if (leaf->GetSize() >= leaf->GetMaxSize()) {
+      new_leaf = Split(leaf);
+    }
+  }
+  if (new_leaf == nullptr) {
+    leaf_page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(leaf_page->GetPageId(), inserted);
+    return inserted;
+  }
+  KeyType separator = *new_leaf->GetLowFence();
+  page_id_t new_leaf_page_id = new_leaf->GetPageId();
+  leaf_page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(leaf_page->GetPageId(), true);
+  buffer_pool_manager_->UnpinPage(new_leaf_page_id, true);
+  InsertIntoParentBLink(&path, leaf_page->GetPageId(), separator, new_leaf_page_id);
+  return inserted;
+}
+
+/*
+ * The parent is the page one level up the path, or a page to its right if it split in the meantime. If the path
+ * runs out, the page that split was the root when the path was taken: it either still is and gets a new root above
+ * it, or the tree has grown since, and a new path is taken down from the new root.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::InsertIntoParentBLink(std::vector<page_id_t> *path, page_id_t left_page_id, const KeyType &key,
+                                           page_id_t right_page_id) {
+  KeyType separator = key;
+  size_t level = 0;
+  while (true) {
+    if (path->empty()) {
+      root_latch_.WLock();
+      if (root_page_id_ == left_page_id) {
+        page_id_t root_page_id;
+        Page *root_page = buffer_pool_manager_->NewPage(&root_page_id);
+        if (root_page == nullptr) {
+          root_latch_.WUnlock();
+          throw Exception(ExceptionType::OUT_OF_MEMORY, "BPlusTree: cannot allocate new root page");
+        }
+        auto root = reinterpret_cast<InternalPage *>(root_page->GetData());
+        root->Init(root_page_id, INVALID_PAGE_ID, internal_max_size_);
+        root->PopulateNewRoot(left_page_id, separator, right_page_id);
+        root_page_id_ = root_page_id;
+        UpdateRootPageId();
+        buffer_pool_manager_->UnpinPage(root_page_id, true);
+        root_latch_.WUnlock();
+        return;
+      }
+      root_latch_.WUnlock();
+      // levels are counted from the leaves, which stay where they are as the tree grows
+      Page *leaf_page = DescendToLeaf(&separator, false, path);
+      leaf_page->RUnlatch();
+      buffer_pool_manager_->UnpinPage(leaf_page->GetPageId(), false);
+      if (path->size() <= level) {
+        // the left page was reached by moving right from the root, which split but has no new root above it yet
+        path->clear();
+        std::this_thread::yield();
+        continue;
+      }
+      path->resize(path->size() - level);
+    }
+    Page *parent_page = FetchNode(path->back());
+    path->pop_back();
+    parent_page->WLatch();
+    parent_page = MoveRight(parent_page, &separator, false, true);
+    auto parent = reinterpret_cast<InternalPage *>(parent_page->GetData());
+    InternalPage *new_parent = nullptr;
+    if (!parent->HasRoomFor(separator)) {
+      new_parent = Split(parent);
+      InternalPage *target = comparator_(separator, new_parent->KeyAt(0)) < 0 ? parent : new_parent;
+      target->InsertNode(separator, right_page_id, comparator_);
+    } else {
+      parent->InsertNode(separator, right_page_id, comparator_);
+      if (parent->GetSize() > parent->GetMaxSize()) {
+        new_parent = Split(parent);
+      }
+    }
+    if (new_parent == nullptr) {
+      parent_page->WUnlatch();
+      buffer_pool_manager_->UnpinPage(parent_page->GetPageId(), true);
+      return;
+    }
+    separator = new_parent->KeyAt(0);
+    left_page_id = parent_page->GetPageId();
+    right_page_id = new_parent->GetPageId();
+    parent_page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(left_page_id, true);
+    buffer_pool_manager_->UnpinPage(right_page_id, true);
+    level++;
+  }
+}
+
+/*
+ * A new key gets an entry of its own. In a non-unique tree, the value of a key that is there already goes into its
+ * posting list, which grows by less than the room for a new key.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::InsertIntoLeafPage(LeafPage *leaf, int index, const KeyType &key, const ValueType &value) {
+  if (index < 0) {
+    leaf->Insert(key, value, comparator_);
+    return true;
+  }
+  if (unique_) {
+    return false;
+  }
+  std::string posting = leaf->PostingAt(index);
+  if (!PostingList::Insert(buffer_pool_manager_, &posting, value)) {
+    return false;
+  }
+  leaf->SetPostingAt(index, posting);
+  return true;
 }
 
 /*
@@ -86,11 +645,49 @@ bool BPLUSTREE_TYPE::InsertIntoLeaf(const KeyType &key, const ValueType &value,
  * User needs to first ask for new page from buffer pool manager(NOTICE: throw
  * an "out of memory" exception if returned value is nullptr), then move half
  * of key & value pairs from input page to newly created page
+ * The new page is returned pinned but not latched: it is only reachable through the input page and its parent, which
+ * the caller holds write latches on.
  */
 INDEX_TEMPLATE_ARGUMENTS
 template <typename N>
 N *BPLUSTREE_TYPE::Split(N *node) {
-  return nullptr;
+  page_id_t new_page_id;
+  Page *new_page = buffer_pool_manager_->NewPage(&new_page_id);
+  if (new_page == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "BPlusTree: cannot allocate page for split");
+  }
+  auto new_node = reinterpret_cast<N *>(new_page->GetData());
+  if constexpr (std::is_same_v<N, LeafPage>) {
+    new_node->Init(new_page_id, node->GetParentPageId(), leaf_max_size_, nullptr, nullptr, unique_);
+    node->MoveHalfTo(new_node);
+    new_node->SetNextPageId(node->GetNextPageId());
+    new_node->SetPrevPageId(node->GetPageId());
+    node->SetNextPageId(new_page_id);
+    if (new_node->GetNextPageId() != INVALID_PAGE_ID) {
+      LinkPrevPage(new_node->GetNextPageId(), new_page_id);
+    }
+  } else {
+    new_node->Init(new_page_id, node->GetParentPageId(), internal_max_size_);
+    // children of pages in B-link mode are not adopted, since their parent page ids are not kept
+    node->MoveHalfTo(new_node, mode_ == BPlusTreeMode::B_LINK ? nullptr : buffer_pool_manager_);
+    new_node->SetNextPageId(node->GetNextPageId());
+    node->SetNextPageId(new_page_id);
+    // buffered messages go with the children they are for
+    BufferPage *buffer = mode_ == BPlusTreeMode::BUFFERED ? FetchBuffer(node, false) : nullptr;
+    if (buffer != nullptr) {
+      std::vector<Message> messages;
+      buffer->Take(buffer->LowerBound(*new_node->GetLowFence(), comparator_), buffer->GetCount(), &messages);
+      buffer_pool_manager_->UnpinPage(buffer->GetPageId(), true);
+      if (!messages.empty()) {
+        BufferPage *new_buffer = FetchBuffer(new_node, true);
+        for (const auto &message : messages) {
+          new_buffer->Put(message, comparator_);
+        }
+        buffer_pool_manager_->UnpinPage(new_buffer->GetPageId(), true);
+      }
+    }
+  }
+  return new_node;
 }
 
 /*
@@ -103,8 +700,48 @@ N *BPLUSTREE_TYPE::Split(N *node) {
  * recursively if necessary.
  */
 INDEX_TEMPLATE_ARGUMENTS
-void BPLUSTREE_TYPE::InsertIntoParent(BPlusTreePage *old_node, const KeyType &key, BPlusTreePage *new_node,
-                                      Transaction *transaction) {}
+void BPLUSTREE_TYPE::InsertIntoParent(BPlusTreePage *old_node, const KeyType &key, BPlusTreePage *new_node) {
+  if (old_node->IsRootPage()) {
+    // the root latch is still held, since a root that may split is never safe
+    page_id_t root_page_id;
+    Page *root_page = buffer_pool_manager_->NewPage(&root_page_id);
+    if (root_page == nullptr) {
+      throw Exception(ExceptionType::OUT_OF_MEMORY, "BPlusTree: cannot allocate new root page");
+    }
+    auto root = reinterpret_cast<InternalPage *>(root_page->GetData());
+    root->Init(root_page_id, INVALID_PAGE_ID, internal_max_size_);
+    root->PopulateNewRoot(old_node->GetPageId(), key, new_node->GetPageId());
+    old_node->SetParentPageId(root_page_id);
+    new_node->SetParentPageId(root_page_id);
+    root_page_id_ = root_page_id;
+    UpdateRootPageId();
+    buffer_pool_manager_->UnpinPage(root_page_id, true);
+    return;
+  }
+
+  // the parent is write-latched further up the path
+  Page *parent_page = FetchNode(old_node->GetParentPageId());
+  auto parent = reinterpret_cast<InternalPage *>(parent_page->GetData());
+  if (!parent->HasRoomFor(key)) {
+    // the parent is full in bytes: split it first, then insert into the half that took over old_node
+    InternalPage *new_parent = Split(parent);
+    InsertIntoParent(parent, new_parent->KeyAt(0), new_parent);
+    InternalPage *target = old_node->GetParentPageId() == parent->GetPageId() ? parent : new_parent;
+    target->InsertNodeAfter(old_node->GetPageId(), key, new_node->GetPageId());
+    new_node->SetParentPageId(target->GetPageId());
+    buffer_pool_manager_->UnpinPage(new_parent->GetPageId(), true);
+    buffer_pool_manager_->UnpinPage(parent->GetPageId(), true);
+    return;
+  }
+  parent->InsertNodeAfter(old_node->GetPageId(), key, new_node->GetPageId());
+  new_node->SetParentPageId(parent->GetPageId());
+  if (parent->GetSize() > parent->GetMaxSize()) {
+    InternalPage *new_parent = Split(parent);
+    InsertIntoParent(parent, new_parent->KeyAt(0), new_parent);
+    buffer_pool_manager_->UnpinPage(new_parent->GetPageId(), true);
+  }
+  buffer_pool_manager_->UnpinPage(parent->GetPageId(), true);
+}
 
 /*****************************************************************************
  * REMOVE
@@ -117,19 +754,163 @@ void BPLUSTREE_TYPE::InsertIntoParent(BPlusTreePage *old_node, const KeyType &ke
  * necessary.
  */
 INDEX_TEMPLATE_ARGUMENTS
-void BPLUSTREE_TYPE::Remove(const KeyType &key, Transaction *transaction) {}
+void BPLUSTREE_TYPE::Remove(const KeyType &key, Transaction *transaction) { RemoveValues(key, nullptr, transaction); }
 
 /*
- * User needs to first find the sibling of input page. If sibling's size + input
- * page's size > page's max size, then redistribute. Otherwise, merge.
+ * Delete the key & value pair; a unique tree leaves the key alone if it has another value
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::Remove(const KeyType &key, const ValueType &value, Transaction *transaction) {
+  RemoveValues(key, &value, transaction);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::RemoveValues(const KeyType &key, const ValueType *value, Transaction *transaction) {
+  if (mode_ == BPlusTreeMode::BUFFERED) {
+    root_latch_.WLock();
+    ValueType existing;
+    if (value == nullptr || (LookupBuffered(key, &existing) && existing == *value)) {
+      PutMessage(Message{key, ValueType(), BufferedOp::DELETE});
+    }
+    root_latch_.WUnlock();
+    return;
+  }
+  Page *leaf_page = FindLeafOptimistic(key);
+  if (leaf_page == nullptr) {
+    return;
+  }
+  auto leaf = reinterpret_cast<LeafPage *>(leaf_page->GetData());
+  int index = leaf->Find(key, comparator_);
+  bool found = index >= 0;
+  // the parent page id is not stable without the parent's latch, so a root leaf is not told apart here; it is only
+  // handled optimistically while it stays half full. Leaves in B-link mode never merge, so any remove is safe.
+  bool safe = found && (mode_ == BPlusTreeMode::B_LINK || !RemovesEntry(leaf, index, value) ||
+                        leaf->IsHalfFullAfterRemove());
+  bool removed = safe && RemoveFromLeafPage(leaf, key, value);
+  leaf_page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(leaf_page->GetPageId(), removed);
+  if (!found || safe) {
+    return;
+  }
+
+  // the leaf may underflow: retry holding every latch the merge may need
+  WriteContext context;
+  leaf_page = FindLeafPessimistic(key, Operation::REMOVE, &context);
+  if (leaf_page != nullptr) {
+    leaf = reinterpret_cast<LeafPage *>(leaf_page->GetData());
+    if (RemoveFromLeafPage(leaf, key, value)) {
+      CoalesceOrRedistribute(leaf, &context);
+    }
+  }
+  ReleaseWriteContext(&context);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::RemovesEntry(const LeafPage *leaf, int index, const ValueType *value) const {
+  return unique_ || value == nullptr || PostingList::Count(leaf->PostingAt(index)) == 1;
+}
+
+/*
+ * A posting list that shrinks may move back into the leaf, as long as it fits into the free space of the leaf.
+ * Overflow pages are deleted right away: only a thread that holds the latch of the leaf can reach them.
+ * @return : whether anything was removed
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::RemoveFromLeafPage(LeafPage *leaf, const KeyType &key, const ValueType *value) {
+  int index = leaf->Find(key, comparator_);
+  if (index < 0) {
+    return false;
+  }
+  if (unique_) {
+    if (value != nullptr && !(leaf->ValueAt(index) == *value)) {
+      return false;
+    }
+    leaf->RemoveAndDeleteRecord(key, comparator_);
+    return true;
+  }
+  std::string posting = leaf->PostingAt(index);
+  if (value == nullptr) {
+    PostingList::Free(buffer_pool_manager_, posting);
+    leaf->RemoveAndDeleteRecord(key, comparator_);
+    return true;
+  }
+  int max_size = leaf->GetFreeSpace() + static_cast<int>(posting.size());
+  if (!PostingList::Remove(buffer_pool_manager_, &posting, *value, max_size)) {
+    return false;
+  }
+  if (posting.empty()) {
+    leaf->RemoveAndDeleteRecord(key, comparator_);
+  } else {
+    leaf->SetPostingAt(index, posting);
+  }
+  return true;
+}
+
+/*
+ * User needs to first find the sibling of input page. If the pages fit into one, merge. Otherwise, redistribute.
  * Using template N to represent either internal page or leaf page.
+ * With keys of varying length, neither may be possible: a merge may not fit, and the parent may have no room for a
+ * longer separator. The page then stays less than half full until a later remove or insert gets to it.
+ * Pages that become empty are added to the deleted pages of the context and freed once all latches are released.
  * @return: true means target leaf page should be deleted, false means no
  * deletion happens
  */
 INDEX_TEMPLATE_ARGUMENTS
 template <typename N>
-bool BPLUSTREE_TYPE::CoalesceOrRedistribute(N *node, Transaction *transaction) {
-  return false;
+bool BPLUSTREE_TYPE::CoalesceOrRedistribute(N *node, WriteContext *context) {
+  if (node->IsRootPage()) {
+    if (AdjustRoot(node)) {
+      context->deleted_pages_.push_back(node->GetPageId());
+      return true;
+    }
+    return false;
+  }
+  if (node->IsHalfFull()) {
+    return false;
+  }
+
+  // the parent is write-latched further up the path
+  Page *parent_page = FetchNode(node->GetParentPageId());
+  auto parent = reinterpret_cast<InternalPage *>(parent_page->GetData());
+  if (parent->GetSize() < 2) {
+    // a parent left with a single child by an earlier remove: there is no sibling to turn to
+    buffer_pool_manager_->UnpinPage(parent_page->GetPageId(), false);
+    return false;
+  }
+  int index = parent->ValueIndex(node->GetPageId());
+  Page *sibling_page = FetchNode(parent->ValueAt(index == 0 ? 1 : index - 1));
+  if (index > 0 && node->IsLeafPage()) {
+    // iterators latch leaves left to right, so the left sibling must be latched before the leaf. With the parent
+    // write-latched, only iterators and writers updating its prev link can reach the leaf while it is briefly
+    // unlatched, and they do not modify its entries.
+    Page *node_page = context->path_.back();
+    node_page->WUnlatch();
+    sibling_page->WLatch();
+    node_page->WLatch();
+  } else {
+    sibling_page->WLatch();
+  }
+  auto sibling = reinterpret_cast<N *>(sibling_page->GetData());
+
+  // the right page of the two is merged into the left one
+  bool can_merge;
+  if constexpr (std::is_same_v<N, LeafPage>) {
+    can_merge = index == 0 ? sibling->CanMoveAllTo(node) : node->CanMoveAllTo(sibling);
+  } else {
+    can_merge = index == 0 ? sibling->CanMoveAllTo(node, parent->KeyAt(1))
+                           : node->CanMoveAllTo(sibling, parent->KeyAt(index));
+  }
+  bool node_deleted = false;
+  if (can_merge) {
+    node_deleted = index != 0;
+    Coalesce(&sibling, &node, &parent, index, context);
+  } else if (parent->HasRoomForAnyEntry()) {
+    Redistribute(sibling, node, index);
+  }
+  sibling_page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(sibling_page->GetPageId(), true);
+  buffer_pool_manager_->UnpinPage(parent_page->GetPageId(), true);
+  return node_deleted;
 }
 
 /*
@@ -141,6 +922,7 @@ bool BPLUSTREE_TYPE::CoalesceOrRedistribute(N *node, Transaction *transaction) {
  * @param   neighbor_node      sibling page of input "node"
  * @param   node               input from method coalesceOrRedistribute()
  * @param   parent             parent page of input "node"
+ * @param   index              index of "node" in "parent"; the neighbor is its right sibling if 0, else its left one
  * @return  true means parent node should be deleted, false means no deletion
  * happend
  */
@@ -148,22 +930,65 @@ INDEX_TEMPLATE_ARGUMENTS
 template <typename N>
 bool BPLUSTREE_TYPE::Coalesce(N **neighbor_node, N **node,
                               BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator> **parent, int index,
-                              Transaction *transaction) {
-  return false;
+                              WriteContext *context) {
+  // always merge right into left, so that the leaf chain stays intact
+  N *left = *neighbor_node;
+  N *right = *node;
+  int right_index = index;
+  if (index == 0) {
+    std::swap(left, right);
+    right_index = 1;
+  }
+  if constexpr (std::is_same_v<N, LeafPage>) {
+    right->MoveAllTo(left);
+    if (left->GetNextPageId() != INVALID_PAGE_ID) {
+      LinkPrevPage(left->GetNextPageId(), left->GetPageId());
+    }
+  } else {
+    right->MoveAllTo(left, (*parent)->KeyAt(right_index), buffer_pool_manager_);
+  }
+  (*parent)->Remove(right_index);
+  context->deleted_pages_.push_back(right->GetPageId());
+  return CoalesceOrRedistribute(*parent, context);
 }
 
 /*
  * Redistribute key & value pairs from one page to its sibling page. If index ==
  * 0, move sibling page's first key & value pair into end of input "node",
  * otherwise move sibling page's last key & value pair into head of input
- * "node".
+ * "node". Nothing moves if the pair does not fit into "node".
  * Using template N to represent either internal page or leaf page.
+ * The new separator is the low fence of the right page, which the parent must have room for.
  * @param   neighbor_node      sibling page of input "node"
  * @param   node               input from method coalesceOrRedistribute()
  */
 INDEX_TEMPLATE_ARGUMENTS
 template <typename N>
-void BPLUSTREE_TYPE::Redistribute(N *neighbor_node, N *node, int index) {}
+void BPLUSTREE_TYPE::Redistribute(N *neighbor_node, N *node, int index) {
+  Page *parent_page = FetchNode(node->GetParentPageId());
+  auto parent = reinterpret_cast<InternalPage *>(parent_page->GetData());
+  bool moved;
+  if (index == 0) {
+    if constexpr (std::is_same_v<N, LeafPage>) {
+      moved = neighbor_node->MoveFirstToEndOf(node);
+    } else {
+      moved = neighbor_node->MoveFirstToEndOf(node, parent->KeyAt(1), buffer_pool_manager_);
+    }
+    if (moved) {
+      parent->SetKeyAt(1, *neighbor_node->GetLowFence());
+    }
+  } else {
+    if constexpr (std::is_same_v<N, LeafPage>) {
+      moved = neighbor_node->MoveLastToFrontOf(node);
+    } else {
+      moved = neighbor_node->MoveLastToFrontOf(node, parent->KeyAt(index), buffer_pool_manager_);
+    }
+    if (moved) {
+      parent->SetKeyAt(index, *node->GetLowFence());
+    }
+  }
+  buffer_pool_manager_->UnpinPage(parent_page->GetPageId(), moved);
+}
 /*
  * Update root page if necessary
  * NOTE: size of root page can be less than min size and this method is only
@@ -175,7 +1000,316 @@ void BPLUSTREE_TYPE::Redistribute(N *neighbor_node, N *node, int index) {}
  * happend
  */
 INDEX_TEMPLATE_ARGUMENTS
-bool BPLUSTREE_TYPE::AdjustRoot(BPlusTreePage *old_root_node) { return false; }
+bool BPLUSTREE_TYPE::AdjustRoot(BPlusTreePage *old_root_node) {
+  // the root latch is still held, since a root that may shrink is never safe
+  if (old_root_node->IsLeafPage()) {
+    if (old_root_node->GetSize() > 0) {
+      return false;
+    }
+    root_page_id_ = INVALID_PAGE_ID;
+    UpdateRootPageId();
+    return true;
+  }
+  if (old_root_node->GetSize() > 1) {
+    return false;
+  }
+  auto old_root = reinterpret_cast<InternalPage *>(old_root_node);
+  root_page_id_ = old_root->RemoveAndReturnOnlyChild();
+  UpdateRootPageId();
+  // the new root is a child of a write-latched page, so no other writer reads its parent id
+  Page *root_page = FetchNode(root_page_id_);
+  reinterpret_cast<BPlusTreePage *>(root_page->GetData())->SetParentPageId(INVALID_PAGE_ID);
+  buffer_pool_manager_->UnpinPage(root_page_id_, true);
+  return true;
+}
+
+/*****************************************************************************
+ * BUFFERED MODE
+ *****************************************************************************/
+/*
+ * The writer holds the root latch in write mode, and readers hold it until they reach a leaf, so the pages are read
+ * without latches: nothing changes while either holds it. An insert message only sets the value if the key has none
+ * below it, so the lookup goes on past it, and falls back to the oldest insert it passed.
+ * @return : whether key has a value, which is the value of its newest upsert or else of its leaf entry, unless a
+ * delete comes first, or else the value of its oldest insert
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::LookupBuffered(const KeyType &key, ValueType *value) {
+  if (root_page_id_ == INVALID_PAGE_ID) {
+    return false;
+  }
+  bool inserted = false;
+  Page *page = FetchNode(root_page_id_);
+  auto node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+  while (!node->IsLeafPage()) {
+    auto internal = reinterpret_cast<InternalPage *>(node);
+    BufferPage *buffer = FetchBuffer(internal, false);
+    const Message *message = buffer == nullptr ? nullptr : buffer->Find(key, comparator_);
+    if (message != nullptr && message->op_ != BufferedOp::INSERT) {
+      bool found = message->op_ == BufferedOp::UPSERT || inserted;
+      if (message->op_ == BufferedOp::UPSERT) {
+        *value = message->value_;
+      }
+      buffer_pool_manager_->UnpinPage(buffer->GetPageId(), false);
+      buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+      return found;
+    }
+    if (message != nullptr) {
+      inserted = true;
+      *value = message->value_;
+    }
+    if (buffer != nullptr) {
+      buffer_pool_manager_->UnpinPage(buffer->GetPageId(), false);
+    }
+    Page *child_page = FetchNode(internal->Lookup(key, comparator_));
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+    page = child_page;
+    node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+  }
+  bool found = reinterpret_cast<LeafPage *>(node)->Lookup(key, value, comparator_) || inserted;
+  buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+  return found;
+}
+
+/*
+ * A tree of a single leaf has no buffer, so its messages are applied right away
+ * @return : false if the message is an insert of a key that the root buffer or root leaf shows a value of, which is
+ * dropped; an insert of a key with a value further down is dropped only when it gets there
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::PutMessage(const Message &message) {
+  if (root_page_id_ == INVALID_PAGE_ID) {
+    if (message.op_ != BufferedOp::DELETE) {
+      StartNewTree(message.key_, message.value_);
+    }
+    return true;
+  }
+  while (true) {
+    Page *root_page = FetchNode(root_page_id_);
+    auto root = reinterpret_cast<BPlusTreePage *>(root_page->GetData());
+    if (root->IsLeafPage()) {
+      buffer_pool_manager_->UnpinPage(root_page->GetPageId(), false);
+      return ApplyToLeaf(message);
+    }
+    BufferPage *buffer = FetchBuffer(reinterpret_cast<InternalPage *>(root), true);
+    bool room = buffer->HasRoomFor(message.key_, comparator_);
+    bool put = room && buffer->Put(message, comparator_);
+    buffer_pool_manager_->UnpinPage(buffer->GetPageId(), put);
+    buffer_pool_manager_->UnpinPage(root_page->GetPageId(), true);
+    if (room) {
+      return put;
+    }
+    FlushStep();
+  }
+}
+
+/*
+ * Applies a message that has left the buffers: there is no message of its key between the leaf and the page it came
+ * from, and any message above that page is newer and stays where it is. Only the leaf is latched, for the sake of
+ * iterators, which read leaves without the root latch.
+ * @return : false if the message is an insert of a key that the leaf has, which is dropped
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::ApplyToLeaf(const Message &message) {
+  Page *page = FetchNode(root_page_id_);
+  auto node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+  while (!node->IsLeafPage()) {
+    Page *child_page = FetchNode(reinterpret_cast<InternalPage *>(node)->Lookup(message.key_, comparator_));
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+    page = child_page;
+    node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+  }
+  page->WLatch();
+  auto leaf = reinterpret_cast<LeafPage *>(node);
+  int index = leaf->Find(message.key_, comparator_);
+  bool dirty = true;
+  if (message.op_ == BufferedOp::DELETE) {
+    // pages never merge in buffered mode, so the leaf may empty out
+    dirty = index >= 0;
+    if (dirty) {
+      leaf->RemoveAndDeleteRecord(message.key_, comparator_);
+    }
+  } else if (index >= 0) {
+    // an insert of a key that has a value is a duplicate
+    dirty = message.op_ == BufferedOp::UPSERT;
+    if (dirty) {
+      leaf->SetValueAt(index, message.value_);
+    }
+  } else {
+    LeafPage *new_leaf = nullptr;
+    if (!leaf->HasRoomFor(message.key_)) {
+      new_leaf = Split(leaf);
+      LeafPage *target = comparator_(message.key_, *new_leaf->GetLowFence()) < 0 ? leaf : new_leaf;
+      target->Insert(message.key_, message.value_, comparator_);
+    } else if (leaf->Insert(message.key_, message.value_, comparator_) >= leaf->GetMaxSize()) {
+      new_leaf = Split(leaf);
+    }
+    if (new_leaf != nullptr) {
+      InsertIntoParent(leaf, *new_leaf->GetLowFence(), new_leaf);
+      buffer_pool_manager_->UnpinPage(new_leaf->GetPageId(), true);
+    }
+  }
+  page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(page->GetPageId(), dirty);
+  return dirty || message.op_ == BufferedOp::DELETE;
+}
+
+/*
+ * Makes room in a full root buffer one step at a time. If the fullest child of the root has a full buffer as well,
+ * the step is taken below it, following the fullest children down to the first buffer that is not full or whose
+ * fullest child is a leaf. Each step moves messages down a level, so repeated steps from the root make room in it.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::FlushStep() {
+  Page *page = FetchNode(root_page_id_);
+  while (true) {
+    auto node = reinterpret_cast<InternalPage *>(page->GetData());
+    BufferPage *buffer = FetchBuffer(node, false);
+    int begin;
+    int end;
+    Page *child_page = FetchNode(node->ValueAt(FullestChild(node, buffer, &begin, &end)));
+    auto child = reinterpret_cast<BPlusTreePage *>(child_page->GetData());
+    if (child->IsLeafPage()) {
+      std::vector<Message> messages;
+      buffer->Take(begin, end, &messages);
+      buffer_pool_manager_->UnpinPage(buffer->GetPageId(), true);
+      buffer_pool_manager_->UnpinPage(child_page->GetPageId(), false);
+      buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+      for (const auto &message : messages) {
+        ApplyToLeaf(message);
+      }
+      return;
+    }
+    BufferPage *child_buffer = FetchBuffer(reinterpret_cast<InternalPage *>(child), true);
+    if (child_buffer->IsFull()) {
+      buffer_pool_manager_->UnpinPage(child_buffer->GetPageId(), false);
+      buffer_pool_manager_->UnpinPage(buffer->GetPageId(), false);
+      buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+      page = child_page;
+      continue;
+    }
+    // the messages from above are newer, so they replace the child's messages of the same keys
+    int moved = begin;
+    while (moved < end && child_buffer->HasRoomFor(buffer->MessageAt(moved).key_, comparator_)) {
+      child_buffer->Put(buffer->MessageAt(moved), comparator_);
+      moved++;
+    }
+    std::vector<Message> messages;
+    buffer->Take(begin, moved, &messages);
+    buffer_pool_manager_->UnpinPage(child_buffer->GetPageId(), true);
+    buffer_pool_manager_->UnpinPage(child_page->GetPageId(), true);
+    buffer_pool_manager_->UnpinPage(buffer->GetPageId(), true);
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+    return;
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::FlushBuffers() {
+  if (mode_ != BPlusTreeMode::BUFFERED) {
+    return;
+  }
+  root_latch_.WLock();
+  // a root that splits leaves its right half to the new root
+  page_id_t root_page_id;
+  do {
+    root_page_id = root_page_id_;
+    if (root_page_id != INVALID_PAGE_ID) {
+      FlushSubtree(root_page_id);
+    }
+  } while (root_page_id != root_page_id_);
+  root_latch_.WUnlock();
+}
+
+/*
+ * Children are flushed from left to right, each before the messages for it are applied, since those are newer. The
+ * leaves below may split as the messages are applied, and with them the child, the page itself and the pages above,
+ * so the children are found by key: the next child is the one that covers the high fence of the last one. A page
+ * that split is done once the next child is in its right half, which its parent flushes next.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::FlushSubtree(page_id_t page_id) {
+  Page *page = FetchNode(page_id);
+  auto node = reinterpret_cast<InternalPage *>(page->GetData());
+  if (node->IsLeafPage()) {
+    buffer_pool_manager_->UnpinPage(page_id, false);
+    return;
+  }
+  bool has_cursor = false;
+  KeyType cursor;
+  while (!has_cursor || node->GetHighFence() == nullptr || comparator_(cursor, *node->GetHighFence()) < 0) {
+    page_id_t child_page_id = has_cursor ? node->Lookup(cursor, comparator_) : node->ValueAt(0);
+    FlushSubtree(child_page_id);
+    Page *child_page = FetchNode(child_page_id);
+    auto child = reinterpret_cast<BPlusTreePage *>(child_page->GetData());
+    const KeyType *child_high = child->IsLeafPage() ? reinterpret_cast<LeafPage *>(child)->GetHighFence()
+                                                    : reinterpret_cast<InternalPage *>(child)->GetHighFence();
+    bool has_high = child_high != nullptr;
+    KeyType high;
+    if (has_high) {
+      high = *child_high;
+    }
+    buffer_pool_manager_->UnpinPage(child_page_id, false);
+    BufferPage *buffer = FetchBuffer(node, false);
+    if (buffer != nullptr) {
+      int begin = has_cursor ? buffer->LowerBound(cursor, comparator_) : 0;
+      int end = has_high ? buffer->LowerBound(high, comparator_) : buffer->GetCount();
+      std::vector<Message> messages;
+      buffer->Take(begin, end, &messages);
+      buffer_pool_manager_->UnpinPage(buffer->GetPageId(), !messages.empty());
+      for (const auto &message : messages) {
+        ApplyToLeaf(message);
+      }
+    }
+    if (!has_high) {
+      break;
+    }
+    cursor = high;
+    has_cursor = true;
+  }
+  buffer_pool_manager_->UnpinPage(page_id, false);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+typename BPLUSTREE_TYPE::BufferPage *BPLUSTREE_TYPE::FetchBuffer(InternalPage *node, bool create) {
+  if (node->GetBufferPageId() != INVALID_PAGE_ID) {
+    return reinterpret_cast<BufferPage *>(FetchNode(node->GetBufferPageId())->GetData());
+  }
+  if (!create) {
+    return nullptr;
+  }
+  page_id_t buffer_page_id;
+  Page *buffer_page = buffer_pool_manager_->NewPage(&buffer_page_id);
+  if (buffer_page == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "BPlusTree: cannot allocate buffer page");
+  }
+  auto buffer = reinterpret_cast<BufferPage *>(buffer_page->GetData());
+  buffer->Init(buffer_page_id);
+  node->SetBufferPageId(buffer_page_id);
+  return buffer;
+}
+
+/*
+ * Child i covers the keys in [KeyAt(i), KeyAt(i + 1)), so its messages run up to the first one at or after
+ * KeyAt(i + 1)
+ */
+INDEX_TEMPLATE_ARGUMENTS
+int BPLUSTREE_TYPE::FullestChild(InternalPage *node, BufferPage *buffer, int *begin, int *end) const {
+  int fullest = 0;
+  *begin = 0;
+  *end = 0;
+  int first = 0;
+  for (int i = 0; i < node->GetSize() && first < buffer->GetCount(); i++) {
+    int last = i + 1 < node->GetSize() ? buffer->LowerBound(node->KeyAt(i + 1), comparator_) : buffer->GetCount();
+    if (last - first > *end - *begin) {
+      fullest = i;
+      *begin = first;
+      *end = last;
+    }
+    first = last;
+  }
+  return fullest;
+}
 
 /*****************************************************************************
  * INDEX ITERATOR
@@ -186,7 +1320,10 @@ bool BPLUSTREE_TYPE::AdjustRoot(BPlusTreePage *old_root_node) { return false; }
  * @return : index iterator
  */
 INDEX_TEMPLATE_ARGUMENTS
-INDEXITERATOR_TYPE BPLUSTREE_TYPE::Begin() { return INDEXITERATOR_TYPE(); }
+INDEXITERATOR_TYPE BPLUSTREE_TYPE::Begin() {
+  FlushBuffers();
+  return INDEXITERATOR_TYPE(this, nullptr);
+}
 
 /*
  * Input parameter is low key, find the leaf page that contains the input key
@@ -194,7 +1331,44 @@ INDEXITERATOR_TYPE BPLUSTREE_TYPE::Begin() { return INDEXITERATOR_TYPE(); }
  * @return : index iterator
  */
 INDEX_TEMPLATE_ARGUMENTS
-INDEXITERATOR_TYPE BPLUSTREE_TYPE::Begin(const KeyType &key) { return INDEXITERATOR_TYPE(); }
+INDEXITERATOR_TYPE BPLUSTREE_TYPE::Begin(const KeyType &key) {
+  FlushBuffers();
+  return INDEXITERATOR_TYPE(this, &key);
+}
+
+/*
+ * Input parameters are the low key and the high key of a range scan; the
+ * iterator becomes the end iterator past the high key, or at it if
+ * end_inclusive is false
+ * @return : index iterator
+ */
+INDEX_TEMPLATE_ARGUMENTS
+INDEXITERATOR_TYPE BPLUSTREE_TYPE::Begin(const KeyType &key, const KeyType &end_key, bool end_inclusive) {
+  FlushBuffers();
+  return INDEXITERATOR_TYPE(this, &key, &end_key, end_inclusive);
+}
+
+/*
+ * Input parameter is void, construct an index iterator at the last key/value
+ * pair, to be moved backward with operator--
+ * @return : index iterator
+ */
+INDEX_TEMPLATE_ARGUMENTS
+INDEXITERATOR_TYPE BPLUSTREE_TYPE::RBegin() {
+  FlushBuffers();
+  return INDEXITERATOR_TYPE::ReverseFrom(this, nullptr);
+}
+
+/*
+ * Input parameter is high key, construct an index iterator at the last
+ * key/value pair with a key up to it, or below it if inclusive is false
+ * @return : index iterator
+ */
+INDEX_TEMPLATE_ARGUMENTS
+INDEXITERATOR_TYPE BPLUSTREE_TYPE::RBegin(const KeyType &key, bool inclusive) {
+  FlushBuffers();
+  return INDEXITERATOR_TYPE::ReverseFrom(this, &key, inclusive);
+}
 
 /*
  * Input parameter is void, construct an index iterator representing the end
@@ -210,10 +1384,279 @@ INDEXITERATOR_TYPE BPLUSTREE_TYPE::End() { return INDEXITERATOR_TYPE(); }
 /*
  * Find leaf page containing particular key, if leftMost flag == true, find
  * the left most leaf page
+ * Read latches are crabbed down from the root: a child is latched before its parent is released.
  */
 INDEX_TEMPLATE_ARGUMENTS
 Page *BPLUSTREE_TYPE::FindLeafPage(const KeyType &key, bool leftMost) {
-  throw Exception(ExceptionType::NOT_IMPLEMENTED, "Implement this for test");
+  return DescendToLeaf(leftMost ? nullptr : &key, false);
+}
+
+/*
+ * Find the leaf page that holds the keys just below key, i.e. the left one of two leaves whose separator is key; if
+ * key is nullptr, find the right most leaf page
+ */
+INDEX_TEMPLATE_ARGUMENTS
+Page *BPLUSTREE_TYPE::FindLeafPageBefore(const KeyType *key) { return DescendToLeaf(key, true); }
+
+INDEX_TEMPLATE_ARGUMENTS
+Page *BPLUSTREE_TYPE::DescendToLeaf(const KeyType *key, bool before, std::vector<page_id_t> *path) {
+  root_latch_.RLock();
+  if (root_page_id_ == INVALID_PAGE_ID) {
+    root_latch_.RUnlock();
+    return nullptr;
+  }
+  Page *page = FetchNode(root_page_id_);
+  page->RLatch();
+  // in buffered mode, the root latch keeps the writer away from internal pages until the leaf is reached
+  bool hold_root_latch = mode_ == BPlusTreeMode::BUFFERED;
+  if (!hold_root_latch) {
+    root_latch_.RUnlock();
+  }
+  page = MoveRight(page, key, before, false);
+  auto node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+  while (!node->IsLeafPage()) {
+    if (path != nullptr) {
+      path->push_back(page->GetPageId());
+    }
+    auto internal = reinterpret_cast<InternalPage *>(node);
+    page_id_t child_page_id;
+    if (key == nullptr) {
+      child_page_id = internal->ValueAt(before ? internal->GetSize() - 1 : 0);
+    } else {
+      child_page_id = before ? internal->LookupBefore(*key, comparator_) : internal->Lookup(*key, comparator_);
+    }
+    Page *child_page = FetchNode(child_page_id);
+    child_page->RLatch();
+    page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+    page = MoveRight(child_page, key, before, false);
+    node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+  }
+  if (hold_root_latch) {
+    root_latch_.RUnlock();
+  }
+  return page;
+}
+
+/*
+ * A page only ever splits to the right, so the keys that a page no longer covers are in the pages after it. Without
+ * B-link splits, a page that is reached through its latched parent always covers the key, and this is a no-op.
+ * @return : the page that covers the key, latched like the given one, which is released if it is not the same
+ */
+INDEX_TEMPLATE_ARGUMENTS
+Page *BPLUSTREE_TYPE::MoveRight(Page *page, const KeyType *key, bool before, bool exclusive) {
+  while (true) {
+    auto node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+    page_id_t next_page_id;
+    const KeyType *high_fence;
+    if (node->IsLeafPage()) {
+      next_page_id = reinterpret_cast<LeafPage *>(node)->GetNextPageId();
+      high_fence = reinterpret_cast<LeafPage *>(node)->GetHighFence();
+    } else {
+      next_page_id = reinterpret_cast<InternalPage *>(node)->GetNextPageId();
+      high_fence = reinterpret_cast<InternalPage *>(node)->GetHighFence();
+    }
+    if (next_page_id == INVALID_PAGE_ID || high_fence == nullptr) {
+      return page;
+    }
+    // without a key, only the rightmost descent moves right
+    if (key == nullptr ? !before : comparator_(*key, *high_fence) < (before ? 1 : 0)) {
+      return page;
+    }
+    Page *next_page = FetchNode(next_page_id);
+    if (exclusive) {
+      next_page->WLatch();
+      page->WUnlatch();
+    } else {
+      next_page->RLatch();
+      page->RUnlatch();
+    }
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+    page = next_page;
+  }
+}
+
+/*
+ * A leaf that was merged away is left without items or fences (see BPlusTreeLeafPage::MoveAllTo), and a leaf that
+ * split or took items from a sibling has new fences, so a leaf that is live and covers the key is the leaf of the key
+ * however it was found. The page type of a page never changes, and page ids are never reused.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+Page *BPLUSTREE_TYPE::LatchLeafHint(page_id_t page_id, const KeyType &key, bool below) {
+  Page *page = buffer_pool_manager_->FetchPage(page_id);
+  if (page == nullptr) {
+    return nullptr;
+  }
+  page->RLatch();
+  auto leaf = reinterpret_cast<LeafPage *>(page->GetData());
+  bool valid = leaf->IsLeafPage();
+  if (valid) {
+    const KeyType *low = leaf->GetLowFence();
+    const KeyType *high = leaf->GetHighFence();
+    // the keys just below key, rather than key itself, may reach up to the high fence
+    valid = (leaf->GetSize() > 0 || low != nullptr || high != nullptr) &&
+            (low == nullptr || comparator_(*low, key) < (below ? 0 : 1)) &&
+            (high == nullptr || comparator_(key, *high) < (below ? 1 : 0));
+  }
+  if (!valid) {
+    page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(page_id, false);
+    return nullptr;
+  }
+  return page;
+}
+
+/*
+ * Fetch a tree page, throwing if the buffer pool has no frame left for it
+ */
+INDEX_TEMPLATE_ARGUMENTS
+Page *BPLUSTREE_TYPE::FetchNode(page_id_t page_id) {
+  Page *page = buffer_pool_manager_->FetchPage(page_id);
+  if (page == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "BPlusTree: cannot fetch page");
+  }
+  return page;
+}
+
+/*
+ * Prev links are hints, kept up to date only where that needs no waiting: a writer that splits or merges a leaf holds
+ * latches on internal pages that another writer, holding the leaf to its right, may wait for
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::LinkPrevPage(page_id_t page_id, page_id_t prev_page_id) {
+  Page *page = FetchNode(page_id);
+  bool latched = page->TryWLatch();
+  if (latched) {
+    reinterpret_cast<LeafPage *>(page->GetData())->SetPrevPageId(prev_page_id);
+    page->WUnlatch();
+  }
+  buffer_pool_manager_->UnpinPage(page_id, latched);
+}
+
+/*
+ * Optimistic descent for writers: read-latch crabbing like FindLeafPage, except that the leaf is write-latched.
+ * The page type of a page never changes while it is reachable, so it is checked before latching.
+ * @return : the pinned and write-latched leaf, or nullptr if the tree is empty
+ */
+INDEX_TEMPLATE_ARGUMENTS
+Page *BPLUSTREE_TYPE::FindLeafOptimistic(const KeyType &key, std::vector<page_id_t> *path) {
+  root_latch_.RLock();
+  if (root_page_id_ == INVALID_PAGE_ID) {
+    root_latch_.RUnlock();
+    return nullptr;
+  }
+  Page *page = FetchNode(root_page_id_);
+  auto node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+  if (node->IsLeafPage()) {
+    page->WLatch();
+  } else {
+    page->RLatch();
+  }
+  root_latch_.RUnlock();
+  page = MoveRight(page, &key, false, node->IsLeafPage());
+  node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+  while (!node->IsLeafPage()) {
+    if (path != nullptr) {
+      path->push_back(page->GetPageId());
+    }
+    Page *child_page = FetchNode(reinterpret_cast<InternalPage *>(node)->Lookup(key, comparator_));
+    auto child = reinterpret_cast<BPlusTreePage *>(child_page->GetData());
+    if (child->IsLeafPage()) {
+      child_page->WLatch();
+    } else {
+      child_page->RLatch();
+    }
+    page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+    page = MoveRight(child_page, &key, false, child->IsLeafPage());
+    node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+  }
+  return page;
+}
+
+/*
+ * Pessimistic descent for writers: write-latch every page on the way down, and release the root latch and all
+ * ancestors whenever a page is reached that the operation cannot propagate past.
+ * @return : the pinned and write-latched leaf, which is also the last page of the context's path, or nullptr if the
+ * tree is empty (the root latch is then held, so that the caller can start a new tree)
+ */
+INDEX_TEMPLATE_ARGUMENTS
+Page *BPLUSTREE_TYPE::FindLeafPessimistic(const KeyType &key, Operation op, WriteContext *context) {
+  root_latch_.WLock();
+  context->root_latched_ = true;
+  if (root_page_id_ == INVALID_PAGE_ID) {
+    return nullptr;
+  }
+  Page *page = FetchNode(root_page_id_);
+  page->WLatch();
+  auto node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+  if (IsSafe(node, op)) {
+    ReleaseAncestors(context);
+  }
+  context->path_.push_back(page);
+  while (!node->IsLeafPage()) {
+    page = FetchNode(reinterpret_cast<InternalPage *>(node)->Lookup(key, comparator_));
+    page->WLatch();
+    node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+    if (IsSafe(node, op)) {
+      ReleaseAncestors(context);
+    }
+    context->path_.push_back(page);
+  }
+  return page;
+}
+
+/*
+ * A page is safe for an operation if applying it to one of its children cannot make the page split or underflow
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::IsSafe(BPlusTreePage *node, Operation op) const {
+  if (op == Operation::INSERT) {
+    // a separator pushed up by a split below may be of any length
+    bool room = node->IsLeafPage() ? node->GetSize() + 1 < node->GetMaxSize() : node->GetSize() < node->GetMaxSize();
+    return room && node->HasRoomForAnyEntry();
+  }
+  if (node->IsRootPage()) {
+    // the root leaf may shrink to one entry and the root internal page to two children
+    return node->IsLeafPage() ? node->GetSize() > 1 : node->GetSize() > 2;
+  }
+  return node->IsHalfFullAfterRemove();
+}
+
+/*
+ * Release the root latch and every page on the path, none of which has been modified yet
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::ReleaseAncestors(WriteContext *context) {
+  if (context->root_latched_) {
+    root_latch_.WUnlock();
+    context->root_latched_ = false;
+  }
+  for (Page *page : context->path_) {
+    page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+  }
+  context->path_.clear();
+}
+
+/*
+ * Release everything a pessimistic writer still holds, then free the pages it emptied
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::ReleaseWriteContext(WriteContext *context) {
+  for (Page *page : context->path_) {
+    page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), true);
+  }
+  context->path_.clear();
+  if (context->root_latched_) {
+    root_latch_.WUnlock();
+    context->root_latched_ = false;
+  }
+  for (page_id_t page_id : context->deleted_pages_) {
+    buffer_pool_manager_->DeletePage(page_id);
+  }
+  context->deleted_pages_.clear();
 }
 
 /*
@@ -227,13 +1670,18 @@ Page *BPLUSTREE_TYPE::FindLeafPage(const KeyType &key, bool leftMost) {
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::UpdateRootPageId(int insert_record) {
   HeaderPage *header_page = static_cast<HeaderPage *>(buffer_pool_manager_->FetchPage(HEADER_PAGE_ID));
+  // the header page is shared by every index
+  header_page->WLatch();
   if (insert_record != 0) {
-    // create a new record<index_name + root_page_id> in header_page
-    header_page->InsertRecord(index_name_, root_page_id_);
+    // create a new record<index_name + root_page_id> in header_page; the record outlives the tree becoming empty
+    if (!header_page->InsertRecord(index_name_, root_page_id_)) {
+      header_page->UpdateRecord(index_name_, root_page_id_);
+    }
   } else {
     // update root_page_id in header_page
     header_page->UpdateRecord(index_name_, root_page_id_);
   }
+  header_page->WUnlatch();
   buffer_pool_manager_->UnpinPage(HEADER_PAGE_ID, true);
 }
 
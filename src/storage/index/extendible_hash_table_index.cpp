@@ -1,3 +1,4 @@
+#include <utility>
 #include <vector>
 
 #include "storage/index/extendible_hash_table_index.h"
@@ -18,16 +19,29 @@ template <typename KeyType, typename ValueType, typename KeyComparator>
 void HASH_TABLE_INDEX_TYPE::InsertEntry(const Tuple &key, RID rid, Transaction *transaction) {
   // construct insert index key
   KeyType index_key;
-  index_key.SetFromKey(key);
+  index_key.SetFromKey(key, GetKeySchema());
 
   container_.Insert(transaction, index_key, rid);
 }
 
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool HASH_TABLE_INDEX_TYPE::InsertEntries(const std::vector<Tuple> &keys, const std::vector<RID> &rids,
+                                          Transaction *transaction) {
+  // construct insert index keys
+  std::vector<std::pair<KeyType, ValueType>> entries(keys.size());
+  for (size_t i = 0; i < keys.size(); i++) {
+    entries[i].first.SetFromKey(keys[i], GetKeySchema());
+    entries[i].second = rids[i];
+  }
+
+  return container_.BulkLoad(transaction, entries);
+}
+
 template <typename KeyType, typename ValueType, typename KeyComparator>
 void HASH_TABLE_INDEX_TYPE::DeleteEntry(const Tuple &key, RID rid, Transaction *transaction) {
   // construct delete index key
   KeyType index_key;
-  index_key.SetFromKey(key);
+  index_key.SetFromKey(key, GetKeySchema());
 
   container_.Remove(transaction, index_key, rid);
 }
@@ -36,10 +50,28 @@ template <typename KeyType, typename ValueType, typename KeyComparator>
 void HASH_TABLE_INDEX_TYPE::ScanKey(const Tuple &key, std::vector<RID> *result, Transaction *transaction) {
   // construct scan index key
   KeyType index_key;
-  index_key.SetFromKey(key);
+  index_key.SetFromKey(key, GetKeySchema());
 
   container_.GetValue(transaction, index_key, result);
 }
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void HASH_TABLE_INDEX_TYPE::ScanKeys(const std::vector<Tuple> &keys, std::vector<std::vector<RID>> *results,
+                                     Transaction *transaction) {
+  // construct scan index keys
+  std::vector<KeyType> index_keys(keys.size());
+  for (size_t i = 0; i < keys.size(); i++) {
+    index_keys[i].SetFromKey(keys[i], GetKeySchema());
+  }
+
+  container_.GetValues(transaction, index_keys, results);
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+HashTableStats HASH_TABLE_INDEX_TYPE::GetStats(uint32_t bucket_sample_step) {
+  return container_.GetStats(bucket_sample_step);
+}
+
 template class ExtendibleHashTableIndex<GenericKey<4>, RID, GenericComparator<4>>;
 template class ExtendibleHashTableIndex<GenericKey<8>, RID, GenericComparator<8>>;
 template class ExtendibleHashTableIndex<GenericKey<16>, RID, GenericComparator<16>>;
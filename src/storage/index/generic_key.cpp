@@ -0,0 +1,216 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// generic_key.cpp
+//
+// Identification: src/storage/index/generic_key.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstring>
+#include <string>
+
+#include "common/exception.h"
+#include "storage/index/generic_key.h"
+#include "type/limits.h"
+
+namespace bustub {
+
+namespace {
+
+constexpr uint64_t SIGN_BIT = 1ULL << 63;
+
+/** Escape for a 0x00 byte inside a varchar, and the terminators of a NULL and of a non-NULL varchar. */
+constexpr char VARCHAR_ESCAPE = static_cast<char>(0xFF);
+constexpr char VARCHAR_NULL = 0x00;
+constexpr char VARCHAR_END = 0x01;
+
+/** Width of a fixed-size column in the encoding. */
+size_t EncodedSize(TypeId type) {
+  switch (type) {
+    case TypeId::BOOLEAN:
+    case TypeId::TINYINT:
+      return 1;
+    case TypeId::SMALLINT:
+      return 2;
+    case TypeId::INTEGER:
+      return 4;
+    case TypeId::BIGINT:
+    case TypeId::DECIMAL:
+    case TypeId::TIMESTAMP:
+      return 8;
+    default:
+      throw Exception(ExceptionType::UNKNOWN_TYPE, "KeyNormalizer: unsupported key column type");
+  }
+}
+
+/** Unsigned integer whose byte order is the order of the column values; width is EncodedSize(type). */
+uint64_t Normalize(TypeId type, const char *storage) {
+  switch (type) {
+    case TypeId::BOOLEAN:
+    case TypeId::TINYINT:
+      return static_cast<uint8_t>(*reinterpret_cast<const int8_t *>(storage) ^ INT8_MIN);
+    case TypeId::SMALLINT: {
+      int16_t value;
+      memcpy(&value, storage, sizeof(value));
+      return static_cast<uint16_t>(value ^ INT16_MIN);
+    }
+    case TypeId::INTEGER: {
+      int32_t value;
+      memcpy(&value, storage, sizeof(value));
+      return static_cast<uint32_t>(value) ^ (1U << 31);
+    }
+    case TypeId::BIGINT: {
+      int64_t value;
+      memcpy(&value, storage, sizeof(value));
+      return static_cast<uint64_t>(value) ^ SIGN_BIT;
+    }
+    case TypeId::DECIMAL: {
+      double value;
+      memcpy(&value, storage, sizeof(value));
+      // -0.0 == 0.0, so they must encode the same
+      if (value == 0) {
+        value = 0;
+      }
+      uint64_t bits;
+      memcpy(&bits, &value, sizeof(bits));
+      return (bits & SIGN_BIT) != 0 ? ~bits : bits ^ SIGN_BIT;
+    }
+    case TypeId::TIMESTAMP: {
+      uint64_t value;
+      memcpy(&value, storage, sizeof(value));
+      return value;
+    }
+    default:
+      throw Exception(ExceptionType::UNKNOWN_TYPE, "KeyNormalizer: unsupported key column type");
+  }
+}
+
+/** Inverse of Normalize(). */
+Value Denormalize(TypeId type, uint64_t normalized) {
+  switch (type) {
+    case TypeId::BOOLEAN:
+    case TypeId::TINYINT:
+      return Value(type, static_cast<int8_t>(static_cast<int8_t>(normalized) ^ INT8_MIN));
+    case TypeId::SMALLINT:
+      return Value(type, static_cast<int16_t>(static_cast<int16_t>(normalized) ^ INT16_MIN));
+    case TypeId::INTEGER:
+      return Value(type, static_cast<int32_t>(static_cast<uint32_t>(normalized) ^ (1U << 31)));
+    case TypeId::BIGINT:
+      return Value(type, static_cast<int64_t>(normalized ^ SIGN_BIT));
+    case TypeId::DECIMAL: {
+      uint64_t bits = (normalized & SIGN_BIT) != 0 ? normalized ^ SIGN_BIT : ~normalized;
+      double value;
+      memcpy(&value, &bits, sizeof(value));
+      return Value(type, value);
+    }
+    case TypeId::TIMESTAMP:
+      return Value(type, normalized);
+    default:
+      throw Exception(ExceptionType::UNKNOWN_TYPE, "KeyNormalizer: unsupported key column type");
+  }
+}
+
+/** Bytes an encoded varchar takes, including its terminator. */
+size_t VarcharEncodedSize(const char *data, size_t size) {
+  size_t pos = 0;
+  while (pos + 1 < size && !(data[pos] == 0 && data[pos + 1] != VARCHAR_ESCAPE)) {
+    pos += data[pos] == 0 ? 2 : 1;
+  }
+  return pos + 2;
+}
+
+void ThrowKeyTooLarge(size_t size) {
+  throw Exception(ExceptionType::OUT_OF_RANGE, "KeyNormalizer: key does not fit in " + std::to_string(size) + " bytes");
+}
+
+}  // namespace
+
+void KeyNormalizer::Encode(const Tuple &key, const Schema *key_schema, char *data, size_t size) {
+  size_t pos = 0;
+  for (const auto &col : key_schema->GetColumns()) {
+    const char *storage = key.GetData() + col.GetOffset();
+    if (col.IsInlined()) {
+      size_t width = EncodedSize(col.GetType());
+      if (pos + width > size) {
+        ThrowKeyTooLarge(size);
+      }
+      uint64_t normalized = Normalize(col.GetType(), storage);
+      // big-endian, most significant byte first
+      for (size_t i = 0; i < width; i++) {
+        data[pos + i] = static_cast<char>(normalized >> (8 * (width - 1 - i)));
+      }
+      pos += width;
+      continue;
+    }
+
+    uint32_t offset;
+    memcpy(&offset, storage, sizeof(offset));
+    uint32_t len;
+    memcpy(&len, key.GetData() + offset, sizeof(len));
+    const char *bytes = key.GetData() + offset + sizeof(len);
+    bool is_null = len == BUSTUB_VALUE_NULL;
+    if (is_null) {
+      len = 0;
+    }
+    for (uint32_t i = 0; i < len; i++) {
+      if (pos + 2 > size) {
+        ThrowKeyTooLarge(size);
+      }
+      data[pos++] = bytes[i];
+      if (bytes[i] == 0) {
+        data[pos++] = VARCHAR_ESCAPE;
+      }
+    }
+    if (pos + 2 > size) {
+      ThrowKeyTooLarge(size);
+    }
+    data[pos++] = 0;
+    data[pos++] = is_null ? VARCHAR_NULL : VARCHAR_END;
+  }
+  memset(data + pos, 0, size - pos);
+}
+
+Value KeyNormalizer::Decode(const char *data, size_t size, const Schema *key_schema, uint32_t column_idx) {
+  size_t pos = 0;
+  for (uint32_t i = 0; i < column_idx; i++) {
+    const auto &col = key_schema->GetColumn(i);
+    pos += col.IsInlined() ? EncodedSize(col.GetType()) : VarcharEncodedSize(data + pos, size - pos);
+  }
+
+  const auto &col = key_schema->GetColumn(column_idx);
+  if (col.IsInlined()) {
+    size_t width = EncodedSize(col.GetType());
+    uint64_t normalized = 0;
+    for (size_t i = 0; i < width; i++) {
+      normalized = normalized << 8 | static_cast<uint8_t>(data[pos + i]);
+    }
+    return Denormalize(col.GetType(), normalized);
+  }
+
+  std::string bytes;
+  while (pos + 1 < size && !(data[pos] == 0 && data[pos + 1] != VARCHAR_ESCAPE)) {
+    bytes.push_back(data[pos]);
+    pos += data[pos] == 0 ? 2 : 1;
+  }
+  if (pos + 1 < size && data[pos + 1] == VARCHAR_NULL) {
+    return Value(TypeId::VARCHAR, nullptr, BUSTUB_VALUE_NULL, false);
+  }
+  return Value(TypeId::VARCHAR, bytes.data(), static_cast<uint32_t>(bytes.size()), true);
+}
+
+void KeyNormalizer::EncodeBigint(int64_t key, char *data) {
+  uint64_t normalized = static_cast<uint64_t>(key) ^ SIGN_BIT;
+  for (size_t i = 0; i < sizeof(normalized); i++) {
+    data[i] = static_cast<char>(normalized >> (8 * (7 - i)));
+  }
+}
+
+int64_t KeyNormalizer::DecodeBigint(const char *data) {
+  return static_cast<int64_t>(LoadBigEndian64(data) ^ SIGN_BIT);
+}
+
+}  // namespace bustub
@@ -2,29 +2,311 @@
  * index_iterator.cpp
  */
 #include <cassert>
+#include <utility>
 
+#include "common/exception.h"
+#include "storage/index/b_plus_tree.h"
 #include "storage/index/index_iterator.h"
+#include "storage/index/posting_list.h"
 
 namespace bustub {
 
+INDEX_TEMPLATE_ARGUMENTS
+INDEXITERATOR_TYPE::IndexIterator() = default;
+
+INDEX_TEMPLATE_ARGUMENTS
+INDEXITERATOR_TYPE::IndexIterator(BPlusTreeType *tree, const KeyType *key, const KeyType *end_key, bool end_inclusive)
+    : tree_(tree), buffer_pool_manager_(tree->buffer_pool_manager_), end_inclusive_(end_inclusive) {
+  if (end_key != nullptr) {
+    has_end_key_ = true;
+    end_key_ = *end_key;
+  }
+  if (key == nullptr) {
+    Page *page = tree_->FindLeafPage(KeyType{}, true);
+    if (page != nullptr) {
+      LoadFrom(page, 0);
+    }
+  } else {
+    LoadForward(*key, true, INVALID_PAGE_ID);
+  }
+  Prefetch(true);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+INDEXITERATOR_TYPE INDEXITERATOR_TYPE::ReverseFrom(BPlusTreeType *tree, const KeyType *key, bool inclusive) {
+  IndexIterator iterator;
+  iterator.tree_ = tree;
+  iterator.buffer_pool_manager_ = tree->buffer_pool_manager_;
+  iterator.LoadBackward(key == nullptr ? KeyType{} : *key, key != nullptr, inclusive, INVALID_PAGE_ID);
+  iterator.Prefetch(false);
+  return iterator;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+INDEXITERATOR_TYPE::~IndexIterator() { Clear(); }  // NOLINT
+
+INDEX_TEMPLATE_ARGUMENTS
+INDEXITERATOR_TYPE::IndexIterator(IndexIterator &&other) noexcept { *this = std::move(other); }
+
+INDEX_TEMPLATE_ARGUMENTS
+INDEXITERATOR_TYPE &INDEXITERATOR_TYPE::operator=(IndexIterator &&other) noexcept {
+  if (this != &other) {
+    Clear();
+    tree_ = other.tree_;
+    buffer_pool_manager_ = other.buffer_pool_manager_;
+    has_end_key_ = other.has_end_key_;
+    end_key_ = other.end_key_;
+    end_inclusive_ = other.end_inclusive_;
+    batch_ = std::move(other.batch_);
+    index_ = other.index_;
+    page_id_ = other.page_id_;
+    has_low_fence_ = other.has_low_fence_;
+    low_fence_ = other.low_fence_;
+    has_high_fence_ = other.has_high_fence_;
+    high_fence_ = other.high_fence_;
+    prev_page_id_ = other.prev_page_id_;
+    next_page_id_ = other.next_page_id_;
+    at_first_ = other.at_first_;
+    at_last_ = other.at_last_;
+    at_end_key_ = other.at_end_key_;
+    prefetched_page_ = other.prefetched_page_;
+    other.prefetched_page_ = nullptr;
+    other.Clear();
+  }
+  return *this;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool INDEXITERATOR_TYPE::IsEnd() { return batch_.empty(); }
+
+INDEX_TEMPLATE_ARGUMENTS
+const MappingType &INDEXITERATOR_TYPE::operator*() { return batch_[index_]; }
+
 /*
- * NOTE: you can change the destructor/constructor method here
- * set your own input parameters
+ * Past the end of the batch, the next items are in the same leaf if the batch stops short of its last item, and in
+ * the leaf that covers the high fence otherwise
  */
 INDEX_TEMPLATE_ARGUMENTS
-INDEXITERATOR_TYPE::IndexIterator() = default;
+INDEXITERATOR_TYPE &INDEXITERATOR_TYPE::operator++() {
+  if (++index_ < batch_.size()) {
+    return *this;
+  }
+  if (at_end_key_ || (at_last_ && next_page_id_ == INVALID_PAGE_ID)) {
+    Clear();
+  } else if (at_last_) {
+    LoadForward(high_fence_, true, next_page_id_);
+  } else {
+    LoadForward(KeyType(batch_.back().first), false, page_id_);
+  }
+  Prefetch(true);
+  return *this;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+INDEXITERATOR_TYPE &INDEXITERATOR_TYPE::operator--() {
+  if (index_ > 0) {
+    index_--;
+    return *this;
+  }
+  if (at_first_ && !has_low_fence_) {
+    Clear();
+  } else if (at_first_) {
+    LoadBackward(low_fence_, true, false, prev_page_id_);
+  } else {
+    LoadBackward(KeyType(batch_.front().first), true, false, page_id_);
+  }
+  Prefetch(false);
+  return *this;
+}
+
+/*
+ * Iterators are equal if both are at the end, or both at the same item
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool INDEXITERATOR_TYPE::operator==(const IndexIterator &itr) const {
+  if (batch_.empty() || itr.batch_.empty()) {
+    return batch_.empty() && itr.batch_.empty();
+  }
+  const MappingType &item = batch_[index_];
+  const MappingType &other_item = itr.batch_[itr.index_];
+  return tree_->comparator_(item.first, other_item.first) == 0 && item.second == other_item.second;
+}
 
 INDEX_TEMPLATE_ARGUMENTS
-INDEXITERATOR_TYPE::~IndexIterator() = default;  // NOLINT
+void INDEXITERATOR_TYPE::LoadForward(const KeyType &key, bool inclusive, page_id_t hint) {
+  Page *page = LatchHint(hint, key, false, inclusive);
+  if (page == nullptr) {
+    page = tree_->FindLeafPage(key);
+    if (page == nullptr) {
+      Clear();
+      return;
+    }
+  }
+  auto leaf = reinterpret_cast<LeafPage *>(page->GetData());
+  LoadFrom(page, inclusive ? leaf->KeyIndex(key, tree_->comparator_) : leaf->UpperKeyIndex(key, tree_->comparator_));
+}
 
+/*
+ * Leaves before the batch cannot be crabbed to, since latches are taken left to right: the batch is loaded from the
+ * hint or a descent, one leaf at a time, until a leaf has items before the key
+ */
 INDEX_TEMPLATE_ARGUMENTS
-bool INDEXITERATOR_TYPE::IsEnd() { throw std::runtime_error("unimplemented"); }
+void INDEXITERATOR_TYPE::LoadBackward(KeyType key, bool has_key, bool inclusive, page_id_t hint) {
+  while (true) {
+    Page *page = has_key ? LatchHint(hint, key, true, inclusive) : nullptr;
+    if (page == nullptr) {
+      page = has_key && inclusive ? tree_->FindLeafPage(key) : tree_->FindLeafPageBefore(has_key ? &key : nullptr);
+      if (page == nullptr) {
+        Clear();
+        return;
+      }
+    }
+    auto leaf = reinterpret_cast<LeafPage *>(page->GetData());
+    int end = leaf->GetSize();
+    if (has_key) {
+      end = inclusive ? leaf->UpperKeyIndex(key, tree_->comparator_) : leaf->KeyIndex(key, tree_->comparator_);
+    }
+    CopyItems(page, 0, end);
+    page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+    if (!batch_.empty()) {
+      index_ = batch_.size() - 1;
+      return;
+    }
+    if (!has_low_fence_) {
+      Clear();
+      return;
+    }
+    key = low_fence_;
+    has_key = true;
+    inclusive = false;
+    hint = prev_page_id_;
+  }
+}
 
 INDEX_TEMPLATE_ARGUMENTS
-const MappingType &INDEXITERATOR_TYPE::operator*() { throw std::runtime_error("unimplemented"); }
+void INDEXITERATOR_TYPE::LoadFrom(Page *page, int begin) {
+  while (true) {
+    auto leaf = reinterpret_cast<LeafPage *>(page->GetData());
+    CopyItems(page, begin, leaf->GetSize());
+    page_id_t next_page_id = leaf->GetNextPageId();
+    if (!batch_.empty() || at_end_key_ || next_page_id == INVALID_PAGE_ID) {
+      break;
+    }
+    // latch the next leaf before letting go of this one, so it cannot be merged away in between
+    Page *next_page = buffer_pool_manager_->FetchPage(next_page_id);
+    if (next_page == nullptr) {
+      page->RUnlatch();
+      buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+      Clear();
+      throw Exception(ExceptionType::OUT_OF_MEMORY, "IndexIterator: cannot fetch next leaf");
+    }
+    next_page->RLatch();
+    page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+    page = next_page;
+    begin = 0;
+  }
+  page->RUnlatch();
+  buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+  index_ = 0;
+  if (batch_.empty()) {
+    Clear();
+  }
+}
+
+/*
+ * The overflow pages of posting lists are protected by the latch of the leaf, which the caller holds
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void INDEXITERATOR_TYPE::CopyItems(Page *page, int begin, int end) {
+  auto leaf = reinterpret_cast<LeafPage *>(page->GetData());
+  batch_.clear();
+  index_ = 0;
+  at_end_key_ = false;
+  std::vector<ValueType> values;
+  for (int i = begin; i < end; i++) {
+    KeyType key = leaf->KeyAt(i);
+    if (has_end_key_) {
+      int cmp = tree_->comparator_(key, end_key_);
+      if (cmp > 0 || (cmp == 0 && !end_inclusive_)) {
+        at_end_key_ = true;
+        end = i;
+        break;
+      }
+    }
+    if (leaf->IsUnique()) {
+      batch_.emplace_back(key, leaf->ValueAt(i));
+      continue;
+    }
+    values.clear();
+    PostingList::GetValues(buffer_pool_manager_, leaf->PostingAt(i), &values);
+    for (const ValueType &value : values) {
+      batch_.emplace_back(key, value);
+    }
+  }
+  page_id_ = page->GetPageId();
+  has_low_fence_ = leaf->GetLowFence() != nullptr;
+  if (has_low_fence_) {
+    low_fence_ = *leaf->GetLowFence();
+  }
+  has_high_fence_ = leaf->GetHighFence() != nullptr;
+  if (has_high_fence_) {
+    high_fence_ = *leaf->GetHighFence();
+  }
+  prev_page_id_ = leaf->GetPrevPageId();
+  next_page_id_ = leaf->GetNextPageId();
+  at_first_ = begin == 0;
+  at_last_ = end == leaf->GetSize();
+}
+
+/*
+ * Page ids are never reused, so a hint is a leaf of the tree or a page freed by a merge, which has neither fences nor
+ * items. Going forward, the leaf must cover the key; going backward, it must cover the keys just below it.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+Page *INDEXITERATOR_TYPE::LatchHint(page_id_t hint, const KeyType &key, bool before, bool inclusive) {
+  if (hint == INVALID_PAGE_ID) {
+    return nullptr;
+  }
+  return tree_->LatchLeafHint(hint, key, before && !inclusive);
+}
+
+/*
+ * The buffer pool reads synchronously, so the pin is what gets the leaf read ahead of the scan; a pool without a
+ * free frame simply leaves the leaf to be fetched later
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void INDEXITERATOR_TYPE::Prefetch(bool forward) {
+  page_id_t page_id = INVALID_PAGE_ID;
+  if (!batch_.empty()) {
+    if (forward && at_last_ && !at_end_key_) {
+      page_id = next_page_id_;
+    } else if (!forward && at_first_) {
+      page_id = prev_page_id_;
+    }
+  }
+  if (prefetched_page_ != nullptr && prefetched_page_->GetPageId() == page_id) {
+    return;
+  }
+  if (prefetched_page_ != nullptr) {
+    buffer_pool_manager_->UnpinPage(prefetched_page_->GetPageId(), false);
+    prefetched_page_ = nullptr;
+  }
+  if (page_id != INVALID_PAGE_ID) {
+    prefetched_page_ = buffer_pool_manager_->FetchPage(page_id);
+  }
+}
 
 INDEX_TEMPLATE_ARGUMENTS
-INDEXITERATOR_TYPE &INDEXITERATOR_TYPE::operator++() { throw std::runtime_error("unimplemented"); }
+void INDEXITERATOR_TYPE::Clear() {
+  batch_.clear();
+  index_ = 0;
+  if (prefetched_page_ != nullptr) {
+    buffer_pool_manager_->UnpinPage(prefetched_page_->GetPageId(), false);
+    prefetched_page_ = nullptr;
+  }
+}
 
 template class IndexIterator<GenericKey<4>, RID, GenericComparator<4>>;
 
@@ -0,0 +1,373 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// posting_list.cpp
+//
+// Identification: src/storage/index/posting_list.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/index/posting_list.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "common/exception.h"
+#include "storage/page/posting_list_page.h"
+
+namespace bustub {
+
+namespace {
+
+constexpr char INLINE_LIST = 0;
+constexpr char OVERFLOW_LIST = 1;
+constexpr int OVERFLOW_LIST_SIZE = 1 + sizeof(uint32_t) + 2 * sizeof(page_id_t);
+
+/** The reference of a list to its overflow pages. */
+struct OverflowList {
+  uint32_t count_;
+  page_id_t first_page_id_;
+  page_id_t last_page_id_;
+};
+
+OverflowList ReadOverflowList(const std::string &list) {
+  OverflowList overflow;
+  memcpy(&overflow.count_, list.data() + 1, sizeof(uint32_t));
+  memcpy(&overflow.first_page_id_, list.data() + 1 + sizeof(uint32_t), sizeof(page_id_t));
+  memcpy(&overflow.last_page_id_, list.data() + 1 + sizeof(uint32_t) + sizeof(page_id_t), sizeof(page_id_t));
+  return overflow;
+}
+
+void WriteOverflowList(const OverflowList &overflow, std::string *list) {
+  list->assign(OVERFLOW_LIST_SIZE, OVERFLOW_LIST);
+  memcpy(list->data() + 1, &overflow.count_, sizeof(uint32_t));
+  memcpy(list->data() + 1 + sizeof(uint32_t), &overflow.first_page_id_, sizeof(page_id_t));
+  memcpy(list->data() + 1 + sizeof(uint32_t) + sizeof(page_id_t), &overflow.last_page_id_, sizeof(page_id_t));
+}
+
+/** RIDs are ordered by page id, as an unsigned number, then slot. */
+uint64_t RidValue(const RID &rid) {
+  return static_cast<uint64_t>(static_cast<uint32_t>(rid.GetPageId())) << 32 | rid.GetSlotNum();
+}
+
+RID RidOf(uint64_t value) { return RID(static_cast<page_id_t>(value >> 32), static_cast<uint32_t>(value)); }
+
+void PutVarint(uint32_t value, std::string *out) {
+  while (value >= 0x80) {
+    out->push_back(static_cast<char>(value | 0x80));
+    value >>= 7;
+  }
+  out->push_back(static_cast<char>(value));
+}
+
+uint32_t GetVarint(const char **data) {
+  uint32_t value = 0;
+  for (int shift = 0;; shift += 7) {
+    auto byte = static_cast<uint8_t>(*(*data)++);
+    value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+    if ((byte & 0x80) == 0) {
+      return value;
+    }
+  }
+}
+
+/** Append the encoding of a RID, relative to the one before it unless it starts a run. */
+void EncodeRid(uint64_t value, const uint64_t *prev, std::string *out) {
+  auto page = static_cast<uint32_t>(value >> 32);
+  auto slot = static_cast<uint32_t>(value);
+  if (prev == nullptr) {
+    PutVarint(page, out);
+    PutVarint(slot, out);
+    return;
+  }
+  uint32_t page_delta = page - static_cast<uint32_t>(*prev >> 32);
+  PutVarint(page_delta, out);
+  PutVarint(page_delta == 0 ? slot - static_cast<uint32_t>(*prev) - 1 : slot, out);
+}
+
+std::string EncodeRun(const uint64_t *values, size_t count) {
+  std::string run;
+  for (size_t i = 0; i < count; i++) {
+    EncodeRid(values[i], i == 0 ? nullptr : &values[i - 1], &run);
+  }
+  return run;
+}
+
+void DecodeRun(const char *run, int run_size, std::vector<uint64_t> *values) {
+  const char *end = run + run_size;
+  bool first = true;
+  uint64_t prev = 0;
+  while (run < end) {
+    uint32_t page = GetVarint(&run);
+    uint32_t slot = GetVarint(&run);
+    if (!first) {
+      uint32_t prev_page = static_cast<uint32_t>(prev >> 32);
+      slot = page == 0 ? static_cast<uint32_t>(prev) + 1 + slot : slot;
+      page += prev_page;
+    }
+    prev = static_cast<uint64_t>(page) << 32 | slot;
+    values->push_back(prev);
+    first = false;
+  }
+}
+
+void DecodeInline(const std::string &list, std::vector<uint64_t> *values) {
+  DecodeRun(list.data() + 1, static_cast<int>(list.size()) - 1, values);
+}
+
+std::string EncodeInline(const std::vector<uint64_t> &values) {
+  return INLINE_LIST + EncodeRun(values.data(), values.size());
+}
+
+/*
+ * Overflow pages are pinned only while they are read or written
+ */
+PostingListPage *FetchListPage(BufferPoolManager *buffer_pool_manager, page_id_t page_id) {
+  Page *page = buffer_pool_manager->FetchPage(page_id);
+  if (page == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "PostingList: cannot fetch overflow page");
+  }
+  return reinterpret_cast<PostingListPage *>(page->GetData());
+}
+
+PostingListPage *NewListPage(BufferPoolManager *buffer_pool_manager) {
+  page_id_t page_id;
+  Page *page = buffer_pool_manager->NewPage(&page_id);
+  if (page == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "PostingList: cannot allocate overflow page");
+  }
+  auto list_page = reinterpret_cast<PostingListPage *>(page->GetData());
+  list_page->Init(page_id);
+  return list_page;
+}
+
+void SetRunOf(PostingListPage *list_page, const uint64_t *values, size_t count) {
+  std::string run = EncodeRun(values, count);
+  list_page->SetRun(run.data(), static_cast<int>(run.size()), static_cast<int>(count), values[0], values[count - 1]);
+}
+
+void ReadPage(const PostingListPage *list_page, std::vector<uint64_t> *values) {
+  DecodeRun(list_page->GetRun(), list_page->GetRunSize(), values);
+}
+
+}  // namespace
+
+std::string PostingList::Make(const RID &rid) {
+  uint64_t value = RidValue(rid);
+  return EncodeInline({value});
+}
+
+uint32_t PostingList::Count(const std::string &list) {
+  if (list[0] != INLINE_LIST) {
+    return ReadOverflowList(list).count_;
+  }
+  std::vector<uint64_t> values;
+  DecodeInline(list, &values);
+  return values.size();
+}
+
+void PostingList::GetValues(BufferPoolManager *buffer_pool_manager, const std::string &list, std::vector<RID> *result) {
+  std::vector<uint64_t> values;
+  if (list[0] == INLINE_LIST) {
+    DecodeInline(list, &values);
+  } else {
+    for (page_id_t page_id = ReadOverflowList(list).first_page_id_; page_id != INVALID_PAGE_ID;) {
+      PostingListPage *list_page = FetchListPage(buffer_pool_manager, page_id);
+      ReadPage(list_page, &values);
+      page_id_t next_page_id = list_page->GetNextPageId();
+      buffer_pool_manager->UnpinPage(page_id, false);
+      page_id = next_page_id;
+    }
+  }
+  for (uint64_t value : values) {
+    result->push_back(RidOf(value));
+  }
+}
+
+/*
+ * A RID after the last one, the common case for RIDs of a growing table, is appended to the last page. Any other RID
+ * is inserted into the first page whose last RID is not smaller, which is split in half if it overflows.
+ */
+bool PostingList::Insert(BufferPoolManager *buffer_pool_manager, std::string *list, const RID &rid) {
+  uint64_t value = RidValue(rid);
+  if ((*list)[0] == INLINE_LIST) {
+    std::vector<uint64_t> values;
+    DecodeInline(*list, &values);
+    auto it = std::lower_bound(values.begin(), values.end(), value);
+    if (it != values.end() && *it == value) {
+      return false;
+    }
+    values.insert(it, value);
+    std::string encoded = EncodeInline(values);
+    if (static_cast<int>(encoded.size()) <= MAX_INLINE_SIZE) {
+      *list = std::move(encoded);
+      return true;
+    }
+    // the list moves to an overflow page, which easily holds a list that just outgrew the leaf
+    PostingListPage *list_page = NewListPage(buffer_pool_manager);
+    SetRunOf(list_page, values.data(), values.size());
+    page_id_t page_id = list_page->GetPageId();
+    buffer_pool_manager->UnpinPage(page_id, true);
+    WriteOverflowList({static_cast<uint32_t>(values.size()), page_id, page_id}, list);
+    return true;
+  }
+
+  OverflowList overflow = ReadOverflowList(*list);
+  PostingListPage *last_page = FetchListPage(buffer_pool_manager, overflow.last_page_id_);
+  if (value > last_page->GetLastRid()) {
+    uint64_t last_value = last_page->GetLastRid();
+    std::string data;
+    EncodeRid(value, &last_value, &data);
+    if (last_page->GetRunSize() + static_cast<int>(data.size()) <= PostingListPage::RUN_CAPACITY) {
+      last_page->AppendToRun(data.data(), static_cast<int>(data.size()), value);
+    } else {
+      PostingListPage *new_page = NewListPage(buffer_pool_manager);
+      data.clear();
+      EncodeRid(value, nullptr, &data);
+      new_page->AppendToRun(data.data(), static_cast<int>(data.size()), value);
+      last_page->SetNextPageId(new_page->GetPageId());
+      overflow.last_page_id_ = new_page->GetPageId();
+      buffer_pool_manager->UnpinPage(new_page->GetPageId(), true);
+    }
+    buffer_pool_manager->UnpinPage(last_page->GetPageId(), true);
+    overflow.count_++;
+    WriteOverflowList(overflow, list);
+    return true;
+  }
+  buffer_pool_manager->UnpinPage(last_page->GetPageId(), false);
+
+  page_id_t page_id = overflow.first_page_id_;
+  PostingListPage *list_page = FetchListPage(buffer_pool_manager, page_id);
+  while (value > list_page->GetLastRid()) {
+    page_id_t next_page_id = list_page->GetNextPageId();
+    buffer_pool_manager->UnpinPage(page_id, false);
+    page_id = next_page_id;
+    list_page = FetchListPage(buffer_pool_manager, page_id);
+  }
+  std::vector<uint64_t> values;
+  ReadPage(list_page, &values);
+  auto it = std::lower_bound(values.begin(), values.end(), value);
+  if (*it == value) {
+    buffer_pool_manager->UnpinPage(page_id, false);
+    return false;
+  }
+  values.insert(it, value);
+  std::string run = EncodeRun(values.data(), values.size());
+  if (static_cast<int>(run.size()) <= PostingListPage::RUN_CAPACITY) {
+    list_page->SetRun(run.data(), static_cast<int>(run.size()), static_cast<int>(values.size()), values.front(),
+                      values.back());
+  } else {
+    // a page only ever overflows by one RID, so both halves fit
+    size_t keep = values.size() / 2;
+    PostingListPage *new_page = NewListPage(buffer_pool_manager);
+    SetRunOf(new_page, values.data() + keep, values.size() - keep);
+    SetRunOf(list_page, values.data(), keep);
+    new_page->SetNextPageId(list_page->GetNextPageId());
+    list_page->SetNextPageId(new_page->GetPageId());
+    if (overflow.last_page_id_ == page_id) {
+      overflow.last_page_id_ = new_page->GetPageId();
+    }
+    buffer_pool_manager->UnpinPage(new_page->GetPageId(), true);
+  }
+  buffer_pool_manager->UnpinPage(page_id, true);
+  overflow.count_++;
+  WriteOverflowList(overflow, list);
+  return true;
+}
+
+/*
+ * Pages that become empty are unlinked and deleted. Once the list is down to a quarter of what a leaf holds, so that
+ * a list at the limit does not move back and forth, it moves back into the leaf if it fits there.
+ */
+bool PostingList::Remove(BufferPoolManager *buffer_pool_manager, std::string *list, const RID &rid, int max_size) {
+  uint64_t value = RidValue(rid);
+  if ((*list)[0] == INLINE_LIST) {
+    std::vector<uint64_t> values;
+    DecodeInline(*list, &values);
+    auto it = std::lower_bound(values.begin(), values.end(), value);
+    if (it == values.end() || *it != value) {
+      return false;
+    }
+    values.erase(it);
+    *list = values.empty() ? std::string() : EncodeInline(values);
+    return true;
+  }
+
+  OverflowList overflow = ReadOverflowList(*list);
+  page_id_t prev_page_id = INVALID_PAGE_ID;
+  page_id_t page_id = overflow.first_page_id_;
+  PostingListPage *list_page = FetchListPage(buffer_pool_manager, page_id);
+  while (value > list_page->GetLastRid() && list_page->GetNextPageId() != INVALID_PAGE_ID) {
+    page_id_t next_page_id = list_page->GetNextPageId();
+    buffer_pool_manager->UnpinPage(page_id, false);
+    prev_page_id = page_id;
+    page_id = next_page_id;
+    list_page = FetchListPage(buffer_pool_manager, page_id);
+  }
+  std::vector<uint64_t> values;
+  ReadPage(list_page, &values);
+  auto it = std::lower_bound(values.begin(), values.end(), value);
+  if (it == values.end() || *it != value) {
+    buffer_pool_manager->UnpinPage(page_id, false);
+    return false;
+  }
+  values.erase(it);
+  if (!values.empty()) {
+    SetRunOf(list_page, values.data(), values.size());
+    buffer_pool_manager->UnpinPage(page_id, true);
+  } else {
+    page_id_t next_page_id = list_page->GetNextPageId();
+    buffer_pool_manager->UnpinPage(page_id, false);
+    buffer_pool_manager->DeletePage(page_id);
+    if (prev_page_id == INVALID_PAGE_ID) {
+      overflow.first_page_id_ = next_page_id;
+    } else {
+      PostingListPage *prev_page = FetchListPage(buffer_pool_manager, prev_page_id);
+      prev_page->SetNextPageId(next_page_id);
+      buffer_pool_manager->UnpinPage(prev_page_id, true);
+    }
+    if (overflow.last_page_id_ == page_id) {
+      overflow.last_page_id_ = prev_page_id;
+    }
+  }
+  overflow.count_--;
+  if (overflow.count_ == 0) {
+    list->clear();
+    return true;
+  }
+  WriteOverflowList(overflow, list);
+
+  // every RID takes at least two bytes
+  if (static_cast<int>(overflow.count_) * 2 < MAX_INLINE_SIZE / 4) {
+    std::vector<RID> rids;
+    GetValues(buffer_pool_manager, *list, &rids);
+    values.clear();
+    for (const RID &remaining : rids) {
+      values.push_back(RidValue(remaining));
+    }
+    std::string encoded = EncodeInline(values);
+    if (static_cast<int>(encoded.size()) <= std::min(max_size, MAX_INLINE_SIZE / 4)) {
+      Free(buffer_pool_manager, *list);
+      *list = std::move(encoded);
+    }
+  }
+  return true;
+}
+
+void PostingList::Free(BufferPoolManager *buffer_pool_manager, const std::string &list) {
+  if (list.empty() || list[0] == INLINE_LIST) {
+    return;
+  }
+  for (page_id_t page_id = ReadOverflowList(list).first_page_id_; page_id != INVALID_PAGE_ID;) {
+    PostingListPage *list_page = FetchListPage(buffer_pool_manager, page_id);
+    page_id_t next_page_id = list_page->GetNextPageId();
+    buffer_pool_manager->UnpinPage(page_id, false);
+    buffer_pool_manager->DeletePage(page_id);
+    page_id = next_page_id;
+  }
+}
+
+}  // namespace bustub
@@ -0,0 +1,108 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// b_plus_tree_buffer_page.cpp
+//
+// Identification: src/storage/page/b_plus_tree_buffer_page.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/page/b_plus_tree_buffer_page.h"
+
+#include <cstring>
+
+#include "common/macros.h"
+#include "common/rid.h"
+
+namespace bustub {
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_BUFFER_PAGE_TYPE::Init(page_id_t page_id) {
+  static_assert(sizeof(BPlusTreeBufferPage) <= PAGE_SIZE, "buffer page size mismatch");
+  page_id_ = page_id;
+  lsn_ = INVALID_LSN;
+  count_ = 0;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+page_id_t B_PLUS_TREE_BUFFER_PAGE_TYPE::GetPageId() const { return page_id_; }
+
+INDEX_TEMPLATE_ARGUMENTS
+int B_PLUS_TREE_BUFFER_PAGE_TYPE::GetCount() const { return count_; }
+
+INDEX_TEMPLATE_ARGUMENTS
+const typename B_PLUS_TREE_BUFFER_PAGE_TYPE::Message &B_PLUS_TREE_BUFFER_PAGE_TYPE::MessageAt(int index) const {
+  return messages_[index];
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+int B_PLUS_TREE_BUFFER_PAGE_TYPE::LowerBound(const KeyType &key, const KeyComparator &comparator) const {
+  int low = 0;
+  int high = count_;
+  while (low < high) {
+    int mid = (low + high) / 2;
+    if (comparator(messages_[mid].key_, key) < 0) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  return low;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+const typename B_PLUS_TREE_BUFFER_PAGE_TYPE::Message *B_PLUS_TREE_BUFFER_PAGE_TYPE::Find(
+    const KeyType &key, const KeyComparator &comparator) const {
+  int index = LowerBound(key, comparator);
+  if (index < count_ && comparator(messages_[index].key_, key) == 0) {
+    return &messages_[index];
+  }
+  return nullptr;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool B_PLUS_TREE_BUFFER_PAGE_TYPE::HasRoomFor(const KeyType &key, const KeyComparator &comparator) const {
+  return !IsFull() || Find(key, comparator) != nullptr;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool B_PLUS_TREE_BUFFER_PAGE_TYPE::Put(const Message &message, const KeyComparator &comparator) {
+  int index = LowerBound(message.key_, comparator);
+  if (index < count_ && comparator(messages_[index].key_, message.key_) == 0) {
+    Message &older = messages_[index];
+    if (message.op_ != BufferedOp::INSERT) {
+      older = message;
+    } else if (older.op_ == BufferedOp::DELETE) {
+      // the key may still have a value below, which the insert now overwrites
+      older = Message{message.key_, message.value_, BufferedOp::UPSERT};
+    } else {
+      return false;
+    }
+    return true;
+  }
+  BUSTUB_ASSERT(count_ < MAX_COUNT, "buffer page is full");
+  memmove(static_cast<void *>(&messages_[index + 1]), static_cast<void *>(&messages_[index]),
+          (count_ - index) * sizeof(Message));
+  messages_[index] = message;
+  count_++;
+  return true;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_BUFFER_PAGE_TYPE::Take(int begin, int end, std::vector<Message> *result) {
+  result->insert(result->end(), messages_ + begin, messages_ + end);
+  memmove(static_cast<void *>(&messages_[begin]), static_cast<void *>(&messages_[end]),
+          (count_ - end) * sizeof(Message));
+  count_ -= end - begin;
+}
+
+template class BPlusTreeBufferPage<GenericKey<4>, RID, GenericComparator<4>>;
+template class BPlusTreeBufferPage<GenericKey<8>, RID, GenericComparator<8>>;
+template class BPlusTreeBufferPage<GenericKey<16>, RID, GenericComparator<16>>;
+template class BPlusTreeBufferPage<GenericKey<32>, RID, GenericComparator<32>>;
+template class BPlusTreeBufferPage<GenericKey<64>, RID, GenericComparator<64>>;
+
+}  // namespace bustub
@@ -9,10 +9,13 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 #include <sstream>
 
 #include "common/exception.h"
+#include "common/macros.h"
 #include "storage/page/b_plus_tree_internal_page.h"
 
 namespace bustub {
@@ -21,38 +24,149 @@ namespace bustub {
  *****************************************************************************/
 /*
  * Init method after creating a new internal page
- * Including set page type, set current size, set page id, set parent id and set
- * max page size
+ * Including set page type, set current size, set page id, set parent id, set
+ * next and buffer page ids, set max page size and set the key range of the page
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Init(page_id_t page_id, page_id_t parent_id, int max_size) {}
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Init(page_id_t page_id, page_id_t parent_id, int max_size,
+                                          const KeyType *low_fence, const KeyType *high_fence) {
+  static_assert(sizeof(BPlusTreeInternalPage) == INTERNAL_PAGE_HEADER_SIZE, "internal page header size mismatch");
+  SetPageType(IndexPageType::INTERNAL_PAGE);
+  SetPageId(page_id);
+  SetParentPageId(parent_id);
+  SetNextPageId(INVALID_PAGE_ID);
+  SetBufferPageId(INVALID_PAGE_ID);
+  SetMaxSize(max_size);
+  SetLSN();
+  InitEntries(INTERNAL_PAGE_HEADER_SIZE, sizeof(KeyType), sizeof(ValueType));
+  ResetEntries(reinterpret_cast<const char *>(low_fence), reinterpret_cast<const char *>(high_fence));
+}
+/**
+ * Helper methods to set/get next and buffer page ids
+ */
+INDEX_TEMPLATE_ARGUMENTS
+page_id_t B_PLUS_TREE_INTERNAL_PAGE_TYPE::GetNextPageId() const { return next_page_id_; }
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::SetNextPageId(page_id_t next_page_id) { next_page_id_ = next_page_id; }
+
+INDEX_TEMPLATE_ARGUMENTS
+page_id_t B_PLUS_TREE_INTERNAL_PAGE_TYPE::GetBufferPageId() const { return buffer_page_id_; }
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::SetBufferPageId(page_id_t buffer_page_id) { buffer_page_id_ = buffer_page_id; }
+
 /*
  * Helper method to get/set the key associated with input "index"(a.k.a
  * array offset)
+ * The key at index 0 is the low fence of the page, or an empty key if it is unbounded, and cannot be set.
  */
 INDEX_TEMPLATE_ARGUMENTS
 KeyType B_PLUS_TREE_INTERNAL_PAGE_TYPE::KeyAt(int index) const {
-  // replace with your own code
   KeyType key{};
+  if (index == 0) {
+    if (GetLowFence() != nullptr) {
+      key = *GetLowFence();
+    }
+  } else {
+    KeyDataAt(index, reinterpret_cast<char *>(&key));
+  }
   return key;
 }
 
+/*
+ * The key is replaced by removing and inserting the entry, so the page must have room for it
+ */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_INTERNAL_PAGE_TYPE::SetKeyAt(int index, const KeyType &key) {}
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::SetKeyAt(int index, const KeyType &key) {
+  BUSTUB_ASSERT(index > 0, "the first key of an internal page is not stored");
+  ValueType value = ValueAt(index);
+  RemoveEntryAt(index);
+  InsertEntryAt(index, reinterpret_cast<const char *>(&key), reinterpret_cast<const char *>(&value));
+}
 
 /*
  * Helper method to find and return array index(or offset), so that its value
  * equals to input "value"
  */
 INDEX_TEMPLATE_ARGUMENTS
-int B_PLUS_TREE_INTERNAL_PAGE_TYPE::ValueIndex(const ValueType &value) const { return 0; }
+int B_PLUS_TREE_INTERNAL_PAGE_TYPE::ValueIndex(const ValueType &value) const {
+  for (int i = 0; i < GetSize(); i++) {
+    if (ValueAt(i) == value) {
+      return i;
+    }
+  }
+  return -1;
+}
 
 /*
  * Helper method to get the value associated with input "index"(a.k.a array
  * offset)
  */
 INDEX_TEMPLATE_ARGUMENTS
-ValueType B_PLUS_TREE_INTERNAL_PAGE_TYPE::ValueAt(int index) const { return 0; }
+ValueType B_PLUS_TREE_INTERNAL_PAGE_TYPE::ValueAt(int index) const {
+  ValueType value;
+  memcpy(reinterpret_cast<char *>(&value), ValueDataAt(index), sizeof(ValueType));
+  return value;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::SetValueAt(int index, const ValueType &value) {
+  SetValueDataAt(index, reinterpret_cast<const char *>(&value));
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+const KeyType *B_PLUS_TREE_INTERNAL_PAGE_TYPE::GetLowFence() const {
+  return reinterpret_cast<const KeyType *>(LowFenceData());
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+const KeyType *B_PLUS_TREE_INTERNAL_PAGE_TYPE::GetHighFence() const {
+  return reinterpret_cast<const KeyType *>(HighFenceData());
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool B_PLUS_TREE_INTERNAL_PAGE_TYPE::HasRoomFor(const KeyType &key) const {
+  return GetFreeSpace() >= EntrySpace(reinterpret_cast<const char *>(&key));
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+std::vector<MappingType> B_PLUS_TREE_INTERNAL_PAGE_TYPE::GetItems() const {
+  std::vector<MappingType> items;
+  items.reserve(GetSize());
+  for (int i = 0; i < GetSize(); i++) {
+    items.emplace_back(KeyAt(i), ValueAt(i));
+  }
+  return items;
+}
+
+/*
+ * Whether the children fit into a page that covers [low_fence, high_fence), which decides the prefix their keys share
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool B_PLUS_TREE_INTERNAL_PAGE_TYPE::Fits(const std::vector<MappingType> &items, const KeyType *low_fence,
+                                          const KeyType *high_fence) const {
+  if (static_cast<int>(items.size()) > GetMaxSize()) {
+    return false;
+  }
+  int prefix_size = CommonPrefixSize(reinterpret_cast<const char *>(low_fence),
+                                     reinterpret_cast<const char *>(high_fence), sizeof(KeyType));
+  int space = 0;
+  for (size_t i = 0; i < items.size(); i++) {
+    const char *key = i == 0 ? nullptr : reinterpret_cast<const char *>(&items[i].first);
+    space += EntrySpace(key, sizeof(KeyType), sizeof(ValueType), prefix_size);
+  }
+  return space <= GetCapacity();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Rebuild(const KeyType *low_fence, const KeyType *high_fence,
+                                             const MappingType *items, int size) {
+  ResetEntries(reinterpret_cast<const char *>(low_fence), reinterpret_cast<const char *>(high_fence));
+  for (int i = 0; i < size; i++) {
+    Append(items[i].first, items[i].second);
+  }
+}
 
 /*****************************************************************************
  * LOOKUP
@@ -60,11 +174,20 @@ ValueType B_PLUS_TREE_INTERNAL_PAGE_TYPE::ValueAt(int index) const { return 0; }
 /*
  * Find and return the child pointer(page_id) which points to the child page
  * that contains input "key"
- * Start the search from the second key(the first key should always be invalid)
+ * Start the search from the second key(the first key is not stored)
  */
 INDEX_TEMPLATE_ARGUMENTS
 ValueType B_PLUS_TREE_INTERNAL_PAGE_TYPE::Lookup(const KeyType &key, const KeyComparator &comparator) const {
-  return INVALID_PAGE_ID;
+  // binary search for the first key(i) > key; the child to follow is the one before it
+  return ValueAt(SearchEntries(reinterpret_cast<const char *>(&key), 1, true) - 1);
+}
+
+/*
+ * Like Lookup(), but a key equal to a separator goes to the child left of it, which holds the keys just below
+ */
+INDEX_TEMPLATE_ARGUMENTS
+ValueType B_PLUS_TREE_INTERNAL_PAGE_TYPE::LookupBefore(const KeyType &key, const KeyComparator &comparator) const {
+  return ValueAt(SearchEntries(reinterpret_cast<const char *>(&key), 1, false) - 1);
 }
 
 /*****************************************************************************
@@ -78,16 +201,40 @@ ValueType B_PLUS_TREE_INTERNAL_PAGE_TYPE::Lookup(const KeyType &key, const KeyCo
  */
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::PopulateNewRoot(const ValueType &old_value, const KeyType &new_key,
-                                                     const ValueType &new_value) {}
+                                                     const ValueType &new_value) {
+  ResetEntries(LowFenceData(), HighFenceData());
+  Append(KeyType{}, old_value);
+  Append(new_key, new_value);
+}
 /*
  * Insert new_key & new_value pair right after the pair with its value ==
- * old_value
+ * old_value; the page must have room for the key (see HasRoomFor())
  * @return:  new size after insertion
  */
 INDEX_TEMPLATE_ARGUMENTS
 int B_PLUS_TREE_INTERNAL_PAGE_TYPE::InsertNodeAfter(const ValueType &old_value, const KeyType &new_key,
                                                     const ValueType &new_value) {
-  return 0;
+  int index = ValueIndex(old_value) + 1;
+  InsertEntryAt(index, reinterpret_cast<const char *>(&new_key), reinterpret_cast<const char *>(&new_value));
+  return GetSize();
+}
+
+/*
+ * Insert new_key & new_value pair before the first key greater than new_key; the page must have room for the key
+ * @return:  new size after insertion
+ */
+INDEX_TEMPLATE_ARGUMENTS
+int B_PLUS_TREE_INTERNAL_PAGE_TYPE::InsertNode(const KeyType &new_key, const ValueType &new_value,
+                                               const KeyComparator &comparator) {
+  int index = SearchEntries(reinterpret_cast<const char *>(&new_key), 1, true);
+  InsertEntryAt(index, reinterpret_cast<const char *>(&new_key), reinterpret_cast<const char *>(&new_value));
+  return GetSize();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Append(const KeyType &key, const ValueType &value) {
+  const char *key_data = GetSize() == 0 ? nullptr : reinterpret_cast<const char *>(&key);
+  InsertEntryAt(GetSize(), key_data, reinterpret_cast<const char *>(&value));
 }
 
 /*****************************************************************************
@@ -95,17 +242,31 @@ int B_PLUS_TREE_INTERNAL_PAGE_TYPE::InsertNodeAfter(const ValueType &old_value,
  *****************************************************************************/
 /*
  * Remove half of key & value pairs from this page to "recipient" page
+ * A page with too many children is split in half by count, and one that is full in bytes in half by space. The
+ * recipient's first key is the separator that moves up into the parent, and becomes its low fence.
  */
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveHalfTo(BPlusTreeInternalPage *recipient,
-                                                BufferPoolManager *buffer_pool_manager) {}
-
-/* Copy entries into me, starting from {items} and copy {size} entries.
- * Since it is an internal page, for all entries (pages) moved, their parents page now changes to me.
- * So I need to 'adopt' them by changing their parent page id, which needs to be persisted with BufferPoolManger
- */
-INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyNFrom(MappingType *items, int size, BufferPoolManager *buffer_pool_manager) {}
+                                                BufferPoolManager *buffer_pool_manager) {
+  std::vector<MappingType> items = GetItems();
+  int size = GetSize();
+  int keep = size / 2;
+  if (size <= GetMaxSize()) {
+    int space = 0;
+    keep = 0;
+    while (keep < size - 1 && 2 * space < GetUsedSpace()) {
+      space += EntrySpace(keep == 0 ? nullptr : reinterpret_cast<const char *>(&items[keep].first));
+      keep++;
+    }
+    keep = std::max(keep, 1);
+  }
+  KeyType separator = items[keep].first;
+  recipient->Rebuild(&separator, GetHighFence(), items.data() + keep, size - keep);
+  for (int i = keep; i < size && buffer_pool_manager != nullptr; i++) {
+    recipient->Adopt(items[i].second, buffer_pool_manager);
+  }
+  Rebuild(GetLowFence(), &separator, items.data(), keep);
+}
 
 /*****************************************************************************
  * REMOVE
@@ -113,20 +274,43 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyNFrom(MappingType *items, int size, Buf
 /*
  * Remove the key & value pair in internal page according to input index(a.k.a
  * array offset)
- * NOTE: store key&value pair continuously after deletion
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Remove(int index) {}
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Remove(int index) {
+  BUSTUB_ASSERT(index > 0, "the first child of an internal page is removed with its page");
+  RemoveEntryAt(index);
+}
 
 /*
  * Remove the only key & value pair in internal page and return the value
  * NOTE: only call this method within AdjustRoot()(in b_plus_tree.cpp)
  */
 INDEX_TEMPLATE_ARGUMENTS
-ValueType B_PLUS_TREE_INTERNAL_PAGE_TYPE::RemoveAndReturnOnlyChild() { return INVALID_PAGE_ID; }
+ValueType B_PLUS_TREE_INTERNAL_PAGE_TYPE::RemoveAndReturnOnlyChild() {
+  ValueType only_child = ValueAt(0);
+  RemoveEntryAt(0);
+  return only_child;
+}
 /*****************************************************************************
  * MERGE
  *****************************************************************************/
+/*
+ * Whether all of my children fit into the recipient, my left sibling, together with the middle key between us. The
+ * wider key range may have a shorter prefix, so the recipient's own keys can grow.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool B_PLUS_TREE_INTERNAL_PAGE_TYPE::CanMoveAllTo(const BPlusTreeInternalPage *recipient,
+                                                  const KeyType &middle_key) const {
+  if (recipient->GetSize() + GetSize() > GetMaxSize()) {
+    return false;
+  }
+  std::vector<MappingType> items = recipient->GetItems();
+  std::vector<MappingType> my_items = GetItems();
+  my_items[0].first = middle_key;
+  items.insert(items.end(), my_items.begin(), my_items.end());
+  return Fits(items, recipient->GetLowFence(), GetHighFence());
+}
+
 /*
  * Remove all of key & value pairs from this page to "recipient" page.
  * The middle_key is the separation key you should get from the parent. You need
@@ -136,47 +320,94 @@ ValueType B_PLUS_TREE_INTERNAL_PAGE_TYPE::RemoveAndReturnOnlyChild() { return IN
  */
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveAllTo(BPlusTreeInternalPage *recipient, const KeyType &middle_key,
-                                               BufferPoolManager *buffer_pool_manager) {}
+                                               BufferPoolManager *buffer_pool_manager) {
+  std::vector<MappingType> items = recipient->GetItems();
+  std::vector<MappingType> my_items = GetItems();
+  my_items[0].first = middle_key;
+  items.insert(items.end(), my_items.begin(), my_items.end());
+  recipient->Rebuild(recipient->GetLowFence(), GetHighFence(), items.data(), items.size());
+  for (const auto &item : my_items) {
+    recipient->Adopt(item.second, buffer_pool_manager);
+  }
+  recipient->SetNextPageId(GetNextPageId());
+  SetNextPageId(INVALID_PAGE_ID);
+  ResetEntries(nullptr, nullptr);
+}
 
 /*****************************************************************************
  * REDISTRIBUTE
  *****************************************************************************/
 /*
- * Remove the first key & value pair from this page to tail of "recipient" page.
+ * Remove the first key & value pair from this page to tail of "recipient" page, my left sibling.
  *
- * The middle_key is the separation key you should get from the parent. You need
- * to make sure the middle key is added to the recipient to maintain the invariant.
+ * The middle_key is the separation key you should get from the parent. It becomes the key of the moved child, and
+ * my second key becomes the new separation key, which the caller picks up as my low fence.
  * You also need to use BufferPoolManager to persist changes to the parent page id for those
  * pages that are moved to the recipient
+ * @return false, without moving anything, if I would be left with no key or the child does not fit into the recipient
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveFirstToEndOf(BPlusTreeInternalPage *recipient, const KeyType &middle_key,
-                                                      BufferPoolManager *buffer_pool_manager) {}
-
-/* Append an entry at the end.
- * Since it is an internal page, the moved entry(page)'s parent needs to be updated.
- * So I need to 'adopt' it by changing its parent page id, which needs to be persisted with BufferPoolManger
- */
-INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyLastFrom(const MappingType &pair, BufferPoolManager *buffer_pool_manager) {}
+bool B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveFirstToEndOf(BPlusTreeInternalPage *recipient, const KeyType &middle_key,
+                                                      BufferPoolManager *buffer_pool_manager) {
+  if (GetSize() < 3) {
+    return false;
+  }
+  std::vector<MappingType> items = GetItems();
+  KeyType separator = items[1].first;
+  std::vector<MappingType> recipient_items = recipient->GetItems();
+  recipient_items.emplace_back(middle_key, items[0].second);
+  if (!Fits(recipient_items, recipient->GetLowFence(), &separator)) {
+    return false;
+  }
+  recipient->Rebuild(recipient->GetLowFence(), &separator, recipient_items.data(), recipient_items.size());
+  recipient->Adopt(items[0].second, buffer_pool_manager);
+  Rebuild(&separator, GetHighFence(), items.data() + 1, items.size() - 1);
+  return true;
+}
 
 /*
- * Remove the last key & value pair from this page to head of "recipient" page.
- * You need to handle the original dummy key properly, e.g. updating recipient’s array to position the middle_key at the
- * right place.
+ * Remove the last key & value pair from this page to head of "recipient" page, my right sibling.
+ * The middle_key becomes the key of the recipient's old first child, and my last key the new separation key, which
+ * the caller picks up as the recipient's low fence.
  * You also need to use BufferPoolManager to persist changes to the parent page id for those pages that are
  * moved to the recipient
+ * @return false, without moving anything, if I would be left with no key or the child does not fit into the recipient
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveLastToFrontOf(BPlusTreeInternalPage *recipient, const KeyType &middle_key,
-                                                       BufferPoolManager *buffer_pool_manager) {}
+bool B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveLastToFrontOf(BPlusTreeInternalPage *recipient, const KeyType &middle_key,
+                                                       BufferPoolManager *buffer_pool_manager) {
+  int size = GetSize();
+  if (size < 3) {
+    return false;
+  }
+  std::vector<MappingType> items = GetItems();
+  KeyType separator = items[size - 1].first;
+  std::vector<MappingType> recipient_items = recipient->GetItems();
+  recipient_items[0].first = middle_key;
+  recipient_items.insert(recipient_items.begin(), items[size - 1]);
+  if (!Fits(recipient_items, &separator, recipient->GetHighFence())) {
+    return false;
+  }
+  recipient->Rebuild(&separator, recipient->GetHighFence(), recipient_items.data(), recipient_items.size());
+  recipient->Adopt(items[size - 1].second, buffer_pool_manager);
+  Rebuild(GetLowFence(), &separator, items.data(), size - 1);
+  return true;
+}
 
-/* Append an entry at the beginning.
- * Since it is an internal page, the moved entry(page)'s parent needs to be updated.
- * So I need to 'adopt' it by changing its parent page id, which needs to be persisted with BufferPoolManger
+/*
+ * Point the parent page id of a child that moved into this page at me.
+ * Parent page ids are only read by writers that hold the latch of the parent itself, so the child is updated without
+ * taking its latch (the writer may well hold it already).
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyFirstFrom(const MappingType &pair, BufferPoolManager *buffer_pool_manager) {}
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Adopt(const ValueType &child, BufferPoolManager *buffer_pool_manager) {
+  Page *page = buffer_pool_manager->FetchPage(child);
+  if (page == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "BPlusTreeInternalPage: cannot fetch child page");
+  }
+  reinterpret_cast<BPlusTreePage *>(page->GetData())->SetParentPageId(GetPageId());
+  buffer_pool_manager->UnpinPage(child, true);
+}
 
 // valuetype for internalNode should be page id_t
 template class BPlusTreeInternalPage<GenericKey<4>, page_id_t, GenericComparator<4>>;
@@ -9,10 +9,13 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
+#include <cstring>
 #include <sstream>
 
 #include "common/exception.h"
 #include "common/rid.h"
+#include "storage/index/posting_list.h"
 #include "storage/page/b_plus_tree_leaf_page.h"
 
 namespace bustub {
@@ -24,26 +27,59 @@ namespace bustub {
 /**
  * Init method after creating a new leaf page
  * Including set page type, set current size to zero, set page id/parent id, set
- * next page id and set max size
+ * next/prev page id, set max size and set the key range of the page
+ * A non-unique leaf stores posting lists as variable-size values of up to PostingList::MAX_INLINE_SIZE bytes.
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::Init(page_id_t page_id, page_id_t parent_id, int max_size) {}
+void B_PLUS_TREE_LEAF_PAGE_TYPE::Init(page_id_t page_id, page_id_t parent_id, int max_size, const KeyType *low_fence,
+                                      const KeyType *high_fence, bool unique) {
+  static_assert(sizeof(BPlusTreeLeafPage) == LEAF_PAGE_HEADER_SIZE, "leaf page header size mismatch");
+  SetPageType(IndexPageType::LEAF_PAGE);
+  SetPageId(page_id);
+  SetParentPageId(parent_id);
+  SetNextPageId(INVALID_PAGE_ID);
+  SetPrevPageId(INVALID_PAGE_ID);
+  SetMaxSize(max_size);
+  SetLSN();
+  if (unique) {
+    InitEntries(LEAF_PAGE_HEADER_SIZE, sizeof(KeyType), sizeof(ValueType));
+  } else {
+    InitEntries(LEAF_PAGE_HEADER_SIZE, sizeof(KeyType), PostingList::MAX_INLINE_SIZE, true);
+  }
+  ResetEntries(reinterpret_cast<const char *>(low_fence), reinterpret_cast<const char *>(high_fence));
+}
 
 /**
- * Helper methods to set/get next page id
+ * Helper methods to set/get next/prev page id
  */
 INDEX_TEMPLATE_ARGUMENTS
-page_id_t B_PLUS_TREE_LEAF_PAGE_TYPE::GetNextPageId() const { return INVALID_PAGE_ID; }
+page_id_t B_PLUS_TREE_LEAF_PAGE_TYPE::GetNextPageId() const { return next_page_id_; }
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_LEAF_PAGE_TYPE::SetNextPageId(page_id_t next_page_id) { next_page_id_ = next_page_id; }
+
+INDEX_TEMPLATE_ARGUMENTS
+page_id_t B_PLUS_TREE_LEAF_PAGE_TYPE::GetPrevPageId() const { return prev_page_id_; }
 
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::SetNextPageId(page_id_t next_page_id) {}
+void B_PLUS_TREE_LEAF_PAGE_TYPE::SetPrevPageId(page_id_t prev_page_id) { prev_page_id_ = prev_page_id; }
 
 /**
  * Helper method to find the first index i so that array[i].first >= key
  * NOTE: This method is only used when generating index iterator
  */
 INDEX_TEMPLATE_ARGUMENTS
-int B_PLUS_TREE_LEAF_PAGE_TYPE::KeyIndex(const KeyType &key, const KeyComparator &comparator) const { return 0; }
+int B_PLUS_TREE_LEAF_PAGE_TYPE::KeyIndex(const KeyType &key, const KeyComparator &comparator) const {
+  return SearchEntries(reinterpret_cast<const char *>(&key), 0, false);
+}
+
+/**
+ * Helper method to find the first index i so that array[i].first > key
+ */
+INDEX_TEMPLATE_ARGUMENTS
+int B_PLUS_TREE_LEAF_PAGE_TYPE::UpperKeyIndex(const KeyType &key, const KeyComparator &comparator) const {
+  return SearchEntries(reinterpret_cast<const char *>(&key), 0, true);
+}
 
 /*
  * Helper method to find and return the key associated with input "index"(a.k.a
@@ -51,31 +87,137 @@ int B_PLUS_TREE_LEAF_PAGE_TYPE::KeyIndex(const KeyType &key, const KeyComparator
  */
 INDEX_TEMPLATE_ARGUMENTS
 KeyType B_PLUS_TREE_LEAF_PAGE_TYPE::KeyAt(int index) const {
-  // replace with your own code
-  KeyType key{};
+  KeyType key;
+  KeyDataAt(index, reinterpret_cast<char *>(&key));
   return key;
 }
 
+INDEX_TEMPLATE_ARGUMENTS
+ValueType B_PLUS_TREE_LEAF_PAGE_TYPE::ValueAt(int index) const {
+  ValueType value;
+  memcpy(reinterpret_cast<char *>(&value), ValueDataAt(index), sizeof(ValueType));
+  return value;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_LEAF_PAGE_TYPE::SetValueAt(int index, const ValueType &value) {
+  SetValueDataAt(index, reinterpret_cast<const char *>(&value));
+}
+
 /*
  * Helper method to find and return the key & value pair associated with input
  * "index"(a.k.a array offset)
  */
 INDEX_TEMPLATE_ARGUMENTS
-const MappingType &B_PLUS_TREE_LEAF_PAGE_TYPE::GetItem(int index) {
-  // replace with your own code
-  return array_[0];
+MappingType B_PLUS_TREE_LEAF_PAGE_TYPE::GetItem(int index) const { return {KeyAt(index), ValueAt(index)}; }
+
+INDEX_TEMPLATE_ARGUMENTS
+const KeyType *B_PLUS_TREE_LEAF_PAGE_TYPE::GetLowFence() const {
+  return reinterpret_cast<const KeyType *>(LowFenceData());
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+const KeyType *B_PLUS_TREE_LEAF_PAGE_TYPE::GetHighFence() const {
+  return reinterpret_cast<const KeyType *>(HighFenceData());
+}
+
+/*
+ * A key that is in a non-unique leaf already needs room for its posting list to grow, which is less than the room
+ * for a new key with a list of a single value
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool B_PLUS_TREE_LEAF_PAGE_TYPE::HasRoomFor(const KeyType &key) const {
+  if (IsUnique()) {
+    return GetFreeSpace() >= EntrySpace(reinterpret_cast<const char *>(&key));
+  }
+  return GetFreeSpace() >= EntrySpace(reinterpret_cast<const char *>(&key), PostingList::MAX_SINGLE_SIZE);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool B_PLUS_TREE_LEAF_PAGE_TYPE::IsUnique() const { return !HasVariableValues(); }
+
+/*
+ * @return the index of the key, or -1 if it is not in the page
+ */
+INDEX_TEMPLATE_ARGUMENTS
+int B_PLUS_TREE_LEAF_PAGE_TYPE::Find(const KeyType &key, const KeyComparator &comparator) const {
+  int index = KeyIndex(key, comparator);
+  return EntryMatches(index, reinterpret_cast<const char *>(&key)) ? index : -1;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+std::string B_PLUS_TREE_LEAF_PAGE_TYPE::PostingAt(int index) const {
+  return std::string(ValueDataAt(index), ValueSizeAt(index));
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_LEAF_PAGE_TYPE::SetPostingAt(int index, const std::string &posting) {
+  SetValueDataAt(index, posting.data(), static_cast<int>(posting.size()));
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+std::vector<typename B_PLUS_TREE_LEAF_PAGE_TYPE::Entry> B_PLUS_TREE_LEAF_PAGE_TYPE::GetEntries() const {
+  std::vector<Entry> entries;
+  entries.reserve(GetSize());
+  for (int i = 0; i < GetSize(); i++) {
+    entries.emplace_back(KeyAt(i), std::string(ValueDataAt(i), ValueSizeAt(i)));
+  }
+  return entries;
+}
+
+/*
+ * Whether the entries fit into a leaf that covers [low_fence, high_fence), which decides the prefix they share
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool B_PLUS_TREE_LEAF_PAGE_TYPE::Fits(const std::vector<Entry> &entries, const KeyType *low_fence,
+                                      const KeyType *high_fence) const {
+  if (static_cast<int>(entries.size()) >= GetMaxSize()) {
+    return false;
+  }
+  int prefix_size = CommonPrefixSize(reinterpret_cast<const char *>(low_fence),
+                                     reinterpret_cast<const char *>(high_fence), sizeof(KeyType));
+  int size_size = IsUnique() ? 0 : 1;
+  int space = 0;
+  for (const auto &entry : entries) {
+    space += EntrySpace(reinterpret_cast<const char *>(&entry.first), sizeof(KeyType),
+                        static_cast<int>(entry.second.size()) + size_size, prefix_size);
+  }
+  return space <= GetCapacity();
+}
+
+/*
+ * Replace all entries of the page, and its key range
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_LEAF_PAGE_TYPE::Rebuild(const KeyType *low_fence, const KeyType *high_fence, const Entry *entries,
+                                         int size) {
+  ResetEntries(reinterpret_cast<const char *>(low_fence), reinterpret_cast<const char *>(high_fence));
+  for (int i = 0; i < size; i++) {
+    InsertEntryAt(GetSize(), reinterpret_cast<const char *>(&entries[i].first), entries[i].second.data(),
+                  static_cast<int>(entries[i].second.size()));
+  }
 }
 
 /*****************************************************************************
  * INSERTION
  *****************************************************************************/
 /*
- * Insert key & value pair into leaf page ordered by key
+ * Insert key & value pair into leaf page ordered by key; the key must fit (see HasRoomFor())
  * @return  page size after insertion
  */
 INDEX_TEMPLATE_ARGUMENTS
 int B_PLUS_TREE_LEAF_PAGE_TYPE::Insert(const KeyType &key, const ValueType &value, const KeyComparator &comparator) {
-  return 0;
+  int index = KeyIndex(key, comparator);
+  if (EntryMatches(index, reinterpret_cast<const char *>(&key))) {
+    return GetSize();
+  }
+  if (IsUnique()) {
+    InsertEntryAt(index, reinterpret_cast<const char *>(&key), reinterpret_cast<const char *>(&value));
+  } else {
+    std::string posting = PostingList::Make(value);
+    InsertEntryAt(index, reinterpret_cast<const char *>(&key), posting.data(), static_cast<int>(posting.size()));
+  }
+  return GetSize();
 }
 
 /*****************************************************************************
@@ -83,15 +225,49 @@ int B_PLUS_TREE_LEAF_PAGE_TYPE::Insert(const KeyType &key, const ValueType &valu
  *****************************************************************************/
 /*
  * Remove half of key & value pairs from this page to "recipient" page
+ * A leaf that is full in entries is split in half by count, and one that is full in bytes in half by space. The two
+ * leaves are then rebuilt around the shortest separator between them, which becomes the low fence of the recipient.
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveHalfTo(BPlusTreeLeafPage *recipient) {}
+void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveHalfTo(BPlusTreeLeafPage *recipient) {
+  std::vector<Entry> items = GetEntries();
+  int size = GetSize();
+  int keep = size / 2;
+  if (size < GetMaxSize()) {
+    int space = 0;
+    keep = 0;
+    while (keep < size - 1 && 2 * space < GetUsedSpace()) {
+      space +=
+          EntrySpace(reinterpret_cast<const char *>(&items[keep].first), static_cast<int>(items[keep].second.size()));
+      keep++;
+    }
+    keep = std::max(keep, 1);
+  }
+  KeyType separator;
+  SeparatorBetween(reinterpret_cast<const char *>(&items[keep - 1].first),
+                   reinterpret_cast<const char *>(&items[keep].first), sizeof(KeyType),
+                   reinterpret_cast<char *>(&separator));
+  recipient->Rebuild(&separator, GetHighFence(), items.data() + keep, size - keep);
+  Rebuild(GetLowFence(), &separator, items.data(), keep);
+}
 
 /*
  * Copy starting from items, and copy {size} number of elements into me.
+ * The keys must be distinct, also in a non-unique leaf.
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::CopyNFrom(MappingType *items, int size) {}
+void B_PLUS_TREE_LEAF_PAGE_TYPE::CopyNFrom(const MappingType *items, int size) {
+  for (int i = 0; i < size; i++) {
+    if (IsUnique()) {
+      InsertEntryAt(GetSize(), reinterpret_cast<const char *>(&items[i].first),
+                    reinterpret_cast<const char *>(&items[i].second));
+    } else {
+      std::string posting = PostingList::Make(items[i].second);
+      InsertEntryAt(GetSize(), reinterpret_cast<const char *>(&items[i].first), posting.data(),
+                    static_cast<int>(posting.size()));
+    }
+  }
+}
 
 /*****************************************************************************
  * LOOKUP
@@ -103,7 +279,12 @@ void B_PLUS_TREE_LEAF_PAGE_TYPE::CopyNFrom(MappingType *items, int size) {}
  */
 INDEX_TEMPLATE_ARGUMENTS
 bool B_PLUS_TREE_LEAF_PAGE_TYPE::Lookup(const KeyType &key, ValueType *value, const KeyComparator &comparator) const {
-  return false;
+  int index = KeyIndex(key, comparator);
+  if (!EntryMatches(index, reinterpret_cast<const char *>(&key))) {
+    return false;
+  }
+  *value = ValueAt(index);
+  return true;
 }
 
 /*****************************************************************************
@@ -112,48 +293,105 @@ bool B_PLUS_TREE_LEAF_PAGE_TYPE::Lookup(const KeyType &key, ValueType *value, co
 /*
  * First look through leaf page to see whether delete key exist or not. If
  * exist, perform deletion, otherwise return immediately.
- * NOTE: store key&value pair continuously after deletion
  * @return   page size after deletion
  */
 INDEX_TEMPLATE_ARGUMENTS
-int B_PLUS_TREE_LEAF_PAGE_TYPE::RemoveAndDeleteRecord(const KeyType &key, const KeyComparator &comparator) { return 0; }
+int B_PLUS_TREE_LEAF_PAGE_TYPE::RemoveAndDeleteRecord(const KeyType &key, const KeyComparator &comparator) {
+  int index = KeyIndex(key, comparator);
+  if (!EntryMatches(index, reinterpret_cast<const char *>(&key))) {
+    return GetSize();
+  }
+  RemoveEntryAt(index);
+  return GetSize();
+}
 
 /*****************************************************************************
  * MERGE
  *****************************************************************************/
 /*
- * Remove all of key & value pairs from this page to "recipient" page. Don't forget
- * to update the next_page id in the sibling page
- */
-INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveAllTo(BPlusTreeLeafPage *recipient) {}
-
-/*****************************************************************************
- * REDISTRIBUTE
- *****************************************************************************/
-/*
- * Remove the first key & value pair from this page to "recipient" page.
+ * Whether all of my pairs fit into the recipient, my left sibling, once it covers my key range as well. The wider
+ * range may have a shorter prefix, so the recipient's own pairs can grow.
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveFirstToEndOf(BPlusTreeLeafPage *recipient) {}
+bool B_PLUS_TREE_LEAF_PAGE_TYPE::CanMoveAllTo(const BPlusTreeLeafPage *recipient) const {
+  if (recipient->GetSize() + GetSize() >= GetMaxSize()) {
+    return false;
+  }
+  std::vector<Entry> items = recipient->GetEntries();
+  std::vector<Entry> my_items = GetEntries();
+  items.insert(items.end(), my_items.begin(), my_items.end());
+  return Fits(items, recipient->GetLowFence(), GetHighFence());
+}
 
 /*
- * Copy the item into the end of my item list. (Append item to my array)
+ * Remove all of key & value pairs from this page to "recipient" page. Don't forget
+ * to update the next_page id in the sibling page. The page is left without fences or links, so that iterators that
+ * still hold its id as a hint see that it is gone.
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::CopyLastFrom(const MappingType &item) {}
+void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveAllTo(BPlusTreeLeafPage *recipient) {
+  std::vector<Entry> items = recipient->GetEntries();
+  std::vector<Entry> my_items = GetEntries();
+  items.insert(items.end(), my_items.begin(), my_items.end());
+  recipient->Rebuild(recipient->GetLowFence(), GetHighFence(), items.data(), items.size());
+  recipient->SetNextPageId(GetNextPageId());
+  SetNextPageId(INVALID_PAGE_ID);
+  SetPrevPageId(INVALID_PAGE_ID);
+  ResetEntries(nullptr, nullptr);
+}
 
+/*****************************************************************************
+ * REDISTRIBUTE
+ *****************************************************************************/
 /*
- * Remove the last key & value pair from this page to "recipient" page.
+ * Remove the first key & value pair from this page to "recipient" page, my left sibling, and move the separator
+ * between us to the shortest one after the moved pair.
+ * @return false, without moving anything, if I would be left empty or the pair does not fit into the recipient
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveLastToFrontOf(BPlusTreeLeafPage *recipient) {}
+bool B_PLUS_TREE_LEAF_PAGE_TYPE::MoveFirstToEndOf(BPlusTreeLeafPage *recipient) {
+  if (GetSize() < 2) {
+    return false;
+  }
+  std::vector<Entry> items = GetEntries();
+  KeyType separator;
+  SeparatorBetween(reinterpret_cast<const char *>(&items[0].first), reinterpret_cast<const char *>(&items[1].first),
+                   sizeof(KeyType), reinterpret_cast<char *>(&separator));
+  std::vector<Entry> recipient_items = recipient->GetEntries();
+  recipient_items.push_back(items[0]);
+  if (!Fits(recipient_items, recipient->GetLowFence(), &separator)) {
+    return false;
+  }
+  recipient->Rebuild(recipient->GetLowFence(), &separator, recipient_items.data(), recipient_items.size());
+  Rebuild(&separator, GetHighFence(), items.data() + 1, items.size() - 1);
+  return true;
+}
 
 /*
- * Insert item at the front of my items. Move items accordingly.
+ * Remove the last key & value pair from this page to "recipient" page, my right sibling, and move the separator
+ * between us to the shortest one before the moved pair.
+ * @return false, without moving anything, if I would be left empty or the pair does not fit into the recipient
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::CopyFirstFrom(const MappingType &item) {}
+bool B_PLUS_TREE_LEAF_PAGE_TYPE::MoveLastToFrontOf(BPlusTreeLeafPage *recipient) {
+  int size = GetSize();
+  if (size < 2) {
+    return false;
+  }
+  std::vector<Entry> items = GetEntries();
+  KeyType separator;
+  SeparatorBetween(reinterpret_cast<const char *>(&items[size - 2].first),
+                   reinterpret_cast<const char *>(&items[size - 1].first), sizeof(KeyType),
+                   reinterpret_cast<char *>(&separator));
+  std::vector<Entry> recipient_items = recipient->GetEntries();
+  recipient_items.insert(recipient_items.begin(), items[size - 1]);
+  if (!Fits(recipient_items, &separator, recipient->GetHighFence())) {
+    return false;
+  }
+  recipient->Rebuild(&separator, recipient->GetHighFence(), recipient_items.data(), recipient_items.size());
+  Rebuild(GetLowFence(), &separator, items.data(), size - 1);
+  return true;
+}
 
 template class BPlusTreeLeafPage<GenericKey<4>, RID, GenericComparator<4>>;
 template class BPlusTreeLeafPage<GenericKey<8>, RID, GenericComparator<8>>;
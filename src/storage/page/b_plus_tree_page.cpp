@@ -9,53 +9,387 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
+#include <cstring>
+
+#include "common/macros.h"
 #include "storage/page/b_plus_tree_page.h"
 
 namespace bustub {
 
+namespace {
+
+constexpr uint8_t LOW_FENCE = 1;
+constexpr uint8_t HIGH_FENCE = 2;
+constexpr uint8_t VARIABLE_VALUES = 4;
+
+constexpr uint32_t SLOT_OFFSET_MASK = 0xFFFF;
+constexpr int SLOT_HEAD_SHIFT = 16;
+
+/** @return the length of the key without the zero padding at its end */
+int SignificantSize(const char *key, int key_size) {
+  while (key_size > 0 && key[key_size - 1] == 0) {
+    key_size--;
+  }
+  return key_size;
+}
+
+/**
+ * @return the first index in [first, last) whose slot has a head >= head
+ *
+ * The binary search is branchless: the probe decides where the next one goes by a conditional move instead of a
+ * jump, so there are no mispredictions, and both candidates for the next probe are prefetched while it waits.
+ */
+int LowerBoundHead(const uint32_t *slots, int first, int last, uint32_t head) {
+  if (first >= last) {
+    return first;
+  }
+  const uint32_t *base = slots + first;
+  int n = last - first;
+  while (n > 1) {
+    int half = n / 2;
+    __builtin_prefetch(base + half / 2);
+    __builtin_prefetch(base + half + half / 2);
+    base = (base[half] >> SLOT_HEAD_SHIFT) < head ? base + half : base;
+    n -= half;
+  }
+  return static_cast<int>(base - slots) + ((*base >> SLOT_HEAD_SHIFT) < head ? 1 : 0);
+}
+
+}  // namespace
+
 /*
  * Helper methods to get/set page type
  * Page type enum class is defined in b_plus_tree_page.h
  */
-bool BPlusTreePage::IsLeafPage() const { return false; }
-bool BPlusTreePage::IsRootPage() const { return false; }
-void BPlusTreePage::SetPageType(IndexPageType page_type) {}
+bool BPlusTreePage::IsLeafPage() const { return page_type_ == IndexPageType::LEAF_PAGE; }
+bool BPlusTreePage::IsRootPage() const { return parent_page_id_ == INVALID_PAGE_ID; }
+void BPlusTreePage::SetPageType(IndexPageType page_type) { page_type_ = page_type; }
 
 /*
  * Helper methods to get/set size (number of key/value pairs stored in that
  * page)
  */
-int BPlusTreePage::GetSize() const { return 0; }
-void BPlusTreePage::SetSize(int size) {}
-void BPlusTreePage::IncreaseSize(int amount) {}
+int BPlusTreePage::GetSize() const { return size_; }
+void BPlusTreePage::SetSize(int size) { size_ = size; }
+void BPlusTreePage::IncreaseSize(int amount) { size_ += amount; }
 
 /*
  * Helper methods to get/set max size (capacity) of the page
  */
-int BPlusTreePage::GetMaxSize() const { return 0; }
-void BPlusTreePage::SetMaxSize(int size) {}
+int BPlusTreePage::GetMaxSize() const { return max_size_; }
+void BPlusTreePage::SetMaxSize(int size) { max_size_ = size; }
 
 /*
  * Helper method to get min page size
  * Generally, min page size == max page size / 2
+ * A leaf splits when it reaches max size and an internal page when it exceeds it, keeping the lower half either
+ * way, so both halves of a split are at least min size.
  */
-int BPlusTreePage::GetMinSize() const { return 0; }
+int BPlusTreePage::GetMinSize() const { return IsLeafPage() ? max_size_ / 2 : (max_size_ + 1) / 2; }
 
 /*
  * Helper methods to get/set parent page id
  */
-page_id_t BPlusTreePage::GetParentPageId() const { return 0; }
-void BPlusTreePage::SetParentPageId(page_id_t parent_page_id) {}
+page_id_t BPlusTreePage::GetParentPageId() const { return parent_page_id_; }
+void BPlusTreePage::SetParentPageId(page_id_t parent_page_id) { parent_page_id_ = parent_page_id; }
 
 /*
  * Helper methods to get/set self page id
  */
-page_id_t BPlusTreePage::GetPageId() const { return 0; }
-void BPlusTreePage::SetPageId(page_id_t page_id) {}
+page_id_t BPlusTreePage::GetPageId() const { return page_id_; }
+void BPlusTreePage::SetPageId(page_id_t page_id) { page_id_ = page_id; }
 
 /*
  * Helper methods to set lsn
  */
 void BPlusTreePage::SetLSN(lsn_t lsn) { lsn_ = lsn; }
 
+/*****************************************************************************
+ * ENTRY SPACE
+ *****************************************************************************/
+/*
+ * Helper methods to measure the space of the page in bytes of slots and entries
+ */
+int BPlusTreePage::GetCapacity() const { return EntryAreaSize(data_offset_, key_size_); }
+int BPlusTreePage::GetUsedSpace() const {
+  return size_ * SLOT_SIZE + (PAGE_SIZE - heap_offset_ - garbage_size_);
+}
+int BPlusTreePage::GetFreeSpace() const { return GetCapacity() - GetUsedSpace(); }
+int BPlusTreePage::GetMaxEntrySpace() const {
+  return SLOT_SIZE + 1 + key_size_ + value_size_ + (HasVariableValues() ? 1 : 0);
+}
+
+/*
+ * Short keys let a page hold many more than max size / 2 entries, and long ones fewer, so a page counts as half full
+ * by either measure.
+ */
+bool BPlusTreePage::IsHalfFull() const { return size_ >= GetMinSize() || 2 * GetUsedSpace() >= GetCapacity(); }
+bool BPlusTreePage::IsHalfFullAfterRemove() const {
+  return size_ > GetMinSize() || 2 * (GetUsedSpace() - GetMaxEntrySpace()) >= GetCapacity();
+}
+bool BPlusTreePage::HasRoomForAnyEntry() const { return GetFreeSpace() >= GetMaxEntrySpace(); }
+
+int BPlusTreePage::EntrySpace(const char *key, int key_size, int value_size, int prefix_size) {
+  int suffix_size = key == nullptr ? 0 : std::max(SignificantSize(key, key_size) - prefix_size, 0);
+  return SLOT_SIZE + 1 + suffix_size + value_size;
+}
+
+int BPlusTreePage::CommonPrefixSize(const char *low_fence, const char *high_fence, int key_size) {
+  if (low_fence == nullptr || high_fence == nullptr) {
+    return 0;
+  }
+  int prefix_size = 0;
+  while (prefix_size < key_size && low_fence[prefix_size] == high_fence[prefix_size]) {
+    prefix_size++;
+  }
+  return prefix_size;
+}
+
+int BPlusTreePage::EntrySpace(const char *key) const { return EntrySpace(key, value_size_); }
+
+int BPlusTreePage::EntrySpace(const char *key, int value_size) const {
+  return EntrySpace(key, key_size_, value_size + (HasVariableValues() ? 1 : 0), prefix_size_);
+}
+
+/*****************************************************************************
+ * ENTRIES
+ *****************************************************************************/
+void BPlusTreePage::InitEntries(int header_size, int key_size, int value_size, bool variable_values) {
+  data_offset_ = header_size;
+  key_size_ = key_size;
+  value_size_ = value_size;
+  flags_ = variable_values ? VARIABLE_VALUES : 0;
+  ResetEntries(nullptr, nullptr);
+}
+
+/*
+ * The fences may point into this page, so they are copied before anything is overwritten
+ */
+void BPlusTreePage::ResetEntries(const char *low_fence, const char *high_fence) {
+  char low[UINT8_MAX] = {};
+  char high[UINT8_MAX] = {};
+  if (low_fence != nullptr) {
+    memcpy(low, low_fence, key_size_);
+  }
+  if (high_fence != nullptr) {
+    memcpy(high, high_fence, key_size_);
+  }
+  char *data = reinterpret_cast<char *>(this) + data_offset_;
+  memcpy(data, low, key_size_);
+  memcpy(data + key_size_, high, key_size_);
+  flags_ &= VARIABLE_VALUES;
+  flags_ |= (low_fence != nullptr ? LOW_FENCE : 0) | (high_fence != nullptr ? HIGH_FENCE : 0);
+  prefix_size_ =
+      CommonPrefixSize(low_fence != nullptr ? low : nullptr, high_fence != nullptr ? high : nullptr, key_size_);
+  size_ = 0;
+  heap_offset_ = PAGE_SIZE;
+  garbage_size_ = 0;
+}
+
+const char *BPlusTreePage::LowFenceData() const {
+  return (flags_ & LOW_FENCE) != 0 ? reinterpret_cast<const char *>(this) + data_offset_ : nullptr;
+}
+
+const char *BPlusTreePage::HighFenceData() const {
+  return (flags_ & HIGH_FENCE) != 0 ? reinterpret_cast<const char *>(this) + data_offset_ + key_size_ : nullptr;
+}
+
+bool BPlusTreePage::HasVariableValues() const { return (flags_ & VARIABLE_VALUES) != 0; }
+
+/*
+ * Headers and keys are multiples of 4 bytes, so the slots are aligned
+ */
+uint32_t *BPlusTreePage::Slots() {
+  return reinterpret_cast<uint32_t *>(reinterpret_cast<char *>(this) + data_offset_ + 2 * key_size_);
+}
+
+const uint32_t *BPlusTreePage::Slots() const {
+  return reinterpret_cast<const uint32_t *>(reinterpret_cast<const char *>(this) + data_offset_ + 2 * key_size_);
+}
+
+const char *BPlusTreePage::EntryAt(int index) const {
+  return reinterpret_cast<const char *>(this) + (Slots()[index] & SLOT_OFFSET_MASK);
+}
+
+/*
+ * The head is taken from the padded key, so heads order like the keys, and keys with equal heads order by the rest
+ * of their suffix
+ */
+uint32_t BPlusTreePage::HeadOf(const char *key) const {
+  if (key == nullptr) {
+    return 0;
+  }
+  uint32_t head = 0;
+  for (int i = prefix_size_; i < prefix_size_ + 2; i++) {
+    head = head << 8 | (i < key_size_ ? static_cast<uint8_t>(key[i]) : 0);
+  }
+  return head;
+}
+
+int BPlusTreePage::EntryDataSize(int index) const {
+  return 1 + static_cast<uint8_t>(EntryAt(index)[0]) + (HasVariableValues() ? 1 : 0) + ValueSizeAt(index);
+}
+
+/*
+ * Rebuild the key at index from the prefix in the low fence and the suffix in the entry
+ */
+void BPlusTreePage::KeyDataAt(int index, char *key) const {
+  const char *entry = EntryAt(index);
+  int suffix_size = static_cast<uint8_t>(entry[0]);
+  memcpy(key, reinterpret_cast<const char *>(this) + data_offset_, prefix_size_);
+  memcpy(key + prefix_size_, entry + 1, suffix_size);
+  memset(key + prefix_size_ + suffix_size, 0, key_size_ - prefix_size_ - suffix_size);
+}
+
+const char *BPlusTreePage::ValueDataAt(int index) const {
+  const char *entry = EntryAt(index);
+  return entry + 1 + static_cast<uint8_t>(entry[0]) + (HasVariableValues() ? 1 : 0);
+}
+
+int BPlusTreePage::ValueSizeAt(int index) const {
+  if (!HasVariableValues()) {
+    return value_size_;
+  }
+  const char *entry = EntryAt(index);
+  return static_cast<uint8_t>(entry[1 + static_cast<uint8_t>(entry[0])]);
+}
+
+void BPlusTreePage::SetValueDataAt(int index, const char *value) {
+  memcpy(const_cast<char *>(ValueDataAt(index)), value, ValueSizeAt(index));
+}
+
+/*
+ * A value of another size takes a new entry, with the key rebuilt from the old one
+ */
+void BPlusTreePage::SetValueDataAt(int index, const char *value, int value_size) {
+  if (value_size == ValueSizeAt(index)) {
+    memcpy(const_cast<char *>(ValueDataAt(index)), value, value_size);
+    return;
+  }
+  char key[UINT8_MAX];
+  KeyDataAt(index, key);
+  RemoveEntryAt(index);
+  InsertEntryAt(index, key, value, value_size);
+}
+
+/*
+ * Keys without their zero padding compare like the padded keys, as long as a shorter key sorts first.
+ */
+int BPlusTreePage::SearchEntries(const char *key, int begin, bool upper) const {
+  // a key outside the range of the page sorts before or after all of its entries
+  int cmp = memcmp(key, reinterpret_cast<const char *>(this) + data_offset_, prefix_size_);
+  if (cmp != 0) {
+    return cmp < 0 ? begin : size_;
+  }
+  // the heads narrow the search down to the entries whose head ties with the key's, which are few if any
+  uint32_t head = HeadOf(key);
+  const uint32_t *slots = Slots();
+  int left = LowerBoundHead(slots, begin, size_, head);
+  int right = LowerBoundHead(slots, left, size_, head + 1);
+  if (left == right) {
+    return left;
+  }
+  const char *suffix = key + prefix_size_;
+  int suffix_size = std::max(SignificantSize(key, key_size_) - prefix_size_, 0);
+  while (left < right) {
+    int mid = left + (right - left) / 2;
+    const char *entry = EntryAt(mid);
+    int entry_suffix_size = static_cast<uint8_t>(entry[0]);
+    cmp = memcmp(entry + 1, suffix, std::min(entry_suffix_size, suffix_size));
+    if (cmp == 0) {
+      cmp = entry_suffix_size - suffix_size;
+    }
+    if (cmp < 0 || (upper && cmp == 0)) {
+      left = mid + 1;
+    } else {
+      right = mid;
+    }
+  }
+  return left;
+}
+
+bool BPlusTreePage::EntryMatches(int index, const char *key) const {
+  if (index >= size_ || memcmp(key, reinterpret_cast<const char *>(this) + data_offset_, prefix_size_) != 0 ||
+      Slots()[index] >> SLOT_HEAD_SHIFT != HeadOf(key)) {
+    return false;
+  }
+  const char *entry = EntryAt(index);
+  int suffix_size = std::max(SignificantSize(key, key_size_) - prefix_size_, 0);
+  return static_cast<uint8_t>(entry[0]) == suffix_size && memcmp(entry + 1, key + prefix_size_, suffix_size) == 0;
+}
+
+void BPlusTreePage::InsertEntryAt(int index, const char *key, const char *value) {
+  InsertEntryAt(index, key, value, value_size_);
+}
+
+void BPlusTreePage::InsertEntryAt(int index, const char *key, const char *value, int value_size) {
+  BUSTUB_ASSERT(value_size <= value_size_, "B+ tree page value is too large");
+  int suffix_size = key == nullptr ? 0 : std::max(SignificantSize(key, key_size_) - prefix_size_, 0);
+  int size_size = HasVariableValues() ? 1 : 0;
+  int data_size = 1 + suffix_size + size_size + value_size;
+  int slots_end = data_offset_ + 2 * key_size_ + (size_ + 1) * SLOT_SIZE;
+  if (heap_offset_ - data_size < slots_end) {
+    Compact();
+  }
+  BUSTUB_ASSERT(heap_offset_ - data_size >= slots_end, "B+ tree page entry does not fit");
+  heap_offset_ -= data_size;
+  char *entry = reinterpret_cast<char *>(this) + heap_offset_;
+  entry[0] = static_cast<char>(suffix_size);
+  if (suffix_size > 0) {
+    memcpy(entry + 1, key + prefix_size_, suffix_size);
+  }
+  if (size_size != 0) {
+    entry[1 + suffix_size] = static_cast<char>(value_size);
+  }
+  memcpy(entry + 1 + suffix_size + size_size, value, value_size);
+  uint32_t *slots = Slots();
+  memmove(slots + index + 1, slots + index, (size_ - index) * SLOT_SIZE);
+  slots[index] = HeadOf(key) << SLOT_HEAD_SHIFT | heap_offset_;
+  size_++;
+}
+
+/*
+ * The entry's bytes become garbage, which the next insert that runs out of contiguous space compacts away
+ */
+void BPlusTreePage::RemoveEntryAt(int index) {
+  garbage_size_ += EntryDataSize(index);
+  uint32_t *slots = Slots();
+  memmove(slots + index, slots + index + 1, (size_ - index - 1) * SLOT_SIZE);
+  size_--;
+  if (size_ == 0) {
+    heap_offset_ = PAGE_SIZE;
+    garbage_size_ = 0;
+  }
+}
+
+void BPlusTreePage::Compact() {
+  char buffer[PAGE_SIZE];
+  int offset = PAGE_SIZE;
+  uint32_t *slots = Slots();
+  for (int i = 0; i < size_; i++) {
+    int data_size = EntryDataSize(i);
+    offset -= data_size;
+    memcpy(buffer + offset, EntryAt(i), data_size);
+    slots[i] = (slots[i] & ~SLOT_OFFSET_MASK) | offset;
+  }
+  memcpy(reinterpret_cast<char *>(this) + offset, buffer + offset, PAGE_SIZE - offset);
+  heap_offset_ = offset;
+  garbage_size_ = 0;
+}
+
+/*
+ * Keys in (left, right] share the bytes before the first one in which left and right differ, and the shortest of them
+ * is right cut off after that byte.
+ */
+void BPlusTreePage::SeparatorBetween(const char *left, const char *right, int key_size, char *separator) {
+  int length = 0;
+  while (length < key_size && left[length] == right[length]) {
+    length++;
+  }
+  length = std::min(length + 1, key_size);
+  memcpy(separator, right, length);
+  memset(separator + length, 0, key_size - length);
+}
+
 }  // namespace bustub
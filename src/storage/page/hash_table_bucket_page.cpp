@@ -10,6 +10,8 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
+
 #include "storage/page/hash_table_bucket_page.h"
 #include "common/logger.h"
 #include "common/util/hash_util.h"
@@ -17,16 +19,93 @@
 #include "storage/index/hash_comparator.h"
 #include "storage/table/tmp_tuple.h"
 
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
 namespace bustub {
 
+namespace {
+
+/** @return the flags of the BUCKET_GROUP_SIZE slots of a group, bit i for slot i of the group */
+inline uint32_t LoadGroupBits(const char *bitmap, uint32_t group) {
+  const auto *p = reinterpret_cast<const uint8_t *>(bitmap) + group * (BUCKET_GROUP_SIZE / 8);
+  return static_cast<uint32_t>(p[0]) | static_cast<uint32_t>(p[1]) << 8 | static_cast<uint32_t>(p[2]) << 16 |
+         static_cast<uint32_t>(p[3]) << 24;
+}
+
+/** @return the flags of slots 64 * word to 64 * word + 63, bit i for slot 64 * word + i */
+inline uint64_t LoadWord(const char *bitmap, uint32_t word) {
+  uint64_t bits;
+  memcpy(&bits, bitmap + word * sizeof(bits), sizeof(bits));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  bits = __builtin_bswap64(bits);
+#endif
+  return bits;
+}
+
+/** @return bit i set if fingerprints[i] == fingerprint, for the BUCKET_GROUP_SIZE fingerprints of a group */
+inline uint32_t MatchFingerprints(const uint8_t *fingerprints, uint8_t fingerprint) {
+#if defined(__AVX2__)
+  __m256i needle = _mm256_set1_epi8(static_cast<char>(fingerprint));
+  __m256i group = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(fingerprints));
+  return static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(group, needle)));
+#elif defined(__SSE2__)
+  __m128i needle = _mm_set1_epi8(static_cast<char>(fingerprint));
+  __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i *>(fingerprints));
+  __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i *>(fingerprints + 16));
+  auto lo_mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(lo, needle)));
+  auto hi_mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(hi, needle)));
+  return lo_mask | hi_mask << 16;
+#else
+  uint32_t mask = 0;
+  for (uint32_t i = 0; i < BUCKET_GROUP_SIZE; i++) {
+    mask |= static_cast<uint32_t>(fingerprints[i] == fingerprint) << i;
+  }
+  return mask;
+#endif
+}
+
+}  // namespace
+
 template <typename KeyType, typename ValueType, typename KeyComparator>
-bool HASH_TABLE_BUCKET_TYPE::GetValue(KeyType key, KeyComparator cmp, std::vector<ValueType> *result) {
-  for (size_t i = 0; i < BUCKET_ARRAY_SIZE; i++) {
-    if (!IsOccupied(i)) {
-      break;
+uint32_t HASH_TABLE_BUCKET_TYPE::MatchGroup(uint32_t group, uint8_t fingerprint) const {
+  return MatchFingerprints(fingerprints_ + group * BUCKET_GROUP_SIZE, fingerprint) & LoadGroupBits(readable_, group);
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+uint32_t HASH_TABLE_BUCKET_TYPE::NumOccupiedGroups() const {
+  // occupied slots form a prefix: inserts take the first slot that is not readable
+  return (num_readable_ + num_tombstones_ + BUCKET_GROUP_SIZE - 1) / BUCKET_GROUP_SIZE;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+uint32_t HASH_TABLE_BUCKET_TYPE::FirstFreeSlot() const {
+  // without tombstones the readable slots are exactly the occupied prefix
+  if (num_tombstones_ == 0) {
+    return num_readable_;
+  }
+  for (uint32_t word = 0; word < BUCKET_BITMAP_WORDS; word++) {
+    uint64_t free = ~LoadWord(readable_, word);
+    if (free != 0) {
+      return std::min<uint32_t>(word * 64 + __builtin_ctzll(free), BUCKET_ARRAY_SIZE);
     }
-    if (IsReadable(i) && cmp(key, KeyAt(i)) == 0) {
-      result->push_back(ValueAt(i));
+  }
+  return BUCKET_ARRAY_SIZE;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool HASH_TABLE_BUCKET_TYPE::GetValue(KeyType key, uint8_t fingerprint, KeyComparator cmp,
+                                      std::vector<ValueType> *result) {
+  static_assert(sizeof(HashTableBucketPage) + (BUCKET_ARRAY_SIZE - 1) * sizeof(MappingType) <= PAGE_SIZE,
+                "bucket page does not fit into a page");
+  uint32_t num_groups = NumOccupiedGroups();
+  for (uint32_t group = 0; group < num_groups; group++) {
+    for (uint32_t match = MatchGroup(group, fingerprint); match != 0; match &= match - 1) {
+      uint32_t i = group * BUCKET_GROUP_SIZE + __builtin_ctz(match);
+      if (cmp(key, array_[i].first) == 0) {
+        result->push_back(array_[i].second);
+      }
     }
   }
   return !result->empty();
@@ -34,47 +113,64 @@ bool HASH_TABLE_BUCKET_TYPE::GetValue(KeyType key, KeyComparator cmp, std::vecto
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 void HASH_TABLE_BUCKET_TYPE::GetAllValue(std::vector<MappingType> *result) {
-  for (size_t i = 0; i < BUCKET_ARRAY_SIZE && IsReadable(i); i++) {
-    if (!IsOccupied(i)) {
-      break;
+  for (uint32_t word = 0; word < BUCKET_BITMAP_WORDS; word++) {
+    for (uint64_t readable = LoadWord(readable_, word); readable != 0; readable &= readable - 1) {
+      result->push_back(array_[word * 64 + __builtin_ctzll(readable)]);
     }
-    result->push_back({KeyAt(i), ValueAt(i)});
   }
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 void HASH_TABLE_BUCKET_TYPE::Clear() {
-  memset(occupied_, 0, (BUCKET_ARRAY_SIZE - 1) / 8 + 1);
-  memset(readable_, 0, (BUCKET_ARRAY_SIZE - 1) / 8 + 1);
+  memset(occupied_, 0, sizeof(occupied_));
+  memset(readable_, 0, sizeof(readable_));
+  num_readable_ = 0;
+  num_tombstones_ = 0;
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
-bool HASH_TABLE_BUCKET_TYPE::Insert(KeyType key, ValueType value, KeyComparator cmp) {
-  std::vector<ValueType> result;
-  GetValue(key, cmp, &result);
-
-  if (result.empty() || find(result.begin(), result.end(), value) == result.end()) {
-    for (size_t i = 0; i < BUCKET_ARRAY_SIZE; i++) {
-      if (!IsReadable(i)) {
-        array_[i] = {key, value};
-        SetOccupied(i);
-        SetReadable(i);
-        return true;
+bool HASH_TABLE_BUCKET_TYPE::Insert(KeyType key, ValueType value, uint8_t fingerprint, KeyComparator cmp) {
+  uint32_t free_idx = FirstFreeSlot();
+  if (free_idx == BUCKET_ARRAY_SIZE) {
+    return false;
+  }
+  uint32_t num_groups = NumOccupiedGroups();
+  for (uint32_t group = 0; group < num_groups; group++) {
+    for (uint32_t match = MatchGroup(group, fingerprint); match != 0; match &= match - 1) {
+      uint32_t i = group * BUCKET_GROUP_SIZE + __builtin_ctz(match);
+      if (cmp(key, array_[i].first) == 0 && array_[i].second == value) {
+        return false;
       }
     }
   }
-  return false;
+  InsertAt(free_idx, key, value, fingerprint);
+  return true;
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
-bool HASH_TABLE_BUCKET_TYPE::Remove(KeyType key, ValueType value, KeyComparator cmp) {
-  for (size_t i = 0; i < BUCKET_ARRAY_SIZE; i++) {
-    if (IsReadable(i) && cmp(key, KeyAt(i)) == 0 && value == ValueAt(i)) {
-      readable_[i / 8] &= (~(uint8_t(128) >> (i % 8)));
-      return true;
+void HASH_TABLE_BUCKET_TYPE::InsertAt(uint32_t bucket_idx, KeyType key, ValueType value, uint8_t fingerprint) {
+  array_[bucket_idx] = {key, value};
+  fingerprints_[bucket_idx] = fingerprint;
+  SetReadable(bucket_idx);
+  SetOccupied(bucket_idx);
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool HASH_TABLE_BUCKET_TYPE::Remove(KeyType key, ValueType value, uint8_t fingerprint, KeyComparator cmp) {
+  uint32_t num_groups = NumOccupiedGroups();
+  for (uint32_t group = 0; group < num_groups; group++) {
+    for (uint32_t match = MatchGroup(group, fingerprint); match != 0; match &= match - 1) {
+      uint32_t i = group * BUCKET_GROUP_SIZE + __builtin_ctz(match);
+      if (cmp(key, array_[i].first) == 0 && value == array_[i].second) {
+        RemoveAt(i);
+        // once the last pair is gone its tombstones only slow down scans
+        if (num_readable_ == 0) {
+          Clear();
+        }
+        return true;
+      }
     }
   }
-
   return false;
 }
 
@@ -94,67 +190,83 @@ ValueType HASH_TABLE_BUCKET_TYPE::ValueAt(uint32_t bucket_idx) const {
   return {};
 }
 
+template <typename KeyType, typename ValueType, typename KeyComparator>
+uint8_t HASH_TABLE_BUCKET_TYPE::FingerprintAt(uint32_t bucket_idx) const {
+  return fingerprints_[bucket_idx];
+}
+
 template <typename KeyType, typename ValueType, typename KeyComparator>
 void HASH_TABLE_BUCKET_TYPE::RemoveAt(uint32_t bucket_idx) {
-  if (IsReadable(bucket_idx)) {
-    readable_[bucket_idx / 8] &= (~(uint8_t(128) >> (bucket_idx % 8)));
+  if (!IsReadable(bucket_idx)) {
+    return;
+  }
+  readable_[bucket_idx / 8] &= ~(1 << (bucket_idx % 8));
+  num_readable_--;
+  if (IsOccupied(bucket_idx)) {
+    num_tombstones_++;
   }
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 bool HASH_TABLE_BUCKET_TYPE::IsOccupied(uint32_t bucket_idx) const {
-  return ((occupied_[bucket_idx / 8] >> (7 - (bucket_idx % 8))) & 1) == 1;
+  return ((occupied_[bucket_idx / 8] >> (bucket_idx % 8)) & 1) == 1;
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 void HASH_TABLE_BUCKET_TYPE::SetOccupied(uint32_t bucket_idx) {
-  occupied_[bucket_idx / 8] |= (128 >> (bucket_idx % 8));
+  if (IsOccupied(bucket_idx)) {
+    return;
+  }
+  occupied_[bucket_idx / 8] |= (1 << (bucket_idx % 8));
+  if (!IsReadable(bucket_idx)) {
+    num_tombstones_++;
+  }
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 bool HASH_TABLE_BUCKET_TYPE::IsReadable(uint32_t bucket_idx) const {
-  return ((readable_[bucket_idx / 8] >> (7 - (bucket_idx % 8))) & 1) == 1;
+  return ((readable_[bucket_idx / 8] >> (bucket_idx % 8)) & 1) == 1;
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 void HASH_TABLE_BUCKET_TYPE::SetReadable(uint32_t bucket_idx) {
-  readable_[bucket_idx / 8] |= (128 >> (bucket_idx % 8));
+  if (IsReadable(bucket_idx)) {
+    return;
+  }
+  readable_[bucket_idx / 8] |= (1 << (bucket_idx % 8));
+  num_readable_++;
+  if (IsOccupied(bucket_idx)) {
+    num_tombstones_--;
+  }
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 bool HASH_TABLE_BUCKET_TYPE::IsFull() {
-  for (size_t i = 0; i < ((BUCKET_ARRAY_SIZE - 1) / 8 + 1); i++) {
-    if (readable_[i] != -1) {
-      return false;
-    }
-  }
-  return true;
+  return num_readable_ == BUCKET_ARRAY_SIZE;
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 uint32_t HASH_TABLE_BUCKET_TYPE::NumReadable() {
-  uint32_t num_readable = 0;
-  for (size_t i = 0; i < ((BUCKET_ARRAY_SIZE - 1) / 8 + 1); i++) {
-    if (readable_[i] != 255) {
-      char index = readable_[i];
-      for (size_t i = 0; (i < 8) && (index & 1) != 0; i++, index >>= 1) {
-        num_readable++;
-      }
-    } else {
-      num_readable += 8;
-    }
-  }
-  return num_readable;
+  return num_readable_;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+uint32_t HASH_TABLE_BUCKET_TYPE::NumTombstones() {
+  return num_tombstones_;
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 bool HASH_TABLE_BUCKET_TYPE::IsEmpty() {
-  for (size_t i = 0; i < ((BUCKET_ARRAY_SIZE - 1) / 8 + 1); i++) {
-    if (readable_[i] != 0) {
-      return false;
-    }
+  return num_readable_ == 0;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void HASH_TABLE_BUCKET_TYPE::Prefetch() const {
+  const char *begin = reinterpret_cast<const char *>(this);
+  const char *end = reinterpret_cast<const char *>(array_);
+  for (const char *line = begin; line < end; line += 64) {
+    __builtin_prefetch(line);
   }
-  return true;
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
@@ -75,7 +75,34 @@ void HashTableDirectoryPage::IncrLocalDepth(uint32_t bucket_idx) { local_depths_
 
 void HashTableDirectoryPage::DecrLocalDepth(uint32_t bucket_idx) { local_depths_[bucket_idx]--; }
 
-uint32_t HashTableDirectoryPage::GetLocalHighBit(uint32_t bucket_idx) { return 0; }
+uint32_t HashTableDirectoryPage::GetLocalDepthMask(uint32_t bucket_idx) {
+  return (1U << local_depths_[bucket_idx]) - 1;
+}
+
+uint32_t HashTableDirectoryPage::GetLocalHighBit(uint32_t bucket_idx) { return 1U << local_depths_[bucket_idx]; }
+
+void HashTableDirectoryPage::SplitBucket(uint32_t bucket_idx, page_id_t image_page_id) {
+  uint32_t local_depth = local_depths_[bucket_idx];
+  uint32_t local_mask = GetLocalDepthMask(bucket_idx);
+  uint32_t high_bit = GetLocalHighBit(bucket_idx);
+  // the slots of a bucket are exactly the indexes that agree with it on the low local depth bits
+  for (uint32_t i = bucket_idx & local_mask; i < Size(); i += high_bit) {
+    local_depths_[i] = local_depth + 1;
+    if ((i & high_bit) != 0) {
+      bucket_page_ids_[i] = image_page_id;
+    }
+  }
+}
+
+void HashTableDirectoryPage::MergeBucket(uint32_t bucket_idx) {
+  uint32_t merged_depth = local_depths_[bucket_idx] - 1;
+  page_id_t image_page_id = bucket_page_ids_[GetSplitImageIndex(bucket_idx)];
+  uint32_t merged_mask = (1U << merged_depth) - 1;
+  for (uint32_t i = bucket_idx & merged_mask; i < Size(); i += (1U << merged_depth)) {
+    local_depths_[i] = merged_depth;
+    bucket_page_ids_[i] = image_page_id;
+  }
+}
 
 /**
  * VerifyIntegrity - Use this for debugging but **DO NOT CHANGE**
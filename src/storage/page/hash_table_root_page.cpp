@@ -0,0 +1,74 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// hash_table_root_page.cpp
+//
+// Identification: src/storage/page/hash_table_root_page.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/page/hash_table_root_page.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace bustub {
+
+void HashTableRootPage::Init(page_id_t page_id, uint32_t depth) {
+  page_id_ = page_id;
+  lsn_ = 0;
+  depth_ = std::min<uint32_t>(depth, ROOT_MAX_DEPTH);
+  std::fill(directory_page_ids_, directory_page_ids_ + ROOT_ARRAY_SIZE, INVALID_PAGE_ID);
+}
+
+page_id_t HashTableRootPage::GetPageId() const { return page_id_; }
+
+lsn_t HashTableRootPage::GetLSN() const { return lsn_; }
+
+void HashTableRootPage::SetLSN(lsn_t lsn) { lsn_ = lsn; }
+
+// the directories use the low bits of the hash, so the root takes the high ones
+uint32_t HashTableRootPage::HashToDirectoryIndex(uint32_t hash) const {
+  return depth_ == 0 ? 0 : hash >> (32 - depth_);
+}
+
+page_id_t HashTableRootPage::GetDirectoryPageId(uint32_t directory_idx) const {
+  return directory_page_ids_[directory_idx];
+}
+
+void HashTableRootPage::SetDirectoryPageId(uint32_t directory_idx, page_id_t directory_page_id) {
+  directory_page_ids_[directory_idx] = directory_page_id;
+}
+
+uint32_t HashTableRootPage::GetRunStart(uint32_t directory_idx) const {
+  return directory_idx & ~(GetRunLength(directory_idx) - 1);
+}
+
+// runs are aligned, so a run of 2^k indexes is the one whose buddy at distance 2^(k-1) still shares the directory
+uint32_t HashTableRootPage::GetRunLength(uint32_t directory_idx) const {
+  uint32_t length = 1;
+  while (length < MaxSize() &&
+         directory_page_ids_[directory_idx ^ length] == directory_page_ids_[directory_idx]) {
+    length <<= 1;
+  }
+  return length;
+}
+
+uint32_t HashTableRootPage::MaxSize() const { return 1U << depth_; }
+
+uint32_t HashTableRootPage::GetDepth() const { return depth_; }
+
+void HashTableRootPage::IncrDepth() {
+  assert(depth_ < ROOT_MAX_DEPTH);
+  // back to front, so that no index is overwritten before it is copied
+  for (uint32_t i = MaxSize(); i-- > 0;) {
+    directory_page_ids_[2 * i] = directory_page_ids_[i];
+    directory_page_ids_[2 * i + 1] = directory_page_ids_[i];
+  }
+  depth_++;
+}
+
+}  // namespace bustub
@@ -0,0 +1,68 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// posting_list_page.cpp
+//
+// Identification: src/storage/page/posting_list_page.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/page/posting_list_page.h"
+
+#include <cstring>
+
+#include "common/macros.h"
+
+namespace bustub {
+
+void PostingListPage::Init(page_id_t page_id) {
+  static_assert(sizeof(PostingListPage) == PAGE_SIZE, "posting list page size mismatch");
+  page_id_ = page_id;
+  lsn_ = INVALID_LSN;
+  next_page_id_ = INVALID_PAGE_ID;
+  count_ = 0;
+  run_size_ = 0;
+  first_rid_ = 0;
+  last_rid_ = 0;
+}
+
+page_id_t PostingListPage::GetPageId() const { return page_id_; }
+
+page_id_t PostingListPage::GetNextPageId() const { return next_page_id_; }
+
+void PostingListPage::SetNextPageId(page_id_t next_page_id) { next_page_id_ = next_page_id; }
+
+int PostingListPage::GetCount() const { return count_; }
+
+uint64_t PostingListPage::GetFirstRid() const { return first_rid_; }
+
+uint64_t PostingListPage::GetLastRid() const { return last_rid_; }
+
+const char *PostingListPage::GetRun() const { return run_; }
+
+int PostingListPage::GetRunSize() const { return run_size_; }
+
+void PostingListPage::SetRun(const char *run, int run_size, int count, uint64_t first_rid, uint64_t last_rid) {
+  BUSTUB_ASSERT(run_size <= RUN_CAPACITY, "posting list run does not fit");
+  memmove(run_, run, run_size);
+  run_size_ = run_size;
+  count_ = count;
+  first_rid_ = first_rid;
+  last_rid_ = last_rid;
+}
+
+void PostingListPage::AppendToRun(const char *data, int size, uint64_t rid) {
+  BUSTUB_ASSERT(run_size_ + size <= RUN_CAPACITY, "posting list run does not fit");
+  memcpy(run_ + run_size_, data, size);
+  run_size_ += size;
+  if (count_ == 0) {
+    first_rid_ = rid;
+  }
+  count_++;
+  last_rid_ = rid;
+}
+
+}  // namespace bustub
@@ -12,9 +12,12 @@
 
 #include "buffer/buffer_pool_manager_instance.h"
 #include <cstdio>
+#include <fstream>
 #include <random>
 #include <string>
 #include "buffer/buffer_pool_manager.h"
+#include "common/bustub_instance.h"
+#include "common/exception.h"
 #include "gtest/gtest.h"
 
 namespace bustub {
@@ -141,4 +144,108 @@ TEST(BufferPoolManagerInstanceTest, SampleTest) {
   delete disk_manager;
 }
 
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, ChecksumMismatchTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 2;
+  char data[PAGE_SIZE] = {0};
+
+  auto *disk_manager = new DiskManager(db_name);
+  for (int i = 0; i < 3; i++) {
+    snprintf(data, PAGE_SIZE, "page %d", i);
+    disk_manager->WritePage(i, data);
+  }
+  // corrupt page 1 on disk
+  {
+    std::fstream file(db_name, std::ios::binary | std::ios::in | std::ios::out);
+    file.seekp(DiskManager::PageOffset(1) + 100);
+    file.put('x');
+  }
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+
+  // the failed fetch neither keeps the latch nor loses the frame
+  for (int i = 0; i < 3; i++) {
+    EXPECT_THROW(bpm->FetchPage(1), Exception);
+  }
+  auto *page0 = bpm->FetchPage(0);
+  ASSERT_NE(nullptr, page0);
+  EXPECT_EQ(0, strcmp(page0->GetData(), "page 0"));
+  auto *page2 = bpm->FetchPage(2);
+  ASSERT_NE(nullptr, page2);
+  EXPECT_EQ(0, strcmp(page2->GetData(), "page 2"));
+  EXPECT_EQ(1, page0->GetPinCount());
+  EXPECT_EQ(1, page2->GetPinCount());
+
+  // a failed fetch that had to evict a page gives that frame back as well
+  EXPECT_TRUE(bpm->UnpinPage(2, false));
+  EXPECT_THROW(bpm->FetchPage(1), Exception);
+  page_id_t page_id_temp;
+  EXPECT_NE(nullptr, bpm->NewPage(&page_id_temp));
+  EXPECT_EQ(nullptr, bpm->NewPage(&page_id_temp));
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.log");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, ReadOnlyReplicaTest) {
+  const std::string db_name = "test.db";
+  const int num_pages = BUFFER_POOL_SIZE + 2;
+  {
+    BustubInstance primary(db_name);
+    for (int i = 0; i < num_pages; i++) {
+      page_id_t page_id;
+      auto *page = primary.buffer_pool_manager_->NewPage(&page_id);
+      ASSERT_NE(nullptr, page);
+      snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+      primary.buffer_pool_manager_->UnpinPage(page_id, true);
+    }
+    primary.buffer_pool_manager_->FlushAllPages();
+  }
+
+  BustubInstance replica(db_name, DiskManagerType::MMAP_READ_ONLY);
+  auto *bpm = replica.buffer_pool_manager_;
+  char expected[PAGE_SIZE];
+  page_id_t page_id_temp;
+  EXPECT_EQ(nullptr, bpm->NewPage(&page_id_temp));
+  // more pages than fit in the pool read back
+  for (int i = 0; i < num_pages; i++) {
+    auto *page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    snprintf(expected, PAGE_SIZE, "page %d", i);
+    EXPECT_EQ(0, strcmp(page->GetData(), expected));
+    EXPECT_TRUE(bpm->UnpinPage(i, false));
+  }
+
+  // page 0 was unpinned dirty and is the only page left to evict: the fetches that need its frame fail without
+  // keeping the latch, and page 0 stays where it is
+  ASSERT_NE(nullptr, bpm->FetchPage(0));
+  EXPECT_TRUE(bpm->UnpinPage(0, true));
+  for (int i = 1; i < BUFFER_POOL_SIZE; i++) {
+    ASSERT_NE(nullptr, bpm->FetchPage(i));
+  }
+  for (int attempt = 0; attempt < 2; attempt++) {
+    EXPECT_THROW(bpm->FetchPage(BUFFER_POOL_SIZE), Exception);
+    EXPECT_EQ(nullptr, bpm->NewPage(&page_id_temp));
+  }
+  EXPECT_THROW(bpm->FlushPage(1), Exception);
+  auto *page0 = bpm->FetchPage(0);
+  ASSERT_NE(nullptr, page0);
+  EXPECT_EQ(0, strcmp(page0->GetData(), "page 0"));
+
+  // with page 0 pinned, the frame of an unpinned clean page takes the next fetch
+  EXPECT_TRUE(bpm->UnpinPage(1, false));
+  auto *page = bpm->FetchPage(BUFFER_POOL_SIZE);
+  ASSERT_NE(nullptr, page);
+  snprintf(expected, PAGE_SIZE, "page %d", BUFFER_POOL_SIZE);
+  EXPECT_EQ(0, strcmp(page->GetData(), expected));
+
+  remove("test.db");
+  remove("test.log");
+}
+
 }  // namespace bustub
@@ -581,6 +581,110 @@ TEST(CatalogTest, DISABLED_IndexInteraction1) {
   remove("catalog_test.log");
 }
 
+// An index is built over a table larger than one batch, and is not created if it refuses some of the tuples
+TEST(CatalogTest, IndexPopulation) {
+  auto disk_manager = std::make_unique<DiskManager>("catalog_test.db");
+  auto bpm = std::make_unique<BufferPoolManagerInstance>(32, disk_manager.get());
+  auto catalog = std::make_unique<Catalog>(bpm.get(), nullptr, nullptr);
+  auto txn = std::make_unique<Transaction>(0);
+
+  // B+ tree indexes record their root page in the header page, which must come before the table
+  page_id_t header_page_id;
+  bpm->NewPage(&header_page_id);
+  bpm->UnpinPage(header_page_id, true);
+
+  const std::string table_name{"foobar"};
+  std::vector<Column> columns{{"A", TypeId::INTEGER}};
+  Schema table_schema{columns};
+  auto *table_info = catalog->CreateTable(nullptr, table_name, table_schema);
+  ASSERT_NE(Catalog::NULL_TABLE_INFO, table_info);
+
+  // every key once, except key 0, which comes back in the last batch
+  const int num_tuples = static_cast<int>(Catalog::INDEX_BUILD_BATCH_SIZE) + 1000;
+  for (int i = 0; i < num_tuples; i++) {
+    Tuple tuple{std::vector<Value>{ValueFactory::GetIntegerValue(i % (num_tuples - 1))}, &table_schema};
+    RID rid;
+    ASSERT_TRUE(table_info->table_->InsertTuple(tuple, &rid, txn.get()));
+  }
+
+  std::vector<uint32_t> key_attrs{0};
+  Schema key_schema{columns};
+  EXPECT_EQ(Catalog::NULL_INDEX_INFO, (catalog->CreateIndex<GenericKey<4>, RID, GenericComparator<4>>(
+                                          txn.get(), "unique", table_name, table_schema, key_schema, key_attrs, 4)));
+  EXPECT_EQ(Catalog::NULL_INDEX_INFO, catalog->GetIndex("unique", table_name));
+
+  std::vector<IndexInfo *> index_infos{
+      catalog->CreateIndex<GenericKey<4>, RID, GenericComparator<4>>(txn.get(), "b_plus_tree", table_name,
+                                                                     table_schema, key_schema, key_attrs, 4, false),
+      catalog->CreateIndex<GenericKey<4>, RID, GenericComparator<4>>(txn.get(), "hash", table_name, table_schema,
+                                                                     key_schema, key_attrs, 4,
+                                                                     HashFunction<GenericKey<4>>{})};
+  for (auto *index_info : index_infos) {
+    ASSERT_NE(Catalog::NULL_INDEX_INFO, index_info);
+    for (int key : {0, 1, static_cast<int>(Catalog::INDEX_BUILD_BATCH_SIZE), num_tuples - 2}) {
+      Tuple index_key{std::vector<Value>{ValueFactory::GetIntegerValue(key)}, &key_schema};
+      std::vector<RID> results;
+      index_info->index_->ScanKey(index_key, &results, txn.get());
+      EXPECT_EQ(key == 0 ? 2 : 1, results.size()) << index_info->name_ << " key " << key;
+    }
+  }
+
+  remove("catalog_test.db");
+  remove("catalog_test.log");
+}
+
+// A B+ tree index in buffered mode is built like any other, and later writes go through its message buffers
+TEST(CatalogTest, BufferedIndex) {
+  auto disk_manager = std::make_unique<DiskManager>("catalog_test.db");
+  auto bpm = std::make_unique<BufferPoolManagerInstance>(32, disk_manager.get());
+  auto catalog = std::make_unique<Catalog>(bpm.get(), nullptr, nullptr);
+  auto txn = std::make_unique<Transaction>(0);
+
+  page_id_t header_page_id;
+  bpm->NewPage(&header_page_id);
+  bpm->UnpinPage(header_page_id, true);
+
+  const std::string table_name{"foobar"};
+  std::vector<Column> columns{{"A", TypeId::INTEGER}};
+  Schema table_schema{columns};
+  auto *table_info = catalog->CreateTable(nullptr, table_name, table_schema);
+  ASSERT_NE(Catalog::NULL_TABLE_INFO, table_info);
+  const int num_tuples = 1000;
+  for (int i = 0; i < num_tuples; i++) {
+    Tuple tuple{std::vector<Value>{ValueFactory::GetIntegerValue(i)}, &table_schema};
+    RID rid;
+    ASSERT_TRUE(table_info->table_->InsertTuple(tuple, &rid, txn.get()));
+  }
+
+  std::vector<uint32_t> key_attrs{0};
+  Schema key_schema{columns};
+  // buffered mode needs a unique index
+  EXPECT_THROW((catalog->CreateIndex<GenericKey<4>, RID, GenericComparator<4>>(
+                   txn.get(), "non_unique", table_name, table_schema, key_schema, key_attrs, 4, false,
+                   BPlusTreeMode::BUFFERED)),
+               Exception);
+  auto *index_info = catalog->CreateIndex<GenericKey<4>, RID, GenericComparator<4>>(
+      txn.get(), "buffered", table_name, table_schema, key_schema, key_attrs, 4, true, BPlusTreeMode::BUFFERED);
+  ASSERT_NE(Catalog::NULL_INDEX_INFO, index_info);
+  auto *index = index_info->index_.get();
+
+  // new keys, then a duplicate of a loaded key, which the index drops; the RIDs are on a page past the table
+  const RID new_rid(num_tuples, 0);
+  for (int i = num_tuples; i < 2 * num_tuples; i++) {
+    index->InsertEntry(Tuple{std::vector<Value>{ValueFactory::GetIntegerValue(i)}, &key_schema}, new_rid, txn.get());
+  }
+  index->InsertEntry(Tuple{std::vector<Value>{ValueFactory::GetIntegerValue(0)}, &key_schema}, new_rid, txn.get());
+  for (int i = 0; i < 2 * num_tuples; i++) {
+    std::vector<RID> results;
+    index->ScanKey(Tuple{std::vector<Value>{ValueFactory::GetIntegerValue(i)}, &key_schema}, &results, txn.get());
+    ASSERT_EQ(1, results.size()) << "key " << i;
+    EXPECT_EQ(i >= num_tuples, results[0] == new_rid) << "key " << i;
+  }
+
+  remove("catalog_test.db");
+  remove("catalog_test.log");
+}
+
 // Should be able to create and interact with an index that is keyed by a single INTEGER column
 TEST(CatalogTest, DISABLED_IndexInteraction2) {
   auto disk_manager = std::make_unique<DiskManager>("catalog_test.db");
@@ -0,0 +1,60 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// crc32c_util_test.cpp
+//
+// Identification: test/common/crc32c_util_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "common/util/crc32c_util.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(Crc32cUtilTest, KnownValuesTest) {
+  const char *check = "123456789";
+  EXPECT_EQ(0xE3069283U, Crc32cUtil::Crc32c(check, strlen(check)));
+  EXPECT_EQ(0xE3069283U, Crc32cUtil::Crc32cPortable(check, strlen(check)));
+  EXPECT_EQ(0U, Crc32cUtil::Crc32c(check, 0));
+
+  // RFC 3720 B.4: 32 bytes of zeroes and 32 bytes of ones
+  std::vector<char> zeroes(32, 0);
+  std::vector<char> ones(32, static_cast<char>(0xFF));
+  EXPECT_EQ(0x8A9136AAU, Crc32cUtil::Crc32c(zeroes.data(), zeroes.size()));
+  EXPECT_EQ(0x62A8AB43U, Crc32cUtil::Crc32c(ones.data(), ones.size()));
+}
+
+// NOLINTNEXTLINE
+TEST(Crc32cUtilTest, HardwareMatchesPortableTest) {
+  std::mt19937 gen(15445);
+  std::vector<char> data(3 * 4096);
+  for (auto &c : data) {
+    c = static_cast<char>(gen());
+  }
+
+  // every size around the interleaved block boundaries, at odd alignments
+  for (size_t size : {0, 1, 7, 8, 9, 127, 128, 129, 143, 144, 255, 256, 257, 511, 512, 4079, 4080, 4081, 4095, 4096,
+                      4097, 8160, 8192}) {
+    for (size_t align = 0; align < 3; align++) {
+      EXPECT_EQ(Crc32cUtil::Crc32cPortable(data.data() + align, size), Crc32cUtil::Crc32c(data.data() + align, size))
+          << "size " << size << " align " << align;
+    }
+  }
+
+  // checksumming in pieces gives the same result as checksumming at once
+  uint32_t whole = Crc32cUtil::Crc32c(data.data(), 4096);
+  uint32_t pieces = Crc32cUtil::Crc32c(data.data(), 1000);
+  pieces = Crc32cUtil::Crc32c(data.data() + 1000, 3096, pieces);
+  EXPECT_EQ(whole, pieces);
+}
+
+}  // namespace bustub
@@ -0,0 +1,160 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// hash_util_test.cpp
+//
+// Identification: test/common/hash_util_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <chrono>  // NOLINT
+#include <iostream>
+#include <random>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "common/util/hash_util.h"
+#include "container/hash/hash_function.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+namespace {
+
+/** The byte-at-a-time hash HashUtil used before, as the benchmark baseline. */
+hash_t ShiftXorHash(const char *bytes, size_t length) {
+  hash_t hash = length;
+  for (size_t i = 0; i < length; ++i) {
+    hash = ((hash << 5) ^ (hash >> 27)) ^ bytes[i];
+  }
+  return hash;
+}
+
+uint64_t Murmur3Hash(const char *bytes, size_t length) {
+  uint64_t hash[2];
+  murmur3::MurmurHash3_x64_128(bytes, static_cast<int>(length), 0, reinterpret_cast<void *>(&hash));
+  return hash[0];
+}
+
+/** @return nanoseconds per call of hash_fn over num_keys keys of the given size */
+template <typename HashFn>
+double TimeHash(const std::vector<char> &data, size_t key_size, size_t num_keys, HashFn hash_fn) {
+  hash_t sink = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < num_keys; i++) {
+    sink += hash_fn(data.data() + (i * key_size) % (data.size() - key_size), key_size);
+  }
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  EXPECT_NE(0, sink);
+  return std::chrono::duration<double, std::nano>(elapsed).count() / static_cast<double>(num_keys);
+}
+
+}  // namespace
+
+// NOLINTNEXTLINE
+TEST(HashUtilTest, HashBytesTest) {
+  std::mt19937 gen(15445);
+  std::vector<char> data(256);
+  for (auto &c : data) {
+    c = static_cast<char>(gen());
+  }
+
+  // every length takes its own path, and reads nothing past the end
+  std::unordered_set<hash_t> hashes;
+  for (size_t length = 0; length <= 200; length++) {
+    std::string copy(data.data(), length);
+    EXPECT_EQ(HashUtil::HashBytes(data.data(), length), HashUtil::HashBytes(copy.data(), length));
+    hashes.insert(HashUtil::HashBytes(data.data(), length));
+  }
+  EXPECT_EQ(201, hashes.size());
+
+  EXPECT_EQ(HashUtil::HashBytes(data.data(), 4), HashUtil::HashFixed<4>(data.data()));
+  EXPECT_EQ(HashUtil::HashBytes(data.data(), 8), HashUtil::HashFixed<8>(data.data()));
+  EXPECT_EQ(HashUtil::HashBytes(data.data(), 16), HashUtil::HashFixed<16>(data.data()));
+  EXPECT_EQ(HashUtil::HashBytes(data.data(), 32), HashUtil::HashFixed<32>(data.data()));
+  EXPECT_EQ(HashUtil::HashBytes(data.data(), 64), HashUtil::HashFixed<64>(data.data()));
+  EXPECT_NE(HashUtil::CombineHashes(1, 2), HashUtil::CombineHashes(2, 1));
+
+  // flipping any input bit flips about half of the output bits
+  for (size_t length : {4, 8, 16, 32, 64, 100}) {
+    size_t flipped = 0;
+    size_t trials = 0;
+    for (size_t bit = 0; bit < 8 * length; bit++) {
+      std::vector<char> key(data.begin(), data.begin() + length);
+      hash_t before = HashUtil::HashBytes(key.data(), length);
+      key[bit / 8] = static_cast<char>(key[bit / 8] ^ (1 << (bit % 8)));
+      flipped += __builtin_popcountll(before ^ HashUtil::HashBytes(key.data(), length));
+      trials++;
+    }
+    double average = static_cast<double>(flipped) / static_cast<double>(trials);
+    EXPECT_GT(average, 30.0) << "length " << length;
+    EXPECT_LT(average, 34.0) << "length " << length;
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(HashUtilTest, GenericKeyHashFunctionTest) {
+  GenericKey<32> key;
+  GenericKey<32> same;
+  key.SetFromInteger(42);
+  same.SetFromInteger(42);
+  HashFunction<GenericKey<32>> hash_fn;
+  EXPECT_EQ(hash_fn.GetHash(key), hash_fn.GetHash(same));
+  EXPECT_EQ(HashUtil::HashBytes(key.data_, 32), hash_fn.GetHash(key));
+
+  // keys that differ only in their low bits spread over the low bits of the hash, which hash tables index with
+  std::unordered_set<uint64_t> buckets;
+  for (int64_t i = 0; i < 256; i++) {
+    key.SetFromInteger(i);
+    buckets.insert(hash_fn.GetHash(key) & 0xFF);
+  }
+  EXPECT_GT(buckets.size(), 140);
+}
+
+// NOLINTNEXTLINE
+TEST(HashUtilTest, HashBenchmarkTest) {
+  std::mt19937 gen(15445);
+  std::vector<char> data(1 << 20);
+  for (auto &c : data) {
+    c = static_cast<char>(gen());
+  }
+
+  for (size_t key_size : {4, 8, 16, 32, 64, 1024, 64 * 1024}) {
+    size_t num_keys = std::max<size_t>(16, (1 << 23) / key_size);
+    double shift_xor = TimeHash(data, key_size, num_keys, ShiftXorHash);
+    double murmur3 = TimeHash(data, key_size, num_keys, Murmur3Hash);
+    double wyhash = TimeHash(data, key_size, num_keys, HashUtil::HashBytes);
+    std::cout << key_size << " byte keys: shift-xor " << shift_xor << " ns, murmur3 " << murmur3 << " ns, HashBytes "
+              << wyhash << " ns" << std::endl;
+  }
+
+  // index keys through HashFunction, with the length fixed at compile time
+  std::vector<GenericKey<8>> keys8(1 << 16);
+  std::vector<GenericKey<64>> keys64(1 << 16);
+  for (size_t i = 0; i < keys8.size(); i++) {
+    keys8[i].SetFromInteger(static_cast<int64_t>(gen()));
+    keys64[i].SetFromInteger(static_cast<int64_t>(gen()));
+  }
+  auto time_keys = [](auto &keys) {
+    using KeyType = typename std::remove_reference_t<decltype(keys)>::value_type;
+    HashFunction<KeyType> hash_fn;
+    uint64_t sink = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < 16; round++) {
+      for (const auto &key : keys) {
+        sink = sink * 31 + hash_fn.GetHash(key);
+      }
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    EXPECT_NE(0, sink);
+    return std::chrono::duration<double, std::nano>(elapsed).count() / static_cast<double>(16 * keys.size());
+  };
+  std::cout << "HashFunction<GenericKey<8>> " << time_keys(keys8) << " ns, HashFunction<GenericKey<64>> "
+            << time_keys(keys64) << " ns" << std::endl;
+}
+
+}  // namespace bustub
@@ -56,6 +56,52 @@ TEST(HashTablePageTest, DISABLED_DirectoryPageSampleTest) {
   delete bpm;
 }
 
+// NOLINTNEXTLINE
+TEST(HashTablePageTest, DirectorySplitMergeTest) {
+  DiskManager *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(5, disk_manager);
+  page_id_t directory_page_id = INVALID_PAGE_ID;
+  auto directory_page =
+      reinterpret_cast<HashTableDirectoryPage *>(bpm->NewPage(&directory_page_id, nullptr)->GetData());
+
+  // bucket 0 covers the whole directory of depth 2
+  directory_page->SetBucketPageId(0, 100);
+  directory_page->IncrGlobalDepth();
+  directory_page->IncrGlobalDepth();
+  EXPECT_EQ(4, directory_page->Size());
+  directory_page->VerifyIntegrity();
+
+  // split it twice: the odd slots move to 101, then slot 2 moves to 102
+  directory_page->SplitBucket(0, 101);
+  directory_page->VerifyIntegrity();
+  EXPECT_EQ(100, directory_page->GetBucketPageId(0));
+  EXPECT_EQ(101, directory_page->GetBucketPageId(1));
+  EXPECT_EQ(100, directory_page->GetBucketPageId(2));
+  EXPECT_EQ(101, directory_page->GetBucketPageId(3));
+  directory_page->SplitBucket(2, 102);
+  directory_page->VerifyIntegrity();
+  EXPECT_EQ(100, directory_page->GetBucketPageId(0));
+  EXPECT_EQ(102, directory_page->GetBucketPageId(2));
+  EXPECT_EQ(2, directory_page->GetLocalDepth(0));
+  EXPECT_EQ(1, directory_page->GetLocalDepth(3));
+  EXPECT_FALSE(directory_page->CanShrink());
+
+  // merging 102 back into its split image restores the previous directory
+  directory_page->MergeBucket(2);
+  directory_page->VerifyIntegrity();
+  EXPECT_EQ(100, directory_page->GetBucketPageId(2));
+  EXPECT_EQ(1, directory_page->GetLocalDepth(0));
+  EXPECT_TRUE(directory_page->CanShrink());
+  directory_page->DecrGlobalDepth();
+  directory_page->VerifyIntegrity();
+
+  bpm->UnpinPage(directory_page_id, true, nullptr);
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
 // NOLINTNEXTLINE
 TEST(HashTablePageTest, DISABLED_BucketPageSampleTest) {
   DiskManager *disk_manager = new DiskManager("test.db");
@@ -69,7 +115,7 @@ TEST(HashTablePageTest, DISABLED_BucketPageSampleTest) {
 
   // insert a few (key, value) pairs
   for (unsigned i = 0; i < 10; i++) {
-    assert(bucket_page->Insert(i, i, IntComparator()));
+    assert(bucket_page->Insert(i, i, static_cast<uint8_t>(i), IntComparator()));
   }
 
   // check for the inserted pairs
@@ -81,7 +127,7 @@ TEST(HashTablePageTest, DISABLED_BucketPageSampleTest) {
   // remove a few pairs
   for (unsigned i = 0; i < 10; i++) {
     if (i % 2 == 1) {
-      assert(bucket_page->Remove(i, i, IntComparator()));
+      assert(bucket_page->Remove(i, i, static_cast<uint8_t>(i), IntComparator()));
     }
   }
 
@@ -102,7 +148,7 @@ TEST(HashTablePageTest, DISABLED_BucketPageSampleTest) {
   // try to remove the already-removed pairs
   for (unsigned i = 0; i < 10; i++) {
     if (i % 2 == 1) {
-      assert(!bucket_page->Remove(i, i, IntComparator()));
+      assert(!bucket_page->Remove(i, i, static_cast<uint8_t>(i), IntComparator()));
     }
   }
 
@@ -114,4 +160,118 @@ TEST(HashTablePageTest, DISABLED_BucketPageSampleTest) {
   delete bpm;
 }
 
+// NOLINTNEXTLINE
+TEST(HashTablePageTest, BucketPageFingerprintTest) {
+  DiskManager *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(5, disk_manager);
+
+  page_id_t bucket_page_id = INVALID_PAGE_ID;
+  auto bucket_page = reinterpret_cast<HashTableBucketPage<int, int, IntComparator> *>(
+      bpm->NewPage(&bucket_page_id, nullptr)->GetData());
+  using KeyType = int;
+  using ValueType = int;
+  const int capacity = static_cast<int>(BUCKET_ARRAY_SIZE);
+
+  // fill the bucket, every key shares its fingerprint with 15 other keys
+  for (int i = 0; i < capacity; i++) {
+    EXPECT_TRUE(bucket_page->Insert(i, i, static_cast<uint8_t>(i % 16), IntComparator()));
+    EXPECT_EQ(static_cast<uint8_t>(i % 16), bucket_page->FingerprintAt(i));
+  }
+  EXPECT_TRUE(bucket_page->IsFull());
+  EXPECT_FALSE(bucket_page->Insert(capacity, capacity, 0, IntComparator()));
+  EXPECT_FALSE(bucket_page->Insert(0, 0, 0, IntComparator()));
+
+  // only fingerprint matches are candidates, the comparator sorts out the collisions
+  for (int i = 0; i < capacity; i++) {
+    std::vector<int> res;
+    EXPECT_TRUE(bucket_page->GetValue(i, static_cast<uint8_t>(i % 16), IntComparator(), &res));
+    ASSERT_EQ(1, res.size());
+    EXPECT_EQ(i, res[0]);
+    res.clear();
+    EXPECT_FALSE(bucket_page->GetValue(i, static_cast<uint8_t>(i % 16 + 1), IntComparator(), &res));
+  }
+
+  // removes leave tombstones whose slots are reused, a second value for the same key joins the first
+  for (int i = 0; i < capacity; i += 2) {
+    EXPECT_TRUE(bucket_page->Remove(i, i, static_cast<uint8_t>(i % 16), IntComparator()));
+    EXPECT_FALSE(bucket_page->Remove(i, i, static_cast<uint8_t>(i % 16), IntComparator()));
+  }
+  EXPECT_TRUE(bucket_page->Insert(1, 2, 1, IntComparator()));
+  EXPECT_EQ(1, bucket_page->KeyAt(0));
+  std::vector<int> res;
+  EXPECT_TRUE(bucket_page->GetValue(1, 1, IntComparator(), &res));
+  EXPECT_EQ((std::vector<int>{2, 1}), res);
+  for (int i = 2; i < capacity; i++) {
+    res.clear();
+    EXPECT_EQ(i % 2 == 1, bucket_page->GetValue(i, static_cast<uint8_t>(i % 16), IntComparator(), &res));
+  }
+
+  bpm->UnpinPage(bucket_page_id, true, nullptr);
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(HashTablePageTest, BucketPageCountersTest) {
+  DiskManager *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(5, disk_manager);
+
+  page_id_t bucket_page_id = INVALID_PAGE_ID;
+  auto bucket_page = reinterpret_cast<HashTableBucketPage<int, int, IntComparator> *>(
+      bpm->NewPage(&bucket_page_id, nullptr)->GetData());
+  using KeyType = int;
+  using ValueType = int;
+  const int capacity = static_cast<int>(BUCKET_ARRAY_SIZE);
+
+  EXPECT_TRUE(bucket_page->IsEmpty());
+  for (int i = 0; i < 100; i++) {
+    EXPECT_TRUE(bucket_page->Insert(i, i, 0, IntComparator()));
+  }
+  EXPECT_EQ(100, bucket_page->NumReadable());
+  EXPECT_EQ(0, bucket_page->NumTombstones());
+
+  // removed slots become tombstones, inserts reuse the first one
+  for (int i = 10; i < 80; i += 10) {
+    EXPECT_TRUE(bucket_page->Remove(i, i, 0, IntComparator()));
+  }
+  bucket_page->RemoveAt(70);
+  EXPECT_EQ(93, bucket_page->NumReadable());
+  EXPECT_EQ(7, bucket_page->NumTombstones());
+  EXPECT_TRUE(bucket_page->Insert(1000, 1000, 0, IntComparator()));
+  EXPECT_EQ(1000, bucket_page->KeyAt(10));
+  EXPECT_EQ(94, bucket_page->NumReadable());
+  EXPECT_EQ(6, bucket_page->NumTombstones());
+
+  std::vector<std::pair<int, int>> all;
+  bucket_page->GetAllValue(&all);
+  ASSERT_EQ(94, all.size());
+  EXPECT_EQ(1000, all[10].first);
+  EXPECT_EQ(11, all[11].first);
+
+  // filling the tombstones and then the free tail makes the bucket full
+  for (int i = 100; bucket_page->Insert(i, i, 0, IntComparator()); i++) {
+  }
+  EXPECT_TRUE(bucket_page->IsFull());
+  EXPECT_EQ(capacity, bucket_page->NumReadable());
+  EXPECT_EQ(0, bucket_page->NumTombstones());
+
+  // removing the last pair resets the tombstones
+  all.clear();
+  bucket_page->GetAllValue(&all);
+  for (auto &[key, value] : all) {
+    EXPECT_TRUE(bucket_page->Remove(key, value, 0, IntComparator()));
+  }
+  EXPECT_TRUE(bucket_page->IsEmpty());
+  EXPECT_EQ(0, bucket_page->NumTombstones());
+  EXPECT_FALSE(bucket_page->IsOccupied(0));
+
+  bpm->UnpinPage(bucket_page_id, true, nullptr);
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
 }  // namespace bustub
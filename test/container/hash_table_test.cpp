@@ -11,6 +11,7 @@
 //===----------------------------------------------------------------------===//
 
 #include <thread>  // NOLINT
+#include <utility>
 #include <vector>
 
 #include "buffer/buffer_pool_manager_instance.h"
@@ -18,6 +19,7 @@
 #include "container/hash/extendible_hash_table.h"
 #include "gtest/gtest.h"
 #include "murmur3/MurmurHash3.h"
+#include "test_util.h"  // NOLINT
 
 namespace bustub {
 
@@ -117,4 +119,345 @@ TEST(HashTableTest, SampleTest) {
   delete bpm;
 }
 
+// NOLINTNEXTLINE
+TEST(HashTableTest, ConcurrentInsertRemoveTest) {
+  const int num_threads = 4;
+  const int keys_per_thread = 5000;
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  ExtendibleHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), HashFunction<int>());
+
+  // writers on different buckets run concurrently, splits happen while other threads insert
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([&ht, tid]() {
+      for (int i = tid; i < num_threads * keys_per_thread; i += num_threads) {
+        EXPECT_TRUE(ht.Insert(nullptr, i, i));
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  ht.VerifyIntegrity();
+
+  for (int i = 0; i < num_threads * keys_per_thread; i++) {
+    std::vector<int> res;
+    ht.GetValue(nullptr, i, &res);
+    ASSERT_EQ(1, res.size()) << "Failed to keep " << i << std::endl;
+    EXPECT_EQ(i, res[0]);
+  }
+
+  // remove the even keys while readers look up the odd ones, emptied buckets get merged
+  threads.clear();
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([&ht, tid]() {
+      for (int i = 2 * tid; i < num_threads * keys_per_thread; i += 2 * num_threads) {
+        EXPECT_TRUE(ht.Remove(nullptr, i, i));
+        std::vector<int> res;
+        ht.GetValue(nullptr, i + 1, &res);
+        EXPECT_EQ(1, res.size());
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  ht.VerifyIntegrity();
+
+  for (int i = 0; i < num_threads * keys_per_thread; i++) {
+    std::vector<int> res;
+    ht.GetValue(nullptr, i, &res);
+    EXPECT_EQ(i % 2 == 0 ? 0 : 1, res.size());
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(HashTableTest, MultipleDirectoriesTest) {
+  const int num_keys = 20000;
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  // a single directory, as before the root page, and a root fanning out to four directories
+  ExtendibleHashTable<int, int, IntComparator> single("single", bpm, IntComparator(), HashFunction<int>(), 0);
+  ExtendibleHashTable<int, int, IntComparator> multi("multi", bpm, IntComparator(), HashFunction<int>(), 2);
+
+  // lookups and removes into directories that were never allocated find nothing
+  std::vector<int> res;
+  EXPECT_FALSE(multi.GetValue(nullptr, 1, &res));
+  EXPECT_FALSE(multi.Remove(nullptr, 1, 1));
+  EXPECT_EQ(0, multi.GetGlobalDepth());
+
+  for (int i = 0; i < num_keys; i++) {
+    EXPECT_TRUE(single.Insert(nullptr, i, i));
+    EXPECT_TRUE(multi.Insert(nullptr, i, i));
+  }
+  EXPECT_FALSE(multi.Insert(nullptr, 0, 0));
+  single.VerifyIntegrity();
+  multi.VerifyIntegrity();
+
+  // each directory only sees a quarter of the keys, so none grows as deep as the single one
+  EXPECT_LT(multi.GetGlobalDepth(), single.GetGlobalDepth());
+
+  for (int i = 0; i < num_keys; i++) {
+    res.clear();
+    EXPECT_TRUE(multi.GetValue(nullptr, i, &res));
+    ASSERT_EQ(1, res.size());
+    EXPECT_EQ(i, res[0]);
+  }
+
+  for (int i = 0; i < num_keys; i++) {
+    EXPECT_TRUE(multi.Remove(nullptr, i, i));
+  }
+  multi.VerifyIntegrity();
+  for (int i = 0; i < num_keys; i++) {
+    res.clear();
+    EXPECT_FALSE(multi.GetValue(nullptr, i, &res));
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(HashTableTest, RootGrowthTest) {
+  // wide keys keep buckets small: 55 pairs each, so one directory of 512 buckets holds at most 28160
+  const int num_keys = 60000;
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<64> comparator(key_schema.get());
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  ExtendibleHashTable<GenericKey<64>, RID, GenericComparator<64>> ht("blah", bpm, comparator,
+                                                                     HashFunction<GenericKey<64>>(), 0);
+
+  GenericKey<64> key;
+  for (int i = 0; i < num_keys; i++) {
+    key.SetFromInteger(i);
+    ASSERT_TRUE(ht.Insert(nullptr, key, RID(i))) << "key " << i;
+  }
+  ht.VerifyIntegrity();
+
+  // the directory split across a deeper root, and every directory is counted once however many root indexes share it
+  auto stats = ht.GetStats();
+  EXPECT_GT(stats.num_directories_, 1);
+  EXPECT_EQ(num_keys, stats.num_entries_);
+
+  std::vector<RID> res;
+  for (int i = 0; i < num_keys; i++) {
+    key.SetFromInteger(i);
+    res.clear();
+    EXPECT_TRUE(ht.GetValue(nullptr, key, &res));
+    ASSERT_EQ(1, res.size());
+    EXPECT_EQ(RID(i), res[0]);
+  }
+  for (int i = 0; i < num_keys; i += 2) {
+    key.SetFromInteger(i);
+    EXPECT_TRUE(ht.Remove(nullptr, key, RID(i)));
+  }
+  ht.VerifyIntegrity();
+  for (int i = 0; i < num_keys; i++) {
+    key.SetFromInteger(i);
+    res.clear();
+    EXPECT_EQ(i % 2 == 1, ht.GetValue(nullptr, key, &res));
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(HashTableTest, GetValuesTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  ExtendibleHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), HashFunction<int>(), 2);
+
+  // even keys have two values, odd keys one, keys from 10000 on are missing
+  for (int i = 0; i < 5000; i++) {
+    EXPECT_TRUE(ht.Insert(nullptr, i, i));
+    if (i % 2 == 0) {
+      EXPECT_TRUE(ht.Insert(nullptr, i, i + 100000));
+    }
+  }
+
+  // a batch spanning many buckets and several directories, with repeated keys
+  std::vector<int> keys;
+  for (int i = 0; i < 2000; i++) {
+    keys.push_back((i * 7919) % 12000);
+  }
+  keys.push_back(keys[0]);
+  std::vector<std::vector<int>> results;
+  ht.GetValues(nullptr, keys, &results);
+  ASSERT_EQ(keys.size(), results.size());
+  for (size_t i = 0; i < keys.size(); i++) {
+    std::vector<int> expected;
+    ht.GetValue(nullptr, keys[i], &expected);
+    EXPECT_EQ(expected, results[i]) << "key " << keys[i];
+    EXPECT_EQ(keys[i] >= 5000 ? 0 : keys[i] % 2 == 0 ? 2 : 1, results[i].size());
+  }
+
+  ht.GetValues(nullptr, {}, &results);
+  EXPECT_TRUE(results.empty());
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(HashTableTest, BulkLoadTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(50, disk_manager);
+
+  // distinct keys, half of them with a second value
+  std::vector<std::pair<int, int>> entries;
+  for (int i = 0; i < 50000; i++) {
+    entries.emplace_back(i, i);
+    if (i % 2 == 0) {
+      entries.emplace_back(i, i + 100000);
+    }
+  }
+
+  for (size_t num_threads : {1, 4}) {
+    ExtendibleHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), HashFunction<int>(), 0);
+    EXPECT_TRUE(ht.BulkLoad(nullptr, entries, num_threads));
+    ht.VerifyIntegrity();
+    // the depths were picked for the final size, so the table is as deep as inserting one by one makes it at most
+    EXPECT_GE(ht.GetGlobalDepth(), 1);
+    EXPECT_LE(ht.GetGlobalDepth(), 9);
+
+    for (int i = 0; i < 50000; i++) {
+      std::vector<int> res;
+      ht.GetValue(nullptr, i, &res);
+      ASSERT_EQ(i % 2 == 0 ? 2 : 1, res.size()) << "Failed to load " << i;
+    }
+
+    // the loaded table keeps working as usual
+    EXPECT_FALSE(ht.Insert(nullptr, 7, 7));
+    EXPECT_TRUE(ht.Insert(nullptr, 50000, 50000));
+    EXPECT_TRUE(ht.Remove(nullptr, 8, 8));
+    ht.VerifyIntegrity();
+  }
+
+  // buckets that overflow and tables that are not empty fall back to inserting
+  std::vector<std::pair<int, int>> duplicates;
+  for (int i = 0; i < 1000; i++) {
+    duplicates.emplace_back(i < 400 ? 42 : i + 1000, i);
+  }
+  for (int i = 0; i < 1000; i++) {
+    duplicates.emplace_back(i + 2000, i);
+  }
+  ExtendibleHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), HashFunction<int>());
+  EXPECT_TRUE(ht.BulkLoad(nullptr, {duplicates.begin(), duplicates.begin() + 1000}));
+  EXPECT_TRUE(ht.BulkLoad(nullptr, {duplicates.begin() + 1000, duplicates.end()}));
+  ht.VerifyIntegrity();
+  std::vector<int> res;
+  ht.GetValue(nullptr, 42, &res);
+  EXPECT_EQ(400, res.size());
+  for (int i = 1400; i < 3000; i++) {
+    res.clear();
+    ht.GetValue(nullptr, i, &res);
+    ASSERT_EQ(1, res.size());
+  }
+
+  // more values of a key than a bucket holds cannot all be loaded, and the load says so
+  using KeyType = int;
+  using ValueType = int;
+  std::vector<std::pair<int, int>> too_many;
+  for (int i = 0; i <= static_cast<int>(BUCKET_ARRAY_SIZE); i++) {
+    too_many.emplace_back(43, i);
+  }
+  ExtendibleHashTable<int, int, IntComparator> overflowing("blah", bpm, IntComparator(), HashFunction<int>());
+  EXPECT_FALSE(overflowing.BulkLoad(nullptr, too_many));
+  EXPECT_FALSE(ht.BulkLoad(nullptr, too_many));
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(HashTableTest, StatsTest) {
+  using KeyType = int;
+  using ValueType = int;
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  ExtendibleHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), HashFunction<int>(), 2);
+
+  auto stats = ht.GetStats();
+  EXPECT_EQ(0, stats.num_directories_);
+  EXPECT_EQ(1, stats.pages_used_);
+
+  for (int i = 0; i < 5000; i++) {
+    ht.Insert(nullptr, i, i);
+  }
+  for (int i = 0; i < 1000; i++) {
+    ht.Remove(nullptr, i, i);
+  }
+  stats = ht.GetStats();
+  EXPECT_EQ(ht.GetGlobalDepth(), stats.global_depth_);
+  EXPECT_EQ(4, stats.num_directories_);
+  EXPECT_EQ(1 + stats.num_directories_ + stats.num_buckets_, stats.pages_used_);
+  EXPECT_EQ(stats.num_buckets_, stats.num_sampled_buckets_);
+  EXPECT_EQ(4000, stats.num_entries_);
+  EXPECT_GT(stats.TombstoneRatio(), 0);
+  EXPECT_LT(stats.TombstoneRatio(), 0.5);
+  EXPECT_GT(stats.AverageFill(), 0.2);
+  EXPECT_GE(stats.AverageProbeLength(), 1);
+  EXPECT_LE(stats.AverageProbeLength(), (BUCKET_ARRAY_SIZE + BUCKET_GROUP_SIZE - 1) / BUCKET_GROUP_SIZE);
+  uint64_t buckets = 0;
+  uint64_t filled = 0;
+  for (size_t depth = 0; depth < NUM_LOCAL_DEPTHS; depth++) {
+    buckets += stats.local_depth_histogram_[depth];
+  }
+  for (auto count : stats.fill_histogram_) {
+    filled += count;
+  }
+  EXPECT_EQ(stats.num_buckets_, buckets);
+  EXPECT_EQ(stats.num_buckets_, filled);
+  EXPECT_FALSE(stats.ToString().empty());
+
+  auto sampled = ht.GetStats(2);
+  EXPECT_EQ(stats.num_buckets_, sampled.num_buckets_);
+  EXPECT_EQ((stats.num_buckets_ + 1) / 2, sampled.num_sampled_buckets_);
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(HashTableTest, StatsSkewTest) {
+  using KeyType = int;
+  using ValueType = int;
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  ExtendibleHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), HashFunction<int>(), 0);
+
+  // one key with more values than a bucket holds: every split leaves them all on one side
+  for (int i = 0; i <= static_cast<int>(BUCKET_ARRAY_SIZE); i++) {
+    ht.Insert(nullptr, 0, i);
+  }
+  auto stats = ht.GetStats();
+  EXPECT_EQ(NUM_LOCAL_DEPTHS - 1, stats.MaxLocalDepth());
+  EXPECT_EQ(1, stats.num_full_buckets_);
+  EXPECT_EQ(1, stats.fill_histogram_[NUM_FILL_BUCKETS - 1]);
+  EXPECT_LT(stats.AverageFill(), 0.2);
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
 }  // namespace bustub
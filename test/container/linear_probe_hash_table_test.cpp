@@ -0,0 +1,253 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// linear_probe_hash_table_test.cpp
+//
+// Identification: test/container/linear_probe_hash_table_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <atomic>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "common/exception.h"
+#include "container/hash/linear_probe_hash_table.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+// for BLOCK_ARRAY_SIZE
+using KeyType = int;
+using ValueType = int;
+
+// NOLINTNEXTLINE
+TEST(LinearProbeHashTableTest, SampleTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  LinearProbeHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), 1000, HashFunction<int>());
+  size_t initial_size = ht.GetSize();
+
+  // insert enough values to resize a few times
+  for (int i = 0; i < 5000; i++) {
+    EXPECT_TRUE(ht.Insert(nullptr, i, i));
+    std::vector<int> res;
+    ht.GetValue(nullptr, i, &res);
+    ASSERT_EQ(1, res.size()) << "Failed to insert " << i << std::endl;
+    EXPECT_EQ(i, res[0]);
+  }
+  EXPECT_GE(ht.GetSize(), 4 * initial_size);
+
+  // insert one more value for each key
+  for (int i = 0; i < 5000; i++) {
+    EXPECT_FALSE(ht.Insert(nullptr, i, i));
+    if (i == 0) {
+      continue;
+    }
+    EXPECT_TRUE(ht.Insert(nullptr, i, 2 * i));
+    std::vector<int> res;
+    ht.GetValue(nullptr, i, &res);
+    ASSERT_EQ(2, res.size());
+    EXPECT_EQ(3 * i, res[0] + res[1]);
+  }
+
+  // remove the first values
+  for (int i = 0; i < 5000; i++) {
+    EXPECT_TRUE(ht.Remove(nullptr, i, i));
+    EXPECT_FALSE(ht.Remove(nullptr, i, i));
+    std::vector<int> res;
+    ht.GetValue(nullptr, i, &res);
+    if (i == 0) {
+      EXPECT_EQ(0, res.size());
+    } else {
+      ASSERT_EQ(1, res.size());
+      EXPECT_EQ(2 * i, res[0]);
+    }
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(LinearProbeHashTableTest, IncrementalResizeTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  LinearProbeHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), 16 * BLOCK_ARRAY_SIZE,
+                                                   HashFunction<int>());
+  size_t size = ht.GetSize();
+  int num_keys = static_cast<int>(size / 4);
+  for (int i = 0; i < num_keys; i++) {
+    ht.Insert(nullptr, i, i);
+  }
+  EXPECT_FALSE(ht.IsResizing());
+
+  // the resize itself does not move anything
+  ht.Resize(size);
+  EXPECT_TRUE(ht.IsResizing());
+  EXPECT_GE(ht.GetSize(), 2 * size);
+
+  // pairs still in the old table are found by inserts and removes
+  EXPECT_FALSE(ht.Insert(nullptr, num_keys - 1, num_keys - 1));
+  EXPECT_TRUE(ht.Remove(nullptr, num_keys - 1, num_keys - 1));
+  EXPECT_TRUE(ht.Insert(nullptr, num_keys - 1, num_keys - 1));
+  EXPECT_TRUE(ht.IsResizing());
+
+  // each write migrates a couple of blocks, everything stays visible meanwhile
+  int ops = 0;
+  while (ht.IsResizing()) {
+    int key = num_keys + ops;
+    EXPECT_TRUE(ht.Insert(nullptr, key, key));
+    for (int i = 0; i <= key; i++) {
+      std::vector<int> res;
+      ht.GetValue(nullptr, i, &res);
+      ASSERT_EQ(1, res.size()) << "Lost " << i << " after " << ops << " operations";
+      EXPECT_EQ(i, res[0]);
+    }
+    ops++;
+  }
+  EXPECT_GT(ops, 1);
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(LinearProbeHashTableTest, ConcurrentReadersTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  LinearProbeHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), BLOCK_ARRAY_SIZE,
+                                                   HashFunction<int>());
+  const int num_preloaded = 1000;
+  const int num_inserted = 20000;
+  for (int i = 0; i < num_preloaded; i++) {
+    ht.Insert(nullptr, i, i);
+  }
+
+  // readers must see every preloaded key while the writer keeps resizing the table
+  std::atomic<bool> done{false};
+  std::atomic<int> misses{0};
+  std::vector<std::thread> readers;
+  for (int t = 0; t < 4; t++) {
+    readers.emplace_back([&, t] {
+      for (int i = t; !done; i = (i + 7) % num_preloaded) {
+        std::vector<int> res;
+        ht.GetValue(nullptr, i, &res);
+        if (res.size() != 1 || res[0] != i) {
+          misses++;
+        }
+      }
+    });
+  }
+  for (int i = num_preloaded; i < num_preloaded + num_inserted; i++) {
+    ht.Insert(nullptr, i, i);
+  }
+  done = true;
+  for (auto &reader : readers) {
+    reader.join();
+  }
+  EXPECT_EQ(0, misses);
+
+  for (int i = 0; i < num_preloaded + num_inserted; i++) {
+    std::vector<int> res;
+    ht.GetValue(nullptr, i, &res);
+    ASSERT_EQ(1, res.size());
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(LinearProbeHashTableTest, ConcurrentMigrationTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  LinearProbeHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), 16 * BLOCK_ARRAY_SIZE,
+                                                   HashFunction<int>());
+  const int num_threads = 4;
+  const int num_kept = 1000;
+  const int num_removed = 1000;
+  for (int i = 0; i < num_kept + num_removed; i++) {
+    ht.Insert(nullptr, i, i);
+  }
+  ht.Resize(ht.GetSize());
+  ASSERT_TRUE(ht.IsResizing());
+
+  // writers migrate the old table while they insert and remove, readers must see every kept pair exactly once
+  std::atomic<bool> done{false};
+  std::atomic<int> misses{0};
+  std::atomic<int> failed_removes{0};
+  std::vector<std::thread> readers;
+  for (int t = 0; t < 2; t++) {
+    readers.emplace_back([&, t] {
+      for (int i = t; !done; i = (i + 7) % num_kept) {
+        std::vector<int> res;
+        ht.GetValue(nullptr, i, &res);
+        if (res.size() != 1 || res[0] != i) {
+          misses++;
+        }
+      }
+    });
+  }
+  std::vector<std::thread> writers;
+  for (int t = 0; t < num_threads; t++) {
+    writers.emplace_back([&, t] {
+      for (int i = num_kept + t; i < num_kept + num_removed; i += num_threads) {
+        if (!ht.Remove(nullptr, i, i)) {
+          failed_removes++;
+        }
+        int key = i + num_removed;
+        ht.Insert(nullptr, key, key);
+      }
+    });
+  }
+  for (auto &writer : writers) {
+    writer.join();
+  }
+  done = true;
+  for (auto &reader : readers) {
+    reader.join();
+  }
+  EXPECT_EQ(0, misses);
+  EXPECT_EQ(0, failed_removes);
+  EXPECT_FALSE(ht.IsResizing());
+
+  for (int i = 0; i < num_kept + 2 * num_removed; i++) {
+    std::vector<int> res;
+    ht.GetValue(nullptr, i, &res);
+    bool removed = i >= num_kept && i < num_kept + num_removed;
+    ASSERT_EQ(removed ? 0 : 1, res.size()) << i;
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(LinearProbeHashTableTest, OutOfPagesTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  // the header page stays pinned while the blocks are allocated
+  auto *bpm = new BufferPoolManagerInstance(1, disk_manager);
+  EXPECT_THROW((LinearProbeHashTable<int, int, IntComparator>("blah", bpm, IntComparator(), 1000,
+                                                               HashFunction<int>())),
+               Exception);
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+}  // namespace bustub
@@ -25,13 +25,16 @@
 #include "execution/executors/insert_executor.h"
 #include "execution/executors/nested_loop_join_executor.h"
 #include "execution/expressions/aggregate_value_expression.h"
+#include "execution/expressions/arithmetic_expression.h"
 #include "execution/expressions/column_value_expression.h"
 #include "execution/expressions/comparison_expression.h"
 #include "execution/expressions/constant_value_expression.h"
+#include "execution/expressions/logic_expression.h"
 #include "execution/plans/delete_plan.h"
 #include "execution/plans/distinct_plan.h"
 #include "execution/plans/hash_join_plan.h"
 #include "execution/plans/limit_plan.h"
+#include "execution/plans/nested_index_join_plan.h"
 #include "execution/plans/seq_scan_plan.h"
 #include "execution/plans/update_plan.h"
 #include "executor_test_util.h"  // NOLINT
@@ -486,6 +489,118 @@ TEST_F(ExecutorTest, SimpleHashJoinTest) {
   }
 }
 
+// SELECT test_1.colA, test_3.colA, test_3.colB FROM test_1 JOIN test_3 ON test_1.colA = test_3.colA
+TEST_F(ExecutorTest, SimpleNestedIndexJoinTest) {
+  // Construct sequential scan of table test_1, its 1000 tuples probe the index in several batches
+  const Schema *out_schema1{};
+  std::unique_ptr<AbstractPlanNode> scan_plan1{};
+  {
+    auto *table_info = GetExecutorContext()->GetCatalog()->GetTable("test_1");
+    auto &schema = table_info->schema_;
+    auto *col_a = MakeColumnValueExpression(schema, 0, "colA");
+    out_schema1 = MakeOutputSchema({{"colA", col_a}});
+    scan_plan1 = std::make_unique<SeqScanPlanNode>(out_schema1, nullptr, table_info->oid_);
+  }
+
+  // Index test_3 on colA
+  auto *inner_info = GetExecutorContext()->GetCatalog()->GetTable("test_3");
+  auto key_schema = ParseCreateStatement("a integer");
+  GetExecutorContext()->GetCatalog()->CreateIndex<KeyType, ValueType, ComparatorType>(
+      GetTxn(), "index3", "test_3", inner_info->schema_, *key_schema, {0}, 8, HashFunctionType{});
+
+  // Construct the join plan
+  const Schema *out_schema{};
+  std::unique_ptr<NestedIndexJoinPlanNode> join_plan{};
+  {
+    auto *table1_col_a = MakeColumnValueExpression(*out_schema1, 0, "colA");
+    auto *table3_col_a = MakeColumnValueExpression(inner_info->schema_, 1, "colA");
+    auto *table3_col_b = MakeColumnValueExpression(inner_info->schema_, 1, "colB");
+    out_schema = MakeOutputSchema(
+        {{"table1_colA", table1_col_a}, {"table3_colA", table3_col_a}, {"table3_colB", table3_col_b}});
+    auto *predicate = MakeComparisonExpression(table1_col_a, table3_col_a, ComparisonType::Equal);
+    join_plan = std::make_unique<NestedIndexJoinPlanNode>(
+        out_schema, std::vector<const AbstractPlanNode *>{scan_plan1.get()}, predicate, inner_info->oid_, "index3",
+        out_schema1, &inner_info->schema_);
+  }
+
+  std::vector<Tuple> result_set{};
+  GetExecutionEngine()->Execute(join_plan.get(), &result_set, GetTxn(), GetExecutorContext());
+  ASSERT_EQ(result_set.size(), TEST3_SIZE);
+
+  std::unordered_set<int32_t> seen;
+  for (const auto &tuple : result_set) {
+    const auto t1_col_a = tuple.GetValue(out_schema, out_schema->GetColIdx("table1_colA")).GetAs<int32_t>();
+    const auto t3_col_a = tuple.GetValue(out_schema, out_schema->GetColIdx("table3_colA")).GetAs<int32_t>();
+    const auto t3_col_b = tuple.GetValue(out_schema, out_schema->GetColIdx("table3_colB")).GetAs<int32_t>();
+    ASSERT_EQ(t1_col_a, t3_col_a);
+    ASSERT_EQ(t3_col_a, t3_col_b);
+    seen.insert(t1_col_a);
+  }
+  ASSERT_EQ(seen.size(), TEST3_SIZE);
+}
+
+// SELECT test_1.colA, test_3.colA FROM test_1 JOIN test_3 ON <predicate>, for predicates of several shapes
+TEST_F(ExecutorTest, NestedIndexJoinPredicateShapesTest) {
+  const Schema *out_schema1{};
+  std::unique_ptr<AbstractPlanNode> scan_plan1{};
+  {
+    auto *table_info = GetExecutorContext()->GetCatalog()->GetTable("test_1");
+    auto &schema = table_info->schema_;
+    auto *col_a = MakeColumnValueExpression(schema, 0, "colA");
+    out_schema1 = MakeOutputSchema({{"colA", col_a}});
+    scan_plan1 = std::make_unique<SeqScanPlanNode>(out_schema1, nullptr, table_info->oid_);
+  }
+
+  auto *inner_info = GetExecutorContext()->GetCatalog()->GetTable("test_3");
+  auto key_schema = ParseCreateStatement("a integer");
+  GetExecutorContext()->GetCatalog()->CreateIndex<KeyType, ValueType, ComparatorType>(
+      GetTxn(), "index3", "test_3", inner_info->schema_, *key_schema, {0}, 8, HashFunctionType{});
+
+  auto *table1_col_a = MakeColumnValueExpression(*out_schema1, 0, "colA");
+  auto *table3_col_a = MakeColumnValueExpression(inner_info->schema_, 1, "colA");
+  auto *table3_col_b = MakeColumnValueExpression(inner_info->schema_, 1, "colB");
+  auto *out_schema = MakeOutputSchema({{"table1_colA", table1_col_a}, {"table3_colA", table3_col_a}});
+  auto join = [&](const AbstractExpression *predicate) {
+    NestedIndexJoinPlanNode join_plan(out_schema, std::vector<const AbstractPlanNode *>{scan_plan1.get()}, predicate,
+                                      inner_info->oid_, "index3", out_schema1, &inner_info->schema_);
+    std::vector<Tuple> result_set{};
+    GetExecutionEngine()->Execute(&join_plan, &result_set, GetTxn(), GetExecutorContext());
+    std::vector<std::pair<int32_t, int32_t>> pairs;
+    for (const auto &tuple : result_set) {
+      pairs.emplace_back(tuple.GetValue(out_schema, 0).GetAs<int32_t>(),
+                         tuple.GetValue(out_schema, 1).GetAs<int32_t>());
+    }
+    return pairs;
+  };
+
+  // the inner column first probes the index just the same
+  auto pairs = join(MakeComparisonExpression(table3_col_a, table1_col_a, ComparisonType::Equal));
+  ASSERT_EQ(pairs.size(), TEST3_SIZE);
+  for (const auto &[t1_col_a, t3_col_a] : pairs) {
+    ASSERT_EQ(t1_col_a, t3_col_a);
+  }
+
+  // computing on the inner column can't use the index, the join scans test_3 instead
+  auto *one = MakeConstantValueExpression(ValueFactory::GetIntegerValue(1));
+  pairs = join(MakeComparisonExpression(MakeArithmeticExpression(table3_col_a, one, ArithmeticType::Plus),
+                                        table1_col_a, ComparisonType::Equal));
+  ASSERT_EQ(pairs.size(), TEST3_SIZE);
+  for (const auto &[t1_col_a, t3_col_a] : pairs) {
+    ASSERT_EQ(t1_col_a, t3_col_a + 1);
+  }
+
+  // neither can a conjunction
+  auto *ten = MakeConstantValueExpression(ValueFactory::GetIntegerValue(10));
+  pairs = join(MakeLogicExpression(MakeComparisonExpression(table1_col_a, table3_col_a, ComparisonType::Equal),
+                                   MakeComparisonExpression(table3_col_b, ten, ComparisonType::LessThan),
+                                   LogicType::And));
+  ASSERT_EQ(pairs.size(), 10);
+  for (const auto &[t1_col_a, t3_col_a] : pairs) {
+    ASSERT_EQ(t1_col_a, t3_col_a);
+    ASSERT_LT(t3_col_a, 10);
+  }
+}
+
 // SELECT COUNT(col_a), SUM(col_a), min(col_a), max(col_a) from test_1;
 TEST_F(ExecutorTest, SimpleAggregationTest) {
   const Schema *scan_schema;
@@ -25,9 +25,11 @@
 #include "execution/execution_engine.h"
 #include "execution/executor_context.h"
 #include "execution/expressions/aggregate_value_expression.h"
+#include "execution/expressions/arithmetic_expression.h"
 #include "execution/expressions/column_value_expression.h"
 #include "execution/expressions/comparison_expression.h"
 #include "execution/expressions/constant_value_expression.h"
+#include "execution/expressions/logic_expression.h"
 #include "execution/plans/seq_scan_plan.h"
 #include "gtest/gtest.h"
 
@@ -173,6 +175,32 @@ class ExecutorTest : public ::testing::Test {
     return std::make_unique<ComparisonExpression>(lhs, rhs, comp_type);
   }
 
+  /**
+   * Make an arithmetic expression.
+   * @param lhs The abstract expression for the left-hand side of the computation
+   * @param rhs The abstract expression for the right-hand side of the computation
+   * @param compute_type The type of the computation
+   * @return A non-owning pointer to the ArithmeticExpression
+   */
+  const AbstractExpression *MakeArithmeticExpression(const AbstractExpression *lhs, const AbstractExpression *rhs,
+                                                     ArithmeticType compute_type) {
+    allocated_exprs_.emplace_back(std::make_unique<ArithmeticExpression>(lhs, rhs, compute_type));
+    return allocated_exprs_.back().get();
+  }
+
+  /**
+   * Make a logic expression.
+   * @param lhs The abstract expression for the left-hand side of the operation
+   * @param rhs The abstract expression for the right-hand side of the operation
+   * @param logic_type The type of the logic operation
+   * @return A non-owning pointer to the LogicExpression
+   */
+  const AbstractExpression *MakeLogicExpression(const AbstractExpression *lhs, const AbstractExpression *rhs,
+                                                LogicType logic_type) {
+    allocated_exprs_.emplace_back(std::make_unique<LogicExpression>(lhs, rhs, logic_type));
+    return allocated_exprs_.back().get();
+  }
+
   /**
    * Make an aggregate value expression.
    * @param is_group_by_term `true` if the expression is a group-by term, `false` otherwise
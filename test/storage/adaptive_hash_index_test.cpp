@@ -0,0 +1,205 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// adaptive_hash_index_test.cpp
+//
+// Identification: test/storage/adaptive_hash_index_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <atomic>
+#include <cstdio>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "gtest/gtest.h"
+#include "storage/index/adaptive_hash_index.h"
+#include "storage/index/b_plus_tree.h"
+#include "test_util.h"  // NOLINT
+
+namespace bustub {
+
+TEST(AdaptiveHashIndexTest, VoteTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+  // a single bucket, so that every key competes for it
+  AdaptiveHashIndex<GenericKey<8>, GenericComparator<8>> index(1, comparator);
+  GenericKey<8> hot;
+  GenericKey<8> cold;
+  hot.SetFromInteger(1);
+  cold.SetFromInteger(2);
+  page_id_t page_id;
+  int slot;
+
+  EXPECT_FALSE(index.Lookup(hot, &page_id, &slot));
+  index.RecordDescent(hot, 7, 3);
+  EXPECT_FALSE(index.Lookup(hot, &page_id, &slot));
+  index.RecordDescent(hot, 7, 3);
+  ASSERT_TRUE(index.Lookup(hot, &page_id, &slot));
+  EXPECT_EQ(7, page_id);
+  EXPECT_EQ(3, slot);
+
+  // a colder key has to outvote the hot one before it takes over the bucket
+  index.RecordDescent(cold, 8, 0);
+  EXPECT_FALSE(index.Lookup(cold, &page_id, &slot));
+  index.RecordDescent(cold, 8, 0);
+  index.RecordDescent(cold, 8, 0);
+  EXPECT_FALSE(index.Lookup(cold, &page_id, &slot));
+  index.RecordDescent(cold, 8, 0);
+  EXPECT_FALSE(index.Lookup(hot, &page_id, &slot));
+  ASSERT_TRUE(index.Lookup(cold, &page_id, &slot));
+  EXPECT_EQ(8, page_id);
+
+  index.Invalidate(cold);
+  EXPECT_FALSE(index.Lookup(cold, &page_id, &slot));
+  index.RecordDescent(cold, 9, 1);
+  ASSERT_TRUE(index.Lookup(cold, &page_id, &slot));
+  EXPECT_EQ(9, page_id);
+  EXPECT_EQ(3, index.GetHitCount());
+}
+
+/*
+ * Hot keys are found through the hash index, and still found after their leaves split and merge under it
+ */
+// NOLINTNEXTLINE
+TEST(AdaptiveHashIndexTest, LookupTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 4, 4);
+  tree.EnableAdaptiveHashIndex(1024);
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+
+  GenericKey<8> index_key;
+  std::vector<RID> rids;
+  const int64_t num_keys = 500;
+  for (int64_t key = 0; key < num_keys; key += 2) {
+    index_key.SetFromInteger(key);
+    tree.Insert(index_key, RID(0, key));
+  }
+  auto check = [&](int64_t key, bool present) {
+    index_key.SetFromInteger(key);
+    rids.clear();
+    EXPECT_EQ(present, tree.GetValue(index_key, &rids)) << key;
+    if (present && rids.size() == 1) {
+      EXPECT_EQ(key, rids[0].GetSlotNum());
+    }
+  };
+  for (int round = 0; round < 3; round++) {
+    for (int64_t key = 0; key < 20; key++) {
+      check(key, key % 2 == 0);
+    }
+  }
+  size_t hits = tree.GetAdaptiveHashIndex()->GetHitCount();
+  EXPECT_GT(hits, 0);
+
+  // split the leaves of the hot keys, then merge them away, checking the hot keys after every change
+  for (int64_t key = 1; key < 20; key += 2) {
+    index_key.SetFromInteger(key);
+    tree.Insert(index_key, RID(0, key));
+    for (int64_t hot = 0; hot < 20; hot++) {
+      check(hot, hot % 2 == 0 || hot <= key);
+    }
+  }
+  for (int64_t key = 0; key < 20; key++) {
+    index_key.SetFromInteger(key);
+    tree.Remove(index_key);
+    for (int64_t hot = 0; hot < 20; hot++) {
+      check(hot, hot > key);
+    }
+  }
+  EXPECT_GT(tree.GetAdaptiveHashIndex()->GetHitCount(), hits);
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+/*
+ * Readers of a few hot keys go through the hash index while writers split and merge the leaves around them
+ */
+// NOLINTNEXTLINE
+TEST(AdaptiveHashIndexTest, ConcurrentLookupTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(256, disk_manager);
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 4, 4);
+  tree.EnableAdaptiveHashIndex(64);
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+
+  // the hot keys are multiples of 100 and stay in the tree; the writers add and remove the keys in between
+  const int64_t num_keys = 2000;
+  GenericKey<8> index_key;
+  for (int64_t key = 0; key < num_keys; key += 100) {
+    index_key.SetFromInteger(key);
+    tree.Insert(index_key, RID(0, key));
+  }
+  const int num_writers = 4;
+  std::atomic<bool> writers_done{false};
+  std::atomic<int> errors{0};
+  auto writer = [&](int t) {
+    GenericKey<8> key;
+    for (int round = 0; round < 3; round++) {
+      for (int64_t k = t; k < num_keys; k += num_writers) {
+        if (k % 100 != 0) {
+          key.SetFromInteger(k);
+          tree.Insert(key, RID(0, k));
+        }
+      }
+      for (int64_t k = t; k < num_keys; k += num_writers) {
+        if (k % 100 != 0) {
+          key.SetFromInteger(k);
+          tree.Remove(key);
+        }
+      }
+    }
+  };
+  auto reader = [&]() {
+    GenericKey<8> key;
+    std::vector<RID> rids;
+    while (!writers_done) {
+      for (int64_t k = 0; k < num_keys; k += 100) {
+        key.SetFromInteger(k);
+        rids.clear();
+        if (!tree.GetValue(key, &rids) || rids.size() != 1 || rids[0].GetSlotNum() != k) {
+          errors++;
+        }
+      }
+    }
+  };
+
+  std::vector<std::thread> threads;
+  std::thread reader_thread(reader);
+  for (int t = 0; t < num_writers; t++) {
+    threads.emplace_back(writer, t);
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  writers_done = true;
+  reader_thread.join();
+  EXPECT_EQ(0, errors);
+  EXPECT_GT(tree.GetAdaptiveHashIndex()->GetHitCount(), 0);
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+}  // namespace bustub
@@ -12,6 +12,11 @@
 
 #include <algorithm>
 #include <cstdio>
+#include <map>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include "buffer/buffer_pool_manager_instance.h"
 #include "gtest/gtest.h"
@@ -20,7 +25,7 @@
 
 namespace bustub {
 
-TEST(BPlusTreeTests, DISABLED_InsertTest1) {
+TEST(BPlusTreeTests, InsertTest1) {
   // create KeyComparator and index schema
   auto key_schema = ParseCreateStatement("a bigint");
   GenericComparator<8> comparator(key_schema.get());
@@ -78,7 +83,7 @@ TEST(BPlusTreeTests, DISABLED_InsertTest1) {
   remove("test.log");
 }
 
-TEST(BPlusTreeTests, DISABLED_InsertTest2) {
+TEST(BPlusTreeTests, InsertTest2) {
   // create KeyComparator and index schema
   auto key_schema = ParseCreateStatement("a bigint");
   GenericComparator<8> comparator(key_schema.get());
@@ -145,4 +150,528 @@ TEST(BPlusTreeTests, DISABLED_InsertTest2) {
   remove("test.db");
   remove("test.log");
 }
+// NOLINTNEXTLINE
+TEST(BPlusTreeTests, RangeScanTest) {
+  // create KeyComparator and index schema
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  // create b+ tree with small pages so scans cross many leaves
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 3, 3);
+  GenericKey<8> index_key;
+  GenericKey<8> end_key;
+  RID rid;
+  // create transaction
+  Transaction *transaction = new Transaction(0);
+
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+
+  // even keys from 2 to 100, inserted in random order
+  std::vector<int64_t> keys;
+  for (int64_t key = 2; key <= 100; key += 2) {
+    keys.push_back(key);
+  }
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(7));
+  for (auto key : keys) {
+    rid.Set(0, key);
+    index_key.SetFromInteger(key);
+    tree.Insert(index_key, rid, transaction);
+  }
+
+  // backward over the whole tree
+  int64_t current_key = 100;
+  for (auto iterator = tree.RBegin(); iterator != tree.End(); --iterator) {
+    EXPECT_EQ((*iterator).second.GetSlotNum(), current_key);
+    current_key -= 2;
+  }
+  EXPECT_EQ(current_key, 0);
+
+  // iterators must not outlive the buffer pool
+  {
+    // backward from a key that is in the tree, and from one that is not
+    index_key.SetFromInteger(50);
+    auto iterator = tree.RBegin(index_key);
+    EXPECT_EQ((*iterator).second.GetSlotNum(), 50);
+    iterator = tree.RBegin(index_key, false);
+    EXPECT_EQ((*iterator).second.GetSlotNum(), 48);
+    index_key.SetFromInteger(51);
+    iterator = tree.RBegin(index_key, false);
+    EXPECT_EQ((*iterator).second.GetSlotNum(), 50);
+    index_key.SetFromInteger(2);
+    EXPECT_TRUE(tree.RBegin(index_key, false).IsEnd());
+
+    // forward with an inclusive and an exclusive upper bound
+    index_key.SetFromInteger(11);
+    end_key.SetFromInteger(40);
+    for (bool end_inclusive : {true, false}) {
+      current_key = 12;
+      for (iterator = tree.Begin(index_key, end_key, end_inclusive); !iterator.IsEnd(); ++iterator) {
+        EXPECT_EQ((*iterator).second.GetSlotNum(), current_key);
+        current_key += 2;
+      }
+      EXPECT_EQ(current_key, end_inclusive ? 42 : 40);
+    }
+
+    // turn around in the middle of a scan
+    index_key.SetFromInteger(30);
+    iterator = tree.Begin(index_key);
+    for (int i = 0; i < 10; i++) {
+      ++iterator;
+    }
+    EXPECT_EQ((*iterator).second.GetSlotNum(), 50);
+    for (int i = 0; i < 20; i++) {
+      --iterator;
+    }
+    EXPECT_EQ((*iterator).second.GetSlotNum(), 10);
+    ++iterator;
+    EXPECT_EQ((*iterator).second.GetSlotNum(), 12);
+    EXPECT_TRUE(iterator == tree.Begin((*iterator).first));
+  }
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete transaction;
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+// NOLINTNEXTLINE
+TEST(BPlusTreeTests, BulkLoadTest) {
+  // create KeyComparator and index schema
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  // create b+ tree with small pages so the load builds several internal levels
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 8, 6);
+  GenericKey<8> index_key;
+  RID rid;
+  // create transaction
+  Transaction *transaction = new Transaction(0);
+
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+
+  // even keys in order, then keys that do not extend the sorted run
+  std::vector<std::pair<GenericKey<8>, RID>> entries;
+  std::vector<int64_t> keys;
+  for (int64_t key = 0; key < 10000; key += 2) {
+    keys.push_back(key);
+  }
+  keys.push_back(3);
+  keys.push_back(1);
+  keys.push_back(4);
+  for (auto key : keys) {
+    index_key.SetFromInteger(key);
+    rid.Set(static_cast<int32_t>(key >> 32), key & 0xFFFFFFFF);
+    entries.emplace_back(index_key, rid);
+  }
+  tree.BulkLoad(entries, 75, transaction);
+
+  // every leaf is at least half full and has room for more inserts
+  index_key.SetFromInteger(0);
+  Page *leaf_page = tree.FindLeafPage(index_key, true);
+  page_id_t leaf_page_id = leaf_page->GetPageId();
+  leaf_page->RUnlatch();
+  bpm->UnpinPage(leaf_page_id, false);
+  int num_leaves = 0;
+  while (leaf_page_id != INVALID_PAGE_ID) {
+    leaf_page = bpm->FetchPage(leaf_page_id);
+    auto leaf = reinterpret_cast<BPlusTreeLeafPage<GenericKey<8>, RID, GenericComparator<8>> *>(leaf_page->GetData());
+    EXPECT_GE(leaf->GetSize(), leaf->GetMinSize());
+    EXPECT_LT(leaf->GetSize(), leaf->GetMaxSize());
+    bpm->UnpinPage(leaf_page_id, false);
+    leaf_page_id = leaf->GetNextPageId();
+    num_leaves++;
+  }
+  // 5000 sorted keys at 5 per leaf, plus at most one split for the two deferred keys
+  EXPECT_GE(num_leaves, 1000);
+  EXPECT_LE(num_leaves, 1001);
+
+  std::vector<RID> rids;
+  for (auto key : keys) {
+    rids.clear();
+    index_key.SetFromInteger(key);
+    EXPECT_TRUE(tree.GetValue(index_key, &rids));
+    EXPECT_EQ(rids.size(), 1);
+    EXPECT_EQ(rids[0].GetSlotNum(), key);
+  }
+
+  // the loaded tree takes inserts and removes like any other
+  for (int64_t key = 5; key < 10000; key += 2) {
+    index_key.SetFromInteger(key);
+    rid.Set(static_cast<int32_t>(key >> 32), key & 0xFFFFFFFF);
+    EXPECT_TRUE(tree.Insert(index_key, rid, transaction));
+  }
+  for (int64_t key = 0; key < 10000; key += 3) {
+    index_key.SetFromInteger(key);
+    tree.Remove(index_key, transaction);
+  }
+  int64_t current_key = 1;
+  for (auto iterator = tree.Begin(); iterator != tree.End(); ++iterator) {
+    EXPECT_EQ((*iterator).second.GetSlotNum(), current_key);
+    current_key += current_key % 3 == 1 ? 1 : 2;
+  }
+  EXPECT_EQ(current_key, 10000);
+
+  // loading into a non-empty tree inserts one by one
+  entries.clear();
+  for (int64_t key : {10001, 0}) {
+    index_key.SetFromInteger(key);
+    rid.Set(static_cast<int32_t>(key >> 32), key & 0xFFFFFFFF);
+    entries.emplace_back(index_key, rid);
+  }
+  tree.BulkLoad(entries, 75, transaction);
+  for (int64_t key : {10001, 0}) {
+    rids.clear();
+    index_key.SetFromInteger(key);
+    EXPECT_TRUE(tree.GetValue(index_key, &rids));
+  }
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete transaction;
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+// NOLINTNEXTLINE
+TEST(BPlusTreeTests, TruncatedKeysTest) {
+  // long keys that share most of their bytes, as composite keys with a common leading column do
+  auto key_schema = ParseCreateStatement("a varchar(40),b integer");
+  GenericComparator<64> comparator(key_schema.get());
+  using LeafPage = BPlusTreeLeafPage<GenericKey<64>, RID, GenericComparator<64>>;
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  BPlusTree<GenericKey<64>, RID, GenericComparator<64>> tree("foo_pk", bpm, comparator);
+  Transaction *transaction = new Transaction(0);
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+
+  const int num_keys = 20000;
+  auto make_key = [&key_schema](int i) {
+    char name[48];
+    snprintf(name, sizeof(name), "warehouse-01/customer-%06d", i / 4);
+    GenericKey<64> key;
+    key.SetFromKey(Tuple({Value(TypeId::VARCHAR, std::string(name)), Value(TypeId::INTEGER, i % 4)}, key_schema.get()),
+                   key_schema.get());
+    return key;
+  };
+  std::vector<int> order(num_keys);
+  for (int i = 0; i < num_keys; i++) {
+    order[i] = i;
+  }
+  std::mt19937 gen(15445);
+  std::shuffle(order.begin(), order.end(), gen);
+  for (int i : order) {
+    EXPECT_TRUE(tree.Insert(make_key(i), RID(i / 1000, i % 1000), transaction));
+  }
+
+  // every key lies within the fences of its leaf, and leaves hold far more keys than the 56 that fit untruncated
+  auto check_leaves = [&](int expected_keys) {
+    Page *leaf_page = tree.FindLeafPage(GenericKey<64>{}, true);
+    page_id_t leaf_page_id = leaf_page->GetPageId();
+    leaf_page->RUnlatch();
+    bpm->UnpinPage(leaf_page_id, false);
+    int num_leaves = 0;
+    int total_keys = 0;
+    while (leaf_page_id != INVALID_PAGE_ID) {
+      leaf_page = bpm->FetchPage(leaf_page_id);
+      auto leaf = reinterpret_cast<LeafPage *>(leaf_page->GetData());
+      for (int i = 0; i < leaf->GetSize(); i++) {
+        if (leaf->GetLowFence() != nullptr) {
+          EXPECT_LE(comparator(*leaf->GetLowFence(), leaf->KeyAt(i)), 0);
+        }
+        if (leaf->GetHighFence() != nullptr) {
+          EXPECT_LT(comparator(leaf->KeyAt(i), *leaf->GetHighFence()), 0);
+        }
+      }
+      total_keys += leaf->GetSize();
+      bpm->UnpinPage(leaf_page_id, false);
+      leaf_page_id = leaf->GetNextPageId();
+      num_leaves++;
+    }
+    EXPECT_EQ(total_keys, expected_keys);
+    return num_leaves;
+  };
+  EXPECT_LT(check_leaves(num_keys), num_keys / 100);
+
+  std::vector<RID> rids;
+  for (int i = 0; i < num_keys; i++) {
+    rids.clear();
+    EXPECT_TRUE(tree.GetValue(make_key(i), &rids));
+    ASSERT_EQ(rids.size(), 1);
+    EXPECT_EQ(rids[0], RID(i / 1000, i % 1000));
+  }
+
+  // remove all but every fourth key, which merges and redistributes leaves with different prefixes
+  for (int i : order) {
+    if (i % 4 != 0) {
+      tree.Remove(make_key(i), transaction);
+    }
+  }
+  check_leaves(num_keys / 4);
+  int current = 0;
+  for (auto iterator = tree.Begin(); iterator != tree.End(); ++iterator) {
+    EXPECT_EQ(comparator((*iterator).first, make_key(current)), 0);
+    EXPECT_EQ((*iterator).second, RID(current / 1000, current % 1000));
+    current += 4;
+  }
+  EXPECT_EQ(current, num_keys);
+  for (int i = 0; i < num_keys; i++) {
+    rids.clear();
+    EXPECT_EQ(tree.GetValue(make_key(i), &rids), i % 4 == 0);
+  }
+
+  // a bulk load fills the leaves by bytes as well
+  BPlusTree<GenericKey<64>, RID, GenericComparator<64>> loaded("foo_sk", bpm, comparator);
+  std::vector<std::pair<GenericKey<64>, RID>> entries;
+  for (int i = 0; i < num_keys; i++) {
+    entries.emplace_back(make_key(i), RID(i / 1000, i % 1000));
+  }
+  loaded.BulkLoad(entries, 90, transaction);
+  Page *leaf_page = loaded.FindLeafPage(GenericKey<64>{}, true);
+  page_id_t leaf_page_id = leaf_page->GetPageId();
+  leaf_page->RUnlatch();
+  bpm->UnpinPage(leaf_page_id, false);
+  int num_leaves = 0;
+  while (leaf_page_id != INVALID_PAGE_ID) {
+    leaf_page = bpm->FetchPage(leaf_page_id);
+    auto leaf = reinterpret_cast<LeafPage *>(leaf_page->GetData());
+    EXPECT_TRUE(leaf->IsHalfFull());
+    EXPECT_TRUE(leaf->HasRoomForAnyEntry());
+    bpm->UnpinPage(leaf_page_id, false);
+    leaf_page_id = leaf->GetNextPageId();
+    num_leaves++;
+  }
+  EXPECT_LT(num_leaves, num_keys / 150);
+  for (int i = 0; i < num_keys; i += 7) {
+    rids.clear();
+    EXPECT_TRUE(loaded.GetValue(make_key(i), &rids));
+  }
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete transaction;
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+/*
+ * Keys of low cardinality: every key is stored once, with its RIDs in a posting list that moves to overflow pages
+ * as it grows, and back into the leaf as it shrinks.
+ */
+// NOLINTNEXTLINE
+TEST(BPlusTreeTests, NonUniqueKeysTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  // pages fill up in bytes
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_sk", bpm, comparator, PAGE_SIZE, PAGE_SIZE, false);
+  Transaction *transaction = new Transaction(0);
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+
+  const int num_keys = 10;
+  const int rids_per_key = 5000;
+  auto make_key = [](int64_t k) {
+    GenericKey<8> key;
+    key.SetFromInteger(k);
+    return key;
+  };
+  auto make_rid = [](int j) { return RID(j / 100, j % 100); };
+  // RIDs arrive out of order, so that they go into the middle of posting lists as well
+  std::vector<int> order(num_keys * rids_per_key);
+  for (size_t i = 0; i < order.size(); i++) {
+    order[i] = static_cast<int>(i);
+  }
+  std::shuffle(order.begin(), order.end(), std::mt19937(15445));
+  for (int i : order) {
+    EXPECT_TRUE(tree.Insert(make_key(i % num_keys), make_rid(i / num_keys), transaction));
+  }
+  EXPECT_FALSE(tree.Insert(make_key(3), make_rid(42), transaction));
+
+  // a key and its RIDs take about two bytes per RID; a key repeated per entry would take some 400 pages
+  ASSERT_NE(bpm->NewPage(&page_id), nullptr);
+  EXPECT_LT(page_id, 80);
+  bpm->UnpinPage(page_id, false);
+  bpm->DeletePage(page_id);
+
+  std::vector<RID> rids;
+  for (int k = 0; k < num_keys; k++) {
+    rids.clear();
+    EXPECT_TRUE(tree.GetValue(make_key(k), &rids));
+    ASSERT_EQ(rids.size(), rids_per_key);
+    for (int j = 0; j < rids_per_key; j++) {
+      EXPECT_EQ(rids[j], make_rid(j));
+    }
+  }
+  rids.clear();
+  EXPECT_FALSE(tree.GetValue(make_key(num_keys), &rids));
+
+  // the iterator yields every pair, keys in order and the RIDs of a key in order
+  int count = 0;
+  for (auto iterator = tree.Begin(); iterator != tree.End(); ++iterator) {
+    EXPECT_EQ(comparator((*iterator).first, make_key(count / rids_per_key)), 0);
+    EXPECT_EQ((*iterator).second, make_rid(count % rids_per_key));
+    count++;
+  }
+  EXPECT_EQ(count, num_keys * rids_per_key);
+
+  // remove all RIDs but every tenth, then all RIDs of key 0 one by one and key 1 at once
+  for (int i : order) {
+    if (i / num_keys % 10 != 0) {
+      tree.Remove(make_key(i % num_keys), make_rid(i / num_keys), transaction);
+    }
+  }
+  tree.Remove(make_key(2), make_rid(1), transaction);
+  for (int j = 0; j < rids_per_key; j += 10) {
+    tree.Remove(make_key(0), make_rid(j), transaction);
+  }
+  tree.Remove(make_key(1), transaction);
+  for (int k = 0; k < num_keys; k++) {
+    rids.clear();
+    EXPECT_EQ(tree.GetValue(make_key(k), &rids), k > 1);
+    if (k > 1) {
+      ASSERT_EQ(rids.size(), rids_per_key / 10);
+      for (int j = 0; j < rids_per_key / 10; j++) {
+        EXPECT_EQ(rids[j], make_rid(j * 10));
+      }
+    }
+  }
+
+  // lists short enough move back into their leaves
+  for (int k = 2; k < num_keys; k++) {
+    for (int j = 20; j < rids_per_key; j += 10) {
+      tree.Remove(make_key(k), make_rid(j), transaction);
+    }
+    rids.clear();
+    EXPECT_TRUE(tree.GetValue(make_key(k), &rids));
+    EXPECT_EQ(rids, std::vector<RID>({make_rid(0), make_rid(10)}));
+  }
+
+  // a bulk load defers the repeated keys to insertion
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> loaded("foo_sk2", bpm, comparator, PAGE_SIZE, PAGE_SIZE, false);
+  std::vector<std::pair<GenericKey<8>, RID>> entries;
+  for (int k = 0; k < num_keys; k++) {
+    for (int j = 0; j < 100; j++) {
+      entries.emplace_back(make_key(k), make_rid(j));
+    }
+  }
+  loaded.BulkLoad(entries, 90, transaction);
+  for (int k = 0; k < num_keys; k++) {
+    rids.clear();
+    EXPECT_TRUE(loaded.GetValue(make_key(k), &rids));
+    EXPECT_EQ(rids.size(), 100);
+  }
+
+  // a unique tree removes a pair only if the key still has that value
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> unique("foo_pk", bpm, comparator);
+  EXPECT_TRUE(unique.Insert(make_key(1), make_rid(1), transaction));
+  EXPECT_FALSE(unique.Insert(make_key(1), make_rid(2), transaction));
+  unique.Remove(make_key(1), make_rid(2), transaction);
+  rids.clear();
+  EXPECT_TRUE(unique.GetValue(make_key(1), &rids));
+  unique.Remove(make_key(1), make_rid(1), transaction);
+  EXPECT_TRUE(unique.IsEmpty());
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete transaction;
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+/*
+ * Random inserts, upserts and removes against a map, with and without buffered writes. The buffers of the tiny pages
+ * fill up quickly, so that messages move down through several levels and split the pages they reach.
+ */
+// NOLINTNEXTLINE
+TEST(BPlusTreeTests, BufferedTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(100, disk_manager);
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+
+  EXPECT_THROW((BPlusTree<GenericKey<8>, RID, GenericComparator<8>>("foo_sk", bpm, comparator, 4, 4, false,
+                                                                    BPlusTreeMode::BUFFERED)),
+               Exception);
+
+  for (auto mode : {BPlusTreeMode::LATCH_COUPLING, BPlusTreeMode::BUFFERED}) {
+    BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 4, 4, true, mode);
+    std::map<int64_t, int32_t> expected;
+    std::mt19937 rng(42);
+    GenericKey<8> index_key;
+    std::vector<RID> rids;
+    const int64_t num_keys = 20000;
+    for (int i = 0; i < 40000; i++) {
+      int64_t key = rng() % num_keys;
+      auto value = static_cast<int32_t>(rng() % 1000);
+      index_key.SetFromInteger(key);
+      switch (rng() % 4) {
+        case 0:
+        case 1:
+          EXPECT_EQ(expected.count(key) == 0, tree.Insert(index_key, RID(key, value)));
+          expected.emplace(key, value);
+          break;
+        case 2:
+          tree.Upsert(index_key, RID(key, value));
+          expected[key] = value;
+          break;
+        default:
+          tree.Remove(index_key);
+          expected.erase(key);
+      }
+      if (i % 5000 == 0) {
+        for (int64_t k = 0; k < num_keys; k++) {
+          index_key.SetFromInteger(k);
+          rids.clear();
+          auto it = expected.find(k);
+          ASSERT_EQ(it != expected.end(), tree.GetValue(index_key, &rids)) << k;
+          if (it != expected.end()) {
+            EXPECT_EQ(RID(k, it->second), rids[0]);
+          }
+        }
+      }
+    }
+
+    // a scan sees every write, which first flushes the buffers
+    auto it = expected.begin();
+    for (auto iterator = tree.Begin(); iterator != tree.End(); ++iterator, ++it) {
+      ASSERT_NE(it, expected.end());
+      EXPECT_EQ(RID(it->first, it->second), (*iterator).second);
+    }
+    EXPECT_EQ(it, expected.end());
+    for (int64_t k = 0; k < num_keys; k++) {
+      index_key.SetFromInteger(k);
+      rids.clear();
+      EXPECT_EQ(expected.count(k) == 1, tree.GetValue(index_key, &rids)) << k;
+    }
+  }
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
 }  // namespace bustub
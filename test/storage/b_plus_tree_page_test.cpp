@@ -0,0 +1,148 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// b_plus_tree_page_test.cpp
+//
+// Identification: test/storage/b_plus_tree_page_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "storage/page/b_plus_tree_internal_page.h"
+#include "storage/page/b_plus_tree_leaf_page.h"
+#include "storage/page/page.h"
+
+namespace bustub {
+
+namespace {
+
+/**
+ * A normalized key: a leading column that every key shares, then a 4-byte big-endian integer. Keys are written as
+ * bytes, so the comparators below need no schema.
+ */
+template <typename KeyType>
+KeyType MakeKey(uint32_t value) {
+  KeyType key;
+  auto *data = reinterpret_cast<char *>(&key);
+  memset(data, 'k', sizeof(KeyType) - sizeof(uint32_t));
+  for (size_t i = 0; i < sizeof(uint32_t); i++) {
+    data[sizeof(KeyType) - sizeof(uint32_t) + i] = static_cast<char>(value >> (8 * (3 - i)));
+  }
+  return key;
+}
+
+/** Key values are spread out, so that searches for the values in between miss. */
+constexpr uint32_t FIRST_VALUE = 1000;
+constexpr uint32_t STRIDE = 7;
+
+template <typename Search>
+double NanosPerSearch(const std::vector<uint32_t> &probes, const Search &search, int64_t *checksum) {
+  const int rounds = 200;
+  auto start = std::chrono::steady_clock::now();
+  for (int round = 0; round < rounds; round++) {
+    for (uint32_t probe : probes) {
+      *checksum += search(probe);
+    }
+  }
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  return seconds * 1e9 / (static_cast<double>(rounds) * probes.size());
+}
+
+}  // namespace
+
+template <typename KeyType>
+class BPlusTreePageTest : public ::testing::Test {};
+
+using KeyTypes = ::testing::Types<GenericKey<4>, GenericKey<8>, GenericKey<16>, GenericKey<32>, GenericKey<64>>;
+TYPED_TEST_SUITE(BPlusTreePageTest, KeyTypes);
+
+/*
+ * Searches in full pages, with and without fences, must agree with a search of the sorted keys. The search in
+ * pages with fences, where the heads tell almost all keys apart, is timed against a binary search of the sorted
+ * keys with the comparator.
+ */
+// NOLINTNEXTLINE
+TYPED_TEST(BPlusTreePageTest, SearchBenchmarkTest) {
+  using KeyType = TypeParam;
+  using KeyComparator = GenericComparator<sizeof(KeyType)>;
+  using LeafPage = BPlusTreeLeafPage<KeyType, RID, KeyComparator>;
+  using InternalPage = BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator>;
+  KeyComparator comparator(nullptr);
+  auto less = [&comparator](const KeyType &lhs, const KeyType &rhs) { return comparator(lhs, rhs) < 0; };
+  // pages are filled until they are full in bytes
+  const int max_size = PAGE_SIZE;
+
+  for (bool fenced : {false, true}) {
+    KeyType low_fence = MakeKey<KeyType>(FIRST_VALUE);
+    KeyType high_fence = MakeKey<KeyType>(FIRST_VALUE + STRIDE * max_size);
+    const KeyType *low = fenced ? &low_fence : nullptr;
+    const KeyType *high = fenced ? &high_fence : nullptr;
+
+    Page leaf_page;
+    auto *leaf = reinterpret_cast<LeafPage *>(leaf_page.GetData());
+    leaf->Init(1, INVALID_PAGE_ID, max_size, low, high);
+    std::vector<KeyType> keys;
+    for (uint32_t i = 0; leaf->GetSize() + 1 < leaf->GetMaxSize(); i++) {
+      std::pair<KeyType, RID> item(MakeKey<KeyType>(FIRST_VALUE + STRIDE * i), RID(0, i));
+      if (!leaf->HasRoomFor(item.first)) {
+        break;
+      }
+      leaf->CopyNFrom(&item, 1);
+      keys.push_back(item.first);
+    }
+
+    Page internal_page;
+    auto *internal = reinterpret_cast<InternalPage *>(internal_page.GetData());
+    internal->Init(2, INVALID_PAGE_ID, max_size, low, high);
+    for (size_t i = 0; i < keys.size() && internal->HasRoomFor(keys[i]); i++) {
+      internal->Append(keys[i], static_cast<page_id_t>(i));
+    }
+    auto children = static_cast<size_t>(internal->GetSize());
+
+    // probes hit and miss keys inside the page, and fall outside it on both sides
+    std::mt19937 gen(15445);
+    std::vector<uint32_t> probes(4096);
+    for (auto &probe : probes) {
+      probe = static_cast<uint32_t>(gen() % (FIRST_VALUE + STRIDE * keys.size() + FIRST_VALUE));
+    }
+
+    auto sorted_search = [&](uint32_t probe) {
+      auto key = MakeKey<KeyType>(probe);
+      return static_cast<int>(std::lower_bound(keys.begin(), keys.end(), key, less) - keys.begin());
+    };
+    auto leaf_search = [&](uint32_t probe) { return leaf->KeyIndex(MakeKey<KeyType>(probe), comparator); };
+    auto internal_search = [&](uint32_t probe) {
+      return static_cast<int>(internal->Lookup(MakeKey<KeyType>(probe), comparator));
+    };
+    for (uint32_t probe : probes) {
+      auto key = MakeKey<KeyType>(probe);
+      ASSERT_EQ(sorted_search(probe), leaf_search(probe)) << probe;
+      auto child = std::upper_bound(keys.begin() + 1, keys.begin() + children, key, less) - keys.begin() - 1;
+      ASSERT_EQ(child, internal_search(probe)) << probe;
+    }
+
+    if (fenced) {
+      int64_t checksum = 0;
+      double sorted_ns = NanosPerSearch(probes, sorted_search, &checksum);
+      double leaf_ns = NanosPerSearch(probes, leaf_search, &checksum);
+      double internal_ns = NanosPerSearch(probes, internal_search, &checksum);
+      EXPECT_GT(checksum, 0);
+      std::cout << "GenericKey<" << sizeof(KeyType) << ">: leaf page of " << keys.size() << " keys " << leaf_ns
+                << " ns/search, internal page of " << children << " children " << internal_ns
+                << " ns/search, sorted key array " << sorted_ns << " ns/search" << std::endl;
+    }
+  }
+}
+
+}  // namespace bustub
@@ -10,11 +10,28 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cstdio>
 #include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
 
 #include "common/exception.h"
+#include "common/util/crc32c_util.h"
 #include "gtest/gtest.h"
+#include "storage/disk/disk_interface.h"
 #include "storage/disk/disk_manager.h"
+#include "storage/disk/disk_stats.h"
+#include "storage/disk/log_device.h"
+#include "storage/disk/memory_disk_manager.h"
+#include "storage/disk/mmap_disk_manager.h"
 
 namespace bustub {
 
@@ -72,7 +89,575 @@ TEST_F(DiskManagerTest, ReadWriteLogTest) {
   dm.ShutDown();
 }
 
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, LogDeviceConcurrentAppendTest) {
+  const int num_threads = 4;
+  const int num_records = 500;
+  const size_t record_size = 64;
+
+  for (auto sync_mode :
+       {LogDevice::SyncMode::FDATASYNC, LogDevice::SyncMode::DSYNC, LogDevice::SyncMode::SYNC_FILE_RANGE}) {
+    remove("test.log");
+    // small buffers so that appenders rotate through them and have to wait for the device
+    LogDevice device("test.log", sync_mode, 3, 4 * record_size);
+
+    std::vector<std::thread> threads;
+    for (int tid = 0; tid < num_threads; tid++) {
+      threads.emplace_back([&device, tid] {
+        std::vector<char> record(record_size, static_cast<char>('a' + tid));
+        for (int i = 0; i < num_records; i++) {
+          auto offset = device.Append(record.data(), record.size());
+          if (i % 50 == 0) {
+            device.WaitForDurable(offset);
+            EXPECT_GE(device.GetDurableOffset(), offset);
+          }
+        }
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    device.Close();
+
+    // every record made it to the file in one piece
+    LogDevice reader("test.log");
+    std::vector<int> counts(num_threads, 0);
+    std::vector<char> record(record_size);
+    size_t offset = 0;
+    while (reader.Read(record.data(), record.size(), offset)) {
+      int tid = record[0] - 'a';
+      ASSERT_TRUE(tid >= 0 && tid < num_threads);
+      EXPECT_EQ(std::vector<char>(record_size, record[0]), record);
+      counts[tid]++;
+      offset += record_size;
+    }
+    EXPECT_EQ(offset, num_threads * num_records * record_size);
+    for (int tid = 0; tid < num_threads; tid++) {
+      EXPECT_EQ(num_records, counts[tid]);
+    }
+    reader.Close();
+  }
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, LogDeviceWriteErrorTest) {
+  // every write to /dev/full fails with ENOSPC
+  std::ifstream probe("/dev/full");
+  if (!probe.is_open()) {
+    return;
+  }
+  LogDevice device("/dev/full", LogDevice::SyncMode::FDATASYNC, 2, 64);
+  char record[48] = {0};
+  auto offset = device.Append(record, sizeof(record));
+  EXPECT_THROW(device.WaitForDurable(offset), Exception);
+  EXPECT_TRUE(device.HasFailed());
+  EXPECT_EQ(0, device.GetDurableOffset());
+  EXPECT_EQ(0, device.GetNumSyncs());
+
+  // the device stays failed, later appends are never acknowledged either, and appenders do not block on it
+  for (int i = 0; i < 10; i++) {
+    offset = device.Append(record, sizeof(record));
+  }
+  EXPECT_THROW(device.WaitForDurable(offset), Exception);
+  EXPECT_EQ(0, device.GetDurableOffset());
+  device.Close();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, MmapReadPageTest) {
+  char buf[PAGE_SIZE] = {0};
+  char data[PAGE_SIZE] = {0};
+  char zero[PAGE_SIZE] = {0};
+  std::string db_file("test.db");
+  const int num_pages = 2 * MmapDiskManager::READAHEAD_PAGES;
+  {
+    auto dm = DiskManager(db_file);
+    for (int i = 0; i < num_pages; i++) {
+      std::snprintf(data, sizeof(data), "page %d", i);
+      dm.WritePage(i, data);
+    }
+    dm.ShutDown();
+  }
+
+  auto dm = MmapDiskManager(db_file);
+  // sequential scan, crosses the readahead threshold several times
+  for (int i = 0; i < num_pages; i++) {
+    std::snprintf(data, sizeof(data), "page %d", i);
+    dm.ReadPage(i, buf);
+    EXPECT_EQ(std::memcmp(buf, data, sizeof(buf)), 0);
+  }
+
+  // random access
+  std::snprintf(data, sizeof(data), "page %d", 7);
+  dm.ReadPage(7, buf);
+  EXPECT_EQ(std::memcmp(buf, data, sizeof(buf)), 0);
+
+  // reads past the end of the mapping come back zeroed
+  dm.ReadPage(num_pages + 10, buf);
+  EXPECT_EQ(std::memcmp(buf, zero, sizeof(buf)), 0);
+
+  EXPECT_THROW(dm.WritePage(0, data), Exception);
+  EXPECT_FALSE(dm.ReadLog(buf, 16, 0));
+
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, MemoryReadWriteTest) {
+  char buf[PAGE_SIZE] = {0};
+  char data[PAGE_SIZE] = {0};
+  char zero[PAGE_SIZE] = {0};
+  MemoryDiskManager dm;
+  std::strncpy(data, "A test string.", sizeof(data));
+
+  dm.ReadPage(0, buf);  // tolerate empty read
+  EXPECT_EQ(std::memcmp(buf, zero, sizeof(buf)), 0);
+
+  dm.WritePage(0, data);
+  dm.ReadPage(0, buf);
+  EXPECT_EQ(std::memcmp(buf, data, sizeof(buf)), 0);
+
+  // pages in between are never allocated and read back as zeroes
+  dm.WritePage(100, data);
+  dm.ReadPage(100, buf);
+  EXPECT_EQ(std::memcmp(buf, data, sizeof(buf)), 0);
+  dm.ReadPage(50, buf);
+  EXPECT_EQ(std::memcmp(buf, zero, sizeof(buf)), 0);
+  EXPECT_EQ(dm.GetNumWrites(), 2);
+
+  // invalid page ids are rejected instead of sizing the page table from them
+  dm.WritePage(INVALID_PAGE_ID, data);
+  dm.WritePage(-100, data);
+  dm.ReadPage(INVALID_PAGE_ID, buf);
+  EXPECT_EQ(std::memcmp(buf, zero, sizeof(buf)), 0);
+  EXPECT_EQ(dm.GetNumWrites(), 2);
+
+  char log_buf[16] = {0};
+  char log_data[16] = {0};
+  std::strncpy(log_data, "A test string.", sizeof(log_data));
+  EXPECT_FALSE(dm.ReadLog(log_buf, sizeof(log_buf), 0));
+  dm.WriteLog(log_data, sizeof(log_data));
+  EXPECT_TRUE(dm.ReadLog(log_buf, sizeof(log_buf), 0));
+  EXPECT_EQ(std::memcmp(log_buf, log_data, sizeof(log_buf)), 0);
+  EXPECT_EQ(dm.GetNumFlushes(), 1);
+
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, MemoryDeviceModelTest) {
+  char data[PAGE_SIZE] = {0};
+  MemoryDiskManager::DeviceModel model;
+  model.latency_ = std::chrono::microseconds(1000);
+  model.bandwidth_ = 4 * 1024 * 1024;  // a page takes ~1ms
+  MemoryDiskManager dm(model);
+
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < 10; i++) {
+    dm.WritePage(i, data);
+  }
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  EXPECT_GE(elapsed, std::chrono::milliseconds(19));
+
+  // the simulated device time shows up in the latency histogram
+  auto writes = dm.GetStats().Get(IOType::PAGE_WRITE);
+  EXPECT_EQ(writes.count_, 10);
+  EXPECT_GE(writes.AverageLatency(), 1000000);
+  EXPECT_GE(writes.LatencyPercentile(50), 1000000);
+
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, StatsTest) {
+  char buf[PAGE_SIZE] = {0};
+  char data[PAGE_SIZE] = {0};
+  char log_data[16] = {0};
+  std::string db_file("test.db");
+  auto dm = DiskManager(db_file);
+
+  for (int i = 0; i < 4; i++) {
+    dm.WritePage(i, data);
+  }
+  for (int i = 0; i < 4; i++) {
+    dm.ReadPage(i, buf);
+  }
+  dm.WriteLog(log_data, sizeof(log_data));
+
+  auto &stats = dm.GetStats();
+  auto reads = stats.Get(IOType::PAGE_READ);
+  auto writes = stats.Get(IOType::PAGE_WRITE);
+  EXPECT_EQ(reads.count_, 4);
+  EXPECT_EQ(reads.bytes_, 4 * PAGE_SIZE);
+  EXPECT_EQ(writes.count_, 4);
+  EXPECT_EQ(writes.bytes_, 4 * PAGE_SIZE);
+  EXPECT_EQ(dm.GetNumWrites(), 4);
+  EXPECT_EQ(stats.Get(IOType::LOG_WRITE).count_, 1);
+  EXPECT_EQ(stats.Get(IOType::LOG_WRITE).bytes_, sizeof(log_data));
+  EXPECT_EQ(stats.Get(IOType::SYNC).count_, 1);
+  EXPECT_EQ(stats.Get(IOType::SYNC).bytes_, sizeof(log_data));
+
+  uint64_t histogram_total = 0;
+  for (auto bucket_count : writes.latency_histogram_) {
+    histogram_total += bucket_count;
+  }
+  EXPECT_EQ(histogram_total, 4);
+  EXPECT_LE(writes.LatencyPercentile(50), writes.LatencyPercentile(99));
+  EXPECT_NE(stats.ToString().find("page_write"), std::string::npos);
+
+  dm.EnableStatsDump(std::chrono::milliseconds(10));
+  std::this_thread::sleep_for(std::chrono::milliseconds(30));
+  dm.DisableStatsDump();
+
+  stats.Reset();
+  EXPECT_EQ(stats.Get(IOType::PAGE_READ).count_, 0);
+  EXPECT_EQ(stats.Get(IOType::SYNC).count_, 0);
+
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, ConcurrentStatsTest) {
+  const int num_threads = 4;
+  const int num_pages = 100;
+  MemoryDiskManager dm;
+
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([&dm, tid]() {
+      char data[PAGE_SIZE] = {0};
+      for (int i = 0; i < num_pages; i++) {
+        dm.WritePage(tid * num_pages + i, data);
+        dm.ReadPage(tid * num_pages + i, data);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  EXPECT_EQ(dm.GetNumWrites(), num_threads * num_pages);
+  EXPECT_EQ(dm.GetStats().Get(IOType::PAGE_WRITE).count_, num_threads * num_pages);
+  EXPECT_EQ(dm.GetStats().Get(IOType::PAGE_READ).count_, num_threads * num_pages);
+  EXPECT_EQ(dm.GetStats().Get(IOType::PAGE_READ).bytes_, num_threads * num_pages * PAGE_SIZE);
+
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, InterfaceStatsTest) {
+  char buf[PAGE_SIZE] = {0};
+  char data[PAGE_SIZE] = {0};
+  char zero[PAGE_SIZE] = {0};
+  std::string db_file("test.db");
+  std::strncpy(data, "A test string.", sizeof(data));
+  {
+    DiskManager dm(db_file);
+    dm.WritePage(0, data);
+    dm.ShutDown();
+  }
+
+  // every backend zeroes pages past the end and counts the read, whether it found the page or not
+  DiskManager file_dm(db_file);
+  MmapDiskManager mmap_dm(db_file);
+  MemoryDiskManager memory_dm;
+  memory_dm.WritePage(0, data);
+  std::vector<DiskInterface *> backends{&file_dm, &mmap_dm, &memory_dm};
+  for (auto *dm : backends) {
+    dm->GetStats().Reset();
+    dm->ReadPage(0, buf);
+    EXPECT_EQ(std::memcmp(buf, data, sizeof(buf)), 0);
+    std::memset(buf, 'x', sizeof(buf));
+    dm->ReadPage(10, buf);
+    EXPECT_EQ(std::memcmp(buf, zero, sizeof(buf)), 0);
+    EXPECT_EQ(dm->GetStats().Get(IOType::PAGE_READ).count_, 2);
+  }
+  EXPECT_FALSE(file_dm.IsReadOnly());
+  EXPECT_TRUE(mmap_dm.IsReadOnly());
+  EXPECT_FALSE(memory_dm.IsReadOnly());
+
+  // rejected page ids show up in the stats, but not in the write count
+  memory_dm.ReadPage(INVALID_PAGE_ID, buf);
+  memory_dm.WritePage(INVALID_PAGE_ID, data);
+  EXPECT_EQ(memory_dm.GetStats().Get(IOType::PAGE_READ).count_, 3);
+  EXPECT_EQ(memory_dm.GetStats().Get(IOType::PAGE_WRITE).count_, 1);
+  EXPECT_EQ(memory_dm.GetNumWrites(), 1);
+
+  file_dm.ShutDown();
+  mmap_dm.ShutDown();
+  memory_dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, ChecksumTest) {
+  char buf[PAGE_SIZE] = {0};
+  char data[PAGE_SIZE] = {0};
+  std::string db_file("test.db");
+  {
+    auto dm = DiskManager(db_file);
+    for (int i = 0; i < 4; i++) {
+      std::snprintf(data, sizeof(data), "page %d", i);
+      dm.WritePage(i, data);
+    }
+    dm.ShutDown();
+  }
+
+  // flip a byte of page 2 behind the disk manager's back, as a torn write would
+  {
+    std::fstream file(db_file, std::ios::binary | std::ios::in | std::ios::out);
+    file.seekp(DiskManager::PageOffset(2) + 100);
+    file.put('x');
+  }
+
+  auto dm = DiskManager(db_file);
+  dm.ReadPage(1, buf);
+  EXPECT_STREQ(buf, "page 1");
+  EXPECT_THROW(dm.ReadPage(2, buf), Exception);
+
+  dm.SetChecksumVerification(DiskManager::ChecksumVerification::NEVER);
+  EXPECT_NO_THROW(dm.ReadPage(2, buf));
+
+  // pages never written have no checksum, e.g. the hole left by writing past the end of the file
+  dm.SetChecksumVerification(DiskManager::ChecksumVerification::ALWAYS);
+  dm.WritePage(6, data);
+  EXPECT_NO_THROW(dm.ReadPage(5, buf));
+  dm.ShutDown();
+
+  // the checksums are loaded from their block on startup, corrupting one is caught as well
+  {
+    std::fstream file(db_file, std::ios::binary | std::ios::in | std::ios::out);
+    file.seekp(DiskManager::ChecksumOffset(3));
+    file.put('x');
+  }
+  auto reopened = DiskManager(db_file);
+  EXPECT_TRUE(reopened.HasChecksums());
+  EXPECT_THROW(reopened.ReadPage(3, buf), Exception);
+  EXPECT_THROW(reopened.ReadPage(2, buf), Exception);
+  EXPECT_NO_THROW(reopened.ReadPage(5, buf));
+  EXPECT_NO_THROW(reopened.ReadPage(6, buf));
+
+  // rewriting the page gives it a new checksum
+  std::snprintf(data, sizeof(data), "page %d", 2);
+  reopened.WritePage(2, data);
+  reopened.ReadPage(2, buf);
+  EXPECT_STREQ(buf, "page 2");
+
+  reopened.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, ChecksumLayoutTest) {
+  char buf[PAGE_SIZE] = {0};
+  char data[PAGE_SIZE] = {0};
+  std::string db_file("test.db");
+  const auto last_in_block = static_cast<page_id_t>(DiskManager::PAGES_PER_CHECKSUM_BLOCK - 1);
+  const auto first_in_next_block = static_cast<page_id_t>(DiskManager::PAGES_PER_CHECKSUM_BLOCK);
+  // past 2 GiB into the file
+  const page_id_t far_page = (1 << 19) + 10;
+
+  // pages stay aligned, a checksum block sits in front of every PAGES_PER_CHECKSUM_BLOCK pages
+  EXPECT_EQ(DiskManager::ChecksumOffset(0), PAGE_SIZE);
+  EXPECT_EQ(DiskManager::PageOffset(0), 2 * PAGE_SIZE);
+  EXPECT_EQ(DiskManager::PageOffset(last_in_block) + PAGE_SIZE, DiskManager::ChecksumOffset(first_in_next_block));
+  EXPECT_EQ(DiskManager::ChecksumOffset(first_in_next_block) + PAGE_SIZE,
+            DiskManager::PageOffset(first_in_next_block));
+  EXPECT_EQ(DiskManager::PageOffset(far_page) % PAGE_SIZE, 0);
+
+  {
+    auto dm = DiskManager(db_file);
+    for (page_id_t page_id : {0, last_in_block, first_in_next_block, far_page}) {
+      std::snprintf(data, sizeof(data), "page %d", page_id);
+      dm.WritePage(page_id, data);
+    }
+    dm.ShutDown();
+  }
+  {
+    std::fstream file(db_file, std::ios::binary | std::ios::in | std::ios::out);
+    file.seekp(DiskManager::PageOffset(first_in_next_block) + 100);
+    file.put('x');
+  }
+
+  auto dm = DiskManager(db_file);
+  for (page_id_t page_id : {0, last_in_block, far_page}) {
+    std::snprintf(data, sizeof(data), "page %d", page_id);
+    dm.ReadPage(page_id, buf);
+    EXPECT_STREQ(buf, data);
+  }
+  EXPECT_THROW(dm.ReadPage(first_in_next_block, buf), Exception);
+  // a page never written in a block that has checksums
+  EXPECT_NO_THROW(dm.ReadPage(first_in_next_block + 1, buf));
+  dm.ShutDown();
+
+  auto mmap_dm = MmapDiskManager(db_file);
+  std::snprintf(data, sizeof(data), "page %d", far_page);
+  mmap_dm.ReadPage(far_page, buf);
+  EXPECT_STREQ(buf, data);
+  mmap_dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, LegacyFileTest) {
+  char buf[PAGE_SIZE] = {0};
+  char data[PAGE_SIZE] = {0};
+  std::string db_file("test.db");
+  // a file from before checksums: pages at PAGE_SIZE stride, no header
+  {
+    std::ofstream file(db_file, std::ios::binary);
+    for (int i = 0; i < 3; i++) {
+      std::memset(data, 0, sizeof(data));
+      std::snprintf(data, sizeof(data), "page %d", i);
+      file.write(data, PAGE_SIZE);
+    }
+  }
+
+  {
+    auto dm = DiskManager(db_file);
+    EXPECT_FALSE(dm.HasChecksums());
+    for (int i = 0; i < 3; i++) {
+      std::snprintf(data, sizeof(data), "page %d", i);
+      dm.ReadPage(i, buf);
+      EXPECT_STREQ(buf, data);
+    }
+    // written back in the same layout
+    std::snprintf(data, sizeof(data), "page %d", 3);
+    dm.WritePage(3, data);
+    dm.ShutDown();
+  }
+  {
+    std::ifstream file(db_file, std::ios::binary);
+    file.seekg(3 * PAGE_SIZE);
+    file.read(buf, PAGE_SIZE);
+    EXPECT_STREQ(buf, "page 3");
+  }
+
+  auto mmap_dm = MmapDiskManager(db_file);
+  for (int i = 0; i < 4; i++) {
+    std::snprintf(data, sizeof(data), "page %d", i);
+    mmap_dm.ReadPage(i, buf);
+    EXPECT_STREQ(buf, data);
+  }
+  mmap_dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, ChecksumFirstReadTest) {
+  char buf[PAGE_SIZE] = {0};
+  char data[PAGE_SIZE] = {0};
+  std::string db_file("test.db");
+  {
+    auto dm = DiskManager(db_file);
+    dm.WritePage(0, data);
+    dm.WritePage(1, data);
+    dm.ShutDown();
+  }
+
+  auto dm = DiskManager(db_file);
+  dm.SetChecksumVerification(DiskManager::ChecksumVerification::FIRST_READ);
+  dm.ReadPage(0, buf);
+
+  {
+    std::fstream file(db_file, std::ios::binary | std::ios::in | std::ios::out);
+    file.seekp(DiskManager::PageOffset(0) + 10);
+    file.put('x');
+    file.seekp(DiskManager::PageOffset(1) + 10);
+    file.put('x');
+  }
+
+  // page 0 was already verified since startup, page 1 was not
+  EXPECT_NO_THROW(dm.ReadPage(0, buf));
+  EXPECT_THROW(dm.ReadPage(1, buf), Exception);
+
+  dm.SetChecksumVerification(DiskManager::ChecksumVerification::ALWAYS);
+  EXPECT_THROW(dm.ReadPage(0, buf), Exception);
+
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, ChecksumOverheadBenchmarkTest) {
+  const int num_pages = 1024;
+  const int num_rounds = 8;
+  char buf[PAGE_SIZE] = {0};
+  char data[PAGE_SIZE] = {0};
+  std::string db_file("test.db");
+  auto dm = DiskManager(db_file);
+  auto seconds_since = [](std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  };
+  double megabytes = static_cast<double>(num_pages) * num_rounds * PAGE_SIZE / (1024.0 * 1024.0);
+
+  // write path: WritePage always checksums, so compare the time spent in the checksum alone with the whole write
+  auto start = std::chrono::steady_clock::now();
+  for (int round = 0; round < num_rounds; round++) {
+    for (int i = 0; i < num_pages; i++) {
+      std::snprintf(data, sizeof(data), "page %d round %d", i, round);
+      dm.WritePage(i, data);
+    }
+  }
+  double write = seconds_since(start);
+  uint32_t sink = 0;
+  start = std::chrono::steady_clock::now();
+  for (int round = 0; round < num_rounds; round++) {
+    for (int i = 0; i < num_pages; i++) {
+      data[0] = static_cast<char>(i + round);
+      sink += Crc32cUtil::Crc32c(data, PAGE_SIZE);
+    }
+  }
+  double checksum = seconds_since(start);
+  EXPECT_NE(0, sink);
+
+  // read path: scan with and without verification, alternating between the two and keeping the best pass of each so
+  // that a noisy neighbour does not land on only one side
+  auto scan = [&](DiskManager::ChecksumVerification verification, bool cold) {
+    dm.SetChecksumVerification(verification);
+    if (cold) {
+      // drop the file from the page cache, so that every read goes to the device
+      int fd = open(db_file.c_str(), O_RDONLY);
+      fdatasync(fd);
+      posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+      close(fd);
+    }
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < num_pages; i++) {
+      dm.ReadPage(i, buf);
+    }
+    return seconds_since(start);
+  };
+  auto best_of = [&](bool cold, int rounds, double *without, double *with) {
+    *without = *with = std::numeric_limits<double>::max();
+    for (int round = 0; round < rounds; round++) {
+      *without = std::min(*without, scan(DiskManager::ChecksumVerification::NEVER, cold));
+      *with = std::min(*with, scan(DiskManager::ChecksumVerification::ALWAYS, cold));
+    }
+  };
+  // the file is in the page cache, so this reads at memory bandwidth, the worst case for checksum overhead
+  double warm_without;
+  double warm_with;
+  best_of(false, num_rounds * 4, &warm_without, &warm_with);
+  double cold_without;
+  double cold_with;
+  best_of(true, 3, &cold_without, &cold_with);
+  double scan_megabytes = megabytes / num_rounds;
+
+  std::cout << "crc32c " << (Crc32cUtil::IsHardwareAccelerated() ? "hardware" : "portable") << ":" << std::endl
+            << "  write: " << megabytes / write << " MB/s, " << checksum / write * 100.0
+            << "% of it checksumming" << std::endl
+            << "  cached read: " << scan_megabytes / warm_without << " MB/s without checksums, "
+            << scan_megabytes / warm_with << " MB/s with checksums, " << (warm_with / warm_without - 1.0) * 100.0
+            << "% overhead" << std::endl
+            << "  uncached read: " << scan_megabytes / cold_without << " MB/s without checksums, "
+            << scan_megabytes / cold_with << " MB/s with checksums, "
+            << (cold_with / cold_without - 1.0) * 100.0 << "% overhead" << std::endl;
+
+  dm.ShutDown();
+}
+
 // NOLINTNEXTLINE
 TEST_F(DiskManagerTest, ThrowBadFileTest) { EXPECT_THROW(DiskManager("dev/null\\/foo/bar/baz/test.db"), Exception); }
 
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, MmapThrowBadFileTest) {
+  EXPECT_THROW(MmapDiskManager("dev/null\\/foo/bar/baz/test.db"), Exception);
+}
+
 }  // namespace bustub
@@ -0,0 +1,108 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// generic_key_test.cpp
+//
+// Identification: test/storage/generic_key_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "storage/index/generic_key.h"
+#include "test_util.h"  // NOLINT
+
+namespace bustub {
+
+namespace {
+
+/** Column by column comparison of the values, as the comparator did before keys were normalized. */
+int CompareValues(const std::vector<Value> &lhs, const std::vector<Value> &rhs) {
+  for (size_t i = 0; i < lhs.size(); i++) {
+    if (lhs[i].CompareLessThan(rhs[i]) == CmpBool::CmpTrue) {
+      return -1;
+    }
+    if (lhs[i].CompareGreaterThan(rhs[i]) == CmpBool::CmpTrue) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+}  // namespace
+
+// NOLINTNEXTLINE
+TEST(GenericKeyTest, NormalizedOrderTest) {
+  auto key_schema = ParseCreateStatement("a smallint,b varchar(8),c double,d integer");
+  GenericComparator<64> comparator(key_schema.get());
+
+  // few distinct values per column, so that ties fall through to the next column
+  std::mt19937 gen(15445);
+  const std::vector<std::string> strings = {"", "a", "ab", "b", std::string("a\0b", 3), "zz"};
+  std::vector<std::vector<Value>> values;
+  std::vector<GenericKey<64>> keys;
+  for (int i = 0; i < 200; i++) {
+    std::vector<Value> row{
+        Value(TypeId::SMALLINT, static_cast<int16_t>(static_cast<int>(gen() % 5) - 2)),
+        Value(TypeId::VARCHAR, strings[gen() % strings.size()]),
+        Value(TypeId::DECIMAL, (static_cast<double>(gen() % 7) - 3) / 2),
+        Value(TypeId::INTEGER, static_cast<int32_t>(gen())),
+    };
+    GenericKey<64> key;
+    key.SetFromKey(Tuple(row, key_schema.get()), key_schema.get());
+    values.push_back(row);
+    keys.push_back(key);
+  }
+
+  for (size_t i = 0; i < keys.size(); i++) {
+    for (size_t j = 0; j < keys.size(); j++) {
+      EXPECT_EQ(CompareValues(values[i], values[j]), comparator(keys[i], keys[j])) << i << " " << j;
+    }
+    for (uint32_t col = 0; col < key_schema->GetColumnCount(); col++) {
+      EXPECT_EQ(CmpBool::CmpTrue, keys[i].ToValue(key_schema.get(), col).CompareEquals(values[i][col]));
+    }
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(GenericKeyTest, EdgeValuesTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+  std::vector<int64_t> integers = {BUSTUB_INT64_MIN, -256, -1, 0, 1, 255, 256, BUSTUB_INT64_MAX};
+  for (size_t i = 0; i + 1 < integers.size(); i++) {
+    GenericKey<8> lhs;
+    GenericKey<8> rhs;
+    lhs.SetFromKey(Tuple({Value(TypeId::BIGINT, integers[i])}, key_schema.get()), key_schema.get());
+    rhs.SetFromInteger(integers[i + 1]);
+    EXPECT_EQ(-1, comparator(lhs, rhs));
+    EXPECT_EQ(1, comparator(rhs, lhs));
+    EXPECT_EQ(integers[i], lhs.ToString());
+  }
+
+  // -0.0 and 0.0 are the same key
+  auto decimal_schema = ParseCreateStatement("a double");
+  GenericComparator<8> decimal_comparator(decimal_schema.get());
+  GenericKey<8> negative_zero;
+  GenericKey<8> zero;
+  GenericKey<8> negative;
+  negative_zero.SetFromKey(Tuple({Value(TypeId::DECIMAL, -0.0)}, decimal_schema.get()), decimal_schema.get());
+  zero.SetFromKey(Tuple({Value(TypeId::DECIMAL, 0.0)}, decimal_schema.get()), decimal_schema.get());
+  negative.SetFromKey(Tuple({Value(TypeId::DECIMAL, -1e-300)}, decimal_schema.get()), decimal_schema.get());
+  EXPECT_EQ(0, decimal_comparator(negative_zero, zero));
+  EXPECT_EQ(-1, decimal_comparator(negative, zero));
+
+  // keys that do not fit are rejected
+  auto varchar_schema = ParseCreateStatement("a varchar(8)");
+  GenericKey<8> varchar_key;
+  EXPECT_THROW(varchar_key.SetFromKey(Tuple({Value(TypeId::VARCHAR, "too long")}, varchar_schema.get()),
+                                    varchar_schema.get()),
+               Exception);
+}
+
+}  // namespace bustub